@@ -1223,6 +1223,8 @@ enum opt {
     OPT_DUMP,
     OPT_HELP,
     OPT_MUX_MAX_DELAY,
+    OPT_SINK_CPU,
+    OPT_SINK_NUMA,
 };
 
 static struct option options[] = {
@@ -1249,6 +1251,8 @@ static struct option options[] = {
     { "dump", required_argument, NULL, OPT_DUMP },
     { "help", no_argument, NULL, OPT_HELP },
     { "mux-max-delay", required_argument, NULL, OPT_MUX_MAX_DELAY },
+    { "sink-cpu", required_argument, NULL, OPT_SINK_CPU },
+    { "sink-numa", required_argument, NULL, OPT_SINK_NUMA },
     { 0, 0, 0, 0 },
 };
 
@@ -1283,6 +1287,8 @@ int main(int argc, char **argv)
     bool ts = false;
     uint64_t time_limit = DEFAULT_TIME_LIMIT;
     unsigned int rt_priority = 0;
+    struct upipe_pthread_sched sink_sched;
+    upipe_pthread_sched_init(&sink_sched);
     const char *syslog_tag = NULL;
     bool udp = false;
     int mtu = TS_PAYLOAD_SIZE;
@@ -1372,6 +1378,17 @@ int main(int argc, char **argv)
         case OPT_MUX_MAX_DELAY:
             mux_max_delay = strtoull(optarg, NULL, 10);
             break;
+        case OPT_SINK_CPU:
+            if (!ubase_check(upipe_pthread_sched_add_cpu(&sink_sched,
+                            strtoul(optarg, NULL, 10))))
+                usage(argv[0], "invalid CPU %s\n", optarg);
+            break;
+        case OPT_SINK_NUMA:
+            if (!strcmp(optarg, "local"))
+                sink_sched.numa_node = UPIPE_PTHREAD_SCHED_NUMA_LOCAL;
+            else
+                sink_sched.numa_node = atoi(optarg);
+            break;
 
         case OPT_HELP:
             usage(argv[0], NULL);
@@ -1500,22 +1517,18 @@ int main(int argc, char **argv)
     struct upipe_mgr *wsink_mgr = NULL;
     {
         struct upipe_mgr *sink_xfer_mgr = NULL;
-        pthread_attr_t attr;
         /* sink thread */
-        pthread_attr_init(&attr);
         if (rt_priority) {
-            pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
-            pthread_attr_setschedpolicy(&attr, SCHED_RR);
-            struct sched_param param;
-            param.sched_priority = rt_priority;
-            pthread_attr_setschedparam(&attr, &param);
+            sink_sched.policy = SCHED_RR;
+            sink_sched.priority = rt_priority;
         }
         struct umutex *wsink_mutex = NULL;
         if (dump)
             wsink_mutex = umutex_pthread_alloc(0);
-        sink_xfer_mgr = upipe_pthread_xfer_mgr_alloc(XFER_QUEUE,
+        sink_xfer_mgr = upipe_pthread_xfer_mgr_alloc_sched(XFER_QUEUE,
                 XFER_POOL, uprobe_use(main_probe), upump_ev_mgr_alloc_loop,
-                UPUMP_POOL, UPUMP_BLOCKER_POOL, wsink_mutex, NULL, &attr);
+                UPUMP_POOL, UPUMP_BLOCKER_POOL, wsink_mutex, NULL, NULL,
+                &sink_sched);
         assert(sink_xfer_mgr != NULL);
         umutex_release(wsink_mutex);
 
@@ -0,0 +1,421 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/** @file
+ * @short Statistical multiplexing of several files into one TS
+ *
+ * Each input file is a program of the output TS. Its video streams are
+ * transcoded with x264 in capped CRF mode, and its audio streams are
+ * passed through. The TS mux runs in statmux mode at a constant octetrate,
+ * and the target octetrates it throws for the video inputs are relayed to
+ * the x264 encoders with @ref upipe_enc_set_octetrate. All the pipes run in
+ * the same thread, so the encoders can be reconfigured from the probe.
+ */
+
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_uclock.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/upump.h>
+#include <upump-ev/upump_ev.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_file_sink.h>
+#include <upipe-av/upipe_av.h>
+#include <upipe-av/upipe_avformat_source.h>
+#include <upipe-av/upipe_avcodec_decode.h>
+#include <upipe-swscale/upipe_sws.h>
+#include <upipe-filters/upipe_filter_format.h>
+#include <upipe-framers/upipe_auto_framer.h>
+#include <upipe-ts/upipe_ts_mux.h>
+#include <upipe-x264/upipe_x264.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH    10
+#define UREF_POOL_DEPTH     10
+#define UBUF_POOL_DEPTH     10
+#define UPUMP_POOL          5
+#define UPUMP_BLOCKER_POOL  5
+#define DEFAULT_OCTETRATE   (8000000 / 8)
+#define DEFAULT_INTERVAL    (UCLOCK_FREQ / 2)
+#define DEFAULT_CRF         "23"
+
+/** input file, muxed as one program */
+struct input {
+    /** structure for the list of inputs */
+    struct uchain uchain;
+    /** probe catching the split events of the source */
+    struct uprobe uprobe;
+    /** avformat source */
+    struct upipe *avfsrc;
+    /** program of the TS mux */
+    struct upipe *program;
+    /** number of the input */
+    unsigned int id;
+};
+
+UBASE_FROM_TO(input, uchain, uchain, uchain)
+UBASE_FROM_TO(input, uprobe, uprobe, uprobe)
+
+/** video encoder fed by the TS mux target octetrate */
+struct encoder {
+    /** structure for the list of encoders */
+    struct uchain uchain;
+    /** probe catching the events of the TS mux input */
+    struct uprobe uprobe;
+    /** x264 pipe */
+    struct upipe *x264;
+};
+
+UBASE_FROM_TO(encoder, uchain, uchain, uchain)
+UBASE_FROM_TO(encoder, uprobe, uprobe, uprobe)
+
+static enum uprobe_log_level loglevel = UPROBE_LOG_NOTICE;
+static struct uprobe *logger;
+static struct upipe_mgr *upipe_avcdec_mgr;
+static struct upipe_mgr *upipe_ffmt_mgr;
+static struct upipe_mgr *upipe_x264_mgr;
+static struct uref_mgr *uref_mgr;
+static struct uchain inputs;
+static struct uchain encoders;
+static uint64_t mux_octetrate = DEFAULT_OCTETRATE;
+static uint64_t interval = DEFAULT_INTERVAL;
+static const char *crf = DEFAULT_CRF;
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-d] [-r <octetrate>] [-i <interval>] [-q <crf>] <sink file> <source file> ...\n", argv0);
+    fprintf(stderr, "   -d: more verbose\n");
+    fprintf(stderr, "   -r: TS octetrate (default %"PRIu64")\n",
+            (uint64_t)DEFAULT_OCTETRATE);
+    fprintf(stderr, "   -i: statmux interval, in ms (default %"PRIu64")\n",
+            (uint64_t)(DEFAULT_INTERVAL * 1000 / UCLOCK_FREQ));
+    fprintf(stderr, "   -q: x264 CRF (default %s)\n", DEFAULT_CRF);
+    exit(EXIT_FAILURE);
+}
+
+/* main uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            break;
+
+        case UPROBE_SOURCE_END:
+            upipe_release(upipe);
+            return UBASE_ERR_NONE;
+    }
+    return uprobe_throw_next(uprobe, upipe, event, args);
+}
+
+/* relay the statmux target octetrate to the encoder */
+static int catch_mux_input(struct uprobe *uprobe, struct upipe *upipe,
+                           int event, va_list args)
+{
+    if (event != UPROBE_TS_MUX_TARGET_OCTETRATE)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+    struct encoder *encoder = encoder_from_uprobe(uprobe);
+    uint64_t octetrate = va_arg(args, uint64_t);
+    upipe_notice_va(upipe, "new target %"PRIu64" bits/s", octetrate * 8);
+    if (!ubase_check(upipe_enc_set_octetrate(encoder->x264, octetrate)))
+        upipe_warn(upipe, "unable to change the encoder octetrate");
+    return UBASE_ERR_NONE;
+}
+
+/* allocate a capped CRF encoder, and the mux input it feeds */
+static void encoder_alloc(struct input *input, struct upipe *upipe,
+                          uint64_t id)
+{
+    struct encoder *encoder = malloc(sizeof(struct encoder));
+    assert(encoder != NULL);
+    uchain_init(&encoder->uchain);
+    ulist_add(&encoders, &encoder->uchain);
+    uprobe_init(&encoder->uprobe, catch_mux_input, uprobe_use(logger));
+
+    encoder->x264 = upipe_void_alloc_output(upipe, upipe_x264_mgr,
+            uprobe_pfx_alloc_va(uprobe_use(logger), loglevel,
+                                "enc %u.%"PRIu64, input->id, id));
+    assert(encoder->x264 != NULL);
+
+    /* start from an even share of half the TS octetrate */
+    char rate[32];
+    snprintf(rate, sizeof(rate), "%"PRIu64,
+             mux_octetrate * 8 / 1000 / 2 / ulist_depth(&inputs));
+    ubase_assert(upipe_x264_set_default_preset(encoder->x264, "faster",
+                                               NULL));
+    ubase_assert(upipe_set_option(encoder->x264, "crf", crf));
+    ubase_assert(upipe_set_option(encoder->x264, "vbv-maxrate", rate));
+    ubase_assert(upipe_set_option(encoder->x264, "vbv-bufsize", rate));
+    ubase_assert(upipe_set_option(encoder->x264, "repeat-headers", "1"));
+
+    struct upipe *sink = upipe_void_alloc_output_sub(encoder->x264,
+            input->program,
+            uprobe_pfx_alloc_va(uprobe_use(&encoder->uprobe), loglevel,
+                                "mux %u.%"PRIu64, input->id, id));
+    assert(sink != NULL);
+    upipe_release(sink);
+}
+
+/* catch source events */
+static int catch_src(struct uprobe *uprobe, struct upipe *upipe,
+                     int event, va_list args)
+{
+    if (event != UPROBE_SPLIT_UPDATE)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    struct input *input = input_from_uprobe(uprobe);
+    struct uref *flow_def = NULL;
+    while (ubase_check(upipe_split_iterate(upipe, &flow_def)) &&
+           flow_def != NULL) {
+        const char *def = "(none)";
+        uref_flow_get_def(flow_def, &def);
+        uint64_t id = 0;
+        uref_flow_get_id(flow_def, &id);
+        if (ubase_ncmp(def, "block.") ||
+            (!strstr(def, ".pic.") && !strstr(def, ".sound."))) {
+            upipe_warn_va(upipe, "flow def %s is not supported", def);
+            continue;
+        }
+        upipe_notice_va(upipe, "New flow %"PRIu64" (%s)", id, def);
+
+        struct upipe *avfsrc_output = upipe_flow_alloc_sub(input->avfsrc,
+                uprobe_pfx_alloc_va(uprobe_use(logger), loglevel,
+                                    "src %u.%"PRIu64, input->id, id),
+                flow_def);
+        assert(avfsrc_output != NULL);
+
+        if (strstr(def, ".sound.")) {
+            /* audio is passed through */
+            struct upipe *sink = upipe_void_alloc_output_sub(avfsrc_output,
+                    input->program,
+                    uprobe_pfx_alloc_va(uprobe_use(logger), loglevel,
+                                        "mux %u.%"PRIu64, input->id, id));
+            assert(sink != NULL);
+            upipe_release(sink);
+            continue;
+        }
+
+        struct upipe *decoder = upipe_void_alloc_output(avfsrc_output,
+                upipe_avcdec_mgr,
+                uprobe_pfx_alloc_va(uprobe_use(logger), loglevel,
+                                    "dec %u.%"PRIu64, input->id, id));
+        assert(decoder != NULL);
+        upipe_release(decoder);
+
+        struct uref *ffmt_flow = uref_alloc_control(uref_mgr);
+        assert(ffmt_flow != NULL);
+        uref_flow_set_def(ffmt_flow, "pic.");
+        struct upipe *ffmt = upipe_flow_alloc_output(decoder, upipe_ffmt_mgr,
+                uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_VERBOSE,
+                                    "ffmt %u.%"PRIu64, input->id, id),
+                ffmt_flow);
+        uref_free(ffmt_flow);
+        assert(ffmt != NULL);
+        upipe_release(ffmt);
+
+        encoder_alloc(input, ffmt, id);
+    }
+    return UBASE_ERR_NONE;
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "dr:i:q:")) != -1) {
+        switch (opt) {
+            case 'd':
+                if (loglevel > 0)
+                    loglevel--;
+                break;
+            case 'r':
+                mux_octetrate = strtoull(optarg, NULL, 0);
+                break;
+            case 'i':
+                interval = strtoull(optarg, NULL, 0) * UCLOCK_FREQ / 1000;
+                break;
+            case 'q':
+                crf = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                break;
+        }
+    }
+    if (argc - optind < 2 || !mux_octetrate || !interval)
+        usage(argv[0]);
+    const char *sink_path = argv[optind++];
+
+    /* upipe env */
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    struct upump_mgr *upump_mgr = upump_ev_mgr_alloc_default(UPUMP_POOL,
+            UPUMP_BLOCKER_POOL);
+    struct uclock *uclock = uclock_std_alloc(0);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    logger = uprobe_stdio_alloc(uprobe_use(&uprobe), stdout, loglevel);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+    logger = uprobe_uclock_alloc(logger, uclock);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    upipe_av_init(false, uprobe_use(logger));
+
+    /* pipe managers */
+    struct upipe_mgr *upipe_avfsrc_mgr = upipe_avfsrc_mgr_alloc();
+    struct upipe_mgr *upipe_sws_mgr = upipe_sws_mgr_alloc();
+    upipe_avcdec_mgr = upipe_avcdec_mgr_alloc();
+    upipe_x264_mgr = upipe_x264_mgr_alloc();
+    upipe_ffmt_mgr = upipe_ffmt_mgr_alloc();
+    upipe_ffmt_mgr_set_sws_mgr(upipe_ffmt_mgr, upipe_sws_mgr);
+    upipe_mgr_release(upipe_sws_mgr);
+
+    struct upipe_mgr *upipe_autof_mgr = upipe_autof_mgr_alloc();
+    if (upipe_autof_mgr != NULL) {
+        upipe_avfsrc_mgr_set_autof_mgr(upipe_avfsrc_mgr, upipe_autof_mgr);
+        upipe_mgr_release(upipe_autof_mgr);
+    }
+
+    /* TS mux in statmux mode */
+    struct upipe_mgr *upipe_ts_mux_mgr = upipe_ts_mux_mgr_alloc();
+    struct upipe *ts_mux = upipe_void_alloc(upipe_ts_mux_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), loglevel, "ts mux"));
+    assert(ts_mux != NULL);
+    upipe_mgr_release(upipe_ts_mux_mgr);
+    struct uref *flow_def = uref_alloc_control(uref_mgr);
+    uref_flow_set_def(flow_def, "void.");
+    ubase_assert(upipe_set_flow_def(ts_mux, flow_def));
+    upipe_attach_uclock(ts_mux);
+    ubase_assert(upipe_ts_mux_set_mode(ts_mux, UPIPE_TS_MUX_MODE_STATMUX));
+    ubase_assert(upipe_ts_mux_set_octetrate(ts_mux, mux_octetrate));
+    ubase_assert(upipe_ts_mux_set_statmux_interval(ts_mux, interval));
+
+    struct upipe_mgr *upipe_fsink_mgr = upipe_fsink_mgr_alloc();
+    struct upipe *fsink = upipe_void_alloc_output(ts_mux, upipe_fsink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), loglevel, "fsink"));
+    assert(fsink != NULL);
+    upipe_mgr_release(upipe_fsink_mgr);
+    if (unlikely(!ubase_check(upipe_fsink_set_path(fsink, sink_path,
+                                                   UPIPE_FSINK_OVERWRITE)))) {
+        fprintf(stderr, "error: could not open %s\n", sink_path);
+        exit(EXIT_FAILURE);
+    }
+    upipe_release(fsink);
+
+    /* one program per source */
+    ulist_init(&inputs);
+    ulist_init(&encoders);
+    for (unsigned int i = 0; optind < argc; i++, optind++) {
+        struct input *input = malloc(sizeof(struct input));
+        assert(input != NULL);
+        uchain_init(&input->uchain);
+        ulist_add(&inputs, &input->uchain);
+        input->id = i;
+        uprobe_init(&input->uprobe, catch_src, uprobe_use(logger));
+        input->program = upipe_void_alloc_sub(ts_mux,
+                uprobe_pfx_alloc_va(uprobe_use(logger), loglevel,
+                                    "program %u", i));
+        assert(input->program != NULL);
+        ubase_assert(upipe_set_flow_def(input->program, flow_def));
+
+        input->avfsrc = upipe_void_alloc(upipe_avfsrc_mgr,
+                uprobe_pfx_alloc_va(uprobe_use(&input->uprobe), loglevel,
+                                    "avfsrc %u", i));
+        assert(input->avfsrc != NULL);
+        upipe_attach_uclock(input->avfsrc);
+        if (unlikely(!ubase_check(upipe_set_uri(input->avfsrc,
+                                                argv[optind])))) {
+            fprintf(stderr, "error: could not open %s\n", argv[optind]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    uref_free(flow_def);
+
+    /* fire */
+    upump_mgr_run(upump_mgr, NULL);
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&encoders, uchain, uchain_tmp) {
+        struct encoder *encoder = encoder_from_uchain(uchain);
+        ulist_delete(uchain);
+        upipe_release(encoder->x264);
+        uprobe_clean(&encoder->uprobe);
+        free(encoder);
+    }
+    ulist_delete_foreach (&inputs, uchain, uchain_tmp) {
+        struct input *input = input_from_uchain(uchain);
+        ulist_delete(uchain);
+        upipe_release(input->program);
+        uprobe_clean(&input->uprobe);
+        free(input);
+    }
+    upipe_release(ts_mux);
+
+    upipe_mgr_release(upipe_avfsrc_mgr);
+    upipe_mgr_release(upipe_avcdec_mgr);
+    upipe_mgr_release(upipe_x264_mgr);
+    upipe_mgr_release(upipe_ffmt_mgr);
+
+    upipe_av_clean();
+
+    upump_mgr_release(upump_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uclock_release(uclock);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
@@ -30,10 +30,37 @@ extern "C" {
 #endif
 
 #include <upipe/upipe.h>
+#include <upipe-dvbcsa/upipe_dvbcsa_common.h>
 
 /** @This is the dvbcsa decryption pipe signature. */
 #define UPIPE_DVBCSA_DEC_SIGNATURE  UBASE_FOURCC('d','v','b','d')
 
+/** @This extends @ref upipe_dvbcsa_command with specific commands for
+ * dvbcsa decryption pipes. */
+enum upipe_dvbcsa_dec_command {
+    UPIPE_DVBCSA_DEC_SENTINEL = UPIPE_DVBCSA_CONTROL_LOCAL,
+
+    /** set the number of descrambling threads (unsigned int) */
+    UPIPE_DVBCSA_DEC_SET_THREADS,
+};
+
+/** @This sets the number of threads descrambling the batches of packets,
+ * in batch mode only. With 0 (the default), the batches are descrambled in
+ * the thread of the pipe. Otherwise, consecutive batches are descrambled in
+ * parallel, and packets are output in their input order once their batch
+ * is descrambled.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_threads number of descrambling threads
+ * @return an error code
+ */
+static inline int upipe_dvbcsa_dec_set_threads(struct upipe *upipe,
+                                               unsigned int nb_threads)
+{
+    return upipe_control(upipe, UPIPE_DVBCSA_DEC_SET_THREADS,
+                         UPIPE_DVBCSA_DEC_SIGNATURE, nb_threads);
+}
+
 /** @This returns the dvbcsa decrypt pipe management structure.
  *
  * @return a pointer to the manager
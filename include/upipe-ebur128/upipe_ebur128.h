@@ -25,6 +25,11 @@
 
 /** @file
  * @short Upipe ebur128
+ *
+ * Samples are copied to a ring buffer and metered by a background thread, so
+ * that loudness measurement never delays the audio path. The loudness
+ * attributes attached to the urefs are the latest values computed by the
+ * thread, and thus lag slightly behind the uref they are attached to.
  */
 
 #ifndef _UPIPE_EBUR128_UPIPE_EBUR128_H_
@@ -39,11 +44,51 @@ extern "C" {
 #include <stdint.h>
 
 UREF_ATTR_FLOAT(ebur128, momentary, "ebur128.momentary", momentary loudness)
+UREF_ATTR_FLOAT(ebur128, shortterm, "ebur128.shortterm", short-term loudness)
 UREF_ATTR_FLOAT(ebur128, lra, "ebur128.lra", loudness range)
 UREF_ATTR_FLOAT(ebur128, global, "ebur128.global", global integrated loudness)
 
 #define UPIPE_EBUR128_SIGNATURE UBASE_FOURCC('r', '1', '2', '8')
 
+/** @This extends upipe_command with specific commands for ebur128 pipes. */
+enum upipe_ebur128_command {
+    UPIPE_EBUR128_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** set the period of the loudness attributes (uint64_t) */
+    UPIPE_EBUR128_SET_PERIOD,
+    /** get the period of the loudness attributes (uint64_t *) */
+    UPIPE_EBUR128_GET_PERIOD
+};
+
+/** @This sets the period at which the loudness attributes are attached to
+ * the urefs. The period is counted in samples of the flow, so it does not
+ * depend on timestamps. The default of 0 attaches them to every uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param period period in units of the 27 MHz clock
+ * @return an error code
+ */
+static inline int upipe_ebur128_set_period(struct upipe *upipe,
+                                           uint64_t period)
+{
+    return upipe_control(upipe, UPIPE_EBUR128_SET_PERIOD,
+                         UPIPE_EBUR128_SIGNATURE, period);
+}
+
+/** @This gets the period at which the loudness attributes are attached to
+ * the urefs.
+ *
+ * @param upipe description structure of the pipe
+ * @param period_p filled in with the period in units of the 27 MHz clock
+ * @return an error code
+ */
+static inline int upipe_ebur128_get_period(struct upipe *upipe,
+                                           uint64_t *period_p)
+{
+    return upipe_control(upipe, UPIPE_EBUR128_GET_PERIOD,
+                         UPIPE_EBUR128_SIGNATURE, period_p);
+}
+
 /** @This returns the management structure for all avformat sources.
  *
  * @return pointer to manager
@@ -33,6 +33,51 @@ extern "C" {
 
 #define UPIPE_FILTER_BLEND_SIGNATURE UBASE_FOURCC('b', 'l', 'e', 'n')
 
+/** @This defines the deinterlacing modes. */
+enum upipe_filter_blend_mode {
+    /** average of consecutive lines (default) */
+    UPIPE_FILTER_BLEND_MODE_BLEND,
+    /** motion-adaptive interpolation of the missing field from the
+     * previous and next pictures; this delays the output by one picture */
+    UPIPE_FILTER_BLEND_MODE_YADIF,
+};
+
+/** @This extends upipe_command with specific commands for blend pipes. */
+enum upipe_filter_blend_command {
+    UPIPE_FILTER_BLEND_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the current deinterlacing mode (int *) */
+    UPIPE_FILTER_BLEND_GET_MODE,
+    /** sets the deinterlacing mode (int) */
+    UPIPE_FILTER_BLEND_SET_MODE,
+};
+
+/** @This returns the current deinterlacing mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode_p filled in with the mode
+ * @return an error code
+ */
+static inline int upipe_filter_blend_get_mode(struct upipe *upipe,
+                                              int *mode_p)
+{
+    return upipe_control(upipe, UPIPE_FILTER_BLEND_GET_MODE,
+                         UPIPE_FILTER_BLEND_SIGNATURE, mode_p);
+}
+
+/** @This sets the deinterlacing mode. Switching away from
+ * @ref UPIPE_FILTER_BLEND_MODE_YADIF outputs the buffered picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode new mode
+ * @return an error code
+ */
+static inline int upipe_filter_blend_set_mode(struct upipe *upipe, int mode)
+{
+    return upipe_control(upipe, UPIPE_FILTER_BLEND_SET_MODE,
+                         UPIPE_FILTER_BLEND_SIGNATURE, mode);
+}
+
 /** @This returns the management structure for all avformat sources.
  *
  * @return pointer to manager
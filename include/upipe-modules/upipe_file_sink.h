@@ -40,6 +40,8 @@ extern "C" {
 
 #define UPIPE_FSINK_SIGNATURE UBASE_FOURCC('f','s','n','k')
 #define UPIPE_FSINK_EXPECTED_FLOW_DEF "block."
+/** alignment of the addresses, sizes and file offsets of direct I/O */
+#define UPIPE_FSINK_DIRECT_ALIGN 4096
 
 /** @This defines file opening modes. */
 enum upipe_fsink_mode {
@@ -69,6 +71,10 @@ enum upipe_fsink_command {
     UPIPE_FSINK_SET_SYNC_PERIOD,
     /** gets fdatasync period (uint64_t *) */
     UPIPE_FSINK_GET_SYNC_PERIOD,
+    /** sets the size of the direct I/O buffer, or 0 (unsigned int) */
+    UPIPE_FSINK_SET_DIRECT_SIZE,
+    /** gets the size of the direct I/O buffer (unsigned int *) */
+    UPIPE_FSINK_GET_DIRECT_SIZE,
 
     /** outer pipes commands begin here */
     UPIPE_FSINK_CONTROL_LOCAL = UPIPE_CONTROL_LOCAL + 0x1000
@@ -162,6 +168,45 @@ static inline int upipe_fsink_set_sync_period(struct upipe *upipe,
                          UPIPE_FSINK_SIGNATURE, sync_period);
 }
 
+/** @This sets the size of the buffer used for direct I/O. When it is not 0,
+ * the files opened afterwards bypass the page cache (O_DIRECT): incoming
+ * blocks are gathered in an aligned buffer of this size, except when they
+ * are themselves aligned on @ref UPIPE_FSINK_DIRECT_ALIGN octets and the
+ * buffer is empty, in which case they are written without copy. The last
+ * partial block is padded, written, and the file is truncated to its actual
+ * size when it is closed. Direct I/O is not used if the file system does
+ * not support it, or if the writing position is not aligned (for instance
+ * when appending to a file).
+ *
+ * If the event loop submits I/O operations (@ref upump_alloc_io_write),
+ * full buffers are written by the event loop, and blocks are always copied.
+ * The sink holds its input until the pending write completes.
+ *
+ * @param upipe description structure of the pipe
+ * @param direct_size size of the buffer in octets, rounded up to a multiple
+ * of @ref UPIPE_FSINK_DIRECT_ALIGN, or 0 to use the page cache
+ * @return an error code
+ */
+static inline int upipe_fsink_set_direct_size(struct upipe *upipe,
+                                              unsigned int direct_size)
+{
+    return upipe_control(upipe, UPIPE_FSINK_SET_DIRECT_SIZE,
+                         UPIPE_FSINK_SIGNATURE, direct_size);
+}
+
+/** @This returns the size of the buffer used for direct I/O.
+ *
+ * @param upipe description structure of the pipe
+ * @param direct_size_p filled in with the size of the buffer in octets
+ * @return an error code
+ */
+static inline int upipe_fsink_get_direct_size(struct upipe *upipe,
+                                              unsigned int *direct_size_p)
+{
+    return upipe_control(upipe, UPIPE_FSINK_GET_DIRECT_SIZE,
+                         UPIPE_FSINK_SIGNATURE, direct_size_p);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,12 +38,57 @@ extern "C" {
 
 #define UPIPE_FSRC_SIGNATURE UBASE_FOURCC('f','s','r','c')
 
+/** @This extends upipe_command with specific commands for file source. */
+enum upipe_fsrc_command {
+    UPIPE_FSRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the size of the regions mapped from regular files, or 0 to
+     * read them (unsigned int) */
+    UPIPE_FSRC_SET_MMAP_SIZE,
+    /** returns the size of the regions mapped from regular files
+     * (unsigned int *) */
+    UPIPE_FSRC_GET_MMAP_SIZE
+};
+
 /** @This returns the management structure for all file sources.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_fsrc_mgr_alloc(void);
 
+/** @This sets the size of the regions mapped from regular files. When it is
+ * not 0, regions of this size are mapped in memory and read ahead, and the
+ * output buffers point directly into them instead of being copied by read().
+ * The region is only unmapped when all buffers pointing into it are
+ * released. It should be a large multiple of the output size, for instance
+ * a few megabytes, to amortize the cost of mapping; if the reading position
+ * and the output size are multiples of the page size, so are the addresses
+ * of the output buffers.
+ *
+ * @param upipe description structure of the pipe
+ * @param mmap_size size of the mapped regions in octets, or 0 to use read()
+ * @return an error code
+ */
+static inline int upipe_fsrc_set_mmap_size(struct upipe *upipe,
+                                           unsigned int mmap_size)
+{
+    return upipe_control(upipe, UPIPE_FSRC_SET_MMAP_SIZE, UPIPE_FSRC_SIGNATURE,
+                         mmap_size);
+}
+
+/** @This returns the size of the regions mapped from regular files.
+ *
+ * @param upipe description structure of the pipe
+ * @param mmap_size_p filled in with the size of the mapped regions in octets
+ * @return an error code
+ */
+static inline int upipe_fsrc_get_mmap_size(struct upipe *upipe,
+                                           unsigned int *mmap_size_p)
+{
+    return upipe_control(upipe, UPIPE_FSRC_GET_MMAP_SIZE, UPIPE_FSRC_SIGNATURE,
+                         mmap_size_p);
+}
+
 #ifdef __cplusplus
 }
 #endif
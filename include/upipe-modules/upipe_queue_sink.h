@@ -42,6 +42,9 @@
  * in a different thread. That way the upipe_xfer is released on termination,
  * and releases in turn the qsrc in the appropriate upump_mgr (thread)
  * context.
+ *
+ * If the qsrc was allocated with @ref upipe_qsrc_fanin_alloc, each qsink
+ * claims a lane of the qsrc, and the allocation fails if no lane is left.
  */
 
 #ifndef _UPIPE_MODULES_UPIPE_QUEUE_SINK_H_
@@ -55,12 +58,63 @@ extern "C" {
 
 #define UPIPE_QSINK_SIGNATURE UBASE_FOURCC('q','s','n','k')
 
+/** @This extends upipe_command with specific commands for queue sink. */
+enum upipe_qsink_command {
+    UPIPE_QSINK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the wake-up coalescing parameters (unsigned int *,
+     * uint64_t *) */
+    UPIPE_QSINK_GET_COALESCE,
+    /** sets the wake-up coalescing parameters (unsigned int, uint64_t) */
+    UPIPE_QSINK_SET_COALESCE
+};
+
 /** @This returns the management structure for all queue sinks.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_qsink_mgr_alloc(void);
 
+/** @This returns the wake-up coalescing parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param threshold_p filled in with the number of queued urefs waking up the
+ * queue source
+ * @param timeout_p filled in with the maximum time a uref may stay pending
+ * (in 27 MHz ticks)
+ * @return an error code
+ */
+static inline int upipe_qsink_get_coalesce(struct upipe *upipe,
+                                           unsigned int *threshold_p,
+                                           uint64_t *timeout_p)
+{
+    return upipe_control(upipe, UPIPE_QSINK_GET_COALESCE,
+                         UPIPE_QSINK_SIGNATURE, threshold_p, timeout_p);
+}
+
+/** @This sets the wake-up coalescing parameters. By default (threshold 1)
+ * the queue source is woken up as soon as the queue stops being empty.
+ * With a higher threshold, it is only woken up when the given number of
+ * urefs is queued, or when the timeout expires after the first pending uref,
+ * which saves cross-thread wake-ups at the expense of latency.
+ *
+ * Coalescing is not available if the queue source was allocated in fan-in
+ * mode, since it is then only woken up when it has drained all lanes.
+ *
+ * @param upipe description structure of the pipe
+ * @param threshold number of queued urefs waking up the queue source
+ * @param timeout maximum time a uref may stay pending (in 27 MHz ticks,
+ * mandatory if threshold is greater than 1)
+ * @return an error code
+ */
+static inline int upipe_qsink_set_coalesce(struct upipe *upipe,
+                                           unsigned int threshold,
+                                           uint64_t timeout)
+{
+    return upipe_control(upipe, UPIPE_QSINK_SET_COALESCE,
+                         UPIPE_QSINK_SIGNATURE, threshold, timeout);
+}
+
 /** @hidden */
 #define ARGS_DECL , struct upipe *qsrc
 /** @hidden */
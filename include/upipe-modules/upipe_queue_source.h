@@ -28,9 +28,21 @@
  *
  * Note that the allocator requires an additional parameter:
  * @table 2
- * @item queue_length @item maximum length of the queue (<= 255)
+ * @item queue_length @item maximum length of the queue
  * @end table
  *
+ * In fan-in mode, where several queue sinks running in different threads
+ * feed the same queue source, the allocator requires another parameter:
+ * @table 2
+ * @item queue_length @item maximum length of the queue of each sink
+ * @item nb_lanes @item maximum number of sinks
+ * @end table
+ *
+ * Each sink then pushes to its own lane, so that sinks do not contend with
+ * each other, and the queue source pops the lanes in a round-robin fashion.
+ * Source end is thrown when the last sink is released, so all sinks should
+ * be allocated before the first one is released.
+ *
  * Also note that this module is exceptional in that upipe_release() may be
  * called from another thread. The release function is thread-safe.
  */
@@ -49,15 +61,23 @@ extern "C" {
 #include <assert.h>
 
 #define UPIPE_QSRC_SIGNATURE UBASE_FOURCC('q','s','r','c')
+#define UPIPE_QSRC_FANIN_SIGNATURE UBASE_FOURCC('q','s','r','f')
 
 /** @This extends upipe_command with specific commands for queue source. */
 enum upipe_qsrc_command {
     UPIPE_QSRC_SENTINEL = UPIPE_CONTROL_LOCAL,
 
-    /** returns the maximum length of the queue (unsigned int *) */
+    /** returns the maximum length of the queue, or of each lane in fan-in
+     * mode (unsigned int *) */
     UPIPE_QSRC_GET_MAX_LENGTH,
     /** returns the current length of the queue (unsigned int *) */
-    UPIPE_QSRC_GET_LENGTH
+    UPIPE_QSRC_GET_LENGTH,
+    /** returns the maximum number of elements output per wake-up
+     * (unsigned int *) */
+    UPIPE_QSRC_GET_BATCH,
+    /** sets the maximum number of elements output per wake-up
+     * (unsigned int) */
+    UPIPE_QSRC_SET_BATCH
 };
 
 /** @This returns the management structure for all queue sources.
@@ -66,7 +86,8 @@ enum upipe_qsrc_command {
  */
 struct upipe_mgr *upipe_qsrc_mgr_alloc(void);
 
-/** @This returns the maximum length of the queue.
+/** @This returns the maximum length of the queue, or of each lane in
+ * fan-in mode.
  *
  * @param upipe description structure of the pipe
  * @param length_p filled in with the maximum length of the queue
@@ -95,6 +116,37 @@ static inline int upipe_qsrc_get_length(struct upipe *upipe,
                          UPIPE_QSRC_SIGNATURE, length_p);
 }
 
+/** @This returns the maximum number of elements dequeued and output each
+ * time the queue source is woken up.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_p filled in with the maximum number of elements per wake-up
+ * @return an error code
+ */
+static inline int upipe_qsrc_get_batch(struct upipe *upipe,
+                                       unsigned int *batch_p)
+{
+    return upipe_control(upipe, UPIPE_QSRC_GET_BATCH,
+                         UPIPE_QSRC_SIGNATURE, batch_p);
+}
+
+/** @This sets the maximum number of elements dequeued and output each time
+ * the queue source is woken up (default 1). Draining several elements per
+ * wake-up amortizes the cost of the event loop iteration when the producer
+ * is fast. Unlike other control commands, this may be called before the pipe
+ * is transferred to the thread running it.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of elements per wake-up
+ * @return an error code
+ */
+static inline int upipe_qsrc_set_batch(struct upipe *upipe,
+                                       unsigned int batch)
+{
+    return upipe_control(upipe, UPIPE_QSRC_SET_BATCH,
+                         UPIPE_QSRC_SIGNATURE, batch);
+}
+
 /** @hidden */
 #define ARGS_DECL , unsigned int queue_length
 /** @hidden */
@@ -103,6 +155,14 @@ UPIPE_HELPER_ALLOC(qsrc, UPIPE_QSRC_SIGNATURE)
 #undef ARGS
 #undef ARGS_DECL
 
+/** @hidden */
+#define ARGS_DECL , unsigned int queue_length, unsigned int nb_lanes
+/** @hidden */
+#define ARGS , queue_length, nb_lanes
+UPIPE_HELPER_ALLOC(qsrc_fanin, UPIPE_QSRC_FANIN_SIGNATURE)
+#undef ARGS
+#undef ARGS_DECL
+
 #ifdef __cplusplus
 }
 #endif
@@ -94,7 +94,7 @@ enum upipe_xfer_mgr_command {
  * @param mutex mutual exclusion primitives to access the event loop, or NULL
  * @return pointer to manager
  */
-struct upipe_mgr *upipe_xfer_mgr_alloc(uint8_t queue_length,
+struct upipe_mgr *upipe_xfer_mgr_alloc(unsigned int queue_length,
                                        uint16_t msg_pool_depth,
                                        struct umutex *mutex);
 
@@ -51,6 +51,18 @@ enum upipe_udpsink_command {
     UPIPE_UDPSINK_SET_FD,
     /** set remote address (const struct sockaddr *, socklen_t) **/
     UPIPE_UDPSINK_SET_PEER,
+    /** get batching parameters (unsigned int *, uint64_t *) **/
+    UPIPE_UDPSINK_GET_BATCH,
+    /** set batching parameters (unsigned int, uint64_t) **/
+    UPIPE_UDPSINK_SET_BATCH,
+    /** get UDP segmentation offload (int *) **/
+    UPIPE_UDPSINK_GET_GSO,
+    /** set UDP segmentation offload (int) **/
+    UPIPE_UDPSINK_SET_GSO,
+    /** get kernel-paced transmission parameters (int *, uint64_t *) **/
+    UPIPE_UDPSINK_GET_TXTIME,
+    /** set kernel-paced transmission parameters (int, uint64_t) **/
+    UPIPE_UDPSINK_SET_TXTIME,
 };
 
 /** @This returns the management structure for all udp sinks.
@@ -96,6 +108,101 @@ static inline int upipe_udpsink_set_peer(struct upipe *upipe,
     return upipe_control(upipe, UPIPE_UDPSINK_SET_PEER, UPIPE_UDPSINK_SIGNATURE,
             addr, addrlen);
 }
+
+/** @This returns the batching parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_p filled in with the max number of datagrams per system call
+ * @param window_p filled in with the batching window (in 27 MHz units)
+ * @return an error code
+ */
+static inline int upipe_udpsink_get_batch(struct upipe *upipe,
+                                          unsigned int *batch_p,
+                                          uint64_t *window_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_GET_BATCH,
+                         UPIPE_UDPSINK_SIGNATURE, batch_p, window_p);
+}
+
+/** @This sets the batching parameters. When batch is greater than 1,
+ * consecutive buffers received in the same pump callback, or due within the
+ * given window, are sent with a single sendmmsg() call.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch max number of datagrams per system call (1 disables batching)
+ * @param window buffers due within this delay are sent in the same batch
+ * (in 27 MHz units)
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_batch(struct upipe *upipe,
+                                          unsigned int batch, uint64_t window)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_BATCH,
+                         UPIPE_UDPSINK_SIGNATURE, batch, window);
+}
+
+/** @This returns whether UDP segmentation offload is enabled.
+ *
+ * @param upipe description structure of the pipe
+ * @param gso_p filled in with true if segmentation offload is enabled
+ * @return an error code
+ */
+static inline int upipe_udpsink_get_gso(struct upipe *upipe, int *gso_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_GET_GSO,
+                         UPIPE_UDPSINK_SIGNATURE, gso_p);
+}
+
+/** @This enables UDP segmentation offload (UDP_SEGMENT) in batch mode:
+ * consecutive datagrams of the same size (typically 7 TS packets) are
+ * handed to the kernel as a single message.
+ *
+ * @param upipe description structure of the pipe
+ * @param gso true to enable segmentation offload
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_gso(struct upipe *upipe, int gso)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_GSO,
+                         UPIPE_UDPSINK_SIGNATURE, gso);
+}
+
+/** @This returns the kernel-paced transmission parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param clockid_p filled in with the clock of the kernel scheduler, or -1
+ * if kernel pacing is not active
+ * @param horizon_p filled in with the pacing horizon (in 27 MHz units)
+ * @return an error code
+ */
+static inline int upipe_udpsink_get_txtime(struct upipe *upipe,
+                                           int *clockid_p,
+                                           uint64_t *horizon_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_GET_TXTIME,
+                         UPIPE_UDPSINK_SIGNATURE, clockid_p, horizon_p);
+}
+
+/** @This enables kernel-paced transmission (SO_TXTIME). In live mode,
+ * packets due within the horizon are sent immediately with their
+ * transmit time, and released by the kernel (etf or fq qdisc) instead of
+ * waiting on a timer. If the socket option is refused, the pipe keeps
+ * using timers.
+ *
+ * @param upipe description structure of the pipe
+ * @param clockid clock of the kernel scheduler (CLOCK_TAI for etf,
+ * CLOCK_MONOTONIC for fq), or -1 to disable
+ * @param horizon packets due within this delay are handed to the kernel
+ * (in 27 MHz units, at most one minute)
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_txtime(struct upipe *upipe, int clockid,
+                                           uint64_t horizon)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_TXTIME,
+                         UPIPE_UDPSINK_SIGNATURE, clockid, horizon);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -47,6 +47,14 @@ enum upipe_udpsrc_command {
     UPIPE_UDPSRC_GET_FD,
     /** set socket fd (int) **/
     UPIPE_UDPSRC_SET_FD,
+    /** get max number of datagrams read per wake-up (unsigned int *) **/
+    UPIPE_UDPSRC_GET_BATCH,
+    /** set max number of datagrams read per wake-up (unsigned int) **/
+    UPIPE_UDPSRC_SET_BATCH,
+    /** get kernel receive timestamps state (int *) **/
+    UPIPE_UDPSRC_GET_TIMESTAMPS,
+    /** set kernel receive timestamps (int) **/
+    UPIPE_UDPSRC_SET_TIMESTAMPS,
 };
 
 /** @This extends uprobe_throw with specific events . */
@@ -81,6 +89,65 @@ static inline int upipe_udpsrc_set_fd(struct upipe *upipe, int fd)
                          fd);
 }
 
+/** @This returns the maximum number of datagrams read per wake-up.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_p filled in with the batch depth
+ * @return an error code
+ */
+static inline int upipe_udpsrc_get_batch(struct upipe *upipe,
+                                         unsigned int *batch_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_GET_BATCH, UPIPE_UDPSRC_SIGNATURE,
+                         batch_p);
+}
+
+/** @This sets the maximum number of datagrams read per wake-up. When it is
+ * greater than 1, the socket is drained with a single recvmmsg() call into a
+ * preallocated vector of buffers, and all received datagrams are output
+ * from the same pump callback.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of datagrams (1 disables batching)
+ * @return an error code
+ */
+static inline int upipe_udpsrc_set_batch(struct upipe *upipe,
+                                         unsigned int batch)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_SET_BATCH, UPIPE_UDPSRC_SIGNATURE,
+                         batch);
+}
+
+/** @This returns whether kernel receive timestamps are in use.
+ *
+ * @param upipe description structure of the pipe
+ * @param timestamps_p filled in with true if kernel timestamps are enabled
+ * on the socket
+ * @return an error code
+ */
+static inline int upipe_udpsrc_get_timestamps(struct upipe *upipe,
+                                              int *timestamps_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_GET_TIMESTAMPS,
+                         UPIPE_UDPSRC_SIGNATURE, timestamps_p);
+}
+
+/** @This enables kernel receive timestamps (SO_TIMESTAMPNS). In live mode,
+ * cr_sys is then derived from the arrival time of the datagram in the
+ * kernel instead of the time the read watcher was triggered. If the socket
+ * option is refused, the pipe keeps using the current time.
+ *
+ * @param upipe description structure of the pipe
+ * @param timestamps true to enable kernel timestamps
+ * @return an error code
+ */
+static inline int upipe_udpsrc_set_timestamps(struct upipe *upipe,
+                                              int timestamps)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_SET_TIMESTAMPS,
+                         UPIPE_UDPSRC_SIGNATURE, timestamps);
+}
+
 /** @This returns the management structure for all udp socket sources.
  *
  * @return pointer to manager
@@ -82,6 +82,19 @@ enum upipe_work_mgr_command {
     UPIPE_WORK_MGR_GET_SET_MGR(qsink, QSINK)
     UPIPE_WORK_MGR_GET_SET_MGR(xfer, XFER)
 #undef UPIPE_WORK_MGR_GET_SET_MGR
+
+    /** returns the maximum number of urefs output by queue sources per
+     * wake-up (unsigned int *) */
+    UPIPE_WORK_MGR_GET_BATCH,
+    /** sets the maximum number of urefs output by queue sources per
+     * wake-up (unsigned int) */
+    UPIPE_WORK_MGR_SET_BATCH,
+    /** returns the wake-up coalescing parameters of queue sinks
+     * (unsigned int *, uint64_t *) */
+    UPIPE_WORK_MGR_GET_COALESCE,
+    /** sets the wake-up coalescing parameters of queue sinks
+     * (unsigned int, uint64_t) */
+    UPIPE_WORK_MGR_SET_COALESCE,
 };
 
 /** @hidden */
@@ -119,6 +132,67 @@ UPIPE_WORK_MGR_GET_SET_MGR2(qsink, QSINK)
 UPIPE_WORK_MGR_GET_SET_MGR2(xfer, XFER)
 #undef UPIPE_WORK_MGR_GET_SET_MGR2
 
+/** @This returns the maximum number of urefs output per wake-up by the
+ * queue sources of the pipes allocated afterwards.
+ *
+ * @param mgr pointer to manager
+ * @param batch_p filled in with the maximum number of urefs per wake-up
+ * @return an error code
+ */
+static inline int upipe_work_mgr_get_batch(struct upipe_mgr *mgr,
+                                           unsigned int *batch_p)
+{
+    return upipe_mgr_control(mgr, UPIPE_WORK_MGR_GET_BATCH,
+                             UPIPE_WORK_SIGNATURE, batch_p);
+}
+
+/** @This sets the maximum number of urefs output per wake-up by the queue
+ * sources of the pipes allocated afterwards (see @ref upipe_qsrc_set_batch).
+ *
+ * @param mgr pointer to manager
+ * @param batch maximum number of urefs per wake-up
+ * @return an error code
+ */
+static inline int upipe_work_mgr_set_batch(struct upipe_mgr *mgr,
+                                           unsigned int batch)
+{
+    return upipe_mgr_control(mgr, UPIPE_WORK_MGR_SET_BATCH,
+                             UPIPE_WORK_SIGNATURE, batch);
+}
+
+/** @This returns the wake-up coalescing parameters of the queue sinks of the
+ * pipes allocated afterwards.
+ *
+ * @param mgr pointer to manager
+ * @param threshold_p filled in with the number of queued urefs waking up the
+ * queue sources
+ * @param timeout_p filled in with the maximum time a uref may stay pending
+ * @return an error code
+ */
+static inline int upipe_work_mgr_get_coalesce(struct upipe_mgr *mgr,
+                                              unsigned int *threshold_p,
+                                              uint64_t *timeout_p)
+{
+    return upipe_mgr_control(mgr, UPIPE_WORK_MGR_GET_COALESCE,
+                             UPIPE_WORK_SIGNATURE, threshold_p, timeout_p);
+}
+
+/** @This sets the wake-up coalescing parameters of the queue sinks of the
+ * pipes allocated afterwards (see @ref upipe_qsink_set_coalesce).
+ *
+ * @param mgr pointer to manager
+ * @param threshold number of queued urefs waking up the queue sources
+ * @param timeout maximum time a uref may stay pending (in 27 MHz ticks)
+ * @return an error code
+ */
+static inline int upipe_work_mgr_set_coalesce(struct upipe_mgr *mgr,
+                                              unsigned int threshold,
+                                              uint64_t timeout)
+{
+    return upipe_mgr_control(mgr, UPIPE_WORK_MGR_SET_COALESCE,
+                             UPIPE_WORK_SIGNATURE, threshold, timeout);
+}
+
 /** @hidden */
 #define ARGS_DECL , struct upipe *upipe_remote, struct uprobe *uprobe_remote, unsigned int input_queue_length, unsigned int output_queue_length
 /** @hidden */
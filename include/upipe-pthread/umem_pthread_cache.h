@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe umem manager caching buffers in thread-local magazines
+ *
+ * This manager sits in front of another umem manager (typically a umem pool
+ * manager). Buffers are sorted in size classes in power of 2's, and each
+ * thread keeps two magazines of buffers per size class, so that most
+ * allocations and releases do not touch any shared cache line. Full
+ * magazines are exchanged between threads through a shared depot, so that
+ * buffers allocated in one thread and released in another are returned in
+ * batches.
+ *
+ * The thread-local magazines are returned to the depot when the thread
+ * exits, or when @ref umem_pthread_cache_mgr_flush is called. Buffers
+ * remaining in the magazines of threads still running when the manager is
+ * freed are leaked.
+ */
+
+#ifndef _UPIPE_PTHREAD_UMEM_PTHREAD_CACHE_H_
+/** @hidden */
+#define _UPIPE_PTHREAD_UMEM_PTHREAD_CACHE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/umem.h>
+
+#include <stdint.h>
+
+/** @This holds the statistics of a umem pthread cache manager. */
+struct umem_pthread_cache_stats {
+    /** allocations served from the thread-local magazines */
+    uint64_t alloc_hits;
+    /** allocations served from a magazine taken from the depot */
+    uint64_t alloc_depot;
+    /** allocations forwarded to the underlying manager */
+    uint64_t alloc_misses;
+    /** releases stored in the thread-local magazines */
+    uint64_t free_hits;
+    /** releases stored after giving a full magazine to the depot */
+    uint64_t free_depot;
+    /** releases forwarded to the underlying manager */
+    uint64_t free_misses;
+};
+
+/** @This allocates a new instance of the umem pthread cache manager.
+ *
+ * @param umem_mgr underlying umem manager
+ * @param class0_size size (in octets) of the smallest size class; it must be
+ * a power of 2
+ * @param nb_classes number of size classes, in power of 2's increments;
+ * larger buffers are directly managed by the underlying manager
+ * @param magazine_size number of buffers per magazine
+ * @param depot_depth maximum number of full magazines kept in the depot per
+ * size class
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pthread_cache_mgr_alloc(struct umem_mgr *umem_mgr,
+                                              size_t class0_size,
+                                              unsigned int nb_classes,
+                                              unsigned int magazine_size,
+                                              unsigned int depot_depth);
+
+/** @This returns the magazines of the calling thread to the depot, and
+ * accounts for its statistics.
+ *
+ * @param mgr pointer to umem manager
+ */
+void umem_pthread_cache_mgr_flush(struct umem_mgr *mgr);
+
+/** @This returns the statistics of the manager. The statistics of a thread
+ * are only accounted for when it exchanges a magazine with the depot, is
+ * flushed or exits.
+ *
+ * @param mgr pointer to umem manager
+ * @param stats filled in with the statistics
+ */
+void umem_pthread_cache_mgr_get_stats(struct umem_mgr *mgr,
+                                      struct umem_pthread_cache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -26,6 +26,12 @@
 /** @file
  * @short Upipe module allowing to transfer other pipes to a new POSIX thread
  * This is particularly helpful for multithreaded applications.
+ *
+ * The new thread may be pinned to a set of CPUs, run with a real-time
+ * scheduling policy, and have its memory allocated on a given NUMA node,
+ * see @ref upipe_pthread_xfer_mgr_alloc_sched. Since buffer pools allocate
+ * their buffers in the thread which first needs them, the pools used by the
+ * pipes transferred to the thread then get their memory from that node.
  */
 
 #ifndef _UPIPE_PTHREAD_UPIPE_PTHREAD_TRANSFER_H_
@@ -40,11 +46,87 @@ extern "C" {
 #include <upipe/upump.h>
 
 #include <stdint.h>
+#include <string.h>
 #include <pthread.h>
 
 /** @hidden */
 struct umutex;
 
+/** @This is the maximum number of CPUs in a CPU set. */
+#define UPIPE_PTHREAD_SCHED_MAX_CPUS 1024
+
+/** @This requests the NUMA node of the CPU the thread runs on. */
+#define UPIPE_PTHREAD_SCHED_NUMA_LOCAL -2
+
+/** @This describes the scheduling of a transfer thread. */
+struct upipe_pthread_sched {
+    /** set of CPUs the thread is pinned to, or empty set to inherit */
+    uint64_t cpus[UPIPE_PTHREAD_SCHED_MAX_CPUS / 64];
+    /** scheduling policy (SCHED_OTHER, SCHED_FIFO, SCHED_RR), or -1 to
+     * inherit */
+    int policy;
+    /** static priority for SCHED_FIFO and SCHED_RR */
+    int priority;
+    /** NUMA node the memory allocated by the thread is bound to,
+     * @ref UPIPE_PTHREAD_SCHED_NUMA_LOCAL, or -1 */
+    int numa_node;
+};
+
+/** @This initializes a scheduling description, so that the thread inherits
+ * the scheduling of its parent.
+ *
+ * @param sched pointer to scheduling description
+ */
+static inline void upipe_pthread_sched_init(struct upipe_pthread_sched *sched)
+{
+    memset(sched->cpus, 0, sizeof(sched->cpus));
+    sched->policy = -1;
+    sched->priority = 0;
+    sched->numa_node = -1;
+}
+
+/** @This adds a CPU to the set of CPUs the thread is pinned to.
+ *
+ * @param sched pointer to scheduling description
+ * @param cpu CPU number
+ * @return an error code
+ */
+static inline int upipe_pthread_sched_add_cpu(struct upipe_pthread_sched *sched,
+                                              unsigned int cpu)
+{
+    if (unlikely(cpu >= UPIPE_PTHREAD_SCHED_MAX_CPUS))
+        return UBASE_ERR_INVALID;
+    sched->cpus[cpu / 64] |= UINT64_C(1) << (cpu % 64);
+    return UBASE_ERR_NONE;
+}
+
+/** @This checks if a CPU belongs to the set of CPUs the thread is pinned
+ * to.
+ *
+ * @param sched pointer to scheduling description
+ * @param cpu CPU number
+ * @return true if the CPU is in the set
+ */
+static inline bool upipe_pthread_sched_has_cpu(
+        const struct upipe_pthread_sched *sched, unsigned int cpu)
+{
+    if (unlikely(cpu >= UPIPE_PTHREAD_SCHED_MAX_CPUS))
+        return false;
+    return !!(sched->cpus[cpu / 64] & (UINT64_C(1) << (cpu % 64)));
+}
+
+/** @This applies a scheduling description to the calling thread. It is
+ * called by the transfer thread at startup, but may also be used by
+ * applications for their own threads.
+ *
+ * @param sched pointer to scheduling description
+ * @param uprobe pointer to probe used to report errors, or NULL
+ * @return an error code, UBASE_ERR_EXTERNAL if one of the settings couldn't
+ * be applied (the others are applied nevertheless)
+ */
+int upipe_pthread_sched_apply(const struct upipe_pthread_sched *sched,
+                              struct uprobe *uprobe);
+
 /** @This returns a management structure for transfer pipes, using a new
  * pthread. You would need one management structure per target thread.
  *
@@ -61,12 +143,38 @@ struct umutex;
  * @param attr pthread attributes
  * @return pointer to xfer manager
  */
-struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(unsigned int queue_length,
         uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
         upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
         uint16_t upump_blocker_pool_depth, struct umutex *mutex,
         pthread_t *pthread_id_p, const pthread_attr_t *restrict attr);
 
+/** @This returns a management structure for transfer pipes, using a new
+ * pthread with the given scheduling. Settings which cannot be applied (for
+ * instance a real-time policy without the required privileges) are reported
+ * as warnings on uprobe_pthread_upump_mgr, and the thread runs anyway.
+ *
+ * @param queue_length maximum length of the internal queue of commands
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
+ * with the created upump_mgr
+ * @param upump_mgr_alloc alloc function provided by the upump manager
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param mutex mutual exclusion pimitives to access the event loop, or NULL
+ * @param pthread_id_p reference to created thread ID (may be NULL)
+ * @param attr pthread attributes
+ * @param sched scheduling of the new thread, or NULL to inherit
+ * @return pointer to xfer manager
+ */
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_sched(unsigned int queue_length,
+        uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
+        upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth, struct umutex *mutex,
+        pthread_t *pthread_id_p, const pthread_attr_t *restrict attr,
+        const struct upipe_pthread_sched *sched);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe pool of POSIX threads running upump managers
+ *
+ * A pool runs a fixed number of worker threads, and hands out lightweight
+ * upump managers, called domains. All pipes attached to a domain form an
+ * independent pipeline: the pumps of a domain are never dispatched by two
+ * workers at the same time, so the pipes keep single-threaded semantics,
+ * but a domain may be dispatched by any worker over time.
+ *
+ * When a pump of a domain triggers, the domain is queued on the run queue
+ * of the worker which last ran it; idle workers steal domains from the run
+ * queues of the other workers, so that independent pipelines are balanced
+ * across the threads.
+ *
+ * Domains support idlers, timers and file descriptors; signals are not
+ * supported and should be watched by the main event loop. A thread other
+ * than the workers may only access the pipes and pumps of a domain while
+ * holding the mutex given at the allocation of the domain, or before any of
+ * its pumps is started.
+ */
+
+#ifndef _UPIPE_PTHREAD_UPUMP_PTHREAD_POOL_H_
+/** @hidden */
+#define _UPIPE_PTHREAD_UPUMP_PTHREAD_POOL_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upump.h>
+
+#include <stdint.h>
+#include <pthread.h>
+
+#define UPUMP_PTHREAD_POOL_SIGNATURE UBASE_FOURCC('p','o','o','l')
+
+/** @hidden */
+struct umutex;
+/** @hidden */
+struct upump_pthread_pool;
+
+/** @This holds the statistics of a pool. */
+struct upump_pthread_pool_stats {
+    /** number of times a domain was run */
+    uint64_t runs;
+    /** number of times a domain was stolen by another worker */
+    uint64_t steals;
+};
+
+/** @This allocates a pool and starts its worker threads.
+ *
+ * @param nb_workers number of worker threads
+ * @param attr pthread attributes of the workers, or NULL
+ * @return pointer to pool, or NULL in case of error
+ */
+struct upump_pthread_pool *upump_pthread_pool_alloc(unsigned int nb_workers,
+        const pthread_attr_t *restrict attr);
+
+/** @This stops the worker threads and frees a pool. All domains must have
+ * been released, and it must not be called from a worker thread.
+ *
+ * @param pool pointer to pool
+ */
+void upump_pthread_pool_free(struct upump_pthread_pool *pool);
+
+/** @This returns the statistics of a pool.
+ *
+ * @param pool pointer to pool
+ * @param stats filled in with the statistics
+ */
+void upump_pthread_pool_get_stats(struct upump_pthread_pool *pool,
+                                  struct upump_pthread_pool_stats *stats);
+
+/** @This allocates a domain of a pool, that is a upump manager whose pumps
+ * are dispatched by the workers of the pool.
+ *
+ * upump_mgr_run() on a domain waits until the domain has no active blocking
+ * pump, and is not being dispatched; its mutex argument is ignored. It must
+ * not be called from a worker thread, nor with the domain mutex held.
+ *
+ * @param pool pointer to pool
+ * @param mutex mutual exclusion primitives held by the workers while they
+ * dispatch the pumps of the domain, or NULL
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @return pointer to the wrapped upump_mgr structure, or NULL in case of error
+ */
+struct upump_mgr *upump_pthread_pool_mgr_alloc(struct upump_pthread_pool *pool,
+        struct umutex *mutex, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -45,7 +45,11 @@ enum upipe_sws_command {
     /** set flags (int) */
     UPIPE_SWS_SET_FLAGS,
     /** get flags (int *) */
-    UPIPE_SWS_GET_FLAGS
+    UPIPE_SWS_GET_FLAGS,
+    /** set the number of slice threads (unsigned int) */
+    UPIPE_SWS_SET_THREADS,
+    /** get the number of slice threads (unsigned int *) */
+    UPIPE_SWS_GET_THREADS
 };
 
 /** @This gets the swscale flags.
@@ -72,6 +76,36 @@ static inline bool upipe_sws_set_flags(struct upipe *upipe, int flags)
                          flags);
 }
 
+/** @This sets the number of slice threads of the swscale contexts. Each
+ * context still scales the whole frame or field, and its threads render
+ * horizontal slices of the output, so that the output is the same as with a
+ * single thread. The default of 1 disables slice threading. Values above 1
+ * require libswscale 6.4.100 or later.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_threads number of slice threads
+ * @return an error code
+ */
+static inline int upipe_sws_set_threads(struct upipe *upipe,
+                                        unsigned int nb_threads)
+{
+    return upipe_control(upipe, UPIPE_SWS_SET_THREADS, UPIPE_SWS_SIGNATURE,
+                         nb_threads);
+}
+
+/** @This gets the number of slice threads.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_threads_p filled in with the number of slice threads
+ * @return an error code
+ */
+static inline int upipe_sws_get_threads(struct upipe *upipe,
+                                        unsigned int *nb_threads_p)
+{
+    return upipe_control(upipe, UPIPE_SWS_GET_THREADS, UPIPE_SWS_SIGNATURE,
+                         nb_threads_p);
+}
+
 /** @This returns the management structure for sws pipes.
  *
  * @return pointer to manager
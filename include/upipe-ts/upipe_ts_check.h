@@ -42,12 +42,52 @@ extern "C" {
 
 #define UPIPE_TS_CHECK_SIGNATURE UBASE_FOURCC('t','s','c','k')
 
+/** @This extends upipe_command with specific commands for ts check. */
+enum upipe_ts_check_command {
+    UPIPE_TS_CHECK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the maximum number of packets per output uref
+     * (unsigned int *) */
+    UPIPE_TS_CHECK_GET_VECTOR,
+    /** sets the maximum number of packets per output uref (unsigned int) */
+    UPIPE_TS_CHECK_SET_VECTOR
+};
+
 /** @This returns the management structure for all ts_check pipes.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_ts_check_mgr_alloc(void);
 
+/** @This returns the maximum number of TS packets per output uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector_p filled in with the number of packets
+ * @return an error code
+ */
+static inline int upipe_ts_check_get_vector(struct upipe *upipe,
+                                            unsigned int *vector_p)
+{
+    return upipe_control(upipe, UPIPE_TS_CHECK_GET_VECTOR,
+                         UPIPE_TS_CHECK_SIGNATURE, vector_p);
+}
+
+/** @This sets the maximum number of TS packets per output uref. With a
+ * value above 1, consecutive valid packets are output as a single uref
+ * and the output flow definition carries the t.vector attribute. The
+ * default value of 1 outputs one packet per uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector number of packets
+ * @return an error code
+ */
+static inline int upipe_ts_check_set_vector(struct upipe *upipe,
+                                            unsigned int vector)
+{
+    return upipe_control(upipe, UPIPE_TS_CHECK_SET_VECTOR,
+                         UPIPE_TS_CHECK_SIGNATURE, vector);
+}
+
 #ifdef __cplusplus
 }
 #endif
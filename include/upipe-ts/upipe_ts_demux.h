@@ -54,6 +54,9 @@ enum upipe_ts_demux_command {
     UPIPE_TS_DEMUX_SET_CONFORMANCE,
     /** sets the BISS-CA private key file (const char *) */
     UPIPE_TS_DEMUX_SET_PRIVATE_KEY,
+    /** sets the maximum number of TS packets per internal uref
+     * (unsigned int) */
+    UPIPE_TS_DEMUX_SET_VECTOR,
 };
 
 /** @This returns the currently detected conformance mode. It cannot return
@@ -98,6 +101,25 @@ static inline int upipe_ts_demux_set_private_key(struct upipe *upipe,
             UPIPE_TS_DEMUX_SIGNATURE, private_key);
 }
 
+/** @This sets the maximum number of TS packets carried by a single uref
+ * between the ts_sync or ts_check inner pipe and the ts_split inner pipe.
+ * Packets of unused PIDs are then dropped without being allocated, and the
+ * packets of each elementary stream and PSI PID are passed to ts_decaps as
+ * a single vector. The PCR PID of a program is still passed one packet at a
+ * time, so that clock references are known before the vectors are flushed.
+ * If the inner pipe already exists, the new value is applied to it at once.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector number of packets (1 to disable)
+ * @return an error code
+ */
+static inline int upipe_ts_demux_set_vector(struct upipe *upipe,
+                                            unsigned int vector)
+{
+    return upipe_control(upipe, UPIPE_TS_DEMUX_SET_VECTOR,
+                         UPIPE_TS_DEMUX_SIGNATURE, vector);
+}
+
 /** @This returns the management structure for all ts_demux pipes.
  *
  * @return pointer to manager
@@ -43,6 +43,9 @@ enum uprobe_ts_mux_event {
 
     /** last continuity counter for an input (unsigned int) */
     UPROBE_TS_MUX_LAST_CC,
+    /** new target octetrate for the encoder feeding an input, in statmux
+     * mode (uint64_t) */
+    UPROBE_TS_MUX_TARGET_OCTETRATE,
 
     /** ts_encaps events begin here */
     UPROBE_TS_MUX_ENCAPS = UPROBE_LOCAL + 0x1000
@@ -53,7 +56,11 @@ enum upipe_ts_mux_mode {
     /** constant octetrate */
     UPIPE_TS_MUX_MODE_CBR,
     /** capped octetrate */
-    UPIPE_TS_MUX_MODE_CAPPED
+    UPIPE_TS_MUX_MODE_CAPPED,
+    /** constant octetrate, with the octetrate left by PSI tables, padding
+     * and the other inputs periodically redistributed between the video
+     * inputs according to their buffer fullness */
+    UPIPE_TS_MUX_MODE_STATMUX
 };
 
 /** @This returns a string describing the mode.
@@ -67,6 +74,7 @@ static inline const char *
     switch (mode) {
         case UPIPE_TS_MUX_MODE_CBR: return "CBR";
         case UPIPE_TS_MUX_MODE_CAPPED: return "Capped VBR";
+        case UPIPE_TS_MUX_MODE_STATMUX: return "Statmux";
         default: return "unknown";
     }
 }
@@ -158,6 +166,10 @@ enum upipe_ts_mux_command {
     /** prepares the next access unit/section for the given date
      * (uint64_t, uint64_t) */
     UPIPE_TS_MUX_PREPARE,
+    /** returns the current statmux interval (uint64_t *) */
+    UPIPE_TS_MUX_GET_STATMUX_INTERVAL,
+    /** sets the statmux interval (uint64_t) */
+    UPIPE_TS_MUX_SET_STATMUX_INTERVAL,
 
     /** ts_encaps commands begin here */
     UPIPE_TS_MUX_ENCAPS = UPIPE_CONTROL_LOCAL + 0x1000,
@@ -712,6 +724,34 @@ static inline int upipe_ts_mux_prepare(struct upipe *upipe, uint64_t cr_sys,
                                UPIPE_TS_MUX_SIGNATURE, cr_sys, latency);
 }
 
+/** @This returns the current interval between two redistributions of the
+ * octetrates in statmux mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param interval_p filled in with the interval
+ * @return an error code
+ */
+static inline int upipe_ts_mux_get_statmux_interval(struct upipe *upipe,
+                                                    uint64_t *interval_p)
+{
+    return upipe_control(upipe, UPIPE_TS_MUX_GET_STATMUX_INTERVAL,
+                         UPIPE_TS_MUX_SIGNATURE, interval_p);
+}
+
+/** @This sets the interval between two redistributions of the octetrates in
+ * statmux mode. It should typically be the duration of a GOP.
+ *
+ * @param upipe description structure of the pipe
+ * @param interval new interval
+ * @return an error code
+ */
+static inline int upipe_ts_mux_set_statmux_interval(struct upipe *upipe,
+                                                    uint64_t interval)
+{
+    return upipe_control(upipe, UPIPE_TS_MUX_SET_STATMUX_INTERVAL,
+                         UPIPE_TS_MUX_SIGNATURE, interval);
+}
+
 /** @This returns a description string for local commands.
  *
  * @param cmd control command
@@ -49,7 +49,12 @@ enum upipe_ts_sync_command {
     /** returns the configured number of packets to synchronize with (int *) */
     UPIPE_TS_SYNC_GET_SYNC,
     /** sets the configured number of packets to synchronize with (int) */
-    UPIPE_TS_SYNC_SET_SYNC
+    UPIPE_TS_SYNC_SET_SYNC,
+    /** returns the maximum number of packets per output uref
+     * (unsigned int *) */
+    UPIPE_TS_SYNC_GET_VECTOR,
+    /** sets the maximum number of packets per output uref (unsigned int) */
+    UPIPE_TS_SYNC_SET_VECTOR
 };
 
 /** @This returns the management structure for all ts_sync pipes.
@@ -84,6 +89,34 @@ static inline int upipe_ts_sync_set_sync(struct upipe *upipe, int sync)
                          sync);
 }
 
+/** @This returns the maximum number of TS packets per output uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector_p filled in with the number of packets
+ * @return an error code
+ */
+static inline int upipe_ts_sync_get_vector(struct upipe *upipe,
+                                           unsigned int *vector_p)
+{
+    return upipe_control(upipe, UPIPE_TS_SYNC_GET_VECTOR,
+                         UPIPE_TS_SYNC_SIGNATURE, vector_p);
+}
+
+/** @This sets the maximum number of TS packets per output uref. With a
+ * value above 1, synchronized packets are output in batches and the output
+ * flow definition carries the t.vector attribute.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector number of packets
+ * @return an error code
+ */
+static inline int upipe_ts_sync_set_vector(struct upipe *upipe,
+                                           unsigned int vector)
+{
+    return upipe_control(upipe, UPIPE_TS_SYNC_SET_VECTOR,
+                         UPIPE_TS_SYNC_SIGNATURE, vector);
+}
+
 #ifdef __cplusplus
 }
 #endif
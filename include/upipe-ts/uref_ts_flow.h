@@ -46,6 +46,7 @@ UREF_ATTR_UNSIGNED(ts_flow, pid, "t.pid", PID)
 UREF_ATTR_UNSIGNED(ts_flow, pcr_pid, "t.pcr_pid", PCR PID)
 UREF_ATTR_UNSIGNED(ts_flow, max_delay, "t.maxdelay", maximum retention time)
 UREF_ATTR_UNSIGNED(ts_flow, tb_rate, "t.tbrate", T-STD TB emptying rate)
+UREF_ATTR_VOID(ts_flow, vector, "t.vector", vector of TS packets per uref)
 UREF_ATTR_OPAQUE(ts_flow, psi_filter_internal, "t.psi.filter", PSI filter)
 UREF_ATTR_UNSIGNED(ts_flow, psi_section_interval, "t.psi.sec",
         interval between PSI sections)
@@ -47,6 +47,7 @@ extern "C" {
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <assert.h>
 
 #ifdef __GNUC__
 
@@ -344,6 +345,34 @@ static inline uint64_t ubase_gcd(uint64_t a, uint64_t b)
     return a;
 }
 
+/** @This returns the base 2 logarithm of a positive integer, rounded down.
+ *
+ * @param x integer (not null)
+ * @return position of the most significant bit set
+ */
+static inline unsigned int ubase_log2(uint64_t x)
+{
+    assert(x != 0);
+#ifdef __GNUC__
+    return 63 - __builtin_clzll(x);
+#else
+    unsigned int log2 = 0;
+    while (x >>= 1)
+        log2++;
+    return log2;
+#endif
+}
+
+/** @This returns the base 2 logarithm of a positive integer, rounded up.
+ *
+ * @param x integer (not null)
+ * @return smallest n such that 2^n >= x
+ */
+static inline unsigned int ubase_log2_ceil(uint64_t x)
+{
+    return x <= 1 ? 0 : ubase_log2(x - 1) + 1;
+}
+
 /** @This defines the rational type. */
 struct urational {
     /** numerator */
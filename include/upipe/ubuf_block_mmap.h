@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe ubuf manager for block formats mapping regions of files
+ *
+ * The buffers are private, copy-on-write mappings of a file: they may be
+ * written to without altering the file. The mapping is shared by all the
+ * ubufs created from it (see @ref ubuf_block_splice), and is unmapped when
+ * the last of them is freed, so that a large window may be mapped once and
+ * sliced into smaller blocks without copying.
+ */
+
+#ifndef _UPIPE_UBUF_BLOCK_MMAP_H_
+/** @hidden */
+#define _UPIPE_UBUF_BLOCK_MMAP_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @This is the signature to use to map a region of a file. */
+#define UBUF_BLOCK_MMAP_ALLOC UBASE_FOURCC('m','m','a','p')
+
+/** @This returns a new ubuf from the block mmap allocator, mapping a region
+ * of a file. The region must lie entirely within the file.
+ *
+ * @param mgr management structure for this ubuf type
+ * @param fd file descriptor, opened for reading
+ * @param offset offset of the region in the file, in octets (no alignment
+ * is required)
+ * @param size size of the region, in octets
+ * @return pointer to ubuf or NULL in case of failure
+ */
+static inline struct ubuf *ubuf_block_mmap_alloc_from_fd(
+        struct ubuf_mgr *mgr, int fd, uint64_t offset, int size)
+{
+    return ubuf_alloc(mgr, UBUF_BLOCK_MMAP_ALLOC, fd, offset, size);
+}
+
+/** @This allocates a new instance of the ubuf manager for block formats
+ * mapping regions of files.
+ *
+ * @param ubuf_pool_depth maximum number of ubuf structures in the pool
+ * @param shared_pool_depth maximum number of shared structures in the pool
+ * @param readahead true if the kernel should be asked to read the mapped
+ * regions ahead (madvise(MADV_WILLNEED))
+ * @return pointer to manager, or NULL in case of error
+ */
+struct ubuf_mgr *ubuf_block_mmap_mgr_alloc(uint16_t ubuf_pool_depth,
+                                           uint16_t shared_pool_depth,
+                                           bool readahead);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
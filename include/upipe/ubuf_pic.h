@@ -353,6 +353,31 @@ static inline int ubuf_pic_resize(struct ubuf *ubuf, int hskip, int vskip,
                         new_hsize, new_vsize);
 }
 
+/** @This blends a picture plane into another, using SIMD kernels when
+ * available.
+ *
+ * @param chroma chroma type of the planes
+ * @param dest pointer to the first line of the destination plane
+ * @param dest_stride stride of the destination plane
+ * @param src pointer to the first line of the source plane
+ * @param src_stride stride of the source plane
+ * @param hsize size of a line, in octets
+ * @param vsize number of lines
+ * @param alpha_plane pointer to alpha plane buffer, if any
+ * @param alpha_stride horizontal stride of the alpha plane buffer
+ * @param hsub horizontal subsampling of the planes
+ * @param vsub vertical subsampling of the planes
+ * @param alpha alpha multiplier
+ * @param threshold alpha blending method (see @ref ubuf_pic_blit_alpha)
+ */
+void ubuf_pic_plane_blend(const char *chroma,
+                          uint8_t *dest, size_t dest_stride,
+                          const uint8_t *src, size_t src_stride,
+                          size_t hsize, size_t vsize,
+                          const uint8_t *alpha_plane, size_t alpha_stride,
+                          uint8_t hsub, uint8_t vsub,
+                          uint8_t alpha, uint8_t threshold);
+
 /** @This blits a picture ubuf to another ubuf.
  *
  * @param dest destination ubuf
@@ -370,7 +395,7 @@ static inline int ubuf_pic_resize(struct ubuf *ubuf, int hskip, int vskip,
  * @param alpha alpha multiplier
  * @param threshold alpha blending method
  *    0 means ignore alpha
- *    255 means blends src and dest together using alpha levels (slow)
+ *    255 means blends src and dest together using alpha levels
  *    Any value in between means using the src pixels if and only if
  *      their alpha value is more than this value
  * @return an error code
@@ -428,45 +453,10 @@ static inline int ubuf_pic_blit_alpha(struct ubuf *dest, struct ubuf *src,
                           src_macropixel_size;
         int plane_vsize = extract_vsize / src_vsub;
 
-        for (int i = 0; i < plane_vsize; i++) {
-            if ((!alpha_plane && alpha == 0xff) || threshold == 0) {
-                memcpy(dest_buffer, src_buffer, plane_hsize);
-            } else if (!alpha_plane) {
-                for (int j = 0; j < plane_hsize; j++) {
-                    dest_buffer[j] = (dest_buffer[j] * (0xff - alpha) + src_buffer[j] * alpha) / 0xff;
-                }
-            } else if (threshold != 0xff) {
-                /* This is an on/off blending
-                 * if alpha is over the threshold, we use the subpicture pixel.
-                 */
-                if (alpha == 0xff) {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub];
-                        if (a > threshold) dest_buffer[j] = src_buffer[j];
-                    }
-                } else {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = (uint16_t)alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub] * (uint16_t)alpha / 0xff;
-                        if (a > threshold) dest_buffer[j] = src_buffer[j];
-                    }
-                }
-            } else {
-                /* smooth and slow blending */
-                if (alpha == 0xff) {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub];
-                        dest_buffer[j] = (dest_buffer[j] * (0xff - a) + src_buffer[j] * a) / 0xff;
-                    }
-                } else {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = (uint16_t)alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub] * (uint16_t)alpha / 0xff;
-                        dest_buffer[j] = (dest_buffer[j] * (0xff - a) + src_buffer[j] * a) / 0xff;
-                    }
-                }
-            }
-            dest_buffer += dest_stride;
-            src_buffer += src_stride;
-        }
+        ubuf_pic_plane_blend(chroma, dest_buffer, dest_stride,
+                             src_buffer, src_stride, plane_hsize, plane_vsize,
+                             alpha_plane, alpha_stride, src_hsub, src_vsub,
+                             alpha, threshold);
 
         err = ubuf_pic_plane_unmap(dest, chroma,
                                    dest_hoffset, dest_voffset,
@@ -25,6 +25,13 @@
 
 /** @file
  * @short Upipe thread-safe first-in first-out data structure
+ *
+ * The FIFO is a bounded ring of cells, each tagged with a sequence number
+ * that tells producers and consumers whether the cell is free or carries an
+ * element. The number of cells is rounded up to a power of two, while the
+ * number of elements is still bounded by the requested length. The head and
+ * tail positions sit on separate cache lines so that producers and
+ * consumers running on different CPUs do not bounce them.
  */
 
 #ifndef _UPIPE_UFIFO_H_
@@ -35,37 +42,109 @@ extern "C" {
 #endif
 
 #include <upipe/ubase.h>
-#include <upipe/uring.h>
+#include <upipe/uatomic.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/** @This is the maximum number of elements in a ufifo. */
+#define UFIFO_MAX_LENGTH (UINT32_C(1) << 31)
+
+/** @hidden */
+#define UFIFO_CACHELINE_SIZE 64
+
+/** @internal @This defines a cell of the ring. */
+struct ufifo_cell {
+    /** sequence number of the cell */
+    uatomic_uint32_t seq;
+    /** pointer to opaque structure */
+    void *opaque;
+};
 
 /** @This is the implementation of first-in first-out data structure. */
 struct ufifo {
-    /** ring structure */
-    struct uring uring;
-    /** uring FIFO of elements carrying a uchain */
-    uring_fifo fifo_carrier;
-    /** uring LIFO of elements not carrying a uchain */
-    uring_lifo lifo_empty;
+    /** maximum number of elements */
+    uint32_t length;
+    /** number of cells in the ring, minus one */
+    uint32_t mask;
+    /** array of cells */
+    struct ufifo_cell *cells;
+
+    /** @hidden */
+    uint8_t pad_tail[UFIFO_CACHELINE_SIZE];
+    /** position of the next element to push */
+    uatomic_uint32_t tail;
+    /** @hidden */
+    uint8_t pad_head[UFIFO_CACHELINE_SIZE];
+    /** position of the next element to pop */
+    uatomic_uint32_t head;
+    /** @hidden */
+    uint8_t pad_end[UFIFO_CACHELINE_SIZE];
 };
 
+/** @hidden */
+#define UFIFO_MASK_1(v) ((v) | ((v) >> 1))
+/** @hidden */
+#define UFIFO_MASK_2(v) (UFIFO_MASK_1(v) | (UFIFO_MASK_1(v) >> 2))
+/** @hidden */
+#define UFIFO_MASK_4(v) (UFIFO_MASK_2(v) | (UFIFO_MASK_2(v) >> 4))
+/** @hidden */
+#define UFIFO_MASK_8(v) (UFIFO_MASK_4(v) | (UFIFO_MASK_4(v) >> 8))
+/** @hidden */
+#define UFIFO_MASK_16(v) (UFIFO_MASK_8(v) | (UFIFO_MASK_8(v) >> 16))
+
+/** @This returns the number of cells actually allocated for a given
+ * maximum number of elements, that is the next power of two (and at least
+ * two, so that a full cell can be told apart from a free one). It is a
+ * constant expression if length is constant.
+ *
+ * @param length maximum number of elements in the FIFO
+ * @return number of cells
+ */
+#define ufifo_capacity(length)                                              \
+    ((uint32_t)(length) <= 2 ? UINT32_C(2) :                                \
+     UFIFO_MASK_16((uint32_t)(length) - 1) + 1)
+
 /** @This returns the required size of extra data space for ufifo.
  *
  * @param length maximum number of elements in the FIFO
  * @return size in octets to allocate
  */
-#define ufifo_sizeof(length) uring_sizeof(length)
+#define ufifo_sizeof(length)                                                \
+    (ufifo_capacity(length) * sizeof(struct ufifo_cell))
 
 /** @This initializes a ufifo.
  *
  * @param ufifo pointer to a ufifo structure
- * @param length maximum number of elements in the FIFO (max 255)
+ * @param length maximum number of elements in the FIFO (at most
+ * UFIFO_MAX_LENGTH)
  * @param extra mandatory extra space allocated by the caller, with the size
  * returned by @ref #ufifo_sizeof
  */
-static inline void ufifo_init(struct ufifo *ufifo, uint8_t length, void *extra)
+static inline void ufifo_init(struct ufifo *ufifo, uint32_t length,
+                              void *extra)
 {
-    uring_lifo_init(&ufifo->uring, &ufifo->lifo_empty,
-                    uring_init(&ufifo->uring, length, extra));
-    uring_fifo_init(&ufifo->uring, &ufifo->fifo_carrier);
+    assert(length && length <= UFIFO_MAX_LENGTH);
+    ufifo->length = length;
+    ufifo->mask = ufifo_capacity(length) - 1;
+    ufifo->cells = (struct ufifo_cell *)extra;
+    for (uint32_t i = 0; i <= ufifo->mask; i++) {
+        ufifo->cells[i].opaque = NULL;
+        uatomic_init(&ufifo->cells[i].seq, i);
+    }
+    uatomic_init(&ufifo->tail, 0);
+    uatomic_init(&ufifo->head, 0);
+}
+
+/** @This returns the maximum number of elements in the FIFO.
+ *
+ * @param ufifo pointer to a ufifo structure
+ * @return maximum number of elements
+ */
+static inline uint32_t ufifo_length(struct ufifo *ufifo)
+{
+    return ufifo->length;
 }
 
 /** @This pushes a new element.
@@ -78,12 +157,32 @@ static inline void ufifo_init(struct ufifo *ufifo, uint8_t length, void *extra)
 static inline bool ufifo_push(struct ufifo *ufifo, void *opaque)
 {
     assert(opaque != NULL);
-    uring_index index = uring_lifo_pop(&ufifo->uring, &ufifo->lifo_empty);
-    if (index == URING_INDEX_NULL)
-        return false;
-    uring_elem_set(&ufifo->uring, index, opaque);
-    uring_fifo_push(&ufifo->uring, &ufifo->fifo_carrier, index);
-    return true;
+    uint32_t pos = uatomic_load(&ufifo->tail);
+    for ( ; ; ) {
+        struct ufifo_cell *cell = &ufifo->cells[pos & ufifo->mask];
+        int32_t diff = (int32_t)(uatomic_load(&cell->seq) - pos);
+        if (likely(diff == 0)) {
+            uint32_t head = uatomic_load(&ufifo->head);
+            if (unlikely((int32_t)(pos - head) < 0)) {
+                /* other threads went past our position */
+                pos = uatomic_load(&ufifo->tail);
+                continue;
+            }
+            if (unlikely(pos - head >= ufifo->length))
+                return false;
+            if (likely(uatomic_compare_exchange(&ufifo->tail, &pos,
+                                                pos + 1))) {
+                cell->opaque = opaque;
+                uatomic_store(&cell->seq, pos + 1);
+                return true;
+            }
+            /* pos was reloaded by the failed exchange */
+        } else if (diff < 0) {
+            /* the cell still carries an element from the previous lap */
+            return false;
+        } else
+            pos = uatomic_load(&ufifo->tail);
+    }
 }
 
 /** @internal @This pops an element.
@@ -93,14 +192,25 @@ static inline bool ufifo_push(struct ufifo *ufifo, void *opaque)
  */
 static inline void *ufifo_pop_internal(struct ufifo *ufifo)
 {
-    void *opaque;
-    uring_index index = uring_fifo_pop(&ufifo->uring, &ufifo->fifo_carrier);
-    if (index == URING_INDEX_NULL)
-        return NULL;
-    opaque = uring_elem_get(&ufifo->uring, index);
-    uring_elem_set(&ufifo->uring, index, NULL);
-    uring_lifo_push(&ufifo->uring, &ufifo->lifo_empty, index);
-    return opaque;
+    uint32_t pos = uatomic_load(&ufifo->head);
+    for ( ; ; ) {
+        struct ufifo_cell *cell = &ufifo->cells[pos & ufifo->mask];
+        int32_t diff = (int32_t)(uatomic_load(&cell->seq) - (pos + 1));
+        if (likely(diff == 0)) {
+            if (likely(uatomic_compare_exchange(&ufifo->head, &pos,
+                                                pos + 1))) {
+                void *opaque = cell->opaque;
+                cell->opaque = NULL;
+                uatomic_store(&cell->seq, pos + ufifo->mask + 1);
+                return opaque;
+            }
+            /* pos was reloaded by the failed exchange */
+        } else if (diff < 0) {
+            /* the cell has not been pushed yet */
+            return NULL;
+        } else
+            pos = uatomic_load(&ufifo->head);
+    }
 }
 
 /** @This pops an element with type checking.
@@ -118,8 +228,10 @@ static inline void *ufifo_pop_internal(struct ufifo *ufifo)
  */
 static inline void ufifo_clean(struct ufifo *ufifo)
 {
-    uring_lifo_clean(&ufifo->uring, &ufifo->lifo_empty);
-    uring_fifo_clean(&ufifo->uring, &ufifo->fifo_carrier);
+    for (uint32_t i = 0; i <= ufifo->mask; i++)
+        uatomic_clean(&ufifo->cells[i].seq);
+    uatomic_clean(&ufifo->tail);
+    uatomic_clean(&ufifo->head);
 }
 
 #ifdef __cplusplus
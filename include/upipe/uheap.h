@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe implementation of intrusive binary min-heaps (NOT thread-safe)
+ *
+ * Structures are inserted in the heap by embedding a @ref uheap_node, and
+ * may be re-keyed or removed in O(log n) as the node keeps its position in
+ * the heap.
+ */
+
+#ifndef _UPIPE_UHEAP_H_
+/** @hidden */
+#define _UPIPE_UHEAP_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @This is the index of a node which is not in a heap. */
+#define UHEAP_NONE SIZE_MAX
+
+/** @This is the structure to embed in elements of a heap. */
+struct uheap_node {
+    /** key, smaller keys are closer to the top */
+    uint64_t key;
+    /** position in the heap, or UHEAP_NONE */
+    size_t index;
+};
+
+/** @This is the structure of a heap. */
+struct uheap {
+    /** array of nodes */
+    struct uheap_node **nodes;
+    /** number of nodes in the heap */
+    size_t size;
+    /** number of allocated nodes */
+    size_t alloc;
+};
+
+/** @This initializes a heap.
+ *
+ * @param uheap pointer to a heap
+ */
+static inline void uheap_init(struct uheap *uheap)
+{
+    uheap->nodes = NULL;
+    uheap->size = uheap->alloc = 0;
+}
+
+/** @This cleans up a heap. The nodes are not released.
+ *
+ * @param uheap pointer to a heap
+ */
+static inline void uheap_clean(struct uheap *uheap)
+{
+    for (size_t i = 0; i < uheap->size; i++)
+        uheap->nodes[i]->index = UHEAP_NONE;
+    free(uheap->nodes);
+    uheap_init(uheap);
+}
+
+/** @This initializes a heap node.
+ *
+ * @param node pointer to a heap node
+ */
+static inline void uheap_node_init(struct uheap_node *node)
+{
+    node->key = UINT64_MAX;
+    node->index = UHEAP_NONE;
+}
+
+/** @This checks if a node is in a heap.
+ *
+ * @param node pointer to a heap node
+ * @return true if the node is in a heap
+ */
+static inline bool uheap_node_is_in(const struct uheap_node *node)
+{
+    return node->index != UHEAP_NONE;
+}
+
+/** @This returns the node with the smallest key.
+ *
+ * @param uheap pointer to a heap
+ * @return pointer to the top node, or NULL if the heap is empty
+ */
+static inline struct uheap_node *uheap_peek(const struct uheap *uheap)
+{
+    return uheap->size ? uheap->nodes[0] : NULL;
+}
+
+/** @This returns the number of nodes in a heap.
+ *
+ * @param uheap pointer to a heap
+ * @return number of nodes
+ */
+static inline size_t uheap_size(const struct uheap *uheap)
+{
+    return uheap->size;
+}
+
+/** @internal @This places a node at the given position.
+ *
+ * @param uheap pointer to a heap
+ * @param node pointer to a heap node
+ * @param index position
+ */
+static inline void uheap_set(struct uheap *uheap, struct uheap_node *node,
+                             size_t index)
+{
+    uheap->nodes[index] = node;
+    node->index = index;
+}
+
+/** @internal @This moves a node towards the top of the heap.
+ *
+ * @param uheap pointer to a heap
+ * @param node pointer to a heap node
+ */
+static inline void uheap_sift_up(struct uheap *uheap, struct uheap_node *node)
+{
+    size_t index = node->index;
+    while (index) {
+        size_t parent = (index - 1) / 2;
+        if (uheap->nodes[parent]->key <= node->key)
+            break;
+        uheap_set(uheap, uheap->nodes[parent], index);
+        index = parent;
+    }
+    uheap_set(uheap, node, index);
+}
+
+/** @internal @This moves a node towards the bottom of the heap.
+ *
+ * @param uheap pointer to a heap
+ * @param node pointer to a heap node
+ */
+static inline void uheap_sift_down(struct uheap *uheap,
+                                   struct uheap_node *node)
+{
+    size_t index = node->index;
+    for ( ; ; ) {
+        size_t child = 2 * index + 1;
+        if (child >= uheap->size)
+            break;
+        if (child + 1 < uheap->size &&
+            uheap->nodes[child + 1]->key < uheap->nodes[child]->key)
+            child++;
+        if (node->key <= uheap->nodes[child]->key)
+            break;
+        uheap_set(uheap, uheap->nodes[child], index);
+        index = child;
+    }
+    uheap_set(uheap, node, index);
+}
+
+/** @This removes a node from a heap. It is a no-op if the node is not in
+ * the heap.
+ *
+ * @param uheap pointer to a heap
+ * @param node pointer to a heap node
+ */
+static inline void uheap_delete(struct uheap *uheap, struct uheap_node *node)
+{
+    if (!uheap_node_is_in(node))
+        return;
+
+    size_t index = node->index;
+    node->index = UHEAP_NONE;
+    struct uheap_node *last = uheap->nodes[--uheap->size];
+    if (last == node)
+        return;
+
+    uheap_set(uheap, last, index);
+    if (index && uheap->nodes[(index - 1) / 2]->key > last->key)
+        uheap_sift_up(uheap, last);
+    else
+        uheap_sift_down(uheap, last);
+}
+
+/** @This inserts a node in a heap with the given key, or changes its key
+ * if it is already in the heap.
+ *
+ * @param uheap pointer to a heap
+ * @param node pointer to a heap node
+ * @param key new key
+ * @return an error code
+ */
+static inline int uheap_update(struct uheap *uheap, struct uheap_node *node,
+                               uint64_t key)
+{
+    if (!uheap_node_is_in(node)) {
+        if (uheap->size >= uheap->alloc) {
+            size_t alloc = uheap->alloc ? uheap->alloc * 2 : 16;
+            struct uheap_node **nodes =
+                realloc(uheap->nodes, alloc * sizeof(struct uheap_node *));
+            if (unlikely(nodes == NULL))
+                return UBASE_ERR_ALLOC;
+            uheap->nodes = nodes;
+            uheap->alloc = alloc;
+        }
+        node->key = key;
+        uheap_set(uheap, node, uheap->size++);
+        uheap_sift_up(uheap, node);
+        return UBASE_ERR_NONE;
+    }
+
+    uint64_t old_key = node->key;
+    node->key = key;
+    if (key < old_key)
+        uheap_sift_up(uheap, node);
+    else if (key > old_key)
+        uheap_sift_down(uheap, node);
+    return UBASE_ERR_NONE;
+}
+
+/** @This removes the node with the smallest key from a heap.
+ *
+ * @param uheap pointer to a heap
+ * @return pointer to the removed node, or NULL if the heap is empty
+ */
+static inline struct uheap_node *uheap_pop(struct uheap *uheap)
+{
+    struct uheap_node *node = uheap_peek(uheap);
+    if (node != NULL)
+        uheap_delete(uheap, node);
+    return node;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe hugepage-backed memory allocator
+ *
+ * This memory allocator carves buffers out of a single arena, allocated at
+ * initialization with 2 MiB or 1 GiB hugepages (or transparent hugepages if
+ * none are reserved), optionally bound to a NUMA node, and pre-faulted so
+ * that no page fault occurs in the data path. Buffers are sorted in size
+ * classes in 1.5x increments, and released buffers are kept in lock-free
+ * per-class lists. It reverts to malloc() and free() when the arena is
+ * exhausted or for buffers larger than the arena.
+ *
+ * The manager may be selected for a pipeline by passing it to
+ * @ref uprobe_ubuf_mem_alloc or @ref uprobe_ubuf_mem_pool_alloc.
+ */
+
+#ifndef _UPIPE_UMEM_HUGEPAGE_H_
+/** @hidden */
+#define _UPIPE_UMEM_HUGEPAGE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/umem.h>
+
+#include <stdbool.h>
+
+/** size of a 2 MiB hugepage */
+#define UMEM_HUGEPAGE_2M (UINT64_C(2) << 20)
+/** size of a 1 GiB hugepage */
+#define UMEM_HUGEPAGE_1G (UINT64_C(1) << 30)
+
+/** @This allocates a new instance of the umem hugepage manager.
+ *
+ * @param arena_size size (in octets) of the arena, rounded up to a multiple
+ * of page_size
+ * @param page_size size of the hugepages (@ref UMEM_HUGEPAGE_2M or
+ * @ref UMEM_HUGEPAGE_1G)
+ * @param numa_node NUMA node on which the arena is allocated, or -1 to use
+ * the default policy of the calling thread
+ * @param chunk_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_hugepage_mgr_alloc(size_t arena_size, size_t page_size,
+                                         int numa_node, size_t chunk_size);
+
+/** @This allocates a new instance of the umem hugepage manager, with
+ * 2 MiB hugepages and 64 KiB chunks.
+ *
+ * @param arena_size size (in octets) of the arena
+ * @param numa_node NUMA node on which the arena is allocated, or -1
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_hugepage_mgr_alloc_simple(size_t arena_size,
+                                                int numa_node);
+
+/** @This returns whether the arena of the manager is actually backed by
+ * explicit hugepages, as opposed to transparent hugepages or regular pages.
+ *
+ * @param mgr pointer to umem manager
+ * @return true if the arena is backed by explicit hugepages
+ */
+bool umem_hugepage_mgr_is_hugetlb(struct umem_mgr *mgr);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
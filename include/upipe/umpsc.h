@@ -0,0 +1,387 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe multiple-producer single-consumer queue of elements
+ *
+ * Each producer thread claims its own lane, which is a bounded
+ * single-producer single-consumer ring, so that producers never contend on
+ * a shared position. The consumer pops the lanes in a round-robin fashion.
+ * The consumer is woken up by a single ueventfd, which producers only write
+ * after the consumer has found all lanes empty and flagged itself as
+ * waiting; as long as the consumer is busy, pushing an element does not
+ * involve any system call nor any write to a shared cache line.
+ *
+ * Back-pressure is applied per lane: a producer whose lane is full waits on
+ * the ueventfd of its own lane.
+ */
+
+#ifndef _UPIPE_UMPSC_H_
+/** @hidden */
+#define _UPIPE_UMPSC_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/ufifo.h>
+#include <upipe/ueventfd.h>
+#include <upipe/upump.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/** @This is the maximum number of elements in a lane. */
+#define UMPSC_MAX_LENGTH UFIFO_MAX_LENGTH
+
+/** @hidden */
+#define UMPSC_CACHELINE_SIZE 64
+
+/** @This is the implementation of a lane, owned by a single producer. */
+struct umpsc_lane {
+    /** array of elements */
+    void **elements;
+    /** ueventfd triggered when data can be pushed */
+    struct ueventfd event_push;
+    /** set to 1 when the lane is claimed by a producer */
+    uatomic_uint32_t used;
+
+    /** @hidden */
+    uint8_t pad_tail[UMPSC_CACHELINE_SIZE];
+    /** position of the next element to push */
+    uatomic_uint32_t tail;
+    /** @hidden */
+    uint8_t pad_head[UMPSC_CACHELINE_SIZE];
+    /** position of the next element to pop */
+    uatomic_uint32_t head;
+    /** @hidden */
+    uint8_t pad_end[UMPSC_CACHELINE_SIZE];
+};
+
+/** @This is the implementation of a multiple-producer single-consumer
+ * queue. */
+struct umpsc {
+    /** number of lanes */
+    uint32_t nb_lanes;
+    /** maximum number of elements per lane */
+    uint32_t length;
+    /** number of cells per lane, minus one */
+    uint32_t mask;
+    /** array of lanes */
+    struct umpsc_lane *lanes;
+    /** next lane to pop, for use by the consumer only */
+    uint32_t next;
+
+    /** set to 1 when the consumer waits for the ueventfd */
+    uatomic_uint32_t waiting;
+    /** ueventfd triggered when data can be popped */
+    struct ueventfd event_pop;
+};
+
+/** @This returns the required size of extra data space for umpsc.
+ *
+ * @param nb_lanes maximum number of producers
+ * @param length maximum number of elements per lane
+ * @return size in octets to allocate
+ */
+#define umpsc_sizeof(nb_lanes, length)                                      \
+    ((nb_lanes) * (sizeof(struct umpsc_lane) +                              \
+                   ufifo_capacity(length) * sizeof(void *)))
+
+/** @This initializes a umpsc.
+ *
+ * @param umpsc pointer to a umpsc structure
+ * @param nb_lanes maximum number of producers
+ * @param length maximum number of elements per lane (at most
+ * UMPSC_MAX_LENGTH)
+ * @param extra mandatory extra space allocated by the caller, with the size
+ * returned by @ref #umpsc_sizeof
+ * @return false in case of failure
+ */
+static inline bool umpsc_init(struct umpsc *umpsc, uint32_t nb_lanes,
+                              uint32_t length, void *extra)
+{
+    assert(nb_lanes);
+    assert(length && length <= UMPSC_MAX_LENGTH);
+    if (unlikely(!ueventfd_init(&umpsc->event_pop, false)))
+        return false;
+
+    umpsc->nb_lanes = nb_lanes;
+    umpsc->length = length;
+    umpsc->mask = ufifo_capacity(length) - 1;
+    umpsc->lanes = (struct umpsc_lane *)extra;
+    umpsc->next = 0;
+    uatomic_init(&umpsc->waiting, 1);
+
+    void **elements = (void **)(umpsc->lanes + nb_lanes);
+    for (uint32_t i = 0; i < nb_lanes; i++) {
+        struct umpsc_lane *lane = &umpsc->lanes[i];
+        if (unlikely(!ueventfd_init(&lane->event_push, true))) {
+            while (i--)
+                ueventfd_clean(&umpsc->lanes[i].event_push);
+            ueventfd_clean(&umpsc->event_pop);
+            return false;
+        }
+        lane->elements = elements;
+        elements += umpsc->mask + 1;
+        uatomic_init(&lane->used, 0);
+        uatomic_init(&lane->tail, 0);
+        uatomic_init(&lane->head, 0);
+    }
+    return true;
+}
+
+/** @This claims a free lane for the calling producer. It may be called from
+ * any thread.
+ *
+ * @param umpsc pointer to a umpsc structure
+ * @return pointer to the lane, or NULL if all lanes are in use
+ */
+static inline struct umpsc_lane *umpsc_lane_get(struct umpsc *umpsc)
+{
+    for (uint32_t i = 0; i < umpsc->nb_lanes; i++) {
+        struct umpsc_lane *lane = &umpsc->lanes[i];
+        uint32_t expected = 0;
+        if (uatomic_compare_exchange(&lane->used, &expected, 1))
+            return lane;
+    }
+    return NULL;
+}
+
+/** @This gives a lane back. Elements still queued in the lane are
+ * nevertheless popped by the consumer, and the lane may be claimed again by
+ * another producer.
+ *
+ * @param lane pointer to a lane claimed by @ref umpsc_lane_get
+ */
+static inline void umpsc_lane_put(struct umpsc_lane *lane)
+{
+    uatomic_store(&lane->used, 0);
+}
+
+/** @This returns the index of a lane in the queue.
+ *
+ * @param umpsc pointer to a umpsc structure
+ * @param lane pointer to a lane
+ * @return index of the lane
+ */
+static inline uint32_t umpsc_lane_index(struct umpsc *umpsc,
+                                        struct umpsc_lane *lane)
+{
+    assert(lane >= umpsc->lanes && lane < umpsc->lanes + umpsc->nb_lanes);
+    return lane - umpsc->lanes;
+}
+
+/** @This returns the number of lanes currently claimed by producers.
+ *
+ * @param umpsc pointer to a umpsc structure
+ * @return number of producers
+ */
+static inline unsigned int umpsc_producers(struct umpsc *umpsc)
+{
+    unsigned int producers = 0;
+    for (uint32_t i = 0; i < umpsc->nb_lanes; i++)
+        producers += uatomic_load(&umpsc->lanes[i].used);
+    return producers;
+}
+
+/** @This allocates a watcher triggering when data is ready to be pushed
+ * into the given lane.
+ *
+ * @param lane pointer to a lane
+ * @param upump_mgr management structure for this event loop
+ * @param cb function to call when the watcher triggers
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @return pointer to allocated watcher, or NULL in case of failure
+ */
+static inline struct upump *umpsc_lane_upump_alloc_push(
+        struct umpsc_lane *lane, struct upump_mgr *upump_mgr,
+        upump_cb cb, void *opaque, struct urefcount *refcount)
+{
+    return ueventfd_upump_alloc(&lane->event_push, upump_mgr, cb, opaque,
+                                refcount);
+}
+
+/** @This allocates a watcher triggering when data is ready to be popped.
+ *
+ * @param umpsc pointer to a umpsc structure
+ * @param upump_mgr management structure for this event loop
+ * @param cb function to call when the watcher triggers
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @return pointer to allocated watcher, or NULL in case of failure
+ */
+static inline struct upump *umpsc_upump_alloc_pop(struct umpsc *umpsc,
+                                                  struct upump_mgr *upump_mgr,
+                                                  upump_cb cb, void *opaque,
+                                                  struct urefcount *refcount)
+{
+    return ueventfd_upump_alloc(&umpsc->event_pop, upump_mgr, cb, opaque,
+                                refcount);
+}
+
+/** @This pushes an element into a lane. It may only be called by the
+ * producer owning the lane.
+ *
+ * @param umpsc pointer to a umpsc structure
+ * @param lane pointer to a lane claimed by @ref umpsc_lane_get
+ * @param element pointer to element to push
+ * @return false if the lane is full and the element couldn't be queued
+ */
+static inline bool umpsc_push(struct umpsc *umpsc, struct umpsc_lane *lane,
+                              void *element)
+{
+    uint32_t tail = uatomic_load(&lane->tail);
+    if (unlikely(tail - uatomic_load(&lane->head) >= umpsc->length)) {
+        /* signal that we are full */
+        ueventfd_read(&lane->event_push);
+
+        /* double-check */
+        if (likely(tail - uatomic_load(&lane->head) >= umpsc->length))
+            return false;
+
+        /* signal that we're alright again */
+        ueventfd_write(&lane->event_push);
+    }
+
+    lane->elements[tail & umpsc->mask] = element;
+    uatomic_store(&lane->tail, tail + 1);
+
+    /* only wake up the consumer if it found all lanes empty */
+    if (unlikely(uatomic_load(&umpsc->waiting))) {
+        uint32_t expected = 1;
+        if (uatomic_compare_exchange(&umpsc->waiting, &expected, 0))
+            ueventfd_write(&umpsc->event_pop);
+    }
+    return true;
+}
+
+/** @internal @This pops an element from the first non-empty lane, starting
+ * from the lane following the one popped last.
+ *
+ * @param umpsc pointer to a umpsc structure
+ * @return pointer to element, or NULL if all lanes are empty
+ */
+static inline void *umpsc_pop_lanes(struct umpsc *umpsc)
+{
+    uint32_t index = umpsc->next;
+    for (uint32_t i = 0; i < umpsc->nb_lanes; i++) {
+        struct umpsc_lane *lane = &umpsc->lanes[index];
+        if (++index == umpsc->nb_lanes)
+            index = 0;
+
+        uint32_t head = uatomic_load(&lane->head);
+        if (uatomic_load(&lane->tail) == head)
+            continue;
+
+        void *element = lane->elements[head & umpsc->mask];
+        uatomic_store(&lane->head, head + 1);
+        /* the producer may have found the lane full before we popped */
+        if (unlikely(uatomic_load(&lane->tail) - head == umpsc->length))
+            ueventfd_write(&lane->event_push);
+        umpsc->next = index;
+        return element;
+    }
+    return NULL;
+}
+
+/** @internal @This pops an element from the queue. It may only be called by
+ * the consumer.
+ *
+ * @param umpsc pointer to a umpsc structure
+ * @return pointer to element, or NULL if the queue is empty
+ */
+static inline void *umpsc_pop_internal(struct umpsc *umpsc)
+{
+    void *element = umpsc_pop_lanes(umpsc);
+    if (unlikely(element == NULL)) {
+        /* signal that we starve */
+        ueventfd_read(&umpsc->event_pop);
+        uatomic_store(&umpsc->waiting, 1);
+
+        /* double-check */
+        element = umpsc_pop_lanes(umpsc);
+        if (likely(element == NULL))
+            return NULL;
+
+        /* signal that we're alright again, unless a producer did */
+        uint32_t expected = 1;
+        if (uatomic_compare_exchange(&umpsc->waiting, &expected, 0))
+            ueventfd_write(&umpsc->event_pop);
+    }
+    return element;
+}
+
+/** @This pops an element from the queue with type checking.
+ *
+ * @param umpsc pointer to a umpsc structure
+ * @param type type of the opaque pointer
+ * @return pointer to element, or NULL if the queue is empty
+ */
+#define umpsc_pop(umpsc, type) (type)umpsc_pop_internal(umpsc)
+
+/** @This returns the number of elements in the queue. The value may no
+ * longer be valid when it is returned.
+ *
+ * @param umpsc pointer to a umpsc structure
+ * @return number of elements
+ */
+static inline unsigned int umpsc_length(struct umpsc *umpsc)
+{
+    unsigned int length = 0;
+    for (uint32_t i = 0; i < umpsc->nb_lanes; i++) {
+        struct umpsc_lane *lane = &umpsc->lanes[i];
+        uint32_t head = uatomic_load(&lane->head);
+        length += uatomic_load(&lane->tail) - head;
+    }
+    return length;
+}
+
+/** @This cleans up the queue data structure. Please note that it is the
+ * caller's responsibility to empty the queue first.
+ *
+ * @param umpsc pointer to a umpsc structure
+ */
+static inline void umpsc_clean(struct umpsc *umpsc)
+{
+    for (uint32_t i = 0; i < umpsc->nb_lanes; i++) {
+        struct umpsc_lane *lane = &umpsc->lanes[i];
+        uatomic_clean(&lane->used);
+        uatomic_clean(&lane->tail);
+        uatomic_clean(&lane->head);
+        ueventfd_clean(&lane->event_push);
+    }
+    uatomic_clean(&umpsc->waiting);
+    ueventfd_clean(&umpsc->event_pop);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -161,6 +161,14 @@ enum upipe_command {
      * in octets (uint64_t *, uint64_t *) */
     UPIPE_SRC_GET_RANGE,
 
+    /*
+     * Encoder-related commands
+     */
+    /** returns the target octetrate of the encoder (uint64_t *) */
+    UPIPE_ENC_GET_OCTETRATE,
+    /** sets the target octetrate of the encoder (uint64_t) */
+    UPIPE_ENC_SET_OCTETRATE,
+
     /** non-standard commands implemented by a module type can start from
      * there (first arg = signature) */
     UPIPE_CONTROL_LOCAL = 0x8000
@@ -372,6 +380,8 @@ static inline const char *upipe_command_str(struct upipe *upipe, int cmd)
     UBASE_CASE_TO_STR(UPIPE_SRC_SET_POSITION);
     UBASE_CASE_TO_STR(UPIPE_SRC_GET_RANGE);
     UBASE_CASE_TO_STR(UPIPE_SRC_SET_RANGE);
+    UBASE_CASE_TO_STR(UPIPE_ENC_GET_OCTETRATE);
+    UBASE_CASE_TO_STR(UPIPE_ENC_SET_OCTETRATE);
     case UPIPE_CONTROL_LOCAL: break;
     }
     return NULL;
@@ -1524,6 +1534,32 @@ static inline int upipe_src_set_range(struct upipe *upipe,
     return upipe_control(upipe, UPIPE_SRC_SET_RANGE, offset, length);
 }
 
+/** @This returns the target octetrate of an encoder.
+ *
+ * @param upipe description structure of the pipe
+ * @param octetrate_p filled in with the target octetrate
+ * @return an error code
+ */
+static inline int upipe_enc_get_octetrate(struct upipe *upipe,
+                                          uint64_t *octetrate_p)
+{
+    return upipe_control(upipe, UPIPE_ENC_GET_OCTETRATE, octetrate_p);
+}
+
+/** @This sets the target octetrate of an encoder. The change is applied
+ * while encoding, without emitting a new flow definition, so that it can be
+ * driven by a statistical multiplexer.
+ *
+ * @param upipe description structure of the pipe
+ * @param octetrate new target octetrate
+ * @return an error code
+ */
+static inline int upipe_enc_set_octetrate(struct upipe *upipe,
+                                          uint64_t octetrate)
+{
+    return upipe_control(upipe, UPIPE_ENC_SET_OCTETRATE, octetrate);
+}
+
 /** @This declares twelve functions to allocate pipes with a certain pipe
  * allocator.
  *
@@ -42,6 +42,7 @@ extern "C" {
 #include <stdbool.h>
 #include <stdarg.h>
 #include <assert.h>
+#include <sys/types.h>
 
 /** @hidden */
 struct upump_mgr;
@@ -67,6 +68,12 @@ enum upump_type {
     UPUMP_TYPE_FD_WRITE,
     /** event triggers on a UNIX signal (argument = int) */
     UPUMP_TYPE_SIGNAL,
+    /** event triggers on the completion of a read operation submitted
+     * to the event loop (argument = int) */
+    UPUMP_TYPE_IO_READ,
+    /** event triggers on the completion of a write operation submitted
+     * to the event loop (argument = int) */
+    UPUMP_TYPE_IO_WRITE,
     /* TODO: Windows objects */
 
     /** non-standard types implemented by a upump handler can start
@@ -92,6 +99,12 @@ enum upump_command {
     UPUMP_FREE_BLOCKER,
     /** restarts the pump (void) */
     UPUMP_RESTART,
+    /** submits an operation on a started I/O pump (void *, size_t,
+     * uint64_t) */
+    UPUMP_IO_SUBMIT,
+    /** returns the result of the last completed operation of an I/O pump
+     * (ssize_t *) */
+    UPUMP_IO_GET_RESULT,
 
     /** non-standard commands implemented by a upump handler can start
      * from there (first arg = signature) */
@@ -288,6 +301,50 @@ static inline struct upump *upump_alloc_signal(struct upump_mgr *mgr,
     return upump_alloc(mgr, cb, opaque, refcount, UPUMP_TYPE_SIGNAL, signal);
 }
 
+/** @This allocates and initializes a pump reading from a file descriptor.
+ * Operations are submitted with @ref upump_io_submit on the started pump,
+ * and the pump triggers when each of them completes. Event loops which
+ * cannot submit I/O operations return NULL, and the caller then falls back
+ * to @ref upump_alloc_fd_read and system calls.
+ *
+ * @param mgr management structure for this event loop
+ * @param cb function to call when an operation completes
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @param fd file descriptor to read from
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static inline struct upump *upump_alloc_io_read(struct upump_mgr *mgr,
+                                                upump_cb cb, void *opaque,
+                                                struct urefcount *refcount,
+                                                int fd)
+{
+    return upump_alloc(mgr, cb, opaque, refcount, UPUMP_TYPE_IO_READ, fd);
+}
+
+/** @This allocates and initializes a pump writing to a file descriptor.
+ * Operations are submitted with @ref upump_io_submit on the started pump,
+ * and the pump triggers when each of them completes. Event loops which
+ * cannot submit I/O operations return NULL, and the caller then falls back
+ * to @ref upump_alloc_fd_write and system calls.
+ *
+ * @param mgr management structure for this event loop
+ * @param cb function to call when an operation completes
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @param fd file descriptor to write to
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static inline struct upump *upump_alloc_io_write(struct upump_mgr *mgr,
+                                                 upump_cb cb, void *opaque,
+                                                 struct urefcount *refcount,
+                                                 int fd)
+{
+    return upump_alloc(mgr, cb, opaque, refcount, UPUMP_TYPE_IO_WRITE, fd);
+}
+
 /** @internal @This sends a control command to the pump. Note that all control
  * commands must be executed from the same thread - no reentrancy or locking
  * is required from the pump. Also note that all arguments are owned by the
@@ -396,6 +453,37 @@ static inline void upump_set_status(struct upump *upump, bool status)
     upump_control(upump, UPUMP_SET_STATUS, i);
 }
 
+/** @This submits a read or write operation on a started I/O pump. Only one
+ * operation may be pending at a time. The buffer must remain valid until the
+ * operation completes or the pump is stopped; stopping the pump cancels the
+ * pending operation and waits for it.
+ *
+ * @param upump description structure of the pump
+ * @param buffer buffer to read into or write from
+ * @param size size of the buffer
+ * @param offset offset in the file, or UINT64_MAX to use and update the
+ * file position
+ * @return an error code, including @ref UBASE_ERR_BUSY if an operation is
+ * already pending
+ */
+static inline int upump_io_submit(struct upump *upump, void *buffer,
+                                  size_t size, uint64_t offset)
+{
+    return upump_control(upump, UPUMP_IO_SUBMIT, buffer, size, offset);
+}
+
+/** @This returns the result of the last completed operation of an I/O pump,
+ * that is the number of octets transferred, or a negative errno value.
+ *
+ * @param upump description structure of the pump
+ * @param result_p filled in with the result
+ * @return an error code
+ */
+static inline int upump_io_get_result(struct upump *upump, ssize_t *result_p)
+{
+    return upump_control(upump, UPUMP_IO_GET_RESULT, result_p);
+}
+
 /** @This gets the opaque structure with a cast.
  *
  * @param upump description structure of the pump
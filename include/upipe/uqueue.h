@@ -65,15 +65,19 @@ struct uqueue {
  */
 #define uqueue_sizeof(length) ufifo_sizeof(length)
 
+/** @This is the maximum number of elements in a uqueue. */
+#define UQUEUE_MAX_LENGTH UFIFO_MAX_LENGTH
+
 /** @This initializes a uqueue.
  *
  * @param uqueue pointer to a uqueue structure
- * @param length maximum number of elements in the queue
+ * @param length maximum number of elements in the queue (at most
+ * UQUEUE_MAX_LENGTH)
  * @param extra mandatory extra space allocated by the caller, with the size
  * returned by @ref #ufifo_sizeof
  * @return false in case of failure
  */
-static inline bool uqueue_init(struct uqueue *uqueue, uint8_t length,
+static inline bool uqueue_init(struct uqueue *uqueue, uint32_t length,
                                void *extra)
 {
     if (unlikely(!ueventfd_init(&uqueue->event_push, true)))
@@ -127,31 +131,69 @@ static inline struct upump *uqueue_upump_alloc_pop(struct uqueue *uqueue,
                                 refcount);
 }
 
-/** @This pushes an element into the queue.
+/** @This pushes an element into the queue, and only wakes up the consumer
+ * when the number of queued elements reaches the given threshold. Elements
+ * pushed below the threshold stay pending until a later push reaches it, or
+ * until the producer calls @ref uqueue_signal_pop.
  *
  * @param uqueue pointer to a uqueue structure
  * @param element pointer to element to push
+ * @param threshold number of queued elements triggering the wake-up of the
+ * consumer (1 signals every transition from an empty queue)
  * @return false if the queue is full and the element couldn't be queued
  */
-static inline bool uqueue_push(struct uqueue *uqueue, void *element)
+static inline bool uqueue_push_coalesce(struct uqueue *uqueue, void *element,
+                                        uint32_t threshold)
 {
     if (unlikely(!ufifo_push(&uqueue->fifo, element))) {
         /* signal that we are full */
         ueventfd_read(&uqueue->event_push);
 
         /* double-check */
-        if (likely(!ufifo_push(&uqueue->fifo, element)))
+        if (likely(!ufifo_push(&uqueue->fifo, element))) {
+            /* a consumer may have released a cell without having
+             * decremented the counter yet */
+            if (unlikely(uatomic_load(&uqueue->counter) < uqueue->length))
+                ueventfd_write(&uqueue->event_push);
             return false;
+        }
 
         /* signal that we're alright again */
         ueventfd_write(&uqueue->event_push);
     }
 
-    if (unlikely(uatomic_fetch_add(&uqueue->counter, 1) == 0))
+    if (unlikely(threshold > uqueue->length))
+        threshold = uqueue->length;
+    else if (unlikely(!threshold))
+        threshold = 1;
+    if (unlikely(uatomic_fetch_add(&uqueue->counter, 1) + 1 == threshold))
         ueventfd_write(&uqueue->event_pop);
     return true;
 }
 
+/** @This pushes an element into the queue.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param element pointer to element to push
+ * @return false if the queue is full and the element couldn't be queued
+ */
+static inline bool uqueue_push(struct uqueue *uqueue, void *element)
+{
+    return uqueue_push_coalesce(uqueue, element, 1);
+}
+
+/** @This wakes up the consumer if elements are pending in the queue. It is
+ * typically called by the producer after a series of
+ * @ref uqueue_push_coalesce that did not reach the threshold.
+ *
+ * @param uqueue pointer to a uqueue structure
+ */
+static inline void uqueue_signal_pop(struct uqueue *uqueue)
+{
+    if (likely(uatomic_load(&uqueue->counter)))
+        ueventfd_write(&uqueue->event_pop);
+}
+
 /** @internal @This pops an element from the queue.
  *
  * @param uqueue pointer to a uqueue structure
@@ -166,8 +208,13 @@ static inline void *uqueue_pop_internal(struct uqueue *uqueue)
 
         /* double-check */
         element = ufifo_pop(&uqueue->fifo, void *);
-        if (likely(element == NULL))
+        if (likely(element == NULL)) {
+            /* an element pushed later may be counted while an earlier
+             * producer has not filled its cell yet */
+            if (unlikely(uatomic_load(&uqueue->counter)))
+                ueventfd_write(&uqueue->event_pop);
             return NULL;
+        }
 
         /* signal that we're alright again */
         ueventfd_write(&uqueue->event_pop);
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short declarations for a Upipe main loop using io_uring
+ *
+ * The standard pump types are implemented on top of an io_uring instance:
+ * file descriptors are watched with one-shot poll requests, signals with
+ * signalfd, and timers and idlers are handled in user space, with the ring
+ * waiting for at most the next timer deadline.
+ *
+ * Additionally, the I/O pumps (@ref upump_alloc_io_read and
+ * @ref upump_alloc_io_write) submit the read or write operation itself
+ * to the ring, so that the callback is called with the operation already
+ * completed, instead of a readiness notification followed by a separate
+ * system call. Operations on buffers lying in a region registered with
+ * @ref upump_uring_mgr_register_buffers use fixed buffers and avoid the
+ * mapping of the pages on each operation.
+ *
+ * The file sink submits its direct I/O writes through these pumps. The
+ * other pipes of upipe-modules only use the standard pump types, and keep
+ * doing their I/O with system calls when run by this manager.
+ *
+ * It requires Linux 5.11 or later.
+ */
+
+#ifndef _UPUMP_URING_UPUMP_URING_H_
+/** @hidden */
+#define _UPUMP_URING_UPUMP_URING_H_
+
+#include <upipe/upump.h>
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPUMP_URING_SIGNATURE UBASE_FOURCC('u','r','n','g')
+
+/** @This allocates and initializes a upump_mgr structure bound to a new
+ * io_uring instance.
+ *
+ * @param entries number of entries of the submission ring
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @return pointer to the wrapped upump_mgr structure, or NULL if io_uring is
+ * not available
+ */
+struct upump_mgr *upump_uring_mgr_alloc(unsigned int entries,
+                                        uint16_t upump_pool_depth,
+                                        uint16_t upump_blocker_pool_depth);
+
+/** @This registers the regions of memory that may be used by I/O pumps as
+ * fixed buffers, replacing the previously registered ones. It must not be
+ * called while an operation is pending.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param iovecs array of regions, or NULL to unregister the regions
+ * @param nb_iovecs number of regions
+ * @return an error code
+ */
+int upump_uring_mgr_register_buffers(struct upump_mgr *mgr,
+                                     const struct iovec *iovecs,
+                                     unsigned int nb_iovecs);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
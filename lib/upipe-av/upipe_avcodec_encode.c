@@ -1404,6 +1404,30 @@ static int upipe_avcenc_set_option(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This changes the target octetrate of the encoder while it is
+ * running. The maximum rate is scaled accordingly. Only the encoders which
+ * check their rate control parameters between frames (such as libx264)
+ * take the new value into account; the flow definition is not updated.
+ *
+ * @param upipe description structure of the pipe
+ * @param octetrate new target octetrate
+ * @return an error code
+ */
+static int upipe_avcenc_set_octetrate(struct upipe *upipe, uint64_t octetrate)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    AVCodecContext *context = upipe_avcenc->context;
+    if (!octetrate || octetrate > INT64_MAX / 8)
+        return UBASE_ERR_INVALID;
+
+    int64_t bit_rate = octetrate * 8;
+    if (context->rc_max_rate && context->bit_rate)
+        context->rc_max_rate = (int64_t)((double)context->rc_max_rate *
+                                         bit_rate / context->bit_rate);
+    context->bit_rate = bit_rate;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -1450,6 +1474,18 @@ static int upipe_avcenc_control(struct upipe *upipe,
             const char *content = va_arg(args, const char *);
             return upipe_avcenc_set_option(upipe, option, content);
         }
+        case UPIPE_ENC_GET_OCTETRATE: {
+            struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+            uint64_t *octetrate_p = va_arg(args, uint64_t *);
+            if (upipe_avcenc->context->bit_rate <= 0)
+                return UBASE_ERR_INVALID;
+            *octetrate_p = upipe_avcenc->context->bit_rate / 8;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_ENC_SET_OCTETRATE: {
+            uint64_t octetrate = va_arg(args, uint64_t);
+            return upipe_avcenc_set_octetrate(upipe, octetrate);
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
@@ -34,6 +34,7 @@
 #include <upipe/uclock.h>
 #include <upipe/uref_block.h>
 #include <upipe/uref_clock.h>
+#include <upipe/ueventfd.h>
 
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
@@ -51,6 +52,8 @@
 #include <gcrypt.h>
 #endif
 
+#include <pthread.h>
+
 #include "common.h"
 
 /** expected input flow format */
@@ -60,6 +63,8 @@
 
 /** @hidden */
 static void upipe_dvbcsa_dec_worker(struct upump *upump);
+/** @hidden */
+static void upipe_dvbcsa_dec_event(struct upump *upump);
 
 enum mode {
     CSA,
@@ -125,10 +130,60 @@ struct upipe_dvbcsa_dec {
     /** batch mode */
     enum mode mode;
 
+    /** number of descrambling threads, or 0 */
+    unsigned int nb_threads;
+    /** descrambling threads */
+    pthread_t *threads;
+    /** protects the jobs queue and the done flag of the jobs */
+    pthread_mutex_t mutex;
+    /** signals new jobs to the threads */
+    pthread_cond_t cond;
+    /** signals finished jobs */
+    pthread_cond_t done_cond;
+    /** jobs waiting for a thread */
+    struct uchain jobs;
+    /** true if the threads must exit */
+    bool exit;
+    /** jobs submitted and not output yet, in input order */
+    struct uchain pending;
+    /** jobs available for reuse */
+    struct uchain free_jobs;
+    /** true if the pipe retains itself until the pending jobs are output */
+    bool retained;
+    /** event triggered by the threads when a job is done */
+    struct ueventfd event;
+    /** upump watching the event */
+    struct upump *event_upump;
+
     /** common dvbcsa structure */
     struct upipe_dvbcsa_common common;
 };
 
+/** @This is a batch of packets descrambled by a thread. */
+struct upipe_dvbcsa_dec_job {
+    /** link into the jobs queue */
+    struct uchain uchain;
+    /** link into the pending or free jobs */
+    struct uchain uchain_pending;
+    /** key to descramble the batch with */
+    dvbcsa_bs_key_t *key;
+    /** batch items */
+    struct dvbcsa_bs_batch_s *batch;
+    /** mapped urefs */
+    struct uref **mapped;
+    /** number of batch items */
+    unsigned int nb;
+    /** urefs to output when the batch is descrambled, in input order */
+    struct uchain urefs;
+    /** true when the batch is descrambled */
+    bool done;
+};
+
+/** @hidden */
+UBASE_FROM_TO(upipe_dvbcsa_dec_job, uchain, uchain, uchain);
+/** @hidden */
+UBASE_FROM_TO(upipe_dvbcsa_dec_job, uchain, uchain_pending, uchain_pending);
+
 /** @hidden */
 static int upipe_dvbcsa_dec_check(struct upipe *upipe,
                                   struct uref *flow_def);
@@ -146,6 +201,7 @@ UPIPE_HELPER_UCLOCK(upipe_dvbcsa_dec, uclock, uclock_request,
                     upipe_dvbcsa_dec_unregister_output_request);
 UPIPE_HELPER_UPUMP_MGR(upipe_dvbcsa_dec, upump_mgr);
 UPIPE_HELPER_UPUMP(upipe_dvbcsa_dec, upump, upump_mgr);
+UPIPE_HELPER_UPUMP(upipe_dvbcsa_dec, event_upump, upump_mgr);
 UPIPE_HELPER_INPUT(upipe_dvbcsa_dec, urefs, nb_urefs, max_urefs, blockers,
                    NULL);
 
@@ -180,6 +236,80 @@ static void upipe_dvbcsa_dec_free_key(struct upipe *upipe)
         upipe_dvbcsa_dec->key[i] = NULL;
 }
 
+/** @internal @This descrambles the submitted batches.
+ *
+ * @param opaque pointer to the private structure of the pipe
+ * @return NULL
+ */
+static void *upipe_dvbcsa_dec_thread(void *opaque)
+{
+    struct upipe_dvbcsa_dec *upipe_dvbcsa_dec = opaque;
+
+    pthread_mutex_lock(&upipe_dvbcsa_dec->mutex);
+    for ( ; ; ) {
+        struct uchain *uchain = NULL;
+        while (!upipe_dvbcsa_dec->exit &&
+               !(uchain = ulist_pop(&upipe_dvbcsa_dec->jobs)))
+            pthread_cond_wait(&upipe_dvbcsa_dec->cond,
+                              &upipe_dvbcsa_dec->mutex);
+        if (!uchain)
+            break;
+        pthread_mutex_unlock(&upipe_dvbcsa_dec->mutex);
+
+        struct upipe_dvbcsa_dec_job *job =
+            upipe_dvbcsa_dec_job_from_uchain(uchain);
+        dvbcsa_bs_decrypt(job->key, job->batch, 184);
+
+        pthread_mutex_lock(&upipe_dvbcsa_dec->mutex);
+        job->done = true;
+        pthread_cond_broadcast(&upipe_dvbcsa_dec->done_cond);
+        ueventfd_write(&upipe_dvbcsa_dec->event);
+    }
+    pthread_mutex_unlock(&upipe_dvbcsa_dec->mutex);
+    return NULL;
+}
+
+/** @internal @This stops the descrambling threads. The batches not yet
+ * taken by a thread are left in the queue.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_dvbcsa_dec_stop_threads(struct upipe *upipe)
+{
+    struct upipe_dvbcsa_dec *upipe_dvbcsa_dec =
+        upipe_dvbcsa_dec_from_upipe(upipe);
+
+    if (!upipe_dvbcsa_dec->nb_threads)
+        return;
+
+    pthread_mutex_lock(&upipe_dvbcsa_dec->mutex);
+    upipe_dvbcsa_dec->exit = true;
+    pthread_cond_broadcast(&upipe_dvbcsa_dec->cond);
+    pthread_mutex_unlock(&upipe_dvbcsa_dec->mutex);
+
+    for (unsigned i = 0; i < upipe_dvbcsa_dec->nb_threads; i++)
+        pthread_join(upipe_dvbcsa_dec->threads[i], NULL);
+    free(upipe_dvbcsa_dec->threads);
+    upipe_dvbcsa_dec->threads = NULL;
+    upipe_dvbcsa_dec->nb_threads = 0;
+    upipe_dvbcsa_dec->exit = false;
+}
+
+/** @internal @This frees a job and the urefs it holds.
+ *
+ * @param job job to free
+ */
+static void upipe_dvbcsa_dec_job_free(struct upipe_dvbcsa_dec_job *job)
+{
+    for (unsigned i = 0; i < job->nb; i++)
+        uref_block_unmap(job->mapped[i], 0);
+
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&job->urefs)))
+        uref_free(uref_from_uchain(uchain));
+    free(job);
+}
+
 /** @internal @This frees a dvbcsa decription pipe.
  *
  * @param upipe description structure of the pipe
@@ -196,6 +326,20 @@ static void upipe_dvbcsa_dec_free(struct upipe *upipe)
     for (unsigned i = 0; i < upipe_dvbcsa_dec->current; i++)
         uref_block_unmap(upipe_dvbcsa_dec->mapped[i], 0);
 
+    upipe_dvbcsa_dec_clean_event_upump(upipe);
+    upipe_dvbcsa_dec_stop_threads(upipe);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&upipe_dvbcsa_dec->pending)))
+        upipe_dvbcsa_dec_job_free(
+            upipe_dvbcsa_dec_job_from_uchain_pending(uchain));
+    while ((uchain = ulist_pop(&upipe_dvbcsa_dec->free_jobs)))
+        upipe_dvbcsa_dec_job_free(
+            upipe_dvbcsa_dec_job_from_uchain_pending(uchain));
+    ueventfd_clean(&upipe_dvbcsa_dec->event);
+    pthread_cond_destroy(&upipe_dvbcsa_dec->done_cond);
+    pthread_cond_destroy(&upipe_dvbcsa_dec->cond);
+    pthread_mutex_destroy(&upipe_dvbcsa_dec->mutex);
+
     upipe_dvbcsa_dec_free_key(upipe);
     free(upipe_dvbcsa_dec->mapped);
     free(upipe_dvbcsa_dec->batch);
@@ -248,6 +392,7 @@ static struct upipe *upipe_dvbcsa_dec_alloc(struct upipe_mgr *mgr,
     upipe_dvbcsa_dec_init_uclock(upipe);
     upipe_dvbcsa_dec_init_upump_mgr(upipe);
     upipe_dvbcsa_dec_init_upump(upipe);
+    upipe_dvbcsa_dec_init_event_upump(upipe);
     upipe_dvbcsa_common_init(common);
     for (int i = 0; i < 2; i++)
         upipe_dvbcsa_dec->key[i] = NULL;
@@ -257,6 +402,17 @@ static struct upipe *upipe_dvbcsa_dec_alloc(struct upipe_mgr *mgr,
                                         sizeof (struct dvbcsa_bs_batch_s));
     upipe_dvbcsa_dec->mapped = malloc(bs_size * sizeof (struct uref *));
     upipe_dvbcsa_dec->current = 0;
+    upipe_dvbcsa_dec->nb_threads = 0;
+    upipe_dvbcsa_dec->threads = NULL;
+    pthread_mutex_init(&upipe_dvbcsa_dec->mutex, NULL);
+    pthread_cond_init(&upipe_dvbcsa_dec->cond, NULL);
+    pthread_cond_init(&upipe_dvbcsa_dec->done_cond, NULL);
+    ulist_init(&upipe_dvbcsa_dec->jobs);
+    upipe_dvbcsa_dec->exit = false;
+    ulist_init(&upipe_dvbcsa_dec->pending);
+    ulist_init(&upipe_dvbcsa_dec->free_jobs);
+    upipe_dvbcsa_dec->retained = false;
+    bool event = ueventfd_init(&upipe_dvbcsa_dec->event, false);
 
     if (flow_def) {
         uint64_t latency;
@@ -272,7 +428,7 @@ static struct upipe *upipe_dvbcsa_dec_alloc(struct upipe_mgr *mgr,
     upipe_throw_ready(upipe);
 
     if (unlikely(!upipe_dvbcsa_dec->batch ||
-                 !upipe_dvbcsa_dec->mapped)) {
+                 !upipe_dvbcsa_dec->mapped || !event)) {
         upipe_err(upipe, "allocation failed");
         upipe_release(upipe);
         return NULL;
@@ -304,6 +460,137 @@ static int upipe_dvbcsa_dec_set_flow_def_real(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This checks whether the pipe retains no uref.
+ *
+ * @param upipe description structure of the pipe
+ * @return true if no uref is retained
+ */
+static bool upipe_dvbcsa_dec_check_idle(struct upipe *upipe)
+{
+    struct upipe_dvbcsa_dec *upipe_dvbcsa_dec =
+        upipe_dvbcsa_dec_from_upipe(upipe);
+
+    if (upipe_dvbcsa_dec->nb_threads)
+        return !upipe_dvbcsa_dec->retained;
+    return upipe_dvbcsa_dec_check_input(upipe);
+}
+
+/** @internal @This submits the current batch to the descrambling threads,
+ * along with the urefs retained so far.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_dvbcsa_dec_submit(struct upipe *upipe)
+{
+    struct upipe_dvbcsa_dec *upipe_dvbcsa_dec =
+        upipe_dvbcsa_dec_from_upipe(upipe);
+    unsigned current = upipe_dvbcsa_dec->current;
+    if (!current)
+        return;
+
+    struct upipe_dvbcsa_dec_job *job;
+    struct uchain *uchain = ulist_pop(&upipe_dvbcsa_dec->free_jobs);
+    if (uchain)
+        job = upipe_dvbcsa_dec_job_from_uchain_pending(uchain);
+    else {
+        unsigned bs_size = upipe_dvbcsa_dec->batch_size;
+        job = malloc(sizeof (*job) +
+                     (bs_size + 1) * sizeof (struct dvbcsa_bs_batch_s) +
+                     bs_size * sizeof (struct uref *));
+        if (unlikely(!job)) {
+            /* descramble in this thread */
+            upipe_err(upipe, "allocation failed");
+            upipe_dvbcsa_dec->current = 0;
+            upipe_dvbcsa_dec->batch[current].data = NULL;
+            upipe_dvbcsa_dec->batch[current].len = 0;
+            dvbcsa_bs_decrypt(
+                upipe_dvbcsa_dec->key_bs[upipe_dvbcsa_dec->odd],
+                upipe_dvbcsa_dec->batch, 184);
+            for (unsigned i = 0; i < current; i++)
+                uref_block_unmap(upipe_dvbcsa_dec->mapped[i], 0);
+            return;
+        }
+        job->batch = (struct dvbcsa_bs_batch_s *)(job + 1);
+        job->mapped = (struct uref **)(job->batch + bs_size + 1);
+        ulist_init(&job->urefs);
+    }
+
+    job->key = upipe_dvbcsa_dec->key_bs[upipe_dvbcsa_dec->odd];
+    memcpy(job->batch, upipe_dvbcsa_dec->batch,
+           current * sizeof (struct dvbcsa_bs_batch_s));
+    job->batch[current].data = NULL;
+    job->batch[current].len = 0;
+    memcpy(job->mapped, upipe_dvbcsa_dec->mapped,
+           current * sizeof (struct uref *));
+    job->nb = current;
+    job->done = false;
+    upipe_dvbcsa_dec->current = 0;
+
+    struct uref *uref;
+    while ((uref = upipe_dvbcsa_dec_pop_input(upipe)))
+        ulist_add(&job->urefs, uref_to_uchain(uref));
+    ulist_add(&upipe_dvbcsa_dec->pending, &job->uchain_pending);
+
+    pthread_mutex_lock(&upipe_dvbcsa_dec->mutex);
+    ulist_add(&upipe_dvbcsa_dec->jobs, &job->uchain);
+    pthread_cond_signal(&upipe_dvbcsa_dec->cond);
+    pthread_mutex_unlock(&upipe_dvbcsa_dec->mutex);
+}
+
+/** @internal @This outputs the descrambled jobs in input order, and the
+ * urefs retained after the last job when it is output.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_dvbcsa_dec_output_jobs(struct upipe *upipe,
+                                         struct upump **upump_p)
+{
+    struct upipe_dvbcsa_dec *upipe_dvbcsa_dec =
+        upipe_dvbcsa_dec_from_upipe(upipe);
+    struct uchain *uchain;
+
+    while ((uchain = ulist_peek(&upipe_dvbcsa_dec->pending))) {
+        struct upipe_dvbcsa_dec_job *job =
+            upipe_dvbcsa_dec_job_from_uchain_pending(uchain);
+        pthread_mutex_lock(&upipe_dvbcsa_dec->mutex);
+        bool done = job->done;
+        pthread_mutex_unlock(&upipe_dvbcsa_dec->mutex);
+        if (!done)
+            break;
+
+        ulist_pop(&upipe_dvbcsa_dec->pending);
+        for (unsigned i = 0; i < job->nb; i++)
+            uref_block_unmap(job->mapped[i], 0);
+        job->nb = 0;
+
+        while ((uchain = ulist_pop(&job->urefs))) {
+            struct uref *uref = uref_from_uchain(uchain);
+            if (unlikely(ubase_check(uref_flow_get_def(uref, NULL))))
+                upipe_dvbcsa_dec_set_flow_def_real(upipe, uref);
+            else
+                upipe_dvbcsa_dec_output(upipe, uref, upump_p);
+        }
+        ulist_add(&upipe_dvbcsa_dec->free_jobs, &job->uchain_pending);
+    }
+
+    if (!ulist_empty(&upipe_dvbcsa_dec->pending) ||
+        upipe_dvbcsa_dec->current || !upipe_dvbcsa_dec->retained)
+        return;
+
+    /* output the clear packets received after the last job */
+    struct uref *uref;
+    while ((uref = upipe_dvbcsa_dec_pop_input(upipe)))
+        if (unlikely(ubase_check(uref_flow_get_def(uref, NULL))))
+            upipe_dvbcsa_dec_set_flow_def_real(upipe, uref);
+        else
+            upipe_dvbcsa_dec_output(upipe, uref, upump_p);
+
+    /* no more buffered urefs */
+    upipe_dvbcsa_dec->retained = false;
+    upipe_release(upipe);
+}
+
 /** @internal @This flushes the retained urefs.
  *
  * @param upipe description structure of the pipe
@@ -316,6 +603,11 @@ static void upipe_dvbcsa_dec_flush(struct upipe *upipe,
 
     upipe_dvbcsa_dec_set_upump(upipe, NULL);
 
+    if (upipe_dvbcsa_dec->nb_threads) {
+        upipe_dvbcsa_dec_submit(upipe);
+        return;
+    }
+
     /* descramble remaining packets */
     unsigned current = upipe_dvbcsa_dec->current;
     if (current) {
@@ -346,6 +638,43 @@ static void upipe_dvbcsa_dec_flush(struct upipe *upipe,
     upipe_release(upipe);
 }
 
+/** @internal @This descrambles and outputs all the retained urefs, waiting
+ * for the descrambling threads if needed.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_dvbcsa_dec_drain(struct upipe *upipe,
+                                   struct upump **upump_p)
+{
+    struct upipe_dvbcsa_dec *upipe_dvbcsa_dec =
+        upipe_dvbcsa_dec_from_upipe(upipe);
+
+    if (!upipe_dvbcsa_dec->nb_threads) {
+        if (!upipe_dvbcsa_dec_check_input(upipe))
+            upipe_dvbcsa_dec_flush(upipe, upump_p);
+        return;
+    }
+
+    if (!upipe_dvbcsa_dec->retained)
+        return;
+
+    upipe_dvbcsa_dec_flush(upipe, upump_p);
+
+    pthread_mutex_lock(&upipe_dvbcsa_dec->mutex);
+    struct uchain *uchain;
+    ulist_foreach(&upipe_dvbcsa_dec->pending, uchain) {
+        struct upipe_dvbcsa_dec_job *job =
+            upipe_dvbcsa_dec_job_from_uchain_pending(uchain);
+        while (!job->done)
+            pthread_cond_wait(&upipe_dvbcsa_dec->done_cond,
+                              &upipe_dvbcsa_dec->mutex);
+    }
+    pthread_mutex_unlock(&upipe_dvbcsa_dec->mutex);
+
+    upipe_dvbcsa_dec_output_jobs(upipe, upump_p);
+}
+
 /** @internal @This is called when the upump triggers.
  *
  * @param upump timer
@@ -356,6 +685,20 @@ static void upipe_dvbcsa_dec_worker(struct upump *upump)
     return upipe_dvbcsa_dec_flush(upipe, &upump);
 }
 
+/** @internal @This is called when a descrambling thread finishes a job.
+ *
+ * @param upump event watcher
+ */
+static void upipe_dvbcsa_dec_event(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_dvbcsa_dec *upipe_dvbcsa_dec =
+        upipe_dvbcsa_dec_from_upipe(upipe);
+
+    ueventfd_read(&upipe_dvbcsa_dec->event);
+    upipe_dvbcsa_dec_output_jobs(upipe, &upump);
+}
+
 /** @internal @This handles the input buffers.
  *
  * @param upipe description structure of the pipe
@@ -370,7 +713,7 @@ static void upipe_dvbcsa_dec_input(struct upipe *upipe,
         upipe_dvbcsa_dec_from_upipe(upipe);
     struct upipe_dvbcsa_common *common =
         upipe_dvbcsa_dec_to_common(upipe_dvbcsa_dec);
-    bool first = upipe_dvbcsa_dec_check_input(upipe);
+    bool first = upipe_dvbcsa_dec_check_idle(upipe);
 
     /* handle new flow definition */
     if (unlikely(ubase_check(uref_flow_get_def(uref, NULL)))) {
@@ -384,7 +727,7 @@ static void upipe_dvbcsa_dec_input(struct upipe *upipe,
     /* output if no dvbcsa key set */
     if (unlikely(!upipe_dvbcsa_dec->key[0])) {
         if (unlikely(!first))
-            upipe_dvbcsa_dec_flush(upipe, upump_p);
+            upipe_dvbcsa_dec_drain(upipe, upump_p);
         upipe_dvbcsa_dec_output(upipe, uref, upump_p);
         return;
     }
@@ -489,8 +832,10 @@ static void upipe_dvbcsa_dec_input(struct upipe *upipe,
 
     /* biss mode */
 
-    if (!first && upipe_dvbcsa_dec->odd != odd)
+    if (!first && upipe_dvbcsa_dec->odd != odd) {
         upipe_dvbcsa_dec_flush(upipe, upump_p);
+        first = upipe_dvbcsa_dec_check_idle(upipe);
+    }
     upipe_dvbcsa_dec->odd = odd;
 
     unsigned current = upipe_dvbcsa_dec->current;
@@ -504,9 +849,12 @@ static void upipe_dvbcsa_dec_input(struct upipe *upipe,
     if (unlikely(first)) {
         /* make sure to send all buffered urefs */
         upipe_use(upipe);
+        if (upipe_dvbcsa_dec->nb_threads)
+            upipe_dvbcsa_dec->retained = true;
+    }
+    if (!current)
         upipe_dvbcsa_dec_wait_upump(upipe, common->latency,
                                     upipe_dvbcsa_dec_worker);
-    }
 
     /* descramble if we have enough buffered scrambled TS packets */
     if (upipe_dvbcsa_dec->current >= upipe_dvbcsa_dec->batch_size)
@@ -530,6 +878,18 @@ static int upipe_dvbcsa_dec_check(struct upipe *upipe, struct uref *flow_def)
     if (unlikely(!upipe_dvbcsa_dec->upump_mgr))
         return UBASE_ERR_NONE;
 
+    if (upipe_dvbcsa_dec->nb_threads && !upipe_dvbcsa_dec->event_upump) {
+        struct upump *upump =
+            ueventfd_upump_alloc(&upipe_dvbcsa_dec->event,
+                                 upipe_dvbcsa_dec->upump_mgr,
+                                 upipe_dvbcsa_dec_event, upipe,
+                                 upipe->refcount);
+        if (unlikely(!upump))
+            return UBASE_ERR_UPUMP;
+        upipe_dvbcsa_dec_set_event_upump(upipe, upump);
+        upump_start(upump);
+    }
+
     return UBASE_ERR_NONE;
 }
 
@@ -560,6 +920,9 @@ static int upipe_dvbcsa_dec_set_key(struct upipe *upipe, const char *even_key, c
     struct upipe_dvbcsa_dec *upipe_dvbcsa_dec =
         upipe_dvbcsa_dec_from_upipe(upipe);
 
+    /* the submitted batches use the previous keys */
+    if (upipe_dvbcsa_dec->nb_threads)
+        upipe_dvbcsa_dec_drain(upipe, NULL);
     upipe_dvbcsa_dec_free_key(upipe);
 
     struct ustring_dvbcsa_cw even_cw = ustring_to_dvbcsa_cw(ustring_from_str(even_key));
@@ -634,6 +997,53 @@ error:
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the number of descrambling threads.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_threads number of threads, or 0 to descramble in the pipe thread
+ * @return an error code
+ */
+static int upipe_dvbcsa_dec_start_threads(struct upipe *upipe,
+                                          unsigned int nb_threads)
+{
+    struct upipe_dvbcsa_dec *upipe_dvbcsa_dec =
+        upipe_dvbcsa_dec_from_upipe(upipe);
+
+    if (upipe_dvbcsa_dec->mode != CSA_BS)
+        return UBASE_ERR_INVALID;
+    if (nb_threads == upipe_dvbcsa_dec->nb_threads)
+        return UBASE_ERR_NONE;
+
+    upipe_dvbcsa_dec_drain(upipe, NULL);
+    upipe_dvbcsa_dec_stop_threads(upipe);
+    upipe_dvbcsa_dec_set_event_upump(upipe, NULL);
+    if (!nb_threads)
+        return UBASE_ERR_NONE;
+
+    upipe_dvbcsa_dec->threads = malloc(nb_threads * sizeof (pthread_t));
+    UBASE_ALLOC_RETURN(upipe_dvbcsa_dec->threads);
+    for (unsigned i = 0; i < nb_threads; i++) {
+        if (unlikely(pthread_create(&upipe_dvbcsa_dec->threads[i], NULL,
+                                    upipe_dvbcsa_dec_thread,
+                                    upipe_dvbcsa_dec))) {
+            upipe_err_va(upipe, "unable to create descrambling thread %u",
+                         i);
+            if (!i) {
+                /* no thread to stop */
+                free(upipe_dvbcsa_dec->threads);
+                upipe_dvbcsa_dec->threads = NULL;
+                return UBASE_ERR_EXTERNAL;
+            }
+            upipe_dvbcsa_dec->nb_threads = i;
+            upipe_dvbcsa_dec_stop_threads(upipe);
+            return UBASE_ERR_EXTERNAL;
+        }
+    }
+    upipe_dvbcsa_dec->nb_threads = nb_threads;
+    upipe_notice_va(upipe, "descrambling with %u threads", nb_threads);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This handles the pipe control commands.
  *
  * @param upipe description structure of the pipe
@@ -669,6 +1079,12 @@ static int upipe_dvbcsa_dec_control_real(struct upipe *upipe,
         case UPIPE_DVBCSA_ADD_PID:
         case UPIPE_DVBCSA_DEL_PID:
             return upipe_dvbcsa_common_control(common, command, args);
+
+        case UPIPE_DVBCSA_DEC_SET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_DVBCSA_DEC_SIGNATURE);
+            unsigned int nb_threads = va_arg(args, unsigned int);
+            return upipe_dvbcsa_dec_start_threads(upipe, nb_threads);
+        }
     }
     return UBASE_ERR_UNHANDLED;
 }
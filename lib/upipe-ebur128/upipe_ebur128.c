@@ -25,9 +25,16 @@
 
 /** @file
  * @short Upipe ebur128
+ *
+ * The pipe thread copies (and interleaves if needed) the samples to a ring
+ * buffer allocated when the flow definition is set, and a metering thread
+ * feeds them to libebur128. The pipe thread never waits for the metering
+ * thread, except on flow definition changes; if the metering thread falls
+ * more than a second behind, samples are dropped from the measurement.
  */
 
 #include <upipe/ulist.h>
+#include <upipe/uclock.h>
 #include <upipe/uprobe.h>
 #include <upipe/udict.h>
 #include <upipe/uref.h>
@@ -42,9 +49,12 @@
 #include <upipe-ebur128/upipe_ebur128.h>
 
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <math.h>
+#include <pthread.h>
 
 #include <ebur128.h>
 
@@ -70,7 +80,7 @@ struct upipe_ebur128 {
     /** list of output requests */
     struct uchain request_list;
 
-    /** ebur128 state */
+    /** ebur128 state, only used by the metering thread once started */
     ebur128_state *st;
     /** number of channels */
     uint8_t channels;
@@ -78,6 +88,46 @@ struct upipe_ebur128 {
     uint8_t planes;
     /** sample format */
     enum upipe_ebur128_fmt fmt;
+    /** sample rate */
+    uint64_t rate;
+    /** size of an interleaved frame, in octets */
+    size_t frame_size;
+
+    /** period of the loudness attributes */
+    uint64_t period;
+    /** number of samples before the next loudness attributes */
+    uint64_t countdown;
+
+    /** metering thread */
+    pthread_t thread;
+    /** true if the metering thread is running */
+    bool thread_running;
+    /** mutex protecting the fields below */
+    pthread_mutex_t mutex;
+    /** signals the metering thread that samples are available */
+    pthread_cond_t cond_data;
+    /** signals the pipe thread that the ring buffer is empty */
+    pthread_cond_t cond_idle;
+    /** true if the metering thread must exit */
+    bool exit;
+    /** true if the metering thread is processing samples */
+    bool busy;
+    /** ring buffer of interleaved samples */
+    uint8_t *ring;
+    /** size of the ring buffer, in frames */
+    size_t ring_frames;
+    /** number of frames read from the ring buffer by the metering thread */
+    uint64_t ring_read;
+    /** number of frames written to the ring buffer by the pipe thread */
+    uint64_t ring_write;
+    /** latest momentary loudness */
+    double momentary;
+    /** latest short-term loudness */
+    double shortterm;
+    /** latest loudness range */
+    double lra;
+    /** latest integrated loudness */
+    double global;
 
     /** public structure */
     struct upipe upipe;
@@ -108,6 +158,26 @@ static struct upipe *upipe_ebur128_alloc(struct upipe_mgr *mgr,
         return NULL;
     struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
     upipe_ebur128->st = NULL;
+    upipe_ebur128->channels = 0;
+    upipe_ebur128->planes = 0;
+    upipe_ebur128->rate = 0;
+    upipe_ebur128->frame_size = 0;
+    upipe_ebur128->period = 0;
+    upipe_ebur128->countdown = 0;
+    upipe_ebur128->thread_running = false;
+    upipe_ebur128->exit = false;
+    upipe_ebur128->busy = false;
+    upipe_ebur128->ring = NULL;
+    upipe_ebur128->ring_frames = 0;
+    upipe_ebur128->ring_read = 0;
+    upipe_ebur128->ring_write = 0;
+    upipe_ebur128->momentary = -HUGE_VAL;
+    upipe_ebur128->shortterm = -HUGE_VAL;
+    upipe_ebur128->lra = 0;
+    upipe_ebur128->global = -HUGE_VAL;
+    pthread_mutex_init(&upipe_ebur128->mutex, NULL);
+    pthread_cond_init(&upipe_ebur128->cond_data, NULL);
+    pthread_cond_init(&upipe_ebur128->cond_idle, NULL);
 
     upipe_ebur128_init_urefcount(upipe);
     upipe_ebur128_init_output(upipe);
@@ -115,6 +185,177 @@ static struct upipe *upipe_ebur128_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This feeds frames to libebur128.
+ *
+ * @param upipe description structure of the pipe
+ * @param buf interleaved frames
+ * @param frames number of frames
+ */
+static void upipe_ebur128_add_frames(struct upipe *upipe, const uint8_t *buf,
+                                     size_t frames)
+{
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+
+    switch (upipe_ebur128->fmt) {
+        case UPIPE_EBUR128_SHORT:
+            ebur128_add_frames_short(upipe_ebur128->st, (const short *)buf,
+                                     frames);
+            break;
+
+        case UPIPE_EBUR128_INT:
+            ebur128_add_frames_int(upipe_ebur128->st, (const int *)buf,
+                                   frames);
+            break;
+
+        case UPIPE_EBUR128_FLOAT:
+            ebur128_add_frames_float(upipe_ebur128->st, (const float *)buf,
+                                     frames);
+            break;
+
+        case UPIPE_EBUR128_DOUBLE:
+            ebur128_add_frames_double(upipe_ebur128->st, (const double *)buf,
+                                      frames);
+            break;
+    }
+}
+
+/** @internal @This is the main function of the metering thread.
+ *
+ * @param arg description structure of the pipe
+ * @return NULL
+ */
+static void *upipe_ebur128_worker(void *arg)
+{
+    struct upipe *upipe = arg;
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+
+    pthread_mutex_lock(&upipe_ebur128->mutex);
+    while (!upipe_ebur128->exit) {
+        if (upipe_ebur128->ring_read == upipe_ebur128->ring_write) {
+            upipe_ebur128->busy = false;
+            pthread_cond_signal(&upipe_ebur128->cond_idle);
+            pthread_cond_wait(&upipe_ebur128->cond_data,
+                              &upipe_ebur128->mutex);
+            continue;
+        }
+
+        /* the pipe thread does not touch the pending frames nor the
+         * parameters while we are busy */
+        upipe_ebur128->busy = true;
+        size_t offset = upipe_ebur128->ring_read % upipe_ebur128->ring_frames;
+        size_t frames = upipe_ebur128->ring_write - upipe_ebur128->ring_read;
+        if (frames > upipe_ebur128->ring_frames - offset)
+            frames = upipe_ebur128->ring_frames - offset;
+        pthread_mutex_unlock(&upipe_ebur128->mutex);
+
+        upipe_ebur128_add_frames(upipe, upipe_ebur128->ring +
+                                 offset * upipe_ebur128->frame_size, frames);
+
+        double momentary = -HUGE_VAL, shortterm = -HUGE_VAL;
+        double lra = 0, global = -HUGE_VAL;
+        ebur128_loudness_momentary(upipe_ebur128->st, &momentary);
+        ebur128_loudness_shortterm(upipe_ebur128->st, &shortterm);
+        ebur128_loudness_range(upipe_ebur128->st, &lra);
+        ebur128_loudness_global(upipe_ebur128->st, &global);
+
+        pthread_mutex_lock(&upipe_ebur128->mutex);
+        upipe_ebur128->ring_read += frames;
+        upipe_ebur128->momentary = momentary;
+        upipe_ebur128->shortterm = shortterm;
+        upipe_ebur128->lra = lra;
+        upipe_ebur128->global = global;
+    }
+    pthread_mutex_unlock(&upipe_ebur128->mutex);
+    return NULL;
+}
+
+/** @internal @This waits for the metering thread to process all pending
+ * frames. Afterwards the ebur128 state and the ring buffer may be modified
+ * until the next frames are written.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ebur128_drain(struct upipe *upipe)
+{
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+    if (!upipe_ebur128->thread_running)
+        return;
+
+    pthread_mutex_lock(&upipe_ebur128->mutex);
+    while (upipe_ebur128->busy ||
+           upipe_ebur128->ring_read != upipe_ebur128->ring_write)
+        pthread_cond_wait(&upipe_ebur128->cond_idle, &upipe_ebur128->mutex);
+    pthread_mutex_unlock(&upipe_ebur128->mutex);
+}
+
+/** @internal @This stops the metering thread.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ebur128_stop(struct upipe *upipe)
+{
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+    if (!upipe_ebur128->thread_running)
+        return;
+
+    pthread_mutex_lock(&upipe_ebur128->mutex);
+    upipe_ebur128->exit = true;
+    pthread_cond_signal(&upipe_ebur128->cond_data);
+    pthread_mutex_unlock(&upipe_ebur128->mutex);
+    pthread_join(upipe_ebur128->thread, NULL);
+    upipe_ebur128->thread_running = false;
+}
+
+/** @internal @This resizes the ring buffer. The ring buffer must be empty.
+ *
+ * @param upipe description structure of the pipe
+ * @param frames new size of the ring buffer, in frames
+ * @return an error code
+ */
+static int upipe_ebur128_alloc_ring(struct upipe *upipe, size_t frames)
+{
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+    uint8_t *ring = realloc(upipe_ebur128->ring,
+                            frames * upipe_ebur128->frame_size);
+    UBASE_ALLOC_RETURN(ring);
+    upipe_ebur128->ring = ring;
+    upipe_ebur128->ring_frames = frames;
+    upipe_ebur128->ring_read = upipe_ebur128->ring_write = 0;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This copies samples to the ring buffer, interleaving them if
+ * needed.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param dst destination in the ring buffer
+ * @param offset offset of the first sample to copy in the uref
+ * @param samples number of samples to copy
+ * @param sample_size size of a sample in a plane, in octets
+ * @return an error code
+ */
+static int upipe_ebur128_copy(struct upipe *upipe, struct uref *uref,
+                              uint8_t *dst, size_t offset, size_t samples,
+                              uint8_t sample_size)
+{
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+    if (upipe_ebur128->planes != 1)
+        return uref_sound_interleave(uref, dst, offset, samples, sample_size,
+                                     upipe_ebur128->planes);
+
+    const char *channel = NULL;
+    const uint8_t *src;
+    UBASE_RETURN(uref_sound_iterate_plane(uref, &channel))
+    if (unlikely(channel == NULL))
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_sound_plane_read_uint8_t(uref, channel, offset, samples,
+                                               &src))
+    memcpy(dst, src, samples * sample_size);
+    uref_sound_plane_unmap(uref, channel, offset, samples);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This handles input.
  *
  * @param upipe description structure of the pipe
@@ -125,9 +366,9 @@ static void upipe_ebur128_input(struct upipe *upipe, struct uref *uref,
                                 struct upump **upump_p)
 {
     struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
-    double loud = 0, lra = 0, global = 0;
 
-    if (unlikely(upipe_ebur128->output_flow == NULL)) {
+    if (unlikely(upipe_ebur128->output_flow == NULL ||
+                 !upipe_ebur128->thread_running)) {
         upipe_err_va(upipe, "invalid input");
         uref_free(uref);
         return;
@@ -141,78 +382,74 @@ static void upipe_ebur128_input(struct upipe *upipe, struct uref *uref,
         return;
     }
 
-    void *buf = NULL;
-    const char *channel = NULL;
-    if (upipe_ebur128->planes == 1) {
-        if (ubase_check(uref_sound_iterate_plane(uref, &channel)) && channel) {
-            if (unlikely(!ubase_check(uref_sound_plane_read_void(uref,
-                    channel, 0, -1, (const void **)&buf)))) {
-                upipe_warn(upipe, "error mapping sound buffer");
-                uref_free(uref);
-                return;
-            }
-        }
-
-    } else {
-        buf = malloc(sample_size * upipe_ebur128->channels * samples);
-        if (buf == NULL) {
+    if (unlikely(samples > upipe_ebur128->ring_frames / 2)) {
+        /* only happens with unusually large buffers */
+        upipe_ebur128_drain(upipe);
+        if (unlikely(!ubase_check(upipe_ebur128_alloc_ring(upipe,
+                                                           samples * 2)))) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             uref_free(uref);
             return;
         }
-        if (!ubase_check(uref_sound_interleave(uref, (uint8_t *)buf, 0,
-                                               samples, sample_size,
-                                               upipe_ebur128->planes))) {
+    }
+
+    pthread_mutex_lock(&upipe_ebur128->mutex);
+    uint64_t write = upipe_ebur128->ring_write;
+    size_t free_frames = upipe_ebur128->ring_frames -
+        (write - upipe_ebur128->ring_read);
+    pthread_mutex_unlock(&upipe_ebur128->mutex);
+
+    if (unlikely(samples > free_frames)) {
+        upipe_warn_va(upipe, "metering is late, dropping %zu samples",
+                      samples);
+    } else {
+        /* the frames between ring_write and ring_read are ours */
+        size_t offset = write % upipe_ebur128->ring_frames;
+        size_t first = upipe_ebur128->ring_frames - offset;
+        if (first > samples)
+            first = samples;
+        if (unlikely(!ubase_check(upipe_ebur128_copy(upipe, uref,
+                        upipe_ebur128->ring +
+                        offset * upipe_ebur128->frame_size,
+                        0, first, sample_size)) ||
+                     (first < samples &&
+                      !ubase_check(upipe_ebur128_copy(upipe, uref,
+                        upipe_ebur128->ring, first, samples - first,
+                        sample_size))))) {
             upipe_warn(upipe, "error mapping sound buffer");
             uref_free(uref);
             return;
         }
-    }
-
-    if (unlikely((uintptr_t)buf & 1))
-        upipe_warn(upipe, "unaligned buffer");
 
-    switch (upipe_ebur128->fmt) {
-        case UPIPE_EBUR128_SHORT:
-            ebur128_add_frames_short(upipe_ebur128->st, (short *)buf,
-                                     samples);
-            break;
+        pthread_mutex_lock(&upipe_ebur128->mutex);
+        upipe_ebur128->ring_write += samples;
+        pthread_cond_signal(&upipe_ebur128->cond_data);
+        pthread_mutex_unlock(&upipe_ebur128->mutex);
+    }
 
-        case UPIPE_EBUR128_INT:
-            ebur128_add_frames_int(upipe_ebur128->st, (int *)buf,
-                                   samples);
-            break;
+    if (!upipe_ebur128->countdown) {
+        pthread_mutex_lock(&upipe_ebur128->mutex);
+        double momentary = upipe_ebur128->momentary;
+        double shortterm = upipe_ebur128->shortterm;
+        double lra = upipe_ebur128->lra;
+        double global = upipe_ebur128->global;
+        pthread_mutex_unlock(&upipe_ebur128->mutex);
 
-        case UPIPE_EBUR128_FLOAT:
-            ebur128_add_frames_float(upipe_ebur128->st, (float *)buf,
-                                     samples);
-            break;
+        uref_ebur128_set_momentary(uref, momentary);
+        uref_ebur128_set_shortterm(uref, shortterm);
+        uref_ebur128_set_lra(uref, lra);
+        uref_ebur128_set_global(uref, global);
 
-        case UPIPE_EBUR128_DOUBLE:
-            ebur128_add_frames_double(upipe_ebur128->st, (double *)buf,
-                                      samples);
-            break;
+        upipe_verbose_va(upipe, "loud %f short %f lra %f global %f",
+                         momentary, shortterm, lra, global);
 
-        default:
-            upipe_warn_va(upipe, "unknown sample format %d",
-                          upipe_ebur128->fmt);
-            break;
+        upipe_ebur128->countdown = upipe_ebur128->period *
+            upipe_ebur128->rate / UCLOCK_FREQ;
     }
-
-    if (upipe_ebur128->planes == 1)
-        uref_sound_plane_unmap(uref, channel, 0, -1);
+    if (upipe_ebur128->countdown > samples)
+        upipe_ebur128->countdown -= samples;
     else
-        free(buf);
-
-    ebur128_loudness_momentary(upipe_ebur128->st, &loud);
-    ebur128_loudness_range(upipe_ebur128->st, &lra);
-    ebur128_loudness_global(upipe_ebur128->st, &global);
-
-    uref_ebur128_set_momentary(uref, loud);
-    uref_ebur128_set_lra(uref, lra);
-    uref_ebur128_set_global(uref, global);
-
-    upipe_verbose_va(upipe, "loud %f lra %f global %f", loud, lra, global);
+        upipe_ebur128->countdown = 0;
 
     upipe_ebur128_output(upipe, uref, upump_p);
 }
@@ -245,11 +482,14 @@ static int upipe_ebur128_set_flow_def(struct upipe *upipe,
         return UBASE_ERR_INVALID;
 
     uint64_t rate;
+    uint8_t channels, planes, sample_size;
     if (unlikely(!ubase_check(uref_sound_flow_get_rate(flow, &rate)) ||
                  !ubase_check(uref_sound_flow_get_channels(flow,
-                     &upipe_ebur128->channels)) ||
-                 !ubase_check(uref_sound_flow_get_planes(flow,
-                     &upipe_ebur128->planes))))
+                                                           &channels)) ||
+                 !ubase_check(uref_sound_flow_get_planes(flow, &planes)) ||
+                 !ubase_check(uref_sound_flow_get_sample_size(flow,
+                                                              &sample_size)) ||
+                 !rate || !channels || !planes || !sample_size))
         return UBASE_ERR_INVALID;
 
     struct uref *flow_dup;
@@ -257,16 +497,46 @@ static int upipe_ebur128_set_flow_def(struct upipe *upipe,
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return UBASE_ERR_ALLOC;
     }
+
+    /* the metering thread must not use the state while we change it */
+    upipe_ebur128_drain(upipe);
     upipe_ebur128->fmt = fmt;
+    upipe_ebur128->channels = channels;
+    upipe_ebur128->planes = planes;
+    upipe_ebur128->rate = rate;
+    upipe_ebur128->frame_size = (size_t)sample_size * planes;
+    upipe_ebur128->countdown = 0;
 
     if (unlikely(upipe_ebur128->st)) {
-        //ebur128_destroy(&upipe_ebur128->st);
-        ebur128_change_parameters(upipe_ebur128->st,
-                                  upipe_ebur128->channels, rate);
+        ebur128_change_parameters(upipe_ebur128->st, channels, rate);
     } else {
         upipe_ebur128->st =
-            ebur128_init(upipe_ebur128->channels, rate,
-            EBUR128_MODE_LRA | EBUR128_MODE_I | EBUR128_MODE_HISTOGRAM);
+            ebur128_init(channels, rate,
+                         EBUR128_MODE_S | EBUR128_MODE_LRA | EBUR128_MODE_I |
+                         EBUR128_MODE_HISTOGRAM);
+        if (unlikely(upipe_ebur128->st == NULL)) {
+            uref_free(flow_dup);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return UBASE_ERR_ALLOC;
+        }
+    }
+
+    /* one second of audio */
+    if (unlikely(!ubase_check(upipe_ebur128_alloc_ring(upipe, rate)))) {
+        uref_free(flow_dup);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+
+    if (!upipe_ebur128->thread_running) {
+        upipe_ebur128->exit = false;
+        if (unlikely(pthread_create(&upipe_ebur128->thread, NULL,
+                                    upipe_ebur128_worker, upipe) != 0)) {
+            uref_free(flow_dup);
+            upipe_err(upipe, "unable to create metering thread");
+            return UBASE_ERR_EXTERNAL;
+        }
+        upipe_ebur128->thread_running = true;
     }
 
     upipe_ebur128_store_flow_def(upipe, flow_dup);
@@ -322,6 +592,23 @@ static int upipe_ebur128_control(struct upipe *upipe,
         case UPIPE_GET_OUTPUT:
         case UPIPE_SET_OUTPUT:
             return upipe_ebur128_control_output(upipe, command, args);
+
+        case UPIPE_EBUR128_SET_PERIOD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_EBUR128_SIGNATURE)
+            struct upipe_ebur128 *upipe_ebur128 =
+                upipe_ebur128_from_upipe(upipe);
+            upipe_ebur128->period = va_arg(args, uint64_t);
+            upipe_ebur128->countdown = 0;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_EBUR128_GET_PERIOD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_EBUR128_SIGNATURE)
+            struct upipe_ebur128 *upipe_ebur128 =
+                upipe_ebur128_from_upipe(upipe);
+            uint64_t *period_p = va_arg(args, uint64_t *);
+            *period_p = upipe_ebur128->period;
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -334,9 +621,14 @@ static int upipe_ebur128_control(struct upipe *upipe,
 static void upipe_ebur128_free(struct upipe *upipe)
 {
     struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+    upipe_ebur128_stop(upipe);
     if (likely(upipe_ebur128->st)) {
         ebur128_destroy(&upipe_ebur128->st);
     }
+    free(upipe_ebur128->ring);
+    pthread_cond_destroy(&upipe_ebur128->cond_idle);
+    pthread_cond_destroy(&upipe_ebur128->cond_data);
+    pthread_mutex_destroy(&upipe_ebur128->mutex);
     upipe_throw_dead(upipe);
 
     upipe_ebur128_clean_output(upipe);
@@ -0,0 +1,225 @@
+;******************************************************************************
+;* deinterlacing kernels
+;* Copyright (C) 2006-2011 Michael Niedermayer <michaelni@gmx.at>
+;* Copyright (C) 2026 OpenHeadend S.A.R.L.
+;*
+;* This program is free software; you can redistribute it and/or modify it
+;* under the terms of the GNU Lesser General Public License as published by
+;* the Free Software Foundation; either version 2.1 of the License, or
+;* (at your option) any later version.
+;*
+;* This program is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+;* GNU Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public License
+;* along with this program; if not, write to the Free Software Foundation,
+;* Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+;******************************************************************************
+
+%include "x86util.asm"
+
+SECTION_RODATA 32
+
+pb_1: times 32 db 1
+pw_1: times 16 dw 1
+
+SECTION .text
+
+; truncated mean of two lines: pavg rounds up, so subtract the carry
+; (a ^ b) & 1; bytes must be at least mmsize
+%macro MERGE 2 ; b or w, bits
+cglobal filter_merge%2, 4, 5, 4, dst, s1, s2, bytes, i
+    mova      m3, [p%1_1]
+    sub       bytesq, mmsize
+    xor       iq, iq
+
+.loop:
+    movu      m0, [s1q+iq]
+    movu      m1, [s2q+iq]
+    pxor      m2, m0, m1
+    pavg%1    m0, m1
+    pand      m2, m3
+    psub%1    m0, m2
+    movu      [dstq+iq], m0
+    add       iq, mmsize
+    cmp       iq, bytesq
+    jb        .loop
+
+    ; the last block overlaps the previous one
+    movu      m0, [s1q+bytesq]
+    movu      m1, [s2q+bytesq]
+    pxor      m2, m0, m1
+    pavg%1    m0, m1
+    pand      m2, m3
+    psub%1    m0, m2
+    movu      [dstq+bytesq], m0
+    RET
+%endmacro
+
+INIT_XMM sse2
+MERGE b, 8
+MERGE w, 16
+INIT_YMM avx2
+MERGE b, 8
+MERGE w, 16
+
+%if ARCH_X86_64
+
+; load 16 samples and widen them to words
+%macro YADIF_LOAD 2 ; dst, address
+    pmovzxbw  %1, [%2]
+%endmacro
+
+; m7 = spatial score and m8 = spatial prediction for direction %1
+%macro YADIF_SCORE 1 ; j
+    YADIF_LOAD m7, curq+mrefsq+(%1-1)
+    YADIF_LOAD m9, curq+prefsq+(-1-%1)
+    psubw     m7, m9
+    pabsw     m7, m7
+    YADIF_LOAD m8, curq+mrefsq+(%1)
+    YADIF_LOAD m9, curq+prefsq+(-%1)
+    psubw     m10, m8, m9
+    pabsw     m10, m10
+    paddw     m7, m10
+    paddw     m8, m9
+    psrlw     m8, 1
+    YADIF_LOAD m9, curq+mrefsq+(%1+1)
+    YADIF_LOAD m10, curq+prefsq+(1-%1)
+    psubw     m9, m10
+    pabsw     m9, m9
+    paddw     m7, m9
+%endmacro
+
+; keep the prediction of direction %1 where its score is lower, and
+; only where %3 is set if given
+%macro YADIF_CHECK 2-3 ; j, mask[, outer mask]
+    YADIF_SCORE %1
+    pcmpgtw   %2, m6, m7
+%if %0 == 3
+    pand      %2, %3
+%endif
+    pblendvb  m6, m6, m7, %2
+    pblendvb  m5, m5, m8, %2
+%endmacro
+
+%macro YADIF_ADVANCE 1
+    add       dstq, %1
+    add       prevq, %1
+    add       curq, %1
+    add       nextq, %1
+    add       prev2q, %1
+    add       next2q, %1
+%endmacro
+
+INIT_YMM avx2
+; w must be at least 16
+cglobal filter_yadif8, 8, 10, 13, dst, prev, cur, next, w, prefs, mrefs, parity, prev2, next2
+    mov       prev2q, curq
+    mov       next2q, nextq
+    test      parityq, parityq
+    cmovnz    prev2q, prevq
+    cmovnz    next2q, curq
+    sub       wq, 16
+
+.loop:
+    YADIF_LOAD m0, curq+mrefsq      ; c
+    YADIF_LOAD m1, curq+prefsq      ; e
+    YADIF_LOAD m2, prev2q
+    YADIF_LOAD m3, next2q
+    psubw     m4, m2, m3
+    pabsw     m4, m4
+    psrlw     m4, 1                 ; temporal_diff0 >> 1
+    paddw     m2, m3
+    psrlw     m2, 1                 ; d
+
+    YADIF_LOAD m3, prevq+mrefsq
+    YADIF_LOAD m5, prevq+prefsq
+    psubw     m3, m0
+    pabsw     m3, m3
+    psubw     m5, m1
+    pabsw     m5, m5
+    paddw     m3, m5
+    psrlw     m3, 1                 ; temporal_diff1
+    pmaxsw    m4, m3
+    YADIF_LOAD m3, nextq+mrefsq
+    YADIF_LOAD m5, nextq+prefsq
+    psubw     m3, m0
+    pabsw     m3, m3
+    psubw     m5, m1
+    pabsw     m5, m5
+    paddw     m3, m5
+    psrlw     m3, 1                 ; temporal_diff2
+    pmaxsw    m4, m3                ; diff
+
+    paddw     m5, m0, m1
+    psrlw     m5, 1                 ; spatial_pred
+    psubw     m6, m0, m1
+    pabsw     m6, m6
+    YADIF_LOAD m7, curq+mrefsq-1
+    YADIF_LOAD m8, curq+prefsq-1
+    psubw     m7, m8
+    pabsw     m7, m7
+    paddw     m6, m7
+    YADIF_LOAD m7, curq+mrefsq+1
+    YADIF_LOAD m8, curq+prefsq+1
+    psubw     m7, m8
+    pabsw     m7, m7
+    paddw     m6, m7
+    psubw     m6, [pw_1]            ; spatial_score
+
+    YADIF_CHECK -1, m11
+    YADIF_CHECK -2, m12, m11
+    YADIF_CHECK  1, m11
+    YADIF_CHECK  2, m12, m11
+
+    YADIF_LOAD m7, prev2q+mrefsq*2
+    YADIF_LOAD m8, next2q+mrefsq*2
+    paddw     m7, m8
+    psrlw     m7, 1
+    psubw     m7, m0                ; b - c
+    YADIF_LOAD m8, prev2q+prefsq*2
+    YADIF_LOAD m9, next2q+prefsq*2
+    paddw     m8, m9
+    psrlw     m8, 1
+    psubw     m8, m1                ; f - e
+    psubw     m9, m2, m1            ; d - e
+    psubw     m10, m2, m0           ; d - c
+    pminsw    m11, m7, m8
+    pmaxsw    m7, m8
+    pmaxsw    m12, m9, m10
+    pminsw    m9, m10
+    pmaxsw    m12, m11              ; max
+    pminsw    m9, m7                ; min
+    pmaxsw    m4, m9
+    pxor      m10, m10
+    psubw     m10, m12
+    pmaxsw    m4, m10               ; diff
+
+    paddw     m7, m2, m4
+    psubw     m2, m4
+    pmaxsw    m5, m2
+    pminsw    m5, m7
+    vextracti128 xm7, m5, 1
+    packuswb  xm5, xm7
+    movu      [dstq], xm5
+
+    cmp       wq, 16
+    jb        .tail
+    YADIF_ADVANCE 16
+    sub       wq, 16
+    jmp       .loop
+
+    ; the last block overlaps the previous one
+.tail:
+    test      wq, wq
+    jz        .end
+    YADIF_ADVANCE wq
+    xor       wq, wq
+    jmp       .loop
+
+.end:
+    RET
+
+%endif ; ARCH_X86_64
@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2011 VLC authors and VideoLAN
+ * Copyright (C) 2006-2011 Michael Niedermayer <michaelni@gmx.at>
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short deinterlacing kernels
+ *
+ * Blend adapted from VLC video_filter (blend deinterlace) :
+ * - modules/video_filter/deinterlace/merge.c
+ * - modules/video_filter/deinterlace/algo_basic.c
+ *
+ * Motion-adaptive interpolation adapted from libavfilter/vf_yadif.c
+ */
+
+#include <upipe/config.h>
+#include <upipe/ubase.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "deinterlace.h"
+
+/** minimum number of octets processed by the SIMD merge kernels */
+#define MERGE_SIMD_MIN 32
+/** minimum number of samples processed by the SIMD yadif kernels */
+#define YADIF_SIMD_MIN 16
+
+/** @This computes the per-pixel mean of two lines
+ * Code from VLC.
+ * - modules/video_filter/deinterlace/merge.c
+ *
+ * @param _dest dest line
+ * @param _s1 first source line
+ * @param _s2 second source line
+ * @param bytes length in bytes
+ */
+void upipe_filter_merge16_c(void *_dest, const void *_s1,
+                            const void *_s2, uintptr_t bytes)
+{
+    uint16_t *dest = _dest;
+    const uint16_t *s1 = _s1;
+    const uint16_t *s2 = _s2;
+
+    bytes /= 2;
+    for( ; bytes > 0; bytes-- )
+        *dest++ = ( *s1++ + *s2++ ) >> 1;
+}
+
+/** @This computes the per-pixel mean of two lines
+ * Code from VLC.
+ * - modules/video_filter/deinterlace/merge.c
+ *
+ * @param _dest dest line
+ * @param _s1 first source line
+ * @param _s2 second source line
+ * @param bytes length in bytes
+ */
+void upipe_filter_merge8_c(void *_dest, const void *_s1,
+                           const void *_s2, uintptr_t bytes)
+{
+    uint8_t *dest = _dest;
+    const uint8_t *s1 = _s1;
+    const uint8_t *s2 = _s2;
+
+    for( ; bytes > 0; bytes-- )
+        *dest++ = ( *s1++ + *s2++ ) >> 1;
+}
+
+/** @This processes a picture plane
+ * Adapted from VLC.
+ * - modules/video_filter/deinterlace/algo_basic.c
+ *
+ * @param funcs deinterlacing kernels
+ * @param in input buffer
+ * @param out output buffer
+ * @param stride_in stride length of input buffer
+ * @param stride_out stride length of output buffer
+ * @param height picture height
+ * @param macropixel_size size of a macropixel in octets
+ */
+void upipe_filter_blend_plane(const struct upipe_filter_deint_funcs *funcs,
+                              const uint8_t *in, uint8_t *out,
+                              size_t stride_in, size_t stride_out,
+                              size_t height, uint8_t macropixel_size)
+{
+    uint8_t *out_end = out + stride_out * height;
+    size_t bytes = (stride_in < stride_out) ? stride_in : stride_out;
+    upipe_filter_merge_func merge;
+    if (macropixel_size == 2) {
+        bytes &= ~(size_t)1;
+        merge = bytes >= MERGE_SIMD_MIN ? funcs->merge16 :
+                upipe_filter_merge16_c;
+    } else {
+        merge = bytes >= MERGE_SIMD_MIN ? funcs->merge8 :
+                upipe_filter_merge8_c;
+    }
+
+    // Copy first line
+    memcpy(out, in, stride_in);
+    out += stride_out;
+
+    // Compute mean value for remaining lines
+    while (out < out_end) {
+        merge(out, in, in + stride_in, bytes);
+
+        out += stride_out;
+        in += stride_in;
+    }
+}
+
+/* Code adapted from libavfilter/vf_yadif.c, published under LGPL 2.1+ */
+#define YADIF_MAX(a, b) ((a) > (b) ? (a) : (b))
+#define YADIF_MIN(a, b) ((a) > (b) ? (b) : (a))
+
+#define YADIF_CHECK(j)                                                      \
+    {   int score = abs(cur[x + mrefs - 1 + (j)] - cur[x + prefs - 1 - (j)]) \
+                  + abs(cur[x + mrefs + (j)] - cur[x + prefs - (j)])        \
+                  + abs(cur[x + mrefs + 1 + (j)] - cur[x + prefs + 1 - (j)]); \
+        if (score < spatial_score) {                                        \
+            spatial_score = score;                                          \
+            spatial_pred = (cur[x + mrefs + (j)] + cur[x + prefs - (j)]) >> 1;
+
+/** @hidden */
+#define UPIPE_FILTER_YADIF_TEMPLATE(bits, type)                             \
+/** @internal @This interpolates samples of a missing line.                 \
+ *                                                                          \
+ * @param dst output line                                                   \
+ * @param prev same line in the previous picture                            \
+ * @param cur same line in the current picture                              \
+ * @param next same line in the next picture                                \
+ * @param start first sample to interpolate                                 \
+ * @param end last sample to interpolate (excluded)                         \
+ * @param prefs offset of the next line (in samples)                        \
+ * @param mrefs offset of the previous line (in samples)                    \
+ * @param parity 1 to interpolate between the previous and current pictures, \
+ * 0 between the current and next pictures                                  \
+ * @param mode 2 to skip the spatial interlacing check                      \
+ * @param is_not_edge false if there are less than 3 samples on each side   \
+ */                                                                         \
+static inline void upipe_filter_yadif##bits##_line(type *dst,               \
+        const type *prev, const type *cur, const type *next,                \
+        intptr_t start, intptr_t end, intptr_t prefs, intptr_t mrefs,       \
+        intptr_t parity, int mode, bool is_not_edge)                        \
+{                                                                           \
+    const type *prev2 = parity ? prev : cur;                                \
+    const type *next2 = parity ? cur : next;                                \
+                                                                            \
+    for (intptr_t x = start; x < end; x++) {                                \
+        int c = cur[x + mrefs];                                             \
+        int d = (prev2[x] + next2[x]) >> 1;                                 \
+        int e = cur[x + prefs];                                             \
+        int temporal_diff0 = abs(prev2[x] - next2[x]);                      \
+        int temporal_diff1 = (abs(prev[x + mrefs] - c) +                    \
+                              abs(prev[x + prefs] - e)) >> 1;               \
+        int temporal_diff2 = (abs(next[x + mrefs] - c) +                    \
+                              abs(next[x + prefs] - e)) >> 1;               \
+        int diff = YADIF_MAX(YADIF_MAX(temporal_diff0 >> 1,                 \
+                                       temporal_diff1), temporal_diff2);    \
+        int spatial_pred = (c + e) >> 1;                                    \
+                                                                            \
+        if (is_not_edge) {                                                  \
+            int spatial_score = abs(cur[x + mrefs - 1] -                    \
+                                    cur[x + prefs - 1]) + abs(c - e) +      \
+                                abs(cur[x + mrefs + 1] -                    \
+                                    cur[x + prefs + 1]) - 1;                \
+            YADIF_CHECK(-1) YADIF_CHECK(-2) }} }}                           \
+            YADIF_CHECK( 1) YADIF_CHECK( 2) }} }}                           \
+        }                                                                   \
+                                                                            \
+        if (!(mode & 2)) {                                                  \
+            int b = (prev2[x + 2 * mrefs] + next2[x + 2 * mrefs]) >> 1;     \
+            int f = (prev2[x + 2 * prefs] + next2[x + 2 * prefs]) >> 1;     \
+            int max = YADIF_MAX(YADIF_MAX(d - e, d - c),                    \
+                                YADIF_MIN(b - c, f - e));                   \
+            int min = YADIF_MIN(YADIF_MIN(d - e, d - c),                    \
+                                YADIF_MAX(b - c, f - e));                   \
+                                                                            \
+            diff = YADIF_MAX(YADIF_MAX(diff, min), -max);                   \
+        }                                                                   \
+                                                                            \
+        if (spatial_pred > d + diff)                                        \
+            spatial_pred = d + diff;                                        \
+        else if (spatial_pred < d - diff)                                   \
+            spatial_pred = d - diff;                                        \
+                                                                            \
+        dst[x] = spatial_pred;                                              \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+/** @This interpolates samples of a missing line, with spatial              \
+ * interlacing check.                                                       \
+ *                                                                          \
+ * @param dst output line                                                   \
+ * @param prev same line in the previous picture                            \
+ * @param cur same line in the current picture                              \
+ * @param next same line in the next picture                                \
+ * @param w number of samples                                               \
+ * @param prefs offset of the next line (in samples)                        \
+ * @param mrefs offset of the previous line (in samples)                    \
+ * @param parity 1 to interpolate between the previous and current pictures, \
+ * 0 between the current and next pictures                                  \
+ */                                                                         \
+void upipe_filter_yadif##bits##_c(void *dst, const void *prev,              \
+                                  const void *cur, const void *next,        \
+                                  intptr_t w, intptr_t prefs,               \
+                                  intptr_t mrefs, intptr_t parity)          \
+{                                                                           \
+    upipe_filter_yadif##bits##_line(dst, prev, cur, next, 0, w,             \
+                                    prefs, mrefs, parity, 0, true);         \
+}                                                                           \
+                                                                            \
+/** @internal @This deinterlaces a picture plane.                           \
+ *                                                                          \
+ * @param func interpolation kernel                                         \
+ * @param prev previous picture                                             \
+ * @param cur current picture                                               \
+ * @param next next picture                                                 \
+ * @param out output picture                                                \
+ * @param stride_in stride of the input pictures (in samples)               \
+ * @param stride_out stride of the output picture (in samples)              \
+ * @param w number of samples per line                                      \
+ * @param h number of lines                                                 \
+ * @param parity 1 to interpolate even lines, 0 for odd lines               \
+ * @param tff 1 if the top field is first                                   \
+ */                                                                         \
+static void upipe_filter_yadif##bits##_plane(upipe_filter_yadif_func func,  \
+        const type *prev, const type *cur, const type *next, type *out,     \
+        intptr_t stride_in, intptr_t stride_out, intptr_t w, intptr_t h,    \
+        int parity, int tff)                                                \
+{                                                                           \
+    for (intptr_t y = 0; y < h; y++) {                                      \
+        if ((y ^ parity) & 1) {                                             \
+            intptr_t prefs = y + 1 < h ? stride_in : -stride_in;            \
+            intptr_t mrefs = y ? -stride_in : stride_in;                    \
+            int mode = y == 1 || y + 2 == h ? 2 : 0;                        \
+            intptr_t edge = w < 3 ? w : 3;                                  \
+            upipe_filter_yadif##bits##_line(out, prev, cur, next, 0, edge,  \
+                    prefs, mrefs, parity ^ tff, mode, false);               \
+            if (!mode && w >= YADIF_SIMD_MIN + 6)                           \
+                func(out + 3, prev + 3, cur + 3, next + 3, w - 6,           \
+                     prefs, mrefs, parity ^ tff);                           \
+            else                                                            \
+                upipe_filter_yadif##bits##_line(out, prev, cur, next,       \
+                        3, w - 3, prefs, mrefs, parity ^ tff, mode, true);  \
+            upipe_filter_yadif##bits##_line(out, prev, cur, next,           \
+                    w - 3 > edge ? w - 3 : edge, w,                         \
+                    prefs, mrefs, parity ^ tff, mode, false);               \
+        } else {                                                            \
+            memcpy(out, cur, w * sizeof(type));                             \
+        }                                                                   \
+        out += stride_out;                                                  \
+        prev += stride_in;                                                  \
+        cur += stride_in;                                                   \
+        next += stride_in;                                                  \
+    }                                                                       \
+}
+
+UPIPE_FILTER_YADIF_TEMPLATE(8, uint8_t)
+UPIPE_FILTER_YADIF_TEMPLATE(16, uint16_t)
+/* End code */
+
+/** @This deinterlaces a picture plane with motion-adaptive interpolation
+ * of the missing field. The three input pictures must share the same
+ * stride, and the plane must have at least two lines.
+ *
+ * @param funcs deinterlacing kernels
+ * @param prev previous picture
+ * @param cur current picture
+ * @param next next picture
+ * @param out output picture
+ * @param stride_in stride of the input pictures, in octets
+ * @param stride_out stride of the output picture, in octets
+ * @param width number of samples per line
+ * @param height number of lines
+ * @param sample_size size of a sample in octets (1 or 2)
+ * @param parity 1 to interpolate even lines, 0 for odd lines
+ * @param tff 1 if the top field is first
+ */
+void upipe_filter_yadif_plane(const struct upipe_filter_deint_funcs *funcs,
+                              const uint8_t *prev, const uint8_t *cur,
+                              const uint8_t *next, uint8_t *out,
+                              size_t stride_in, size_t stride_out,
+                              size_t width, size_t height,
+                              uint8_t sample_size, int parity, int tff)
+{
+    if (sample_size == 2)
+        upipe_filter_yadif16_plane(funcs->yadif16,
+                (const uint16_t *)prev, (const uint16_t *)cur,
+                (const uint16_t *)next, (uint16_t *)out,
+                stride_in / 2, stride_out / 2, width, height, parity, tff);
+    else
+        upipe_filter_yadif8_plane(funcs->yadif8, prev, cur, next, out,
+                stride_in, stride_out, width, height, parity, tff);
+}
+
+/** @This selects the fastest deinterlacing kernels supported by the CPU.
+ * The assembly kernels are only selected with --enable-unchecked-asm, until
+ * checkasm has validated them.
+ *
+ * @param funcs filled in with the kernels
+ */
+void upipe_filter_deint_setup(struct upipe_filter_deint_funcs *funcs)
+{
+    funcs->merge8 = upipe_filter_merge8_c;
+    funcs->merge16 = upipe_filter_merge16_c;
+    funcs->yadif8 = upipe_filter_yadif8_c;
+    funcs->yadif16 = upipe_filter_yadif16_c;
+
+#if defined(UPIPE_HAVE_X86ASM) && defined(UPIPE_HAVE_UNCHECKED_ASM)
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("sse2")) {
+        funcs->merge8 = upipe_filter_merge8_sse2;
+        funcs->merge16 = upipe_filter_merge16_sse2;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        funcs->merge8 = upipe_filter_merge8_avx2;
+        funcs->merge16 = upipe_filter_merge16_avx2;
+#if defined(__x86_64__)
+        funcs->yadif8 = upipe_filter_yadif8_avx2;
+#endif
+    }
+#endif
+#endif
+}
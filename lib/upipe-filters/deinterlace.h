@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short deinterlacing kernels
+ */
+
+#ifndef _UPIPE_FILTERS_DEINTERLACE_H_
+/** @hidden */
+#define _UPIPE_FILTERS_DEINTERLACE_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+
+/* compute the per-sample truncated mean of two lines; the SIMD kernels
+ * require at least 32 octets */
+typedef void (*upipe_filter_merge_func)(void *dst, const void *s1, const void *s2, uintptr_t bytes);
+
+/* interpolate w samples of a missing line from the current, previous and
+ * next pictures, with spatial interlacing check; 3 samples must be readable
+ * on both sides, and the SIMD kernels require at least 16 samples */
+typedef void (*upipe_filter_yadif_func)(void *dst, const void *prev, const void *cur, const void *next, intptr_t w, intptr_t prefs, intptr_t mrefs, intptr_t parity);
+
+/* fastest kernels supported by the CPU */
+struct upipe_filter_deint_funcs {
+    upipe_filter_merge_func merge8;
+    upipe_filter_merge_func merge16;
+    upipe_filter_yadif_func yadif8;
+    upipe_filter_yadif_func yadif16;
+};
+
+void upipe_filter_deint_setup(struct upipe_filter_deint_funcs *funcs);
+
+void upipe_filter_blend_plane(const struct upipe_filter_deint_funcs *funcs, const uint8_t *in, uint8_t *out, size_t stride_in, size_t stride_out, size_t height, uint8_t macropixel_size);
+void upipe_filter_yadif_plane(const struct upipe_filter_deint_funcs *funcs, const uint8_t *prev, const uint8_t *cur, const uint8_t *next, uint8_t *out, size_t stride_in, size_t stride_out, size_t width, size_t height, uint8_t sample_size, int parity, int tff);
+
+void upipe_filter_merge8_c(void *dst, const void *s1, const void *s2, uintptr_t bytes);
+void upipe_filter_merge16_c(void *dst, const void *s1, const void *s2, uintptr_t bytes);
+void upipe_filter_yadif8_c(void *dst, const void *prev, const void *cur, const void *next, intptr_t w, intptr_t prefs, intptr_t mrefs, intptr_t parity);
+void upipe_filter_yadif16_c(void *dst, const void *prev, const void *cur, const void *next, intptr_t w, intptr_t prefs, intptr_t mrefs, intptr_t parity);
+
+void upipe_filter_merge8_sse2(void *dst, const void *s1, const void *s2, uintptr_t bytes);
+void upipe_filter_merge8_avx2(void *dst, const void *s1, const void *s2, uintptr_t bytes);
+void upipe_filter_merge16_sse2(void *dst, const void *s1, const void *s2, uintptr_t bytes);
+void upipe_filter_merge16_avx2(void *dst, const void *s1, const void *s2, uintptr_t bytes);
+/* 16 samples per iteration, x86_64 only */
+void upipe_filter_yadif8_avx2(void *dst, const void *prev, const void *cur, const void *next, intptr_t w, intptr_t prefs, intptr_t mrefs, intptr_t parity);
+
+#endif
@@ -25,6 +25,8 @@
  * Adapted from VLC video_filter (blend deinterlace) :
  * - modules/video_filter/deinterlace/merge.c
  * - modules/video_filter/deinterlace/algo_basic.c
+ *
+ * The motion-adaptive mode is adapted from libavfilter/vf_yadif.c.
  */
 
 #include <upipe/ulist.h>
@@ -46,6 +48,8 @@
 #include <upipe/upipe_helper_input.h>
 #include <upipe-filters/upipe_filter_blend.h>
 
+#include "deinterlace.h"
+
 #include <stdlib.h>
 #include <strings.h>
 #include <stdint.h>
@@ -88,6 +92,15 @@ struct upipe_filter_blend {
     /** list of blockers (used during udeal) */
     struct uchain blockers;
 
+    /** deinterlacing mode */
+    enum upipe_filter_blend_mode mode;
+    /** deinterlacing kernels */
+    struct upipe_filter_deint_funcs funcs;
+    /** previous picture (yadif mode) */
+    struct uref *prev;
+    /** current picture, waiting for the next one (yadif mode) */
+    struct uref *cur;
+
     /** public structure */
     struct upipe upipe;
 };
@@ -123,106 +136,28 @@ static struct upipe *upipe_filter_blend_alloc(struct upipe_mgr *mgr,
     upipe_filter_blend_init_ubuf_mgr(upipe);
     upipe_filter_blend_init_output(upipe);
     upipe_filter_blend_init_input(upipe);
-    upipe_throw_ready(upipe);
-    return upipe;
-}
-
-/** @internal @This computes the per-pixel mean of two lines
- * Code from VLC.
- * - modules/video_filter/deinterlace/merge.c
- *
- * @param _dest dest line
- * @param _s1 first source line
- * @param _s2 second source line
- * @param bytes length in bytes
- */
-static void upipe_filter_merge16bit( void *_dest, const void *_s1,
-                       const void *_s2, size_t bytes )
-{
-    uint16_t *dest = _dest;
-    const uint16_t *s1 = _s1;
-    const uint16_t *s2 = _s2;
-
-    bytes /= 2;
-    for( ; bytes > 0; bytes-- )
-        *dest++ = ( *s1++ + *s2++ ) >> 1;
-}
-
-/** @internal @This computes the per-pixel mean of two lines
- * Code from VLC.
- * - modules/video_filter/deinterlace/merge.c
- *
- * @param _dest dest line
- * @param _s1 first source line
- * @param _s2 second source line
- * @param bytes length in bytes
- */
-static void upipe_filter_merge8bit( void *_dest, const void *_s1,
-                       const void *_s2, size_t bytes )
-{
-    uint8_t *dest = _dest;
-    const uint8_t *s1 = _s1;
-    const uint8_t *s2 = _s2;
 
-    for( ; bytes > 0; bytes-- )
-        *dest++ = ( *s1++ + *s2++ ) >> 1;
-}
+    struct upipe_filter_blend *upipe_filter_blend =
+        upipe_filter_blend_from_upipe(upipe);
+    upipe_filter_blend->mode = UPIPE_FILTER_BLEND_MODE_BLEND;
+    upipe_filter_deint_setup(&upipe_filter_blend->funcs);
+    upipe_filter_blend->prev = NULL;
+    upipe_filter_blend->cur = NULL;
 
-/** @internal @This processes a picture plane
- * Adapted from VLC.
- * - modules/video_filter/deinterlace/algo_basic.c
- *
- * @param in input buffer
- * @param out output buffer
- * @param stride_in stride length of input buffer
- * @param stride_out stride length of output buffer
- * @param height picture height
- */
-static void upipe_filter_blend_plane(const uint8_t *in, uint8_t *out,
-                                     size_t stride_in, size_t stride_out,
-                                     size_t height, uint8_t macropixel_size)
-{
-    uint8_t *out_end = out + stride_out * height;
-
-    // Copy first line
-    memcpy(out, in, stride_in);
-    out += stride_out;
-
-    // Compute mean value for remaining lines
-    while (out < out_end) {
-        if (macropixel_size == 2)
-            upipe_filter_merge16bit(out, in, in+stride_in,
-                    (stride_in < stride_out) ? stride_in : stride_out);
-        else
-            upipe_filter_merge8bit(out, in, in+stride_in,
-                    (stride_in < stride_out) ? stride_in : stride_out);
-
-        out += stride_out;
-        in += stride_in;
-    }
+    upipe_throw_ready(upipe);
+    return upipe;
 }
 
-/** @internal @This handles input.
+/** @internal @This blends a picture.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
  * @param upump_p reference to upump structure
- * @return always true
  */
-static bool upipe_filter_blend_handle(struct upipe *upipe, struct uref *uref,
-                                      struct upump **upump_p)
+static void upipe_filter_blend_blend(struct upipe *upipe, struct uref *uref,
+                                     struct upump **upump_p)
 {
     struct upipe_filter_blend *upipe_filter_blend = upipe_filter_blend_from_upipe(upipe);
-    const char *def;
-    if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
-        upipe_filter_blend_store_flow_def(upipe, NULL);
-        upipe_filter_blend_require_ubuf_mgr(upipe, uref);
-        return true;
-    }
-
-    if (upipe_filter_blend->flow_def == NULL)
-        return false;
-
     const uint8_t *in;
     uint8_t *out;
     uint8_t hsub, vsub, macropixel_size;
@@ -258,7 +193,9 @@ static bool upipe_filter_blend_handle(struct upipe *upipe, struct uref *uref,
         ubuf_pic_plane_write(ubuf_deint, chroma, 0, 0, -1, -1, &out);
 
         // process plane
-        upipe_filter_blend_plane(in, out, stride_in, stride_out, (size_t) height/vsub, macropixel_size);
+        upipe_filter_blend_plane(&upipe_filter_blend->funcs, in, out,
+                                 stride_in, stride_out,
+                                 (size_t) height/vsub, macropixel_size);
 
         // unmap all
         uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1);
@@ -271,13 +208,195 @@ static bool upipe_filter_blend_handle(struct upipe *upipe, struct uref *uref,
     uref_pic_delete_tff(uref);
 
     upipe_filter_blend_output(upipe, uref, upump_p);
-    return true;
+    return;
 
 error:
     uref_free(uref);
     if (ubuf_deint) {
         ubuf_free(ubuf_deint);
     }
+}
+
+/** @internal @This checks whether a neighbouring picture may be used to
+ * deinterlace the current one.
+ *
+ * @param uref neighbouring picture
+ * @param width width of the current picture
+ * @param height height of the current picture
+ * @return true if the sizes match
+ */
+static bool upipe_filter_blend_match(struct uref *uref,
+                                     size_t width, size_t height)
+{
+    size_t uref_width, uref_height;
+    return ubase_check(uref_pic_size(uref, &uref_width, &uref_height, NULL)) &&
+           uref_width == width && uref_height == height;
+}
+
+/** @internal @This deinterlaces the current picture with motion-adaptive
+ * interpolation of the second field, and outputs it. The previous and next
+ * pictures are only read.
+ *
+ * @param upipe description structure of the pipe
+ * @param prev previous picture
+ * @param cur current picture
+ * @param next next picture
+ * @param upump_p reference to upump structure
+ */
+static void upipe_filter_blend_yadif(struct upipe *upipe, struct uref *prev,
+                                     struct uref *cur, struct uref *next,
+                                     struct upump **upump_p)
+{
+    struct upipe_filter_blend *upipe_filter_blend = upipe_filter_blend_from_upipe(upipe);
+    size_t width, height;
+    uint8_t macropixel;
+    if (unlikely(!ubase_check(uref_pic_size(cur, &width, &height,
+                                            &macropixel)))) {
+        upipe_warn(upipe, "invalid picture received");
+        return;
+    }
+    upipe_verbose_va(upipe, "received pic (%zux%zu)", width, height);
+
+    if (!upipe_filter_blend_match(prev, width, height))
+        prev = cur;
+    if (!upipe_filter_blend_match(next, width, height))
+        next = cur;
+    int tff = ubase_check(uref_pic_get_tff(cur)) ? 1 : 0;
+
+    struct uref *uref = uref_dup(cur);
+    assert(upipe_filter_blend->ubuf_mgr);
+    struct ubuf *ubuf_deint = ubuf_pic_alloc(upipe_filter_blend->ubuf_mgr,
+                                             width, height);
+    if (unlikely(uref == NULL || ubuf_deint == NULL)) {
+        uref_free(uref);
+        if (ubuf_deint != NULL)
+            ubuf_free(ubuf_deint);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    const char *chroma;
+    uref_pic_foreach_plane(cur, chroma) {
+        size_t stride_in, stride_prev, stride_next, stride_out;
+        uint8_t hsub, vsub, macropixel_size;
+        const uint8_t *in_prev, *in, *in_next;
+        uint8_t *out;
+        if (unlikely(!ubase_check(uref_pic_plane_size(cur, chroma, &stride_in,
+                                                &hsub, &vsub, &macropixel_size)) ||
+                     !ubase_check(ubuf_pic_plane_size(ubuf_deint, chroma,
+                                                &stride_out, NULL, NULL, NULL)) ||
+                     !ubase_check(uref_pic_plane_read(cur, chroma, 0, 0, -1, -1,
+                                                      &in)))) {
+            upipe_err_va(upipe, "Could not read chroma %s", chroma);
+            uref_free(uref);
+            ubuf_free(ubuf_deint);
+            return;
+        }
+        ubuf_pic_plane_write(ubuf_deint, chroma, 0, 0, -1, -1, &out);
+
+        size_t plane_height = height / vsub;
+        if (macropixel != 1 || macropixel_size > 2 || plane_height < 2) {
+            /* packed pixels have no single sample size */
+            upipe_filter_blend_plane(&upipe_filter_blend->funcs, in, out,
+                                     stride_in, stride_out, plane_height,
+                                     macropixel_size);
+        } else {
+            in_prev = in_next = in;
+            if (prev != cur &&
+                (!ubase_check(uref_pic_plane_size(prev, chroma, &stride_prev,
+                                                  NULL, NULL, NULL)) ||
+                 stride_prev != stride_in ||
+                 !ubase_check(uref_pic_plane_read(prev, chroma, 0, 0, -1, -1,
+                                                  &in_prev))))
+                in_prev = in;
+            if (next != cur &&
+                (!ubase_check(uref_pic_plane_size(next, chroma, &stride_next,
+                                                  NULL, NULL, NULL)) ||
+                 stride_next != stride_in ||
+                 !ubase_check(uref_pic_plane_read(next, chroma, 0, 0, -1, -1,
+                                                  &in_next))))
+                in_next = in;
+
+            upipe_filter_yadif_plane(&upipe_filter_blend->funcs,
+                                     in_prev, in, in_next, out,
+                                     stride_in, stride_out, width / hsub,
+                                     plane_height, macropixel_size,
+                                     tff ^ 1, tff);
+
+            if (in_prev != in)
+                uref_pic_plane_unmap(prev, chroma, 0, 0, -1, -1);
+            if (in_next != in)
+                uref_pic_plane_unmap(next, chroma, 0, 0, -1, -1);
+        }
+
+        uref_pic_plane_unmap(cur, chroma, 0, 0, -1, -1);
+        ubuf_pic_plane_unmap(ubuf_deint, chroma, 0, 0, -1, -1);
+    }
+
+    uref_attach_ubuf(uref, ubuf_deint);
+    uref_pic_set_progressive(uref);
+    uref_pic_delete_tff(uref);
+
+    upipe_filter_blend_output(upipe, uref, upump_p);
+}
+
+/** @internal @This outputs the buffered picture, if any, in yadif mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to upump structure
+ */
+static void upipe_filter_blend_flush(struct upipe *upipe,
+                                     struct upump **upump_p)
+{
+    struct upipe_filter_blend *upipe_filter_blend = upipe_filter_blend_from_upipe(upipe);
+    struct uref *prev = upipe_filter_blend->prev;
+    struct uref *cur = upipe_filter_blend->cur;
+    upipe_filter_blend->prev = NULL;
+    upipe_filter_blend->cur = NULL;
+
+    if (cur != NULL && upipe_filter_blend->flow_def != NULL)
+        upipe_filter_blend_yadif(upipe, prev != NULL ? prev : cur, cur, cur,
+                                 upump_p);
+    uref_free(prev);
+    uref_free(cur);
+}
+
+/** @internal @This handles input.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to upump structure
+ * @return always true
+ */
+static bool upipe_filter_blend_handle(struct upipe *upipe, struct uref *uref,
+                                      struct upump **upump_p)
+{
+    struct upipe_filter_blend *upipe_filter_blend = upipe_filter_blend_from_upipe(upipe);
+    const char *def;
+    if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        upipe_filter_blend_flush(upipe, upump_p);
+        upipe_filter_blend_store_flow_def(upipe, NULL);
+        upipe_filter_blend_require_ubuf_mgr(upipe, uref);
+        return true;
+    }
+
+    if (upipe_filter_blend->flow_def == NULL)
+        return false;
+
+    if (upipe_filter_blend->mode == UPIPE_FILTER_BLEND_MODE_BLEND) {
+        upipe_filter_blend_blend(upipe, uref, upump_p);
+        return true;
+    }
+
+    /* the current picture is output when the next one is received */
+    if (upipe_filter_blend->cur != NULL) {
+        struct uref *prev = upipe_filter_blend->prev;
+        upipe_filter_blend_yadif(upipe, prev != NULL ? prev : upipe_filter_blend->cur,
+                                 upipe_filter_blend->cur, uref, upump_p);
+        uref_free(prev);
+        upipe_filter_blend->prev = upipe_filter_blend->cur;
+    }
+    upipe_filter_blend->cur = uref;
     return true;
 }
 
@@ -352,6 +471,40 @@ static int upipe_filter_blend_set_flow_def(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the current deinterlacing mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode_p filled in with the mode
+ * @return an error code
+ */
+static int _upipe_filter_blend_get_mode(struct upipe *upipe, int *mode_p)
+{
+    struct upipe_filter_blend *upipe_filter_blend =
+        upipe_filter_blend_from_upipe(upipe);
+    *mode_p = upipe_filter_blend->mode;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the deinterlacing mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode new mode
+ * @return an error code
+ */
+static int _upipe_filter_blend_set_mode(struct upipe *upipe, int mode)
+{
+    struct upipe_filter_blend *upipe_filter_blend =
+        upipe_filter_blend_from_upipe(upipe);
+    if (mode != UPIPE_FILTER_BLEND_MODE_BLEND &&
+        mode != UPIPE_FILTER_BLEND_MODE_YADIF)
+        return UBASE_ERR_INVALID;
+
+    if (mode == UPIPE_FILTER_BLEND_MODE_BLEND)
+        upipe_filter_blend_flush(upipe, NULL);
+    upipe_filter_blend->mode = mode;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on the pipe.
  *
  * @param upipe description structure of the pipe
@@ -385,6 +538,20 @@ static int upipe_filter_blend_control(struct upipe *upipe,
         case UPIPE_GET_OUTPUT:
         case UPIPE_SET_OUTPUT:
             return upipe_filter_blend_control_output(upipe, command, args);
+        case UPIPE_FLUSH:
+            upipe_filter_blend_flush(upipe, NULL);
+            return UBASE_ERR_NONE;
+
+        case UPIPE_FILTER_BLEND_GET_MODE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FILTER_BLEND_SIGNATURE)
+            int *mode_p = va_arg(args, int *);
+            return _upipe_filter_blend_get_mode(upipe, mode_p);
+        }
+        case UPIPE_FILTER_BLEND_SET_MODE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FILTER_BLEND_SIGNATURE)
+            int mode = va_arg(args, int);
+            return _upipe_filter_blend_set_mode(upipe, mode);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -396,6 +563,8 @@ static int upipe_filter_blend_control(struct upipe *upipe,
  */
 static void upipe_filter_blend_free(struct upipe *upipe)
 {
+    /* output the buffered picture */
+    upipe_filter_blend_flush(upipe, NULL);
     upipe_throw_dead(upipe);
 
     upipe_filter_blend_clean_input(upipe);
@@ -0,0 +1,127 @@
+;******************************************************************************
+;* MPEG-style start code search
+;* Copyright (C) 2026 OpenHeadend S.A.R.L.
+;*
+;* Permission is hereby granted, free of charge, to any person obtaining
+;* a copy of this software and associated documentation files (the
+;* "Software"), to deal in the Software without restriction, including
+;* without limitation the rights to use, copy, modify, merge, publish,
+;* distribute, sublicense, and/or sell copies of the Software, and to
+;* permit persons to whom the Software is furnished to do so, subject
+;* to the following conditions:
+;*
+;* The above copyright notice and this permission notice shall be
+;* included in all copies or substantial portions of the Software.
+;*
+;* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+;* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+;* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+;* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+;* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+;* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+;* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+%include "x86util.asm"
+
+SECTION_RODATA 32
+
+pb_1: times 64 db 1
+
+SECTION .text
+
+; look for a start code beginning in each of the mmsize octets at bufq+%1:
+; p[i] | p[i+1] is zero and p[i+2] is one
+%macro FIND_BLOCK 1 ; offset
+    movu      m0, [bufq+%1]
+    movu      m1, [bufq+%1+1]
+    por       m0, m1
+    pcmpeqb   m0, m3
+    movu      m1, [bufq+%1+2]
+    pcmpeqb   m1, m2
+    pand      m0, m1
+    pmovmskb  maskd, m0
+    test      maskd, maskd
+    jnz       .found
+%endmacro
+
+%macro MPEG_FIND 0
+; size must be at least mmsize+2
+cglobal framers_mpeg_find, 2, 4, 4, buf, size, i, mask
+    pxor      m3, m3
+    mova      m2, [pb_1]
+    sub       sizeq, mmsize+2
+    xor       iq, iq
+
+.loop:
+    FIND_BLOCK iq
+    add       iq, mmsize
+    cmp       iq, sizeq
+    jb        .loop
+
+    ; the last block overlaps the previous one, which has no start code
+    mov       iq, sizeq
+    FIND_BLOCK iq
+    add       sizeq, mmsize+2
+%if ARCH_X86_64
+    mov       rax, sizeq
+%else
+    mov       eax, sizeq
+%endif
+    RET
+
+.found:
+    tzcnt     maskd, maskd
+    add       iq, maskq
+%if ARCH_X86_64
+    mov       rax, iq
+%else
+    mov       eax, iq
+%endif
+    RET
+%endmacro
+
+INIT_XMM sse2
+MPEG_FIND
+INIT_YMM avx2
+MPEG_FIND
+
+%if ARCH_X86_64
+; x86inc.asm has no AVX-512 support, so this kernel names the zmm and mask
+; registers itself and clears the upper state before returning
+%macro FIND_BLOCK_AVX512 1 ; offset
+    vmovdqu64 zmm0, [bufq+%1]
+    vporq     zmm0, zmm0, [bufq+%1+1]
+    vptestnmb k1, zmm0, zmm0
+    vpcmpeqb  k1{k1}, zmm2, [bufq+%1+2]
+    kmovq     maskq, k1
+    test      maskq, maskq
+    jnz       .found
+%endmacro
+
+INIT_XMM
+cglobal framers_mpeg_find_avx512, 2, 4, 0, buf, size, i, mask
+    vmovdqu64 zmm2, [pb_1]
+    sub       sizeq, 64+2
+    xor       iq, iq
+
+.loop:
+    FIND_BLOCK_AVX512 iq
+    add       iq, 64
+    cmp       iq, sizeq
+    jb        .loop
+
+    ; the last block overlaps the previous one, which has no start code
+    mov       iq, sizeq
+    FIND_BLOCK_AVX512 iq
+    add       sizeq, 64+2
+    mov       rax, sizeq
+    vzeroupper
+    RET
+
+.found:
+    tzcnt     maskq, maskq
+    add       iq, maskq
+    mov       rax, iq
+    vzeroupper
+    RET
+%endif
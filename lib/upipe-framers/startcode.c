@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ * Copyright (c) 2000,2001 Fabrice Bellard
+ * Copyright (c) 2002-2004 Michael Niedermayer <michaelni@gmx.at>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short MPEG-style start code search kernels
+ */
+
+#include <upipe/config.h>
+#include <upipe/ubase.h>
+
+#include <stdint.h>
+
+#include "startcode.h"
+
+/** @This looks for a start code octet by octet, skipping up to three
+ * octets at a time depending on the value of the last one.
+ *
+ * @param buf linear buffer
+ * @param size size of the buffer
+ * @return offset of the first start code, or size if not found
+ */
+/* Code from libav/libavcodec/mpegvideo.c, published under LGPL 2.1+ */
+uintptr_t upipe_framers_mpeg_find_c(const uint8_t *buf, uintptr_t size)
+{
+    const uint8_t *p = buf + 2;
+    const uint8_t *end = buf + size;
+
+    while (p < end) {
+        if      (p[0] > 1          ) p += 3;
+        else if (p[-1]             ) p += 2;
+        else if (p[-2] | (p[0] - 1)) p++;
+        else
+            return p - 2 - buf;
+    }
+    return size;
+}
+/* End code */
+
+/** @This returns the fastest start code search kernel supported by the CPU.
+ * Kernels other than the C version must be passed at least
+ * @ref UPIPE_FRAMERS_MPEG_FIND_MIN octets. The assembly kernels are only
+ * selected with --enable-unchecked-asm, until checkasm has validated them.
+ *
+ * @return pointer to the search kernel
+ */
+upipe_framers_mpeg_find_func upipe_framers_mpeg_find_setup(void)
+{
+#if defined(UPIPE_HAVE_X86ASM) && defined(UPIPE_HAVE_UNCHECKED_ASM)
+#if defined(__i686__) || defined(__x86_64__)
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx512bw"))
+        return upipe_framers_mpeg_find_avx512;
+#endif
+    if (__builtin_cpu_supports("avx2"))
+        return upipe_framers_mpeg_find_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return upipe_framers_mpeg_find_sse2;
+#endif
+#endif
+    return upipe_framers_mpeg_find_c;
+}
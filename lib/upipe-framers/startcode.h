@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short MPEG-style start code search kernels
+ */
+
+#ifndef _UPIPE_FRAMERS_STARTCODE_H_
+/** @hidden */
+#define _UPIPE_FRAMERS_STARTCODE_H_
+
+#include <inttypes.h>
+
+/* return the offset of the first 00 00 01 start code entirely contained in
+ * the first size octets of buf, or size if there is none */
+typedef uintptr_t (*upipe_framers_mpeg_find_func)(const uint8_t *buf, uintptr_t size);
+
+/* minimum size accepted by the SIMD kernels */
+#define UPIPE_FRAMERS_MPEG_FIND_MIN 128
+
+upipe_framers_mpeg_find_func upipe_framers_mpeg_find_setup(void);
+
+uintptr_t upipe_framers_mpeg_find_c(const uint8_t *buf, uintptr_t size);
+
+/* process 16 octets per iteration, with a zero-octet mask confirmed by
+ * the third octet */
+uintptr_t upipe_framers_mpeg_find_sse2(const uint8_t *buf, uintptr_t size);
+/* process 32 octets per iteration */
+uintptr_t upipe_framers_mpeg_find_avx2(const uint8_t *buf, uintptr_t size);
+/* process 64 octets per iteration, x86_64 only */
+uintptr_t upipe_framers_mpeg_find_avx512(const uint8_t *buf, uintptr_t size);
+
+#endif
@@ -26,8 +26,14 @@
 
 #include <stdint.h>
 
+#include <upipe/uatomic.h>
 #include <upipe-framers/upipe_framers_common.h>
 
+#include "startcode.h"
+
+/** search kernel, resolved on first use */
+static uatomic_ptr_t upipe_framers_mpeg_find;
+
 /** @This scans for an MPEG-style 3-octet start code in a linear buffer.
  *
  * @param p linear buffer
@@ -48,18 +54,25 @@ const uint8_t *upipe_framers_mpeg_scan(const uint8_t *restrict p,
             return p;
     }
 
-    while (p < end) {
-        if      (p[-1] > 1      ) p += 3;
-        else if (p[-2]          ) p += 2;
-        else if (p[-3]|(p[-1]-1)) p++;
-        else {
-            p++;
-            break;
+    /* the octet following the start code must be in the buffer */
+    const uint8_t *buf = p - 3;
+    uintptr_t size = end - buf - 1;
+    uintptr_t offset;
+    if (size < UPIPE_FRAMERS_MPEG_FIND_MIN)
+        offset = upipe_framers_mpeg_find_c(buf, size);
+    else {
+        upipe_framers_mpeg_find_func find =
+            uatomic_ptr_load_ptr(&upipe_framers_mpeg_find,
+                                 upipe_framers_mpeg_find_func);
+        if (unlikely(find == NULL)) {
+            /* all threads resolve the same kernel */
+            find = upipe_framers_mpeg_find_setup();
+            uatomic_ptr_store(&upipe_framers_mpeg_find, (void *)find);
         }
+        offset = find(buf, size);
     }
+    p = offset < size ? buf + offset + 4 : end;
 
-    if (p > end)
-        p = end;
     *state = ((uint32_t)p[-4] << 24) | (p[-3] << 16) | (p[-2] << 8) | p[-1];
 
     return p;
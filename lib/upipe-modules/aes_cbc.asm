@@ -0,0 +1,104 @@
+;******************************************************************************
+;* AES-128 CBC decryption
+;* Copyright (C) 2026 OpenHeadend S.A.R.L.
+;*
+;* Permission is hereby granted, free of charge, to any person obtaining
+;* a copy of this software and associated documentation files (the
+;* "Software"), to deal in the Software without restriction, including
+;* without limitation the rights to use, copy, modify, merge, publish,
+;* distribute, sublicense, and/or sell copies of the Software, and to
+;* permit persons to whom the Software is furnished to do so, subject
+;* to the following conditions:
+;*
+;* The above copyright notice and this permission notice shall be
+;* included in all copies or substantial portions of the Software.
+;*
+;* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+;* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+;* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+;* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+;* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+;* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+;* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+%include "x86util.asm"
+
+SECTION .text
+
+; apply a round to the blocks held in the first %2 registers
+%macro AES_ROUND 3 ; instruction, blocks, key register
+%assign %%i 0
+%rep %2
+    %1        m %+ %%i, m%3
+%assign %%i %%i+1
+%endrep
+%endmacro
+
+; decrypt %1 blocks in place, m%2 holds the previous ciphertext block
+%macro AES_CBC_DEC 4 ; blocks, iv register, key register, tmp register
+%assign %%i 0
+%rep %1
+    movu      m %+ %%i, [bufq+16*%%i]
+%assign %%i %%i+1
+%endrep
+    movu      m%3, [keysq]
+    AES_ROUND pxor, %1, %3
+%assign %%r 1
+%rep 9
+    movu      m%3, [keysq+16*%%r]
+    AES_ROUND aesdec, %1, %3
+%assign %%r %%r+1
+%endrep
+    movu      m%3, [keysq+160]
+    AES_ROUND aesdeclast, %1, %3
+
+    ; the ciphertext is still in memory, xor it before overwriting it
+    pxor      m0, m%2
+%assign %%i 1
+%rep %1-1
+    movu      m%4, [bufq+16*(%%i-1)]
+    pxor      m %+ %%i, m%4
+%assign %%i %%i+1
+%endrep
+    movu      m%2, [bufq+16*(%1-1)]
+%assign %%i 0
+%rep %1
+    movu      [bufq+16*%%i], m %+ %%i
+%assign %%i %%i+1
+%endrep
+    add       bufq, 16*%1
+%endmacro
+
+; void aes_cbc_decrypt(uint8_t *buf, uintptr_t blocks,
+;                      const uint8_t round_keys[11][16], uint8_t iv[16])
+%macro aes_cbc_decrypt 4 ; blocks per iteration, iv, key, tmp registers
+cglobal aes_cbc_decrypt, 4, 4, %4+1, buf, blocks, keys, iv
+    movu      m%2, [ivq]
+    sub       blocksq, %1
+    jl .tail
+
+.loop:
+    AES_CBC_DEC %1, %2, %3, %4
+    sub       blocksq, %1
+    jge .loop
+
+.tail:
+    add       blocksq, %1
+    jz .end
+
+.tail_loop:
+    AES_CBC_DEC 1, %2, %3, %4
+    dec       blocksq
+    jnz .tail_loop
+
+.end:
+    movu      [ivq], m%2
+    RET
+%endmacro
+
+INIT_XMM aesni
+%if ARCH_X86_64
+aes_cbc_decrypt 8, 8, 9, 10
+%else
+aes_cbc_decrypt 4, 4, 5, 6
+%endif
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _UPIPE_MODULES_AES_CBC_H_
+/** @hidden */
+#define _UPIPE_MODULES_AES_CBC_H_
+
+#include <inttypes.h>
+
+/* decrypt blocks of 16 octets in place, and update the initialization
+ * vector with the last ciphertext block */
+typedef void (*upipe_aes_cbc_decrypt_func)(uint8_t *buf, uintptr_t blocks, const uint8_t round_keys[11][16], uint8_t iv[16]);
+
+void upipe_aes_cbc_key_expansion(const uint8_t key[16], uint8_t round_keys[11][16]);
+upipe_aes_cbc_decrypt_func upipe_aes_cbc_decrypt_setup(void);
+
+void upipe_aes_cbc_decrypt_c(uint8_t *buf, uintptr_t blocks, const uint8_t round_keys[11][16], uint8_t iv[16]);
+
+/* process 8 blocks per iteration on x86_64, 4 on x86_32 */
+void upipe_aes_cbc_decrypt_aesni(uint8_t *buf, uintptr_t blocks, const uint8_t round_keys[11][16], uint8_t iv[16]);
+
+#endif
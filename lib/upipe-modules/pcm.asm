@@ -0,0 +1,153 @@
+;******************************************************************************
+;* PCM conversion kernels
+;* Copyright (C) 2026 OpenHeadend S.A.R.L.
+;*
+;* Permission is hereby granted, free of charge, to any person obtaining
+;* a copy of this software and associated documentation files (the
+;* "Software"), to deal in the Software without restriction, including
+;* without limitation the rights to use, copy, modify, merge, publish,
+;* distribute, sublicense, and/or sell copies of the Software, and to
+;* permit persons to whom the Software is furnished to do so, subject
+;* to the following conditions:
+;*
+;* The above copyright notice and this permission notice shall be
+;* included in all copies or substantial portions of the Software.
+;*
+;* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+;* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+;* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+;* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+;* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+;* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+;* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+%include "x86util.asm"
+
+SECTION_RODATA 32
+
+l24_to_s32_shuf: db -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9
+                 db -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9
+s32_to_l24_shuf: db 3, 2, 1, 7, 6, 5, 11, 10, 9, 15, 14, 13, -1, -1, -1, -1
+                 db 3, 2, 1, 7, 6, 5, 11, 10, 9, 15, 14, 13, -1, -1, -1, -1
+s32_to_l24_perm: dd 0, 1, 2, 4, 5, 6, 7, 7
+pd_0to7:         dd 0, 1, 2, 3, 4, 5, 6, 7
+
+SECTION .text
+
+%macro BSWAP16 0
+; bytes must be a non-zero multiple of 32
+cglobal pcm_bswap16, 2, 2, 2, buf, bytes
+    add       bufq, bytesq
+    neg       bytesq
+
+.loop:
+    movu      m0, [bufq+bytesq]
+    psrlw     m1, m0, 8
+    psllw     m0, 8
+    por       m0, m1
+    movu      [bufq+bytesq], m0
+    add       bytesq, mmsize
+    jl        .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+BSWAP16
+INIT_YMM avx2
+BSWAP16
+
+%macro L24_TO_S32 0
+; samples must be a non-zero multiple of 8, reads 4 octets past the end
+cglobal pcm_l24_to_s32, 3, 3, 3, dst, src, samples
+    mova      m2, [l24_to_s32_shuf]
+
+.loop:
+%if mmsize == 16
+    movu      m0, [srcq]
+    movu      m1, [srcq+12]
+    pshufb    m0, m2
+    pshufb    m1, m2
+    movu      [dstq], m0
+    movu      [dstq+16], m1
+%else
+    movu      xm0, [srcq]
+    vinserti128 m0, m0, [srcq+12], 1
+    pshufb    m0, m2
+    movu      [dstq], m0
+%endif
+    add       srcq, 24
+    add       dstq, 32
+    sub       samplesq, 8
+    jg        .loop
+    RET
+%endmacro
+
+INIT_XMM ssse3
+L24_TO_S32
+INIT_YMM avx2
+L24_TO_S32
+
+%macro S32_TO_L24 0
+; samples must be a non-zero multiple of 8, writes 4 octets past the end
+cglobal pcm_s32_to_l24, 3, 3, 4, dst, src, samples
+    mova      m2, [s32_to_l24_shuf]
+%if mmsize == 32
+    mova      m3, [s32_to_l24_perm]
+%endif
+
+.loop:
+%if mmsize == 16
+    movu      m0, [srcq]
+    movu      m1, [srcq+16]
+    pshufb    m0, m2
+    pshufb    m1, m2
+    ; the second store overwrites the 4 zero octets of the first one
+    movu      [dstq], m0
+    movu      [dstq+12], m1
+%else
+    movu      m0, [srcq]
+    pshufb    m0, m2
+    vpermd    m0, m3, m0
+    vextracti128 xm1, m0, 1
+    movu      [dstq], xm0
+    movq      [dstq+16], xm1
+%endif
+    add       srcq, 32
+    add       dstq, 24
+    sub       samplesq, 8
+    jg        .loop
+    RET
+%endmacro
+
+INIT_XMM ssse3
+S32_TO_L24
+INIT_YMM avx2
+S32_TO_L24
+
+INIT_YMM avx2
+; samples must be at least 8
+cglobal pcm_extract32, 4, 6, 4, dst, src, stride, samples, i, last
+    movd      xm3, strided
+    vpbroadcastd m3, xm3
+    pmulld    m3, [pd_0to7]             ; offsets of 8 samples
+    lea       lastq, [samplesq-8]
+    imul      lastq, strideq
+    lea       lastq, [srcq+lastq*4]     ; source of the last block
+    shl       strideq, 5                ; source of 8 samples
+    sub       samplesq, 8
+    xor       iq, iq
+
+.loop:
+    pcmpeqd   m2, m2
+    vpgatherdd m0, [srcq+m3*4], m2
+    movu      [dstq+iq*4], m0
+    add       srcq, strideq
+    add       iq, 8
+    cmp       iq, samplesq
+    jb        .loop
+
+    ; the last block overlaps the previous one
+    pcmpeqd   m2, m2
+    vpgatherdd m0, [lastq+m3*4], m2
+    movu      [dstq+samplesq*4], m0
+    RET
@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short PCM conversion kernels
+ */
+
+#include <upipe/config.h>
+#include <upipe/ubase.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "pcm.h"
+
+/** @This swaps the octets of 16-bit words in place.
+ *
+ * @param buf buffer
+ * @param bytes size of the buffer in octets, rounded down to an even number
+ */
+void upipe_pcm_bswap16_c(uint8_t *buf, uintptr_t bytes)
+{
+    for (uintptr_t i = 0; i + 1 < bytes; i += 2) {
+        uint8_t t = buf[i];
+        buf[i] = buf[i + 1];
+        buf[i + 1] = t;
+    }
+}
+
+/** @This converts big-endian 24-bit samples to the most significant bits of
+ * 32-bit samples.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_l24_to_s32_c(int32_t *dst, const uint8_t *src,
+                            uintptr_t samples)
+{
+    for (uintptr_t i = 0; i < samples; i++)
+        dst[i] = ((uint32_t)src[3*i] << 24) | (src[3*i+1] << 16) |
+                 (src[3*i+2] << 8);
+}
+
+/** @This converts the most significant bits of 32-bit samples to
+ * big-endian 24-bit samples.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_s32_to_l24_c(uint8_t *dst, const int32_t *src,
+                            uintptr_t samples)
+{
+    for (uintptr_t i = 0; i < samples; i++)
+        for (int j = 0; j < 3; j++)
+            dst[3*i+j] = (src[i] >> (8 * (3-j))) & 0xff;
+}
+
+/** @This copies every stride-th 32-bit sample.
+ *
+ * @param dst destination samples
+ * @param src source samples
+ * @param stride distance between two source samples, in samples
+ * @param samples number of samples
+ */
+void upipe_pcm_extract32_c(uint32_t *dst, const uint32_t *src,
+                           intptr_t stride, uintptr_t samples)
+{
+    for (uintptr_t i = 0; i < samples; i++)
+        dst[i] = src[i * stride];
+}
+
+/** @This swaps the octets of 16-bit words in place.
+ *
+ * @param funcs PCM kernels
+ * @param buf buffer
+ * @param bytes size of the buffer in octets, rounded down to an even number
+ */
+void upipe_pcm_bswap16(const struct upipe_pcm_funcs *funcs,
+                       uint8_t *buf, uintptr_t bytes)
+{
+    uintptr_t simd = bytes & ~(uintptr_t)31;
+    if (simd)
+        funcs->bswap16(buf, simd);
+    upipe_pcm_bswap16_c(buf + simd, bytes - simd);
+}
+
+/** @This converts big-endian 24-bit samples to the most significant bits of
+ * 32-bit samples.
+ *
+ * @param funcs PCM kernels
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_l24_to_s32(const struct upipe_pcm_funcs *funcs,
+                          int32_t *dst, const uint8_t *src, uintptr_t samples)
+{
+    /* keep two samples for the C version, so that the SIMD kernels do not
+     * read past the end of the source */
+    uintptr_t simd = samples > 2 ? (samples - 2) & ~(uintptr_t)7 : 0;
+    if (simd)
+        funcs->l24_to_s32(dst, src, simd);
+    upipe_pcm_l24_to_s32_c(dst + simd, src + 3 * simd, samples - simd);
+}
+
+/** @This converts the most significant bits of 32-bit samples to
+ * big-endian 24-bit samples.
+ *
+ * @param funcs PCM kernels
+ * @param dst destination samples
+ * @param src source samples
+ * @param samples number of samples
+ */
+void upipe_pcm_s32_to_l24(const struct upipe_pcm_funcs *funcs,
+                          uint8_t *dst, const int32_t *src, uintptr_t samples)
+{
+    /* keep two samples for the C version, so that the SIMD kernels do not
+     * write past the end of the destination */
+    uintptr_t simd = samples > 2 ? (samples - 2) & ~(uintptr_t)7 : 0;
+    if (simd)
+        funcs->s32_to_l24(dst, src, simd);
+    upipe_pcm_s32_to_l24_c(dst + 3 * simd, src + simd, samples - simd);
+}
+
+/** @hidden */
+#define UPIPE_PCM_EXTRACT_TEMPLATE(size)                                    \
+static void upipe_pcm_extract_##size(uint8_t *dst, uintptr_t dst_stride,    \
+                                     const uint8_t *src,                    \
+                                     uintptr_t src_stride, uintptr_t samples)\
+{                                                                           \
+    for (uintptr_t i = 0; i < samples; i++) {                               \
+        memcpy(dst, src, size);                                             \
+        dst += dst_stride;                                                  \
+        src += src_stride;                                                  \
+    }                                                                       \
+}
+
+UPIPE_PCM_EXTRACT_TEMPLATE(1)
+UPIPE_PCM_EXTRACT_TEMPLATE(2)
+UPIPE_PCM_EXTRACT_TEMPLATE(3)
+UPIPE_PCM_EXTRACT_TEMPLATE(4)
+UPIPE_PCM_EXTRACT_TEMPLATE(8)
+#undef UPIPE_PCM_EXTRACT_TEMPLATE
+
+/** @This copies the samples of a channel from an interleaved buffer.
+ *
+ * @param funcs PCM kernels
+ * @param dst destination buffer
+ * @param dst_stride distance between two destination samples, in octets
+ * @param src source buffer
+ * @param src_stride distance between two source samples, in octets
+ * @param sample_size size of a sample in octets
+ * @param samples number of samples
+ */
+void upipe_pcm_extract(const struct upipe_pcm_funcs *funcs,
+                       uint8_t *dst, uintptr_t dst_stride,
+                       const uint8_t *src, uintptr_t src_stride,
+                       uint8_t sample_size, uintptr_t samples)
+{
+    if (dst_stride == sample_size && src_stride == sample_size) {
+        memcpy(dst, src, sample_size * samples);
+        return;
+    }
+
+    switch (sample_size) {
+        case 1:
+            upipe_pcm_extract_1(dst, dst_stride, src, src_stride, samples);
+            break;
+        case 2:
+            upipe_pcm_extract_2(dst, dst_stride, src, src_stride, samples);
+            break;
+        case 3:
+            upipe_pcm_extract_3(dst, dst_stride, src, src_stride, samples);
+            break;
+        case 4:
+            if (dst_stride == 4 && !(src_stride % 4) && samples >= 8 &&
+                !((uintptr_t)dst % 4) && !((uintptr_t)src % 4))
+                funcs->extract32((uint32_t *)dst, (const uint32_t *)src,
+                                 src_stride / 4, samples);
+            else
+                upipe_pcm_extract_4(dst, dst_stride, src, src_stride,
+                                    samples);
+            break;
+        case 8:
+            upipe_pcm_extract_8(dst, dst_stride, src, src_stride, samples);
+            break;
+        default:
+            for (uintptr_t i = 0; i < samples; i++) {
+                memcpy(dst, src, sample_size);
+                dst += dst_stride;
+                src += src_stride;
+            }
+            break;
+    }
+}
+
+/** @This selects the fastest PCM kernels supported by the CPU. The assembly
+ * kernels are only selected with --enable-unchecked-asm, until checkasm has
+ * validated them.
+ *
+ * @param funcs filled in with the kernels
+ */
+void upipe_pcm_setup(struct upipe_pcm_funcs *funcs)
+{
+    funcs->bswap16 = upipe_pcm_bswap16_c;
+    funcs->l24_to_s32 = upipe_pcm_l24_to_s32_c;
+    funcs->s32_to_l24 = upipe_pcm_s32_to_l24_c;
+    funcs->extract32 = upipe_pcm_extract32_c;
+
+#if defined(UPIPE_HAVE_X86ASM) && defined(UPIPE_HAVE_UNCHECKED_ASM)
+#if defined(__i686__) || defined(__x86_64__)
+    if (__builtin_cpu_supports("sse2"))
+        funcs->bswap16 = upipe_pcm_bswap16_sse2;
+    if (__builtin_cpu_supports("ssse3")) {
+        funcs->l24_to_s32 = upipe_pcm_l24_to_s32_ssse3;
+        funcs->s32_to_l24 = upipe_pcm_s32_to_l24_ssse3;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        funcs->bswap16 = upipe_pcm_bswap16_avx2;
+        funcs->l24_to_s32 = upipe_pcm_l24_to_s32_avx2;
+        funcs->s32_to_l24 = upipe_pcm_s32_to_l24_avx2;
+        funcs->extract32 = upipe_pcm_extract32_avx2;
+    }
+#endif
+#endif
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short PCM conversion kernels
+ */
+
+#ifndef _UPIPE_MODULES_PCM_H_
+/** @hidden */
+#define _UPIPE_MODULES_PCM_H_
+
+#include <inttypes.h>
+
+/* swap the octets of 16-bit words in place; the SIMD kernels require a
+ * multiple of 32 octets */
+typedef void (*upipe_pcm_bswap16_func)(uint8_t *buf, uintptr_t bytes);
+/* convert big-endian 24-bit samples to the most significant bits of 32-bit
+ * samples; the SIMD kernels require a multiple of 8 samples, and may read
+ * up to 4 octets past the end of the source */
+typedef void (*upipe_pcm_l24_to_s32_func)(int32_t *dst, const uint8_t *src, uintptr_t samples);
+/* convert the most significant bits of 32-bit samples to big-endian 24-bit
+ * samples; the SIMD kernels require a multiple of 8 samples, and may write
+ * up to 4 octets past the end of the destination */
+typedef void (*upipe_pcm_s32_to_l24_func)(uint8_t *dst, const int32_t *src, uintptr_t samples);
+/* copy every stride-th 32-bit sample; the SIMD kernels require at least
+ * 8 samples */
+typedef void (*upipe_pcm_extract32_func)(uint32_t *dst, const uint32_t *src, intptr_t stride, uintptr_t samples);
+
+/* fastest kernels supported by the CPU */
+struct upipe_pcm_funcs {
+    upipe_pcm_bswap16_func bswap16;
+    upipe_pcm_l24_to_s32_func l24_to_s32;
+    upipe_pcm_s32_to_l24_func s32_to_l24;
+    upipe_pcm_extract32_func extract32;
+};
+
+void upipe_pcm_setup(struct upipe_pcm_funcs *funcs);
+
+void upipe_pcm_bswap16(const struct upipe_pcm_funcs *funcs, uint8_t *buf, uintptr_t bytes);
+void upipe_pcm_l24_to_s32(const struct upipe_pcm_funcs *funcs, int32_t *dst, const uint8_t *src, uintptr_t samples);
+void upipe_pcm_s32_to_l24(const struct upipe_pcm_funcs *funcs, uint8_t *dst, const int32_t *src, uintptr_t samples);
+void upipe_pcm_extract(const struct upipe_pcm_funcs *funcs, uint8_t *dst, uintptr_t dst_stride, const uint8_t *src, uintptr_t src_stride, uint8_t sample_size, uintptr_t samples);
+
+void upipe_pcm_bswap16_c(uint8_t *buf, uintptr_t bytes);
+void upipe_pcm_l24_to_s32_c(int32_t *dst, const uint8_t *src, uintptr_t samples);
+void upipe_pcm_s32_to_l24_c(uint8_t *dst, const int32_t *src, uintptr_t samples);
+void upipe_pcm_extract32_c(uint32_t *dst, const uint32_t *src, intptr_t stride, uintptr_t samples);
+
+void upipe_pcm_bswap16_sse2(uint8_t *buf, uintptr_t bytes);
+void upipe_pcm_bswap16_avx2(uint8_t *buf, uintptr_t bytes);
+void upipe_pcm_l24_to_s32_ssse3(int32_t *dst, const uint8_t *src, uintptr_t samples);
+void upipe_pcm_l24_to_s32_avx2(int32_t *dst, const uint8_t *src, uintptr_t samples);
+void upipe_pcm_s32_to_l24_ssse3(uint8_t *dst, const int32_t *src, uintptr_t samples);
+void upipe_pcm_s32_to_l24_avx2(uint8_t *dst, const int32_t *src, uintptr_t samples);
+void upipe_pcm_extract32_avx2(uint32_t *dst, const uint32_t *src, intptr_t stride, uintptr_t samples);
+
+#endif
@@ -51,6 +51,8 @@
 #include <string.h>
 #include <assert.h>
 
+#include "pcm.h"
+
 /** @internal @This is the private context of an audio_split pipe. */
 struct upipe_audio_split {
     /** real refcount management structure */
@@ -68,6 +70,8 @@ struct upipe_audio_split {
     uint8_t channel_sample_size;
     /** number of channels */
     uint8_t channels;
+    /** sample copy kernels */
+    struct upipe_pcm_funcs pcm;
 
     /** manager to create output subpipes */
     struct upipe_mgr sub_mgr;
@@ -241,14 +245,9 @@ static void upipe_audio_split_sub_process(struct upipe *upipe,
 
             const uint8_t *in = in_buf + in_idx * split->channel_sample_size;
             uint8_t *out = out_buf + out_idx * split->channel_sample_size;
-            int i, j;
-            for (i = 0; i < samples; i++) {
-                for (j = 0; j < split->channel_sample_size; j++) {
-                    out[j] = in[j];
-                }
-                in += split->sample_size;
-                out += sub->sample_size;
-            }
+            upipe_pcm_extract(&split->pcm, out, sub->sample_size,
+                              in, split->sample_size,
+                              split->channel_sample_size, samples);
             ubuf_sound_plane_unmap(ubuf, channel, 0, -1);
 
             in_idx++;
@@ -413,6 +412,7 @@ static struct upipe *upipe_audio_split_alloc(struct upipe_mgr *mgr,
     upipe_audio_split_init_sub_mgr(upipe);
     upipe_audio_split_init_sub_outputs(upipe);
     upipe_audio_split->flow_def = NULL;
+    upipe_pcm_setup(&upipe_audio_split->pcm);
     upipe_throw_ready(upipe);
     return upipe;
 }
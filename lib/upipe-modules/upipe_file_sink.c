@@ -29,6 +29,8 @@
  * @short Upipe sink module for files
  */
 
+#define _GNU_SOURCE
+
 #include <upipe/ubase.h>
 #include <upipe/ulist.h>
 #include <upipe/uprobe.h>
@@ -69,6 +71,8 @@
 /** @hidden */
 static void upipe_fsink_watcher(struct upump *upump);
 /** @hidden */
+static void upipe_fsink_io_done(struct upump *upump);
+/** @hidden */
 static bool upipe_fsink_output(struct upipe *upipe, struct uref *uref,
                                struct upump **upump_p);
 
@@ -83,6 +87,8 @@ struct upipe_fsink {
     struct upump *upump;
     /** sync watcher */
     struct upump *upump_sync;
+    /** direct I/O write pump, if the event loop submits I/O operations */
+    struct upump *upump_io;
 
     /** uclock structure, if not NULL we are in live mode */
     struct uclock *uclock;
@@ -98,6 +104,21 @@ struct upipe_fsink {
     /** sync period */
     uint64_t sync_period;
 
+    /** size of the direct I/O buffer, or 0 */
+    unsigned int direct_size;
+    /** aligned direct I/O buffer */
+    uint8_t *direct_buffer;
+    /** number of octets in the direct I/O buffer */
+    size_t direct_fill;
+    /** offset in the file of the direct I/O buffer */
+    uint64_t direct_offset;
+    /** size of the file when it was switched to direct I/O */
+    uint64_t direct_eof;
+    /** number of octets of the buffer still being written by upump_io */
+    size_t direct_pending;
+    /** true if the file is opened for direct I/O */
+    bool direct;
+
     /** temporary uref storage */
     struct uchain urefs;
     /** nb urefs in storage */
@@ -117,6 +138,7 @@ UPIPE_HELPER_VOID(upipe_fsink)
 UPIPE_HELPER_UPUMP_MGR(upipe_fsink, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_fsink, upump, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_fsink, upump_sync, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_fsink, upump_io, upump_mgr)
 UPIPE_HELPER_INPUT(upipe_fsink, urefs, nb_urefs, max_urefs, blockers, upipe_fsink_output)
 UPIPE_HELPER_UCLOCK(upipe_fsink, uclock, uclock_request, NULL, upipe_throw_provide_request, NULL)
 
@@ -141,12 +163,17 @@ static struct upipe *upipe_fsink_alloc(struct upipe_mgr *mgr,
     upipe_fsink_init_upump_mgr(upipe);
     upipe_fsink_init_upump(upipe);
     upipe_fsink_init_upump_sync(upipe);
+    upipe_fsink_init_upump_io(upipe);
     upipe_fsink_init_input(upipe);
     upipe_fsink_init_uclock(upipe);
     upipe_fsink->latency = 0;
     upipe_fsink->fd = -1;
     upipe_fsink->path = NULL;
     upipe_fsink->sync_period = 0;
+    upipe_fsink->direct_size = 0;
+    upipe_fsink->direct_buffer = NULL;
+    upipe_fsink->direct_pending = 0;
+    upipe_fsink->direct = false;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -174,6 +201,341 @@ static void upipe_fsink_poll(struct upipe *upipe)
     }
 }
 
+/** @internal @This writes data to a file opened for direct I/O, at the
+ * current direct I/O offset. The data must be aligned unless direct I/O was
+ * cleared on the file descriptor.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffer aligned buffer
+ * @param size size of the buffer, multiple of the alignment for direct I/O
+ * @return false in case of error
+ */
+static bool upipe_fsink_write_direct(struct upipe *upipe,
+                                     const uint8_t *buffer, size_t size)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    while (size) {
+        ssize_t ret = pwrite(upipe_fsink->fd, buffer, size,
+                             upipe_fsink->direct_offset);
+        if (unlikely(ret == -1)) {
+            if (errno == EINTR)
+                continue;
+            upipe_warn_va(upipe, "write error to %s (%m)", upipe_fsink->path);
+            return false;
+        }
+        buffer += ret;
+        size -= ret;
+        upipe_fsink->direct_offset += ret;
+    }
+    return true;
+}
+
+/** @internal @This submits the end of the direct I/O buffer which is still
+ * to be written to the write pump.
+ *
+ * @param upipe description structure of the pipe
+ * @return false if the operation could not be submitted
+ */
+static bool upipe_fsink_submit_direct(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    size_t done = upipe_fsink->direct_size - upipe_fsink->direct_pending;
+    upump_start(upipe_fsink->upump_io);
+    if (unlikely(!ubase_check(upump_io_submit(upipe_fsink->upump_io,
+                        upipe_fsink->direct_buffer + done,
+                        upipe_fsink->direct_pending,
+                        upipe_fsink->direct_offset)))) {
+        upump_stop(upipe_fsink->upump_io);
+        return false;
+    }
+    return true;
+}
+
+/** @internal @This writes the full direct I/O buffer. If the event loop
+ * submits I/O operations, the write is handed to it and the buffer is busy
+ * until @ref upipe_fsink_io_done is called; otherwise it is written
+ * synchronously.
+ *
+ * @param upipe description structure of the pipe
+ * @return false in case of error
+ */
+static bool upipe_fsink_flush_direct(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (upipe_fsink->upump_io != NULL) {
+        upipe_fsink->direct_pending = upipe_fsink->direct_size;
+        if (likely(upipe_fsink_submit_direct(upipe)))
+            return true;
+        upipe_warn(upipe, "unable to submit write, using system calls");
+        upipe_fsink->direct_pending = 0;
+        upipe_fsink_set_upump_io(upipe, NULL);
+    }
+
+    bool ok = upipe_fsink_write_direct(upipe, upipe_fsink->direct_buffer,
+                                       upipe_fsink->direct_size);
+    upipe_fsink->direct_fill = 0;
+    return ok;
+}
+
+/** @internal @This switches the newly opened file to direct I/O, if it was
+ * requested and the writing position is aligned.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsink_open_direct(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (!upipe_fsink->direct_size)
+        return;
+
+#ifdef O_DIRECT
+    off_t position = lseek(upipe_fsink->fd, 0, SEEK_CUR);
+    if (unlikely(position == (off_t)-1 ||
+                 position % UPIPE_FSINK_DIRECT_ALIGN)) {
+        upipe_warn(upipe, "unaligned position, not using direct I/O");
+        return;
+    }
+
+    struct stat st;
+    if (unlikely(fstat(upipe_fsink->fd, &st) == -1)) {
+        upipe_warn(upipe, "can't stat file, not using direct I/O");
+        return;
+    }
+
+    if (upipe_fsink->direct_buffer == NULL) {
+        void *buffer;
+        if (unlikely(posix_memalign(&buffer, UPIPE_FSINK_DIRECT_ALIGN,
+                                    upipe_fsink->direct_size))) {
+            upipe_warn(upipe, "unable to allocate direct I/O buffer");
+            return;
+        }
+        upipe_fsink->direct_buffer = buffer;
+    }
+
+    int flags = fcntl(upipe_fsink->fd, F_GETFL);
+    if (unlikely(flags == -1 ||
+                 fcntl(upipe_fsink->fd, F_SETFL, flags | O_DIRECT) == -1)) {
+        upipe_warn(upipe, "direct I/O is not supported (%m)");
+        return;
+    }
+
+    upipe_fsink->direct = true;
+    upipe_fsink->direct_fill = 0;
+    upipe_fsink->direct_pending = 0;
+    upipe_fsink->direct_offset = position;
+    upipe_fsink->direct_eof = st.st_size;
+
+    /* let the event loop write the buffers if it is able to */
+    if (upipe_fsink->upump_mgr != NULL) {
+        struct upump *upump = upump_alloc_io_write(upipe_fsink->upump_mgr,
+                upipe_fsink_io_done, upipe, upipe->refcount,
+                upipe_fsink->fd);
+        upipe_fsink_set_upump_io(upipe, upump);
+    }
+#else
+    upipe_warn(upipe, "direct I/O is not supported on this platform");
+#endif
+}
+
+/** @internal @This writes the remaining buffered data of a file opened for
+ * direct I/O. If the tail is past the original end of file, it is padded,
+ * written with direct I/O and the file is truncated to its actual size.
+ * Otherwise it is written with buffered I/O, so that existing data is not
+ * overwritten.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsink_close_direct(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (!upipe_fsink->direct)
+        return;
+
+    /* stopping the pump cancels the pending write, which may or may not
+     * have reached the file, so write the same data again */
+    upipe_fsink_set_upump_io(upipe, NULL);
+    if (upipe_fsink->direct_pending) {
+        size_t done = upipe_fsink->direct_size - upipe_fsink->direct_pending;
+        upipe_fsink->direct_pending = 0;
+        upipe_fsink->direct_fill = 0;
+        if (upipe_fsink_write_direct(upipe, upipe_fsink->direct_buffer + done,
+                                     upipe_fsink->direct_size - done) &&
+            !upipe_fsink_check_input(upipe)) {
+            /* output the buffers held during the write */
+            upipe_fsink_output_input(upipe);
+            upipe_fsink_unblock_input(upipe);
+            if (upipe_fsink_check_input(upipe))
+                /* Release the pipe used in @ref upipe_fsink_input. */
+                upipe_release(upipe);
+        }
+    }
+    upipe_fsink->direct = false;
+
+    size_t fill = upipe_fsink->direct_fill;
+    if (fill && upipe_fsink->direct_offset + fill >= upipe_fsink->direct_eof) {
+        size_t size = (fill + UPIPE_FSINK_DIRECT_ALIGN - 1) &
+                      ~(size_t)(UPIPE_FSINK_DIRECT_ALIGN - 1);
+        memset(upipe_fsink->direct_buffer + fill, 0, size - fill);
+        if (upipe_fsink_write_direct(upipe, upipe_fsink->direct_buffer,
+                                     size)) {
+            upipe_fsink->direct_offset -= size - fill;
+            if (unlikely(ftruncate(upipe_fsink->fd,
+                                   upipe_fsink->direct_offset) == -1))
+                upipe_warn_va(upipe, "can't truncate %s (%m)",
+                              upipe_fsink->path);
+        }
+        fill = 0;
+    }
+
+#ifdef O_DIRECT
+    /* the file descriptor may outlive the pipe */
+    int flags = fcntl(upipe_fsink->fd, F_GETFL);
+    if (flags != -1)
+        fcntl(upipe_fsink->fd, F_SETFL, flags & ~O_DIRECT);
+#endif
+
+    if (fill)
+        upipe_fsink_write_direct(upipe, upipe_fsink->direct_buffer, fill);
+    upipe_fsink->direct_fill = 0;
+    /* the file descriptor is left at the end of the written data */
+    lseek(upipe_fsink->fd, upipe_fsink->direct_offset, SEEK_SET);
+}
+
+/** @internal @This outputs data to a file opened for direct I/O. Aligned
+ * parts of the buffers are written without copy when nothing is pending in
+ * the direct I/O buffer, unless the writes are submitted to the event loop:
+ * the data is then always copied, so that the uref may be released before
+ * the write completes.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @return true if the uref was processed, false if it must be held until
+ * the pending write completes
+ */
+static bool upipe_fsink_output_direct(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (upipe_fsink->direct_pending)
+        return false;
+
+    int iovec_count = uref_block_iovec_count(uref, 0, -1);
+    if (unlikely(iovec_count == -1)) {
+        uref_free(uref);
+        upipe_warn(upipe, "cannot read ubuf buffer");
+        return true;
+    }
+    if (unlikely(iovec_count == 0)) {
+        uref_free(uref);
+        return true;
+    }
+
+    struct iovec iovecs[iovec_count];
+    if (unlikely(!ubase_check(uref_block_iovec_read(uref, 0, -1, iovecs)))) {
+        uref_free(uref);
+        upipe_warn(upipe, "cannot read ubuf buffer");
+        return true;
+    }
+
+    bool ok = true;
+    size_t consumed = 0;
+    for (int i = 0; ok && !upipe_fsink->direct_pending && i < iovec_count;
+         i++) {
+        const uint8_t *base = iovecs[i].iov_base;
+        size_t len = iovecs[i].iov_len;
+        while (ok && !upipe_fsink->direct_pending && len) {
+            size_t size;
+            if (!upipe_fsink->direct_fill && upipe_fsink->upump_io == NULL &&
+                len >= UPIPE_FSINK_DIRECT_ALIGN &&
+                !((uintptr_t)base % UPIPE_FSINK_DIRECT_ALIGN)) {
+                size = len & ~(size_t)(UPIPE_FSINK_DIRECT_ALIGN - 1);
+                ok = upipe_fsink_write_direct(upipe, base, size);
+            } else {
+                size = upipe_fsink->direct_size - upipe_fsink->direct_fill;
+                if (size > len)
+                    size = len;
+                memcpy(upipe_fsink->direct_buffer + upipe_fsink->direct_fill,
+                       base, size);
+                upipe_fsink->direct_fill += size;
+                if (upipe_fsink->direct_fill == upipe_fsink->direct_size)
+                    ok = upipe_fsink_flush_direct(upipe);
+            }
+            base += size;
+            len -= size;
+            consumed += size;
+        }
+    }
+    uref_block_iovec_unmap(uref, 0, -1, iovecs);
+
+    if (unlikely(!ok)) {
+        uref_free(uref);
+        upipe_fsink_close_direct(upipe);
+        upipe_fsink_set_upump(upipe, NULL);
+        upipe_fsink_set_upump_sync(upipe, NULL);
+        upipe_throw_sink_end(upipe);
+        return true;
+    }
+
+    size_t uref_size;
+    if (upipe_fsink->direct_pending &&
+        ubase_check(uref_block_size(uref, &uref_size)) &&
+        consumed < uref_size) {
+        /* keep the rest until the buffer is written */
+        uref_block_resize(uref, consumed, -1);
+        return false;
+    }
+    uref_free(uref);
+    return true;
+}
+
+/** @internal @This is called when a write submitted to the event loop
+ * completes. The rest of the buffer is submitted again after a short write,
+ * otherwise the held buffers are output.
+ *
+ * @param upump description structure of the write pump
+ */
+static void upipe_fsink_io_done(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    ssize_t ret = -EIO;
+    upump_io_get_result(upump, &ret);
+    upump_stop(upump);
+
+    if (likely(ret > 0)) {
+        upipe_fsink->direct_offset += ret;
+        upipe_fsink->direct_pending -= ret < upipe_fsink->direct_pending ?
+                                       ret : upipe_fsink->direct_pending;
+        if (upipe_fsink->direct_pending &&
+            likely(upipe_fsink_submit_direct(upipe)))
+            return;
+    }
+
+    if (unlikely(upipe_fsink->direct_pending)) {
+        if (ret < 0)
+            upipe_warn_va(upipe, "write error to %s (%s)", upipe_fsink->path,
+                          strerror(-ret));
+        else
+            upipe_warn_va(upipe, "write error to %s", upipe_fsink->path);
+        /* the buffer is lost, as with synchronous writes */
+        upipe_fsink->direct_pending = 0;
+        upipe_fsink->direct_fill = 0;
+        upipe_fsink_close_direct(upipe);
+        upipe_fsink_set_upump(upipe, NULL);
+        upipe_fsink_set_upump_sync(upipe, NULL);
+        upipe_throw_sink_end(upipe);
+    } else
+        upipe_fsink->direct_fill = 0;
+
+    if (!upipe_fsink_check_input(upipe)) {
+        upipe_fsink_output_input(upipe);
+        upipe_fsink_unblock_input(upipe);
+        if (upipe_fsink_check_input(upipe))
+            /* All packets have been output, release again the pipe that has
+             * been used in @ref upipe_fsink_input. */
+            upipe_release(upipe);
+    }
+}
+
 /** @internal @This outputs data to the file sink.
  *
  * @param upipe description structure of the pipe
@@ -218,6 +580,9 @@ static bool upipe_fsink_output(struct upipe *upipe, struct uref *uref,
     }
 
 write_buffer:
+    if (upipe_fsink->direct)
+        return upipe_fsink_output_direct(upipe, uref);
+
     for ( ; ; ) {
         int iovec_count = uref_block_iovec_count(uref, 0, -1);
         if (unlikely(iovec_count == -1)) {
@@ -395,6 +760,7 @@ static int _upipe_fsink_set_path(struct upipe *upipe, const char *path,
     struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
 
     if (unlikely(upipe_fsink->fd != -1)) {
+        upipe_fsink_close_direct(upipe);
         if (likely(upipe_fsink->path != NULL))
             upipe_notice_va(upipe, "closing file %s", upipe_fsink->path);
         ubase_clean_fd(&upipe_fsink->fd);
@@ -458,6 +824,7 @@ static int _upipe_fsink_set_path(struct upipe *upipe, const char *path,
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return UBASE_ERR_ALLOC;
     }
+    upipe_fsink_open_direct(upipe);
     if (!upipe_fsink_check_input(upipe))
         /* Use again the pipe that we previously released. */
         upipe_use(upipe);
@@ -479,6 +846,7 @@ static int _upipe_fsink_set_fd(struct upipe *upipe, int fd,
     struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
 
     if (unlikely(upipe_fsink->fd != -1)) {
+        upipe_fsink_close_direct(upipe);
         if (likely(upipe_fsink->path != NULL))
             upipe_notice_va(upipe, "closing file %s", upipe_fsink->path);
         ubase_clean_fd(&upipe_fsink->fd);
@@ -525,6 +893,7 @@ static int _upipe_fsink_set_fd(struct upipe *upipe, int fd,
         default:
             break;
     }
+    upipe_fsink_open_direct(upipe);
 
     if (!upipe_fsink_check_input(upipe))
         /* Use again the pipe that we previously released. */
@@ -575,6 +944,26 @@ static int _upipe_fsink_get_sync_period(struct upipe *upipe, uint64_t *p)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the size of the direct I/O buffer, used by the files
+ * opened afterwards.
+ *
+ * @param upipe description structure of the pipe
+ * @param direct_size size of the buffer, or 0 to use the page cache
+ * @return an error code
+ */
+static int _upipe_fsink_set_direct_size(struct upipe *upipe,
+                                        unsigned int direct_size)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (unlikely(upipe_fsink->direct))
+        return UBASE_ERR_BUSY;
+    free(upipe_fsink->direct_buffer);
+    upipe_fsink->direct_buffer = NULL;
+    upipe_fsink->direct_size = (direct_size + UPIPE_FSINK_DIRECT_ALIGN - 1) &
+                               ~(UPIPE_FSINK_DIRECT_ALIGN - 1);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file sink pipe.
  *
  * @param upipe description structure of the pipe
@@ -646,6 +1035,17 @@ static int  _upipe_fsink_control(struct upipe *upipe, int command, va_list args)
             uint64_t *p = va_arg(args, uint64_t *);
             return _upipe_fsink_get_sync_period(upipe, p);
         }
+        case UPIPE_FSINK_SET_DIRECT_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            unsigned int direct_size = va_arg(args, unsigned int);
+            return _upipe_fsink_set_direct_size(upipe, direct_size);
+        }
+        case UPIPE_FSINK_GET_DIRECT_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            unsigned int *p = va_arg(args, unsigned int *);
+            *p = upipe_fsink_from_upipe(upipe)->direct_size;
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -696,6 +1096,7 @@ static void upipe_fsink_free(struct upipe *upipe)
 {
     struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
     if (likely(upipe_fsink->fd != -1)) {
+        upipe_fsink_close_direct(upipe);
         if (likely(upipe_fsink->path != NULL)) {
             upipe_notice_va(upipe, "closing file %s", upipe_fsink->path);
             close(upipe_fsink->fd);
@@ -704,9 +1105,11 @@ static void upipe_fsink_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     free(upipe_fsink->path);
+    free(upipe_fsink->direct_buffer);
     upipe_fsink_clean_uclock(upipe);
     upipe_fsink_clean_upump(upipe);
     upipe_fsink_clean_upump_sync(upipe);
+    upipe_fsink_clean_upump_io(upipe);
     upipe_fsink_clean_upump_mgr(upipe);
     upipe_fsink_clean_input(upipe);
     upipe_fsink_clean_urefcount(upipe);
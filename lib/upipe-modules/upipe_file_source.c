@@ -39,6 +39,7 @@
 #include <upipe/uref_clock.h>
 #include <upipe/upump.h>
 #include <upipe/ubuf.h>
+#include <upipe/ubuf_block_mmap.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
@@ -57,6 +58,7 @@
 #include <stdint.h>
 #include <stdarg.h>
 #include <string.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -71,6 +73,8 @@
 
 /** default size of buffers when unspecified */
 #define UBUF_DEFAULT_SIZE       32768
+/** depth of the pools of the mmap ubuf manager */
+#define UBUF_MMAP_POOL_DEPTH    16
 
 /** @hidden */
 static int upipe_fsrc_check(struct upipe *upipe, struct uref *flow_format);
@@ -123,6 +127,17 @@ struct upipe_fsrc {
     /** length to read */
     uint64_t length;
 
+    /** size of the regions mapped from regular files, or 0 */
+    unsigned int mmap_size;
+    /** ubuf manager mapping regions of regular files */
+    struct ubuf_mgr *mmap_mgr;
+    /** currently mapped region */
+    struct ubuf *window;
+    /** offset of the mapped region in the file */
+    uint64_t window_offset;
+    /** size of the mapped region */
+    uint64_t window_size;
+
     /** public upipe structure */
     struct upipe upipe;
     /** guard for upump */
@@ -177,6 +192,9 @@ static struct upipe *upipe_fsrc_alloc(struct upipe_mgr *mgr,
     upipe_fsrc->uri = NULL;
     upipe_fsrc->fd = -1;
     upipe_fsrc->length = (uint64_t)-1;
+    upipe_fsrc->mmap_size = 0;
+    upipe_fsrc->mmap_mgr = NULL;
+    upipe_fsrc->window = NULL;
     upipe_fsrc->safe = false;
     upipe_throw_ready(upipe);
     return upipe;
@@ -205,6 +223,80 @@ static int upipe_fsrc_get_uri(struct upipe *upipe, const char **path_p)
     return uref_uri_get_path(upipe_fsrc->uri, path_p);
 }
 
+/** @internal @This releases the currently mapped region. It is actually
+ * unmapped when all the buffers pointing into it are released.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsrc_clean_window(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    if (upipe_fsrc->window != NULL) {
+        ubuf_free(upipe_fsrc->window);
+        upipe_fsrc->window = NULL;
+    }
+}
+
+/** @internal @This returns a buffer pointing into the region mapped at the
+ * reading position, mapping a new region if needed, and advances the reading
+ * position.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to uref, or NULL if the data has to be read (end of file or
+ * mapping failure)
+ */
+static struct uref *upipe_fsrc_map(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    off_t position = lseek(upipe_fsrc->fd, 0, SEEK_CUR);
+    if (unlikely(position == (off_t)-1))
+        return NULL;
+
+    if (upipe_fsrc->window == NULL ||
+        (uint64_t)position < upipe_fsrc->window_offset ||
+        (uint64_t)position >= upipe_fsrc->window_offset +
+                              upipe_fsrc->window_size) {
+        upipe_fsrc_clean_window(upipe);
+
+        struct stat st;
+        if (unlikely(fstat(upipe_fsrc->fd, &st) == -1) ||
+            position >= st.st_size)
+            return NULL;
+        uint64_t size = st.st_size - position;
+        if (size > upipe_fsrc->mmap_size)
+            size = upipe_fsrc->mmap_size;
+        upipe_fsrc->window = ubuf_block_mmap_alloc_from_fd(
+                upipe_fsrc->mmap_mgr, upipe_fsrc->fd, position, size);
+        if (unlikely(upipe_fsrc->window == NULL)) {
+            upipe_warn_va(upipe, "unable to map %"PRIu64" octets at %"PRIu64,
+                          size, (uint64_t)position);
+            return NULL;
+        }
+        upipe_fsrc->window_offset = position;
+        upipe_fsrc->window_size = size;
+    }
+
+    uint64_t offset = position - upipe_fsrc->window_offset;
+    uint64_t size = upipe_fsrc->window_size - offset;
+    if (size > upipe_fsrc->output_size)
+        size = upipe_fsrc->output_size;
+    struct ubuf *ubuf = ubuf_block_splice(upipe_fsrc->window, offset, size);
+    if (unlikely(ubuf == NULL))
+        return NULL;
+    struct uref *uref = uref_alloc(upipe_fsrc->uref_mgr);
+    if (unlikely(uref == NULL)) {
+        ubuf_free(ubuf);
+        return NULL;
+    }
+    uref_attach_ubuf(uref, ubuf);
+
+    lseek(upipe_fsrc->fd, size, SEEK_CUR);
+    if (offset + size == upipe_fsrc->window_size)
+        /* the last buffers keep the region mapped */
+        upipe_fsrc_clean_window(upipe);
+    return uref;
+}
+
 /** @internal @This reads data from the source and outputs it.
  * It is called either when the idler triggers (permanent storage mode) or
  * when data is available on the file descriptor (live stream mode).
@@ -237,9 +329,22 @@ static void upipe_fsrc_worker(struct upump *upump)
             return;
     }
 
-    struct uref *uref = uref_block_alloc(upipe_fsrc->uref_mgr,
-                                         upipe_fsrc->ubuf_mgr,
-                                         upipe_fsrc->output_size);
+    struct uref *uref = NULL;
+    size_t uref_size;
+    if (upipe_fsrc->mmap_mgr != NULL && upipe_fsrc->regular_file &&
+        (uref = upipe_fsrc_map(upipe)) != NULL &&
+        ubase_check(uref_block_size(uref, &uref_size))) {
+        if (upipe_fsrc->length != (uint64_t)-1)
+            upipe_fsrc->length -= uref_size;
+        if (upipe_fsrc->uclock != NULL)
+            uref_clock_set_cr_sys(uref, systime);
+        upipe_fsrc_output(upipe, uref, &upipe_fsrc->upump);
+        return;
+    }
+    uref_free(uref);
+
+    uref = uref_block_alloc(upipe_fsrc->uref_mgr, upipe_fsrc->ubuf_mgr,
+                            upipe_fsrc->output_size);
     if (unlikely(uref == NULL)) {
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return;
@@ -430,6 +535,7 @@ static void upipe_fsrc_close(struct upipe *upipe)
     }
     upipe_fsrc->length = (uint64_t)-1;
     upipe_fsrc_set_upump_safe(upipe, NULL);
+    upipe_fsrc_clean_window(upipe);
     uref_free(upipe_fsrc->uri);
     upipe_fsrc->uri = NULL;
 }
@@ -588,6 +694,34 @@ static int _upipe_fsrc_get_range(struct upipe *upipe,
     return _upipe_fsrc_get_length(upipe, length_p);
 }
 
+/** @internal @This sets the size of the regions mapped from regular files.
+ *
+ * @param upipe description structure of the pipe
+ * @param mmap_size size of the mapped regions in octets, or 0 to use read()
+ * @return an error code
+ */
+static int _upipe_fsrc_set_mmap_size(struct upipe *upipe,
+                                     unsigned int mmap_size)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    upipe_fsrc_clean_window(upipe);
+    if (!mmap_size) {
+        ubuf_mgr_release(upipe_fsrc->mmap_mgr);
+        upipe_fsrc->mmap_mgr = NULL;
+    } else if (upipe_fsrc->mmap_mgr == NULL) {
+        upipe_fsrc->mmap_mgr =
+            ubuf_block_mmap_mgr_alloc(UBUF_MMAP_POOL_DEPTH,
+                                      UBUF_MMAP_POOL_DEPTH, true);
+        if (unlikely(upipe_fsrc->mmap_mgr == NULL)) {
+            upipe_err(upipe, "unable to allocate mmap ubuf manager");
+            upipe_fsrc->mmap_size = 0;
+            return UBASE_ERR_ALLOC;
+        }
+    }
+    upipe_fsrc->mmap_size = mmap_size;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe.
  *
  * @param upipe description structure of the pipe
@@ -651,6 +785,18 @@ static int _upipe_fsrc_control(struct upipe *upipe, int command, va_list args)
             return _upipe_fsrc_get_range(upipe, offset_p, length_p);
         }
 
+        case UPIPE_FSRC_SET_MMAP_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSRC_SIGNATURE)
+            unsigned int mmap_size = va_arg(args, unsigned int);
+            return _upipe_fsrc_set_mmap_size(upipe, mmap_size);
+        }
+        case UPIPE_FSRC_GET_MMAP_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSRC_SIGNATURE)
+            unsigned int *mmap_size_p = va_arg(args, unsigned int *);
+            *mmap_size_p = upipe_fsrc_from_upipe(upipe)->mmap_size;
+            return UBASE_ERR_NONE;
+        }
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -678,6 +824,7 @@ static int upipe_fsrc_control(struct upipe *upipe, int command, va_list args)
 static void upipe_fsrc_free(struct upipe *upipe)
 {
     upipe_fsrc_close(upipe);
+    ubuf_mgr_release(upipe_fsrc_from_upipe(upipe)->mmap_mgr);
 
     upipe_throw_dead(upipe);
 
@@ -50,6 +50,8 @@
 #include <assert.h>
 #include <arpa/inet.h>
 
+#include "pcm.h"
+
 #define EXPECTED_FLOW_DEF "block."
 
 /** upipe_htons structure */
@@ -66,6 +68,9 @@ struct upipe_htons {
     /** list of output requests */
     struct uchain request_list;
 
+    /** byteswap kernels */
+    struct upipe_pcm_funcs pcm;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -84,6 +89,7 @@ UPIPE_HELPER_OUTPUT(upipe_htons, output, flow_def, output_state, request_list);
 static void upipe_htons_input(struct upipe *upipe, struct uref *uref,
                               struct upump **upump_p)
 {
+    struct upipe_htons *upipe_htons = upipe_htons_from_upipe(upipe);
     struct ubuf *ubuf;
     size_t size = 0;
     int bufsize = -1, offset = 0;
@@ -125,11 +131,7 @@ static void upipe_htons_input(struct upipe *upipe, struct uref *uref,
             return;
         }
 
-        for (int i = 0; i < bufsize - 1; i += 2) {
-            uint8_t t = buf[i];
-            buf[i] = buf[i + 1];
-            buf[i + 1] = t;
-        }
+        upipe_pcm_bswap16(&upipe_htons->pcm, buf, bufsize);
 
         uref_block_unmap(uref, offset);
         offset += bufsize;
@@ -197,6 +199,9 @@ static struct upipe *upipe_htons_alloc(struct upipe_mgr *mgr,
     upipe_htons_init_urefcount(upipe);
     upipe_htons_init_output(upipe);
 
+    struct upipe_htons *upipe_htons = upipe_htons_from_upipe(upipe);
+    upipe_pcm_setup(&upipe_htons->pcm);
+
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -57,9 +57,11 @@ static void upipe_queue_request_free(struct urefcount *urefcount)
 /** @internal @This allocates a request.
  *
  * @param upstream upstream request
+ * @param upstream_oob queue used to send back the answers
  * @return allocated request, or NULL in case of error
  */
-struct upipe_queue_request *upipe_queue_request_alloc(struct urequest *upstream)
+struct upipe_queue_request *upipe_queue_request_alloc(struct urequest *upstream,
+                                                      struct uqueue *upstream_oob)
 {
     struct upipe_queue_request *request =
         malloc(sizeof(struct upipe_queue_request));
@@ -78,6 +80,7 @@ struct upipe_queue_request *upipe_queue_request_alloc(struct urequest *upstream)
                    upipe_queue_request_free);
     uchain_init(&request->uchain_sink);
     request->upstream = upstream;
+    request->upstream_oob = upstream_oob;
 
     urequest_init(urequest, upstream->type, uref, NULL, NULL);
     return request;
@@ -33,20 +33,27 @@
 
 #include <upipe/ubase.h>
 #include <upipe/uqueue.h>
+#include <upipe/umpsc.h>
 #include <upipe/upipe.h>
 
 #include <assert.h>
 
 /** @internal @This is the structure exported from source to sinks. */
 struct upipe_queue {
-    /** max length of the queue */
+    /** max length of the queue (of each lane in fan-in mode) */
     unsigned int max_length;
+    /** number of lanes in fan-in mode, or 0 */
+    unsigned int nb_lanes;
     /** uref queue */
     struct uqueue uqueue;
+    /** uref queue with one lane per sink, in fan-in mode */
+    struct umpsc umpsc;
     /** out of band downstream queue */
     struct uqueue downstream_oob;
     /** out of band upstream queue */
     struct uqueue upstream_oob;
+    /** out of band upstream queues, one per lane in fan-in mode */
+    struct uqueue *lanes_oob;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -71,6 +78,8 @@ struct upipe_queue_request {
     struct uchain uchain_sink;
     /** pointer to upstream request */
     struct urequest *upstream;
+    /** queue of the sink which registered the request */
+    struct uqueue *upstream_oob;
 
     /** urequest */
     struct urequest urequest;
@@ -83,9 +92,11 @@ UBASE_FROM_TO(upipe_queue_request, uchain, uchain_sink, uchain_sink)
 /** @internal @This allocates a request.
  *
  * @param upstream upstream request
+ * @param upstream_oob queue used to send back the answers
  * @return allocated request, or NULL in case of error
  */
-struct upipe_queue_request *upipe_queue_request_alloc(struct urequest *upstream);
+struct upipe_queue_request *upipe_queue_request_alloc(struct urequest *upstream,
+                                                      struct uqueue *upstream_oob);
 
 /** @This increments the reference count of a upipe_queue_request.
  *
@@ -60,6 +60,8 @@ static bool upipe_qsink_output(struct upipe *upipe, struct uref *uref,
                                struct upump **upump_p);
 /** @hidden */
 static void upipe_qsink_oob(struct upump *upump);
+/** @hidden */
+static void upipe_qsink_coalesce_timer(struct upump *upump);
 
 /** @This is the private context of a queue sink pipe. */
 struct upipe_qsink {
@@ -72,6 +74,8 @@ struct upipe_qsink {
     struct upump *upump;
     /** oob watcher */
     struct upump *upump_oob;
+    /** coalescing timer */
+    struct upump *upump_coalesce;
 
     /** pseudo-output */
     struct upipe *output;
@@ -84,6 +88,12 @@ struct upipe_qsink {
 
     /** pointer to queue source */
     struct upipe *qsrc;
+    /** lane of the queue source in fan-in mode, or NULL */
+    struct umpsc_lane *lane;
+    /** number of queued urefs waking up the queue source */
+    unsigned int coalesce_threshold;
+    /** maximum time a uref may stay pending */
+    uint64_t coalesce_timeout;
     /** temporary uref storage */
     struct uchain urefs;
     /** nb urefs in storage */
@@ -102,6 +112,7 @@ UPIPE_HELPER_UREFCOUNT(upipe_qsink, urefcount, upipe_qsink_free)
 UPIPE_HELPER_UPUMP_MGR(upipe_qsink, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_qsink, upump, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_qsink, upump_oob, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_qsink, upump_coalesce, upump_mgr)
 UPIPE_HELPER_INPUT(upipe_qsink, urefs, nb_urefs, max_urefs, blockers, upipe_qsink_output)
 
 /** @internal @This allocates a queue sink pipe.
@@ -126,14 +137,26 @@ static struct upipe *_upipe_qsink_alloc(struct upipe_mgr *mgr,
     if (unlikely(upipe_qsink == NULL))
         goto upipe_qsink_alloc_err;
 
+    struct upipe_queue *queue = upipe_queue(qsrc);
+    upipe_qsink->lane = NULL;
+    if (queue->nb_lanes &&
+        unlikely((upipe_qsink->lane = umpsc_lane_get(&queue->umpsc)) == NULL)) {
+        uprobe_err(uprobe, NULL, "no lane left in queue source");
+        free(upipe_qsink);
+        goto upipe_qsink_alloc_err;
+    }
+
     struct upipe *upipe = upipe_qsink_to_upipe(upipe_qsink);
     upipe_init(upipe, mgr, uprobe);
     upipe_qsink_init_urefcount(upipe);
     upipe_qsink_init_upump_mgr(upipe);
     upipe_qsink_init_upump(upipe);
     upipe_qsink_init_upump_oob(upipe);
+    upipe_qsink_init_upump_coalesce(upipe);
     upipe_qsink_init_input(upipe);
     upipe_qsink->qsrc = upipe_use(qsrc);
+    upipe_qsink->coalesce_threshold = 1;
+    upipe_qsink->coalesce_timeout = 0;
     upipe_qsink->flow_def = NULL;
     upipe_qsink->flow_def_sent = false;
     upipe_qsink->output = NULL;
@@ -148,6 +171,22 @@ upipe_qsink_alloc_err:
     return NULL;
 }
 
+/** @internal @This returns the queue carrying the answers to the requests
+ * of the sink.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to the upstream queue
+ */
+static struct uqueue *upipe_qsink_upstream_oob(struct upipe *upipe)
+{
+    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    struct upipe_queue *queue = upipe_queue(upipe_qsink->qsrc);
+    if (upipe_qsink->lane == NULL)
+        return &queue->upstream_oob;
+    return &queue->lanes_oob[umpsc_lane_index(&queue->umpsc,
+                                              upipe_qsink->lane)];
+}
+
 /** @internal @This outputs data to the queue.
  *
  * @param upipe description structure of the pipe
@@ -159,8 +198,52 @@ static bool upipe_qsink_output(struct upipe *upipe, struct uref *uref,
                                struct upump **upump_p)
 {
     struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
-    return uqueue_push(&upipe_queue(upipe_qsink->qsrc)->uqueue,
-                       uref_to_uchain(uref));
+    if (upipe_qsink->lane != NULL)
+        return umpsc_push(&upipe_queue(upipe_qsink->qsrc)->umpsc,
+                          upipe_qsink->lane, uref_to_uchain(uref));
+
+    struct uqueue *uqueue = &upipe_queue(upipe_qsink->qsrc)->uqueue;
+    if (likely(upipe_qsink->coalesce_threshold <= 1))
+        return uqueue_push(uqueue, uref_to_uchain(uref));
+
+    if (unlikely(!uqueue_push_coalesce(uqueue, uref_to_uchain(uref),
+                                       upipe_qsink->coalesce_threshold)))
+        return false;
+
+    /* make sure pending urefs are eventually signalled */
+    if (upipe_qsink->upump_coalesce == NULL) {
+        upipe_qsink_check_upump_mgr(upipe);
+        if (likely(upipe_qsink->upump_mgr != NULL))
+            upipe_qsink_wait_upump_coalesce(upipe,
+                                            upipe_qsink->coalesce_timeout,
+                                            upipe_qsink_coalesce_timer);
+        else
+            uqueue_signal_pop(uqueue);
+    }
+    return true;
+}
+
+/** @internal @This cancels the coalescing timer and wakes up the queue
+ * source if urefs are pending.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_qsink_signal(struct upipe *upipe)
+{
+    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    upipe_qsink_set_upump_coalesce(upipe, NULL);
+    if (upipe_qsink->lane == NULL)
+        uqueue_signal_pop(&upipe_queue(upipe_qsink->qsrc)->uqueue);
+}
+
+/** @internal @This is called when the coalescing timeout expires.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_qsink_coalesce_timer(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    upipe_qsink_signal(upipe);
 }
 
 /** @internal @This is called when the queue can be written again.
@@ -197,10 +280,17 @@ static bool upipe_qsink_check_watcher(struct upipe *upipe)
     if (upipe_qsink->upump_mgr == NULL)
         return false;
 
-    struct upump *upump =
-        uqueue_upump_alloc_push(&upipe_queue(upipe_qsink->qsrc)->uqueue,
-                                upipe_qsink->upump_mgr,
-                                upipe_qsink_watcher, upipe, upipe->refcount);
+    struct upump *upump;
+    if (upipe_qsink->lane != NULL)
+        upump = umpsc_lane_upump_alloc_push(upipe_qsink->lane,
+                                            upipe_qsink->upump_mgr,
+                                            upipe_qsink_watcher, upipe,
+                                            upipe->refcount);
+    else
+        upump = uqueue_upump_alloc_push(&upipe_queue(upipe_qsink->qsrc)->uqueue,
+                                        upipe_qsink->upump_mgr,
+                                        upipe_qsink_watcher, upipe,
+                                        upipe->refcount);
     if (unlikely(upump == NULL)) {
         upipe_err_va(upipe, "can't create watcher");
         upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
@@ -306,6 +396,50 @@ static int upipe_qsink_set_flow_def(struct upipe *upipe, struct uref *uref)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the wake-up coalescing parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param threshold_p filled in with the number of queued urefs waking up the
+ * queue source
+ * @param timeout_p filled in with the maximum time a uref may stay pending
+ * @return an error code
+ */
+static int _upipe_qsink_get_coalesce(struct upipe *upipe,
+                                     unsigned int *threshold_p,
+                                     uint64_t *timeout_p)
+{
+    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    if (threshold_p != NULL)
+        *threshold_p = upipe_qsink->coalesce_threshold;
+    if (timeout_p != NULL)
+        *timeout_p = upipe_qsink->coalesce_timeout;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the wake-up coalescing parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param threshold number of queued urefs waking up the queue source
+ * @param timeout maximum time a uref may stay pending
+ * @return an error code
+ */
+static int _upipe_qsink_set_coalesce(struct upipe *upipe,
+                                     unsigned int threshold, uint64_t timeout)
+{
+    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+    if (unlikely(!threshold || (threshold > 1 && !timeout)))
+        return UBASE_ERR_INVALID;
+    /* in fan-in mode the queue source is only woken up when it is idle */
+    if (unlikely(upipe_qsink->lane != NULL && threshold > 1))
+        return UBASE_ERR_INVALID;
+
+    upipe_qsink->coalesce_threshold = threshold;
+    upipe_qsink->coalesce_timeout = timeout;
+    /* flush what may have been left pending with the former parameters */
+    upipe_qsink_signal(upipe);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This flushes all currently held buffers, and unblocks the
  * sources.
  *
@@ -351,7 +485,7 @@ static int upipe_qsink_push_downstream(struct upipe *upipe,
         upipe_qsink_check_upump_mgr(upipe);
         if (upipe_qsink->upump_mgr != NULL) {
             struct upump *upump = uqueue_upump_alloc_pop(
-                    &upipe_queue(upipe_qsink->qsrc)->upstream_oob,
+                    upipe_qsink_upstream_oob(upipe),
                     upipe_qsink->upump_mgr, upipe_qsink_oob, upipe,
                     upipe->refcount);
             if (unlikely(upump == NULL)) {
@@ -377,7 +511,7 @@ static int upipe_qsink_register_request(struct upipe *upipe,
 {
     struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
     struct upipe_queue_request *upipe_queue_proxy =
-        upipe_queue_request_alloc(urequest);
+        upipe_queue_request_alloc(urequest, upipe_qsink_upstream_oob(upipe));
     UBASE_ALLOC_RETURN(upipe_queue_proxy);
     ulist_add(&upipe_qsink->request_list,
               upipe_queue_request_to_uchain_sink(upipe_queue_proxy));
@@ -427,9 +561,8 @@ static int upipe_qsink_unregister_request(struct upipe *upipe,
 static void upipe_qsink_oob(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
-    struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
     struct upipe_queue_upstream *upstream =
-        uqueue_pop(&upipe_queue(upipe_qsink->qsrc)->upstream_oob,
+        uqueue_pop(upipe_qsink_upstream_oob(upipe),
                    struct upipe_queue_upstream *);
     if (unlikely(upstream == NULL))
         return;
@@ -495,6 +628,7 @@ static int _upipe_qsink_control(struct upipe *upipe, int command, va_list args)
         }
         case UPIPE_ATTACH_UPUMP_MGR:
             upipe_qsink_set_upump(upipe, NULL);
+            upipe_qsink_signal(upipe);
             return upipe_qsink_attach_upump_mgr(upipe);
         case UPIPE_GET_OUTPUT: {
             struct upipe **p = va_arg(args, struct upipe **);
@@ -520,6 +654,19 @@ static int _upipe_qsink_control(struct upipe *upipe, int command, va_list args)
 
         case UPIPE_FLUSH:
             return upipe_qsink_flush(upipe);
+
+        case UPIPE_QSINK_GET_COALESCE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSINK_SIGNATURE)
+            unsigned int *threshold_p = va_arg(args, unsigned int *);
+            uint64_t *timeout_p = va_arg(args, uint64_t *);
+            return _upipe_qsink_get_coalesce(upipe, threshold_p, timeout_p);
+        }
+        case UPIPE_QSINK_SET_COALESCE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSINK_SIGNATURE)
+            unsigned int threshold = va_arg(args, unsigned int);
+            uint64_t timeout = va_arg(args, uint64_t);
+            return _upipe_qsink_set_coalesce(upipe, threshold, timeout);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -554,6 +701,24 @@ static void upipe_qsink_free(struct upipe *upipe)
 {
     struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
 
+    /* wake up the queue source for urefs left pending */
+    upipe_qsink_signal(upipe);
+
+    if (upipe_qsink->lane != NULL) {
+        /* the lane may be claimed by another sink, which must ignore the
+         * answers to our requests */
+        struct uchain *uchain, *uchain_tmp;
+        ulist_delete_foreach (&upipe_qsink->request_list, uchain, uchain_tmp) {
+            struct upipe_queue_request *upipe_queue_proxy =
+                upipe_queue_request_from_uchain_sink(uchain);
+            ulist_delete(uchain);
+            upipe_qsink_push_downstream(upipe,
+                    UPIPE_QUEUE_DOWNSTREAM_UNREGISTER, upipe_queue_proxy);
+            upipe_queue_request_release(upipe_queue_proxy);
+        }
+        umpsc_lane_put(upipe_qsink->lane);
+    }
+
     /* play source end */
     upipe_notice_va(upipe, "ending queue source %p", upipe_qsink->qsrc);
     upipe_qsink_push_downstream(upipe, UPIPE_QUEUE_DOWNSTREAM_SOURCE_END, NULL);
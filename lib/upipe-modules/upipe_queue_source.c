@@ -28,9 +28,13 @@
  *
  * Note that the allocator requires an additional parameter:
  * @table 2
- * @item queue_length @item maximum length of the queue (<= 255)
+ * @item queue_length @item maximum length of the queue
  * @end table
  *
+ * In fan-in mode (@ref upipe_qsrc_fanin_alloc), an additional parameter
+ * gives the maximum number of sinks, and each sink gets its own lane of
+ * queue_length elements.
+ *
  * Also note that this module is exceptional in that upipe_release() may be
  * called from another thread. The release function is thread-safe.
  */
@@ -80,6 +84,9 @@ struct upipe_qsrc {
     /** list of output requests */
     struct uchain request_list;
 
+    /** maximum number of urefs output per wake-up */
+    unsigned int batch;
+
     /** structure exported to the sinks */
     struct upipe_queue upipe_queue;
 
@@ -96,6 +103,74 @@ UPIPE_HELPER_UPUMP_MGR(upipe_qsrc, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_qsrc, upump, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_qsrc, upump_oob, upump_mgr)
 
+/** @internal @This initializes the uref queue, and in fan-in mode the
+ * upstream queues of the lanes.
+ *
+ * @param upipe description structure of the pipe
+ * @param length maximum length of the queue (of each lane in fan-in mode)
+ * @param nb_lanes number of lanes, or 0
+ * @return false in case of failure
+ */
+static bool upipe_qsrc_init_queue(struct upipe *upipe, unsigned int length,
+                                  unsigned int nb_lanes)
+{
+    struct upipe_qsrc *upipe_qsrc = upipe_qsrc_from_upipe(upipe);
+    struct upipe_queue *queue = upipe_queue(upipe);
+    queue->nb_lanes = nb_lanes;
+    queue->lanes_oob = NULL;
+    if (!nb_lanes)
+        return uqueue_init(&queue->uqueue, length, upipe_qsrc->uqueue_extra);
+
+    uint8_t *extra = upipe_qsrc->uqueue_extra;
+    queue->lanes_oob = (struct uqueue *)extra;
+    extra += nb_lanes * sizeof(struct uqueue);
+    for (unsigned int i = 0; i < nb_lanes; i++) {
+        if (unlikely(!uqueue_init(&queue->lanes_oob[i], OOB_QUEUES, extra))) {
+            while (i--)
+                uqueue_clean(&queue->lanes_oob[i]);
+            return false;
+        }
+        extra += uqueue_sizeof(OOB_QUEUES);
+    }
+    if (unlikely(!umpsc_init(&queue->umpsc, nb_lanes, length, extra))) {
+        for (unsigned int i = 0; i < nb_lanes; i++)
+            uqueue_clean(&queue->lanes_oob[i]);
+        return false;
+    }
+    return true;
+}
+
+/** @internal @This cleans up the uref queue, and in fan-in mode the upstream
+ * queues of the lanes.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_qsrc_clean_queue(struct upipe *upipe)
+{
+    struct upipe_queue *queue = upipe_queue(upipe);
+    if (!queue->nb_lanes) {
+        uqueue_clean(&queue->uqueue);
+        return;
+    }
+
+    for (unsigned int i = 0; i < queue->nb_lanes; i++)
+        uqueue_clean(&queue->lanes_oob[i]);
+    umpsc_clean(&queue->umpsc);
+}
+
+/** @internal @This pops a uref from the queue.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to uref, or NULL if the queue is empty
+ */
+static inline struct uref *upipe_qsrc_pop(struct upipe *upipe)
+{
+    struct upipe_queue *queue = upipe_queue(upipe);
+    if (queue->nb_lanes)
+        return umpsc_pop(&queue->umpsc, struct uref *);
+    return uqueue_pop(&queue->uqueue, struct uref *);
+}
+
 /** @internal @This allocates a queue source pipe.
  *
  * @param mgr common management structure
@@ -108,28 +183,42 @@ static struct upipe *_upipe_qsrc_alloc(struct upipe_mgr *mgr,
                                        struct uprobe *uprobe,
                                        uint32_t signature, va_list args)
 {
-    if (signature != UPIPE_QSRC_SIGNATURE)
+    if (signature != UPIPE_QSRC_SIGNATURE &&
+        signature != UPIPE_QSRC_FANIN_SIGNATURE)
         goto upipe_qsrc_alloc_err;
     unsigned int length = va_arg(args, unsigned int);
-    if (!length || length > UINT8_MAX)
+    if (!length || length > UQUEUE_MAX_LENGTH)
         goto upipe_qsrc_alloc_err;
+    unsigned int nb_lanes = 0;
+    if (signature == UPIPE_QSRC_FANIN_SIGNATURE) {
+        nb_lanes = va_arg(args, unsigned int);
+        if (!nb_lanes)
+            goto upipe_qsrc_alloc_err;
+    }
 
+    size_t queue_size = uqueue_sizeof(length);
+    if (nb_lanes)
+        queue_size = nb_lanes * (sizeof(struct uqueue) +
+                                 uqueue_sizeof(OOB_QUEUES)) +
+                     umpsc_sizeof(nb_lanes, length);
     struct upipe_qsrc *upipe_qsrc = malloc(sizeof(struct upipe_qsrc) +
-                                           uqueue_sizeof(length) +
+                                           queue_size +
                                            2 * uqueue_sizeof(OOB_QUEUES));
     if (unlikely(upipe_qsrc == NULL))
         goto upipe_qsrc_alloc_err;
 
     struct upipe *upipe = upipe_qsrc_to_upipe(upipe_qsrc);
     upipe_init(upipe, mgr, uprobe);
-    if (unlikely(!uqueue_init(&upipe_queue(upipe)->uqueue, length,
-                              upipe_qsrc->uqueue_extra) ||
-                 !uqueue_init(&upipe_queue(upipe)->downstream_oob, OOB_QUEUES,
-                              upipe_qsrc->uqueue_extra +
-                              uqueue_sizeof(length)) ||
+    if (unlikely(!upipe_qsrc_init_queue(upipe, length, nb_lanes))) {
+        free(upipe_qsrc);
+        goto upipe_qsrc_alloc_err;
+    }
+    if (unlikely(!uqueue_init(&upipe_queue(upipe)->downstream_oob, OOB_QUEUES,
+                              upipe_qsrc->uqueue_extra + queue_size) ||
                  !uqueue_init(&upipe_queue(upipe)->upstream_oob, OOB_QUEUES,
-                              upipe_qsrc->uqueue_extra + uqueue_sizeof(length) +
+                              upipe_qsrc->uqueue_extra + queue_size +
                               uqueue_sizeof(OOB_QUEUES)))) {
+        upipe_qsrc_clean_queue(upipe);
         free(upipe_qsrc);
         goto upipe_qsrc_alloc_err;
     }
@@ -140,6 +229,7 @@ static struct upipe *_upipe_qsrc_alloc(struct upipe_mgr *mgr,
     upipe_qsrc_init_upump(upipe);
     upipe_qsrc_init_upump_oob(upipe);
     upipe_qsrc->upipe_queue.max_length = length;
+    upipe_qsrc->batch = 1;
     upipe_throw_ready(upipe);
 
     return upipe;
@@ -167,7 +257,8 @@ static void upipe_qsrc_input(struct upipe *upipe, struct uref *uref,
     upipe_qsrc_output(upipe, uref, upump_p);
 }
 
-/** @internal @This reads data from the queue and outputs it.
+/** @internal @This reads data from the queue and outputs it, up to the
+ * configured batch size.
  *
  * @param upump description structure of the read watcher
  */
@@ -175,9 +266,15 @@ static void upipe_qsrc_worker(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_qsrc *upipe_qsrc = upipe_qsrc_from_upipe(upipe);
-    struct uref *uref = uqueue_pop(&upipe_queue(upipe)->uqueue, struct uref *);
-    if (likely(uref != NULL))
+    unsigned int batch = upipe_qsrc->batch;
+
+    /* stop if the watcher is replaced or freed by a downstream pipe */
+    while (batch-- && upipe_qsrc->upump == upump) {
+        struct uref *uref = upipe_qsrc_pop(upipe);
+        if (unlikely(uref == NULL))
+            break;
         upipe_qsrc_input(upipe, uref, &upipe_qsrc->upump);
+    }
 }
 
 /** @internal @This handles the result of a request.
@@ -220,7 +317,7 @@ static int upipe_qsrc_provide_request(struct urequest *urequest, va_list args)
             break;
     }
 
-    if (unlikely(!uqueue_push(&upipe_queue(upipe)->upstream_oob, upstream))) {
+    if (unlikely(!uqueue_push(request->upstream_oob, upstream))) {
         upipe_warn(upipe, "unable to send upstream message");
         upipe_queue_upstream_free(upstream);
     }
@@ -260,7 +357,8 @@ static int upipe_qsrc_unregister_request(struct upipe *upipe,
     return err;
 }
 
-/** @internal @This flushes the queue and emits source end.
+/** @internal @This flushes the queue and emits source end. In fan-in mode,
+ * source end is only emitted when the last sink is gone.
  *
  * @param upipe description structure of the pipe
  * @return an error code
@@ -268,10 +366,12 @@ static int upipe_qsrc_unregister_request(struct upipe *upipe,
 static void upipe_qsrc_source_end(struct upipe *upipe)
 {
     struct uref *uref;
-    while ((uref = uqueue_pop(&upipe_queue(upipe)->uqueue,
-                              struct uref *)) != NULL)
+    while ((uref = upipe_qsrc_pop(upipe)) != NULL)
         upipe_qsrc_input(upipe, uref, NULL);
 
+    struct upipe_queue *queue = upipe_queue(upipe);
+    if (queue->nb_lanes && umpsc_producers(&queue->umpsc))
+        return;
     upipe_throw_source_end(upipe);
 }
 
@@ -283,8 +383,7 @@ static void upipe_qsrc_source_end(struct upipe *upipe)
 static void upipe_qsrc_ref_end(struct upipe *upipe)
 {
     struct uref *uref;
-    while ((uref = uqueue_pop(&upipe_queue(upipe)->uqueue,
-                              struct uref *)) != NULL)
+    while ((uref = upipe_qsrc_pop(upipe)) != NULL)
         upipe_qsrc_input(upipe, uref, NULL);
 
     upipe_notice_va(upipe, "freeing queue %p", upipe);
@@ -299,13 +398,17 @@ static void upipe_qsrc_ref_end(struct upipe *upipe)
     while ((upstream = uqueue_pop(&upipe_queue(upipe)->upstream_oob,
                                   struct upipe_queue_upstream *)) != NULL)
         upipe_queue_upstream_free(upstream);
+    for (unsigned int i = 0; i < upipe_queue(upipe)->nb_lanes; i++)
+        while ((upstream = uqueue_pop(&upipe_queue(upipe)->lanes_oob[i],
+                                      struct upipe_queue_upstream *)) != NULL)
+            upipe_queue_upstream_free(upstream);
 
     upipe_qsrc_clean_upump(upipe);
     upipe_qsrc_clean_upump_oob(upipe);
     upipe_qsrc_clean_upump_mgr(upipe);
     upipe_qsrc_clean_output(upipe);
 
-    uqueue_clean(&upipe_queue(upipe)->uqueue);
+    upipe_qsrc_clean_queue(upipe);
     uqueue_clean(&upipe_queue(upipe)->downstream_oob);
     uqueue_clean(&upipe_queue(upipe)->upstream_oob);
 
@@ -349,7 +452,8 @@ static void upipe_qsrc_oob(struct upump *upump)
     upipe_queue_downstream_free(downstream);
 }
 
-/** @internal @This returns the maximum length of the queue.
+/** @internal @This returns the maximum length of the queue, or of each lane
+ * in fan-in mode.
  *
  * @param upipe description structure of the pipe
  * @param length_p filled in with the maximum length of the queue
@@ -375,8 +479,41 @@ static int _upipe_qsrc_get_max_length(struct upipe *upipe,
  */
 static int _upipe_qsrc_get_length(struct upipe *upipe, unsigned int *length_p)
 {
+    struct upipe_queue *queue = upipe_queue(upipe);
     assert(length_p != NULL);
-    *length_p = uqueue_length(&upipe_queue(upipe)->uqueue);
+    if (queue->nb_lanes)
+        *length_p = umpsc_length(&queue->umpsc);
+    else
+        *length_p = uqueue_length(&queue->uqueue);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the maximum number of urefs output per wake-up.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_p filled in with the maximum number of urefs per wake-up
+ * @return an error code
+ */
+static int _upipe_qsrc_get_batch(struct upipe *upipe, unsigned int *batch_p)
+{
+    struct upipe_qsrc *upipe_qsrc = upipe_qsrc_from_upipe(upipe);
+    assert(batch_p != NULL);
+    *batch_p = upipe_qsrc->batch;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the maximum number of urefs output per wake-up.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of urefs per wake-up
+ * @return an error code
+ */
+static int _upipe_qsrc_set_batch(struct upipe *upipe, unsigned int batch)
+{
+    struct upipe_qsrc *upipe_qsrc = upipe_qsrc_from_upipe(upipe);
+    if (unlikely(!batch))
+        return UBASE_ERR_INVALID;
+    upipe_qsrc->batch = batch;
     return UBASE_ERR_NONE;
 }
 
@@ -408,6 +545,16 @@ static int _upipe_qsrc_control(struct upipe *upipe, int command, va_list args)
             unsigned int *length_p = va_arg(args, unsigned int *);
             return _upipe_qsrc_get_length(upipe, length_p);
         }
+        case UPIPE_QSRC_GET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSRC_SIGNATURE)
+            unsigned int *batch_p = va_arg(args, unsigned int *);
+            return _upipe_qsrc_get_batch(upipe, batch_p);
+        }
+        case UPIPE_QSRC_SET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSRC_SIGNATURE)
+            unsigned int batch = va_arg(args, unsigned int);
+            return _upipe_qsrc_set_batch(upipe, batch);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -423,16 +570,33 @@ static int _upipe_qsrc_control(struct upipe *upipe, int command, va_list args)
  */
 static int upipe_qsrc_control(struct upipe *upipe, int command, va_list args)
 {
+    switch (command) {
+        case UPIPE_QSRC_GET_BATCH:
+        case UPIPE_QSRC_SET_BATCH:
+            /* may be called before the pipe is handed to its upump_mgr
+             * thread, so do not ask for a upump_mgr here */
+            return _upipe_qsrc_control(upipe, command, args);
+        default:
+            break;
+    }
+
     UBASE_RETURN(_upipe_qsrc_control(upipe, command, args));
     upipe_qsrc_check_upump_mgr(upipe);
 
     struct upipe_qsrc *upipe_qsrc = upipe_qsrc_from_upipe(upipe);
     if (upipe_qsrc->upump_mgr != NULL && upipe_qsrc->upipe_queue.max_length &&
         upipe_qsrc->upump == NULL) {
-        struct upump *upump =
-            uqueue_upump_alloc_pop(&upipe_queue(upipe)->uqueue,
-                                   upipe_qsrc->upump_mgr,
-                                   upipe_qsrc_worker, upipe, upipe->refcount);
+        struct upipe_queue *queue = upipe_queue(upipe);
+        struct upump *upump;
+        if (queue->nb_lanes)
+            upump = umpsc_upump_alloc_pop(&queue->umpsc, upipe_qsrc->upump_mgr,
+                                          upipe_qsrc_worker, upipe,
+                                          upipe->refcount);
+        else
+            upump = uqueue_upump_alloc_pop(&queue->uqueue,
+                                           upipe_qsrc->upump_mgr,
+                                           upipe_qsrc_worker, upipe,
+                                           upipe->refcount);
         if (unlikely(upump == NULL)) {
             upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
             return UBASE_ERR_UPUMP;
@@ -49,6 +49,8 @@
 
 #include <upipe-modules/upipe_rtp_pcm_pack.h>
 
+#include "pcm.h"
+
 struct upipe_rtp_pcm_pack {
     /** refcount management structure */
     struct urefcount urefcount;
@@ -92,6 +94,9 @@ struct upipe_rtp_pcm_pack {
     /** list of blockers (used during urequest) */
     struct uchain blockers;
 
+    /** conversion kernels */
+    struct upipe_pcm_funcs pcm;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -250,6 +255,10 @@ static struct upipe *upipe_rtp_pcm_pack_alloc(struct upipe_mgr *mgr,
     upipe_rtp_pcm_pack_init_uref_stream(upipe);
     upipe_rtp_pcm_pack_init_output(upipe);
 
+    struct upipe_rtp_pcm_pack *upipe_rtp_pcm_pack =
+        upipe_rtp_pcm_pack_from_upipe(upipe);
+    upipe_pcm_setup(&upipe_rtp_pcm_pack->pcm);
+
     return upipe;
 }
 
@@ -294,9 +303,7 @@ static bool upipe_rtp_pcm_pack_handle(struct upipe *upipe, struct uref *uref,
 
     uref_sound_read_int32_t(uref, 0, -1, &src, 1);
 
-    for (int i = 0; i < s; i++)
-        for (int j = 0; j < 3; j++)
-            dst[3*i+j] = (src[i] >> (8 * (3-j))) & 0xff;
+    upipe_pcm_s32_to_l24(&upipe_rtp_pcm_pack->pcm, dst, src, s);
 
     ubuf_block_unmap(ubuf, 0);
     uref_sound_unmap(uref, 0, -1, 1);
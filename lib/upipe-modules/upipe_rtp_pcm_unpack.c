@@ -49,6 +49,8 @@
 #include <upipe/ubuf_sound.h>
 #include <upipe/ubuf_block.h>
 
+#include "pcm.h"
+
 struct upipe_rtp_pcm_unpack {
     /** refcount management structure */
     struct urefcount urefcount;
@@ -84,6 +86,9 @@ struct upipe_rtp_pcm_unpack {
     /** list of blockers (used during urequest) */
     struct uchain blockers;
 
+    /** conversion kernels */
+    struct upipe_pcm_funcs pcm;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -208,6 +213,10 @@ static struct upipe *upipe_rtp_pcm_unpack_alloc(struct upipe_mgr *mgr,
     upipe_rtp_pcm_unpack_init_input(upipe);
     upipe_rtp_pcm_unpack_init_output(upipe);
 
+    struct upipe_rtp_pcm_unpack *upipe_rtp_pcm_unpack =
+        upipe_rtp_pcm_unpack_from_upipe(upipe);
+    upipe_pcm_setup(&upipe_rtp_pcm_unpack->pcm);
+
     return upipe;
 }
 
@@ -251,8 +260,7 @@ static bool upipe_rtp_pcm_unpack_handle(struct upipe *upipe, struct uref *uref,
     uref_block_read(uref, 0, &size, &src);
     ubuf_sound_write_int32_t(ubuf, 0, -1, &dst, 1);
 
-    for (int i = 0; i < s; i++)
-        dst[i] = (src[3*i] << 24) | (src[3*i+1] << 16) | (src[3*i+2] << 8);
+    upipe_pcm_l24_to_s32(&upipe_rtp_pcm_unpack->pcm, dst, src, s);
 
     ubuf_sound_unmap(ubuf, 0, -1, 1);
     uref_block_unmap(uref, 0);
@@ -28,6 +28,8 @@
  * @short Upipe sink module for udp
  */
 
+#define _GNU_SOURCE
+
 #include <upipe/ubase.h>
 #include <upipe/ulist.h>
 #include <upipe/uprobe.h>
@@ -57,10 +59,17 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <errno.h>
 #include <assert.h>
+#include <time.h>
+
+#ifdef UPIPE_HAVE_LINUX_NET_TSTAMP_H
+#include <linux/net_tstamp.h>
+#endif
 
 /** tolerance for late packets */
 #define SYSTIME_TOLERANCE UCLOCK_FREQ
@@ -72,6 +81,17 @@
 #define UDP_DEFAULT_TTL 0
 #define UDP_DEFAULT_PORT 1234
 
+/** maximum number of datagrams sent in a single batch */
+#define UPIPE_UDPSINK_MAX_BATCH 256
+/** maximum payload of a segmented datagram */
+#define UDP_GSO_MAX_SIZE 65507
+/** maximum number of segments in a segmented datagram */
+#define UDP_GSO_MAX_SEGMENTS 64
+/** number of nanoseconds per second */
+#define NSEC_PER_SEC UINT64_C(1000000000)
+/** maximum delay of packets handed to the kernel with a transmit time */
+#define TXTIME_MAX_HORIZON (UCLOCK_FREQ * 60)
+
 /** @hidden */
 static void upipe_udpsink_watcher(struct upump *upump);
 /** @hidden */
@@ -108,6 +128,19 @@ struct upipe_udpsink {
     /** list of blockers */
     struct uchain blockers;
 
+    /** max number of datagrams sent per system call */
+    unsigned int batch;
+    /** packets due within this delay are sent in the same batch */
+    uint64_t batch_window;
+    /** true if same-size datagrams are coalesced with UDP_SEGMENT */
+    bool gso;
+    /** clock of the kernel transmit time scheduler, or -1 */
+    int txtime_clockid;
+    /** packets due within this delay are handed to the kernel scheduler */
+    uint64_t txtime_horizon;
+    /** true if SO_TXTIME is enabled on the socket */
+    bool txtime;
+
     /** RAW sockets */
     bool raw;
     /** RAW header */
@@ -158,6 +191,12 @@ static struct upipe *upipe_udpsink_alloc(struct upipe_mgr *mgr,
     upipe_udpsink->uri = NULL;
     upipe_udpsink->raw = false;
     upipe_udpsink->addrlen = 0;
+    upipe_udpsink->batch = 1;
+    upipe_udpsink->batch_window = 0;
+    upipe_udpsink->gso = false;
+    upipe_udpsink->txtime_clockid = -1;
+    upipe_udpsink->txtime_horizon = 0;
+    upipe_udpsink->txtime = false;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -185,6 +224,95 @@ static void upipe_udpsink_poll(struct upipe *upipe)
     }
 }
 
+/** @internal @This enables kernel-paced transmission on the socket, if it
+ * was requested.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsink_check_txtime(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    upipe_udpsink->txtime = false;
+    if (upipe_udpsink->txtime_clockid == -1 || upipe_udpsink->fd == -1)
+        return;
+
+#if defined(UPIPE_HAVE_LINUX_NET_TSTAMP_H) && defined(SO_TXTIME)
+    struct sock_txtime sock_txtime = {
+        .clockid = upipe_udpsink->txtime_clockid,
+        .flags = 0,
+    };
+    if (likely(setsockopt(upipe_udpsink->fd, SOL_SOCKET, SO_TXTIME,
+                          &sock_txtime, sizeof(sock_txtime)) == 0)) {
+        upipe_udpsink->txtime = true;
+        return;
+    }
+    upipe_warn_va(upipe, "unable to set SO_TXTIME (%m), using timers");
+#else
+    upipe_warn(upipe, "SO_TXTIME is not supported, using timers");
+#endif
+}
+
+/** @internal @This returns the current date in the clock of the kernel
+ * transmit time scheduler. If the clock cannot be read, kernel pacing is
+ * disabled and the pipe falls back to timers.
+ *
+ * @param upipe description structure of the pipe
+ * @return current date in nanoseconds, or 0 in case of error
+ */
+static uint64_t upipe_udpsink_txtime_now(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    struct timespec ts;
+    if (unlikely(clock_gettime(upipe_udpsink->txtime_clockid, &ts) == -1)) {
+        upipe_warn_va(upipe, "unable to read clock %d (%m), using timers",
+                      upipe_udpsink->txtime_clockid);
+        upipe_udpsink->txtime = false;
+        return 0;
+    }
+    return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/** @internal @This converts a system date to a transmit time. Dates
+ * further than the horizon are brought back to it, so that the conversion
+ * cannot overflow.
+ *
+ * @param upipe description structure of the pipe
+ * @param systime system date of the packet
+ * @param now current system date
+ * @param txtime_now current date in the clock of the kernel scheduler
+ * @return transmit time in nanoseconds, or 0 to send immediately
+ */
+static uint64_t upipe_udpsink_txtime_from_sys(struct upipe *upipe,
+                                              uint64_t systime, uint64_t now,
+                                              uint64_t txtime_now)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (!txtime_now || systime <= now)
+        return 0;
+    uint64_t delay = systime - now;
+    if (unlikely(delay > upipe_udpsink->txtime_horizon))
+        delay = upipe_udpsink->txtime_horizon;
+    return txtime_now + delay * NSEC_PER_SEC / UCLOCK_FREQ;
+}
+
+/** @internal @This adds a transmit time control message.
+ *
+ * @param msghdr message header, with enough control space
+ * @param txtime transmit time in nanoseconds
+ */
+static void upipe_udpsink_set_txtime_cmsg(struct msghdr *msghdr,
+                                          uint64_t txtime)
+{
+#if defined(UPIPE_HAVE_LINUX_NET_TSTAMP_H) && defined(SO_TXTIME)
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(msghdr);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_TXTIME;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+    memcpy(CMSG_DATA(cmsg), &txtime, sizeof(uint64_t));
+    msghdr->msg_controllen = CMSG_SPACE(sizeof(uint64_t));
+#endif
+}
+
 /** @internal @This outputs data to the udp sink.
  *
  * @param upipe description structure of the pipe
@@ -212,6 +340,7 @@ static bool upipe_udpsink_output(struct upipe *upipe, struct uref *uref,
         return true;
     }
 
+    uint64_t txtime = 0, txtime_now;
     if (likely(upipe_udpsink->uclock == NULL))
         goto write_buffer;
 
@@ -223,13 +352,23 @@ static bool upipe_udpsink_output(struct upipe *upipe, struct uref *uref,
 
     uint64_t now = uclock_now(upipe_udpsink->uclock);
     systime += upipe_udpsink->latency;
-    if (unlikely(now < systime)) {
+    if (upipe_udpsink->txtime && now < systime &&
+        systime - now <= upipe_udpsink->txtime_horizon &&
+        (txtime_now = upipe_udpsink_txtime_now(upipe))) {
+        /* let the kernel release the packet on time */
+        txtime = upipe_udpsink_txtime_from_sys(upipe, systime, now,
+                                               txtime_now);
+    } else if (unlikely(now < systime)) {
         upipe_udpsink_check_upump_mgr(upipe);
         if (likely(upipe_udpsink->upump_mgr != NULL)) {
+            /* wake up when the packet enters the horizon of the kernel
+             * scheduler, rather than at its date */
+            uint64_t wait = systime - now;
+            if (upipe_udpsink->txtime)
+                wait -= upipe_udpsink->txtime_horizon;
             upipe_verbose_va(upipe, "sleeping %"PRIu64" (%"PRIu64")",
-                             systime - now, systime);
-            upipe_udpsink_wait_upump(upipe, systime - now,
-                                     upipe_udpsink_watcher);
+                             wait, systime);
+            upipe_udpsink_wait_upump(upipe, wait, upipe_udpsink_watcher);
             return false;
         }
     } else if (now > systime + SYSTIME_TOLERANCE) {
@@ -284,6 +423,10 @@ write_buffer:
             break;
         }
 
+        union {
+            char buf[CMSG_SPACE(sizeof(uint64_t))];
+            struct cmsghdr align;
+        } control;
         struct msghdr msghdr = {
             .msg_name = upipe_udpsink->addrlen ? &upipe_udpsink->addr : NULL,
             .msg_namelen = upipe_udpsink->addrlen,
@@ -291,10 +434,12 @@ write_buffer:
             .msg_iov = iovecs_s,
             .msg_iovlen = iovec_count,
 
-            .msg_control = NULL,
-            .msg_controllen = 0,
+            .msg_control = txtime ? control.buf : NULL,
+            .msg_controllen = txtime ? sizeof(control.buf) : 0,
             .msg_flags = 0,
         };
+        if (txtime)
+            upipe_udpsink_set_txtime_cmsg(&msghdr, txtime);
 
         ssize_t ret = sendmsg(upipe_udpsink->fd, &msghdr, 0);
         uref_block_iovec_unmap(uref, 0, -1, iovecs);
@@ -329,6 +474,297 @@ write_buffer:
     return true;
 }
 
+#ifdef UPIPE_HAVE_SENDMMSG
+/** @internal @This sends a vector of urefs with as few system calls as
+ * possible. Urefs that could not be sent are held again.
+ *
+ * @param upipe description structure of the pipe
+ * @param urefs array of urefs to send
+ * @param txtimes array of transmit times (0 to send immediately)
+ * @param nb_urefs number of urefs in the array
+ * @return false if the socket is not writable anymore
+ */
+static bool upipe_udpsink_send_batch(struct upipe *upipe,
+                                     struct uref **urefs,
+                                     const uint64_t *txtimes,
+                                     unsigned int nb_urefs)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    bool raw = upipe_udpsink->raw;
+    /* all segments of a datagram share the same transmit time */
+    bool gso = upipe_udpsink->gso && !raw && !upipe_udpsink->txtime;
+    size_t sizes[nb_urefs];
+    unsigned int iov_start[nb_urefs];
+    unsigned int iov_count[nb_urefs];
+    unsigned int nb_iovecs = 0;
+
+    for (unsigned int i = 0; i < nb_urefs; i++) {
+        int count = uref_block_iovec_count(urefs[i], 0, -1);
+        if (unlikely(count <= 0 ||
+                     !ubase_check(uref_block_size(urefs[i], &sizes[i])))) {
+            if (count == -1)
+                upipe_warn(upipe, "cannot read ubuf buffer");
+            uref_free(urefs[i]);
+            urefs[i] = NULL;
+            iov_start[i] = nb_iovecs;
+            iov_count[i] = 0;
+            continue;
+        }
+        iov_start[i] = nb_iovecs;
+        iov_count[i] = count + (raw ? 1 : 0);
+        nb_iovecs += iov_count[i];
+    }
+    if (unlikely(!nb_iovecs))
+        return true;
+
+    struct iovec iovecs[nb_iovecs];
+    uint8_t raw_headers[raw ? nb_urefs : 1][RAW_HEADER_SIZE];
+    for (unsigned int i = 0; i < nb_urefs; i++) {
+        if (urefs[i] == NULL)
+            continue;
+        struct iovec *iovec = &iovecs[iov_start[i]];
+        if (raw) {
+            memcpy(raw_headers[i], upipe_udpsink->raw_header,
+                   RAW_HEADER_SIZE);
+            udp_raw_set_len(raw_headers[i], sizes[i]);
+            iovec->iov_base = raw_headers[i];
+            iovec->iov_len = RAW_HEADER_SIZE;
+            iovec++;
+        }
+        if (unlikely(!ubase_check(uref_block_iovec_read(urefs[i], 0, -1,
+                                                        iovec)))) {
+            upipe_warn(upipe, "cannot read ubuf buffer");
+            uref_free(urefs[i]);
+            urefs[i] = NULL;
+            iov_count[i] = 0;
+        }
+    }
+
+    /* build one message per datagram, or per group of same-size
+     * datagrams if segmentation offload is enabled */
+    struct mmsghdr msgs[nb_urefs];
+    unsigned int msg_first[nb_urefs];
+    union {
+        char buf[CMSG_SPACE(sizeof(uint64_t))];
+        struct cmsghdr align;
+    } controls[nb_urefs];
+    unsigned int nb_msgs = 0;
+    bool segmented = false;
+    for (unsigned int i = 0; i < nb_urefs; ) {
+        if (urefs[i] == NULL) {
+            i++;
+            continue;
+        }
+        unsigned int j = i + 1;
+        if (gso) {
+            size_t total = sizes[i];
+            while (j < nb_urefs && urefs[j] != NULL && sizes[j] == sizes[i] &&
+                   j - i < UDP_GSO_MAX_SEGMENTS &&
+                   total + sizes[j] <= UDP_GSO_MAX_SIZE) {
+                total += sizes[j];
+                j++;
+            }
+        }
+
+        struct msghdr *msghdr = &msgs[nb_msgs].msg_hdr;
+        msghdr->msg_name = upipe_udpsink->addrlen ? &upipe_udpsink->addr : NULL;
+        msghdr->msg_namelen = upipe_udpsink->addrlen;
+        msghdr->msg_iov = &iovecs[iov_start[i]];
+        msghdr->msg_iovlen = iov_start[j - 1] + iov_count[j - 1] -
+                             iov_start[i];
+        msghdr->msg_control = NULL;
+        msghdr->msg_controllen = 0;
+        msghdr->msg_flags = 0;
+        if (txtimes[i]) {
+            msghdr->msg_control = controls[nb_msgs].buf;
+            msghdr->msg_controllen = sizeof(controls[nb_msgs].buf);
+            upipe_udpsink_set_txtime_cmsg(msghdr, txtimes[i]);
+        }
+#ifdef UDP_SEGMENT
+        if (j - i > 1) {
+            uint16_t segment = sizes[i];
+            msghdr->msg_control = controls[nb_msgs].buf;
+            msghdr->msg_controllen = sizeof(controls[nb_msgs].buf);
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR(msghdr);
+            cmsg->cmsg_level = IPPROTO_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            memcpy(CMSG_DATA(cmsg), &segment, sizeof(uint16_t));
+            segmented = true;
+        }
+#endif
+        msg_first[nb_msgs++] = i;
+        i = j;
+    }
+
+    unsigned int sent = 0;
+    bool blocked = false;
+    while (sent < nb_msgs) {
+        int ret = sendmmsg(upipe_udpsink->fd, msgs + sent, nb_msgs - sent, 0);
+        if (likely(ret > 0)) {
+            sent += ret;
+            continue;
+        }
+        if (unlikely(ret == 0)) {
+            blocked = true;
+            break;
+        }
+
+        switch (errno) {
+            case EINTR:
+                continue;
+            case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+            case EWOULDBLOCK:
+#endif
+                blocked = true;
+                break;
+            case EIO:
+            case EINVAL:
+            case ENOPROTOOPT:
+            case EOPNOTSUPP:
+                if (segmented) {
+                    /* retry the remaining datagrams one by one */
+                    upipe_warn(upipe, "UDP segmentation offload unavailable");
+                    upipe_udpsink->gso = false;
+                    break;
+                }
+                /* fallthrough */
+            default:
+                /* Errors at this point come from ICMP messages such as
+                 * "port unreachable", and we do not want to kill the
+                 * application with transient errors. */
+                sent++;
+                continue;
+        }
+        break;
+    }
+
+    unsigned int first_unsent = sent < nb_msgs ? msg_first[sent] : nb_urefs;
+    for (unsigned int i = 0; i < nb_urefs; i++) {
+        if (urefs[i] == NULL)
+            continue;
+        uref_block_iovec_unmap(urefs[i], 0, -1,
+                               &iovecs[iov_start[i] + (raw ? 1 : 0)]);
+        if (i < first_unsent)
+            uref_free(urefs[i]);
+    }
+    for (unsigned int i = nb_urefs; i > first_unsent; i--)
+        if (urefs[i - 1] != NULL)
+            upipe_udpsink_unshift_input(upipe, urefs[i - 1]);
+
+    if (blocked) {
+        upipe_udpsink_poll(upipe);
+        return false;
+    }
+    return true;
+}
+
+/** @internal @This outputs the held urefs that are due, by batches.
+ *
+ * @param upipe description structure of the pipe
+ * @return true if all held urefs could be output
+ */
+static bool upipe_udpsink_output_batch(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    unsigned int batch = upipe_udpsink->batch;
+    struct uref *urefs[batch];
+    uint64_t txtimes[batch];
+    uint64_t window = upipe_udpsink->txtime ? upipe_udpsink->txtime_horizon :
+                      upipe_udpsink->batch_window;
+
+    upipe_udpsink_check_upump_mgr(upipe);
+    for ( ; ; ) {
+        unsigned int nb_urefs = 0;
+        uint64_t now = UINT64_MAX;
+        uint64_t txtime_now = 0;
+        uint64_t wait = 0;
+        struct uref *uref;
+
+        while (nb_urefs < batch &&
+               (uref = upipe_udpsink_pop_input(upipe)) != NULL) {
+            const char *def;
+            if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+                uint64_t latency = 0;
+                uref_clock_get_latency(uref, &latency);
+                if (latency > upipe_udpsink->latency)
+                    upipe_udpsink->latency = latency;
+                uref_free(uref);
+                continue;
+            }
+
+            if (unlikely(upipe_udpsink->fd == -1)) {
+                uref_free(uref);
+                upipe_warn(upipe, "received a buffer before opening a socket");
+                continue;
+            }
+
+            txtimes[nb_urefs] = 0;
+            if (likely(upipe_udpsink->uclock == NULL)) {
+                urefs[nb_urefs++] = uref;
+                continue;
+            }
+
+            uint64_t systime = 0;
+            if (unlikely(!ubase_check(uref_clock_get_cr_sys(uref,
+                                                            &systime)))) {
+                upipe_warn(upipe, "received non-dated buffer");
+                urefs[nb_urefs++] = uref;
+                continue;
+            }
+
+            if (now == UINT64_MAX) {
+                now = uclock_now(upipe_udpsink->uclock);
+                if (upipe_udpsink->txtime &&
+                    !(txtime_now = upipe_udpsink_txtime_now(upipe)))
+                    window = upipe_udpsink->batch_window;
+            }
+            systime += upipe_udpsink->latency;
+            if (unlikely(now < systime && systime - now > window &&
+                         upipe_udpsink->upump_mgr != NULL)) {
+                upipe_udpsink_unshift_input(upipe, uref);
+                /* with kernel pacing, wake up when the packet enters the
+                 * horizon */
+                wait = systime - now;
+                if (upipe_udpsink->txtime)
+                    wait -= window;
+                break;
+            }
+            if (now > systime + SYSTIME_TOLERANCE) {
+                upipe_warn_va(upipe,
+                    "dropping late packet %"PRIu64" ms, latency %"PRIu64" ms",
+                    (now - systime) / (UCLOCK_FREQ / 1000),
+                    upipe_udpsink->latency / (UCLOCK_FREQ / 1000));
+                uref_free(uref);
+                continue;
+            }
+            if (now > systime + SYSTIME_PRINT)
+                upipe_warn_va(upipe,
+                    "outputting late packet %"PRIu64" ms, latency %"PRIu64" ms",
+                    (now - systime) / (UCLOCK_FREQ / 1000),
+                    upipe_udpsink->latency / (UCLOCK_FREQ / 1000));
+            if (upipe_udpsink->txtime)
+                txtimes[nb_urefs] = upipe_udpsink_txtime_from_sys(upipe,
+                        systime, now, txtime_now);
+            urefs[nb_urefs++] = uref;
+        }
+
+        if (nb_urefs &&
+            !upipe_udpsink_send_batch(upipe, urefs, txtimes, nb_urefs))
+            return false;
+
+        if (wait) {
+            upipe_verbose_va(upipe, "sleeping %"PRIu64, wait);
+            upipe_udpsink_wait_upump(upipe, wait, upipe_udpsink_watcher);
+            return false;
+        }
+        if (upipe_udpsink_check_input(upipe))
+            return true;
+    }
+}
+#endif
+
 /** @internal @This is called when the file descriptor can be written again.
  * Unblock the sink and unqueue all queued buffers.
  *
@@ -338,7 +774,13 @@ static void upipe_udpsink_watcher(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     upipe_udpsink_set_upump(upipe, NULL);
-    upipe_udpsink_output_input(upipe);
+#ifdef UPIPE_HAVE_SENDMMSG
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (upipe_udpsink->batch > 1)
+        upipe_udpsink_output_batch(upipe);
+    else
+#endif
+        upipe_udpsink_output_input(upipe);
     upipe_udpsink_unblock_input(upipe);
     if (upipe_udpsink_check_input(upipe)) {
         /* All packets have been output, release again the pipe that has been
@@ -356,6 +798,30 @@ static void upipe_udpsink_watcher(struct upump *upump)
 static void upipe_udpsink_input(struct upipe *upipe, struct uref *uref,
                                 struct upump **upump_p)
 {
+#ifdef UPIPE_HAVE_SENDMMSG
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (upipe_udpsink->batch > 1) {
+        /* Hold the buffer until the end of the current pump callback, so
+         * that consecutive buffers are sent together. */
+        bool idle = upipe_udpsink_check_input(upipe);
+        upipe_udpsink_hold_input(upipe, uref);
+        if (upipe_udpsink->nb_urefs >= upipe_udpsink->batch)
+            upipe_udpsink_block_input(upipe, upump_p);
+        if (!idle)
+            return;
+
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+        upipe_udpsink_check_upump_mgr(upipe);
+        if (likely(upipe_udpsink->upump_mgr != NULL))
+            upipe_udpsink_wait_upump(upipe, 0, upipe_udpsink_watcher);
+        else if (upipe_udpsink_output_batch(upipe))
+            upipe_release(upipe);
+        return;
+    }
+#endif
+
     if (!upipe_udpsink_check_input(upipe)) {
         upipe_udpsink_hold_input(upipe, uref);
         upipe_udpsink_block_input(upipe, upump_p);
@@ -443,6 +909,7 @@ static int _upipe_udpsink_set_uri(struct upipe *upipe, const char *uri)
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return UBASE_ERR_ALLOC;
     }
+    upipe_udpsink_check_txtime(upipe);
     if (!upipe_udpsink_check_input(upipe))
         /* Use again the pipe that we previously released. */
         upipe_use(upipe);
@@ -450,6 +917,68 @@ static int _upipe_udpsink_set_uri(struct upipe *upipe, const char *uri)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the batching parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch max number of datagrams per system call, 1 to disable
+ * @param window packets due within this delay are sent in the same batch
+ * @return an error code
+ */
+static int _upipe_udpsink_set_batch(struct upipe *upipe, unsigned int batch,
+                                    uint64_t window)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (unlikely(!batch || batch > UPIPE_UDPSINK_MAX_BATCH))
+        return UBASE_ERR_INVALID;
+#ifndef UPIPE_HAVE_SENDMMSG
+    if (batch > 1)
+        return UBASE_ERR_UNHANDLED;
+#endif
+    upipe_udpsink->batch = batch;
+    upipe_udpsink->batch_window = window;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This enables or disables UDP segmentation offload.
+ *
+ * @param upipe description structure of the pipe
+ * @param gso true to coalesce same-size datagrams
+ * @return an error code
+ */
+static int _upipe_udpsink_set_gso(struct upipe *upipe, bool gso)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+#ifndef UDP_SEGMENT
+    if (gso)
+        return UBASE_ERR_UNHANDLED;
+#endif
+    upipe_udpsink->gso = gso;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the kernel-paced transmission parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param clockid clock of the kernel scheduler, or -1 to disable
+ * @param horizon packets due within this delay are handed to the kernel
+ * @return an error code
+ */
+static int _upipe_udpsink_set_txtime(struct upipe *upipe, int clockid,
+                                     uint64_t horizon)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+#if !defined(UPIPE_HAVE_LINUX_NET_TSTAMP_H) || !defined(SO_TXTIME)
+    if (clockid != -1)
+        return UBASE_ERR_UNHANDLED;
+#endif
+    if (unlikely(horizon > TXTIME_MAX_HORIZON))
+        return UBASE_ERR_INVALID;
+    upipe_udpsink->txtime_clockid = clockid;
+    upipe_udpsink->txtime_horizon = horizon;
+    upipe_udpsink_check_txtime(upipe);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This flushes all currently held buffers, and unblocks the
  * sources.
  *
@@ -524,6 +1053,7 @@ static int _upipe_udpsink_control(struct upipe *upipe,
             UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
             upipe_udpsink_set_upump(upipe, NULL);
             upipe_udpsink->fd = va_arg(args, int );
+            upipe_udpsink_check_txtime(upipe);
             return UBASE_ERR_NONE;
         }
         case UPIPE_UDPSINK_SET_PEER: {
@@ -533,6 +1063,50 @@ static int _upipe_udpsink_control(struct upipe *upipe,
             memcpy(&upipe_udpsink->addr, s, upipe_udpsink->addrlen);
             return UBASE_ERR_NONE;
         }
+        case UPIPE_UDPSINK_GET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            unsigned int *batch_p = va_arg(args, unsigned int *);
+            uint64_t *window_p = va_arg(args, uint64_t *);
+            if (batch_p != NULL)
+                *batch_p = upipe_udpsink->batch;
+            if (window_p != NULL)
+                *window_p = upipe_udpsink->batch_window;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSINK_SET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            unsigned int batch = va_arg(args, unsigned int);
+            uint64_t window = va_arg(args, uint64_t);
+            return _upipe_udpsink_set_batch(upipe, batch, window);
+        }
+        case UPIPE_UDPSINK_GET_TXTIME: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            int *clockid_p = va_arg(args, int *);
+            uint64_t *horizon_p = va_arg(args, uint64_t *);
+            if (clockid_p != NULL)
+                *clockid_p = upipe_udpsink->txtime ?
+                             upipe_udpsink->txtime_clockid : -1;
+            if (horizon_p != NULL)
+                *horizon_p = upipe_udpsink->txtime_horizon;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSINK_SET_TXTIME: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            int clockid = va_arg(args, int);
+            uint64_t horizon = va_arg(args, uint64_t);
+            return _upipe_udpsink_set_txtime(upipe, clockid, horizon);
+        }
+        case UPIPE_UDPSINK_GET_GSO: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            int *gso_p = va_arg(args, int *);
+            *gso_p = upipe_udpsink->gso;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSINK_SET_GSO: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            int gso = va_arg(args, int);
+            return _upipe_udpsink_set_gso(upipe, !!gso);
+        }
         case UPIPE_FLUSH:
             return upipe_udpsink_flush(upipe);
         default:
@@ -28,6 +28,8 @@
  * @short Upipe source module for udp sockets
  */
 
+#define _GNU_SOURCE
+
 #include <upipe/ubase.h>
 #include <upipe/uprobe.h>
 #include <upipe/uclock.h>
@@ -63,6 +65,7 @@
 #include <sys/ioctl.h>
 #include <errno.h>
 #include <assert.h>
+#include <time.h>
 #include <sys/socket.h>
 
 /** default size of buffers when unspecified */
@@ -71,6 +74,23 @@
 #define UDP_DEFAULT_TTL 0
 #define UDP_DEFAULT_PORT 1234
 
+/** maximum number of datagrams read in a single batch */
+#define UPIPE_UDPSRC_MAX_BATCH  1024
+/** number of nanoseconds per second */
+#define NSEC_PER_SEC UINT64_C(1000000000)
+/** kernel timestamps older than this are considered bogus */
+#define MAX_TIMESTAMP_AGE NSEC_PER_SEC
+
+/** @internal @This is the buffer used to receive control messages. */
+union upipe_udpsrc_control {
+#ifdef SO_TIMESTAMPNS
+    char buf[CMSG_SPACE(sizeof(struct timespec))];
+#else
+    char buf[1];
+#endif
+    struct cmsghdr align;
+};
+
 /** @hidden */
 static int upipe_udpsrc_check(struct upipe *upipe, struct uref *flow_format);
 
@@ -122,6 +142,26 @@ struct upipe_udpsrc {
     /** source address (size) */
     socklen_t addrlen;
 
+    /** true if kernel receive timestamps are requested */
+    bool timestamps;
+    /** true if kernel receive timestamps are enabled on the socket */
+    bool kernel_timestamps;
+
+    /** maximum number of datagrams read per wake-up */
+    unsigned int batch;
+#ifdef UPIPE_HAVE_RECVMMSG
+    /** preallocated urefs for batched reads */
+    struct uref **batch_urefs;
+    /** message headers for batched reads */
+    struct mmsghdr *batch_msgs;
+    /** buffers for batched reads */
+    struct iovec *batch_iovecs;
+    /** source addresses for batched reads */
+    struct sockaddr_storage *batch_addrs;
+    /** control messages for batched reads */
+    union upipe_udpsrc_control *batch_controls;
+#endif
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -172,10 +212,315 @@ static struct upipe *upipe_udpsrc_alloc(struct upipe_mgr *mgr,
     upipe_udpsrc->fd = -1;
     upipe_udpsrc->uri = NULL;
     upipe_udpsrc->addrlen = 0;
+    upipe_udpsrc->timestamps = false;
+    upipe_udpsrc->kernel_timestamps = false;
+    upipe_udpsrc->batch = 1;
+#ifdef UPIPE_HAVE_RECVMMSG
+    upipe_udpsrc->batch_urefs = NULL;
+    upipe_udpsrc->batch_msgs = NULL;
+    upipe_udpsrc->batch_iovecs = NULL;
+    upipe_udpsrc->batch_addrs = NULL;
+    upipe_udpsrc->batch_controls = NULL;
+#endif
     upipe_throw_ready(upipe);
     return upipe;
 }
 
+/** @internal @This enables kernel receive timestamps on the socket if
+ * they were requested, or disables them if they were enabled before.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_check_timestamps(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    bool enabled = upipe_udpsrc->kernel_timestamps;
+    upipe_udpsrc->kernel_timestamps = false;
+    if (upipe_udpsrc->fd == -1 || (!upipe_udpsrc->timestamps && !enabled))
+        return;
+
+#ifdef SO_TIMESTAMPNS
+    int on = upipe_udpsrc->timestamps ? 1 : 0;
+    if (likely(setsockopt(upipe_udpsrc->fd, SOL_SOCKET, SO_TIMESTAMPNS,
+                          &on, sizeof(on)) == 0)) {
+        upipe_udpsrc->kernel_timestamps = upipe_udpsrc->timestamps;
+        return;
+    }
+    upipe_warn_va(upipe, "unable to %s SO_TIMESTAMPNS (%m)",
+                  on ? "set" : "clear");
+#else
+    upipe_warn(upipe, "kernel timestamps are not supported");
+#endif
+}
+
+/** @internal @This returns the current real time, to convert kernel
+ * timestamps.
+ *
+ * @param upipe description structure of the pipe
+ * @return current real time in nanoseconds, or 0 if unavailable
+ */
+static uint64_t upipe_udpsrc_real_now(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    struct timespec ts;
+    if (!upipe_udpsrc->kernel_timestamps ||
+        clock_gettime(CLOCK_REALTIME, &ts) == -1)
+        return 0;
+    return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/** @internal @This returns the system date of arrival of a datagram, using
+ * the kernel receive timestamp if there is one.
+ *
+ * @param msghdr received message
+ * @param now current system time
+ * @param real_now current real time in nanoseconds, or 0
+ * @return system date of arrival
+ */
+static uint64_t upipe_udpsrc_arrival(struct msghdr *msghdr, uint64_t now,
+                                     uint64_t real_now)
+{
+#ifdef SO_TIMESTAMPNS
+    if (!real_now)
+        return now;
+
+    struct cmsghdr *cmsg;
+    for (cmsg = CMSG_FIRSTHDR(msghdr); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(msghdr, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET ||
+            cmsg->cmsg_type != SCM_TIMESTAMPNS)
+            continue;
+
+        struct timespec ts;
+        memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+        uint64_t arrival = ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+        if (unlikely(arrival > real_now ||
+                     real_now - arrival > MAX_TIMESTAMP_AGE))
+            break;
+        uint64_t age = (real_now - arrival) * UCLOCK_FREQ / NSEC_PER_SEC;
+        return likely(age < now) ? now - age : now;
+    }
+#endif
+    return now;
+}
+
+/** @internal @This checks the source address of a received datagram, and
+ * throws an event if it changed.
+ *
+ * @param upipe description structure of the pipe
+ * @param addr source address of the datagram
+ * @param addrlen size of the source address
+ */
+static void upipe_udpsrc_check_peer(struct upipe *upipe,
+                                    const struct sockaddr_storage *addr,
+                                    socklen_t addrlen)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (likely(addrlen == upipe_udpsrc->addrlen &&
+               !memcmp(addr, &upipe_udpsrc->addr, addrlen)))
+        return;
+
+    upipe_throw(upipe, UPROBE_UDPSRC_NEW_PEER, UPIPE_UDPSRC_SIGNATURE,
+                addr, &addrlen);
+    upipe_udpsrc->addrlen = addrlen;
+    memcpy(&upipe_udpsrc->addr, addr, addrlen);
+}
+
+/** @internal @This handles a read error on the socket.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_read_error(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    switch (errno) {
+        case EINTR:
+        case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+        case EWOULDBLOCK:
+#endif
+            /* not an issue, try again later */
+            return;
+        case EBADF:
+        case EINVAL:
+        case EIO:
+        default:
+            break;
+    }
+    upipe_err_va(upipe, "read error from %s (%m)", upipe_udpsrc->uri);
+    upipe_udpsrc_set_upump(upipe, NULL);
+    upipe_throw_source_end(upipe);
+}
+
+#ifdef UPIPE_HAVE_RECVMMSG
+/** @internal @This frees the vector used for batched reads.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_clean_batch(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (upipe_udpsrc->batch_urefs != NULL)
+        for (unsigned int i = 0; i < upipe_udpsrc->batch; i++)
+            if (upipe_udpsrc->batch_urefs[i] != NULL)
+                uref_free(upipe_udpsrc->batch_urefs[i]);
+    free(upipe_udpsrc->batch_urefs);
+    free(upipe_udpsrc->batch_msgs);
+    free(upipe_udpsrc->batch_iovecs);
+    free(upipe_udpsrc->batch_addrs);
+    free(upipe_udpsrc->batch_controls);
+    upipe_udpsrc->batch_urefs = NULL;
+    upipe_udpsrc->batch_msgs = NULL;
+    upipe_udpsrc->batch_iovecs = NULL;
+    upipe_udpsrc->batch_addrs = NULL;
+    upipe_udpsrc->batch_controls = NULL;
+}
+
+/** @internal @This allocates the vector used for batched reads.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_udpsrc_init_batch(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    unsigned int batch = upipe_udpsrc->batch;
+    upipe_udpsrc->batch_urefs = calloc(batch, sizeof(struct uref *));
+    upipe_udpsrc->batch_msgs = calloc(batch, sizeof(struct mmsghdr));
+    upipe_udpsrc->batch_iovecs = calloc(batch, sizeof(struct iovec));
+    upipe_udpsrc->batch_addrs = calloc(batch, sizeof(struct sockaddr_storage));
+    upipe_udpsrc->batch_controls =
+        calloc(batch, sizeof(union upipe_udpsrc_control));
+    if (unlikely(upipe_udpsrc->batch_urefs == NULL ||
+                 upipe_udpsrc->batch_msgs == NULL ||
+                 upipe_udpsrc->batch_iovecs == NULL ||
+                 upipe_udpsrc->batch_addrs == NULL ||
+                 upipe_udpsrc->batch_controls == NULL)) {
+        upipe_udpsrc_clean_batch(upipe);
+        return UBASE_ERR_ALLOC;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This reads as many datagrams as possible from the socket, up
+ * to the configured batch depth, with a single system call, and outputs
+ * them.
+ *
+ * @param upump description structure of the read watcher
+ */
+static void upipe_udpsrc_worker_batch(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    unsigned int batch = upipe_udpsrc->batch;
+    uint64_t systime = 0; /* to keep gcc quiet */
+
+    if (unlikely(upipe_udpsrc->batch_urefs == NULL &&
+                 !ubase_check(upipe_udpsrc_init_batch(upipe)))) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    /* (re)fill the vector with writable buffers */
+    for (unsigned int i = 0; i < batch; i++) {
+        struct uref *uref = upipe_udpsrc->batch_urefs[i];
+        if (uref == NULL) {
+            uref = uref_block_alloc(upipe_udpsrc->uref_mgr,
+                                    upipe_udpsrc->ubuf_mgr,
+                                    upipe_udpsrc->output_size);
+            if (unlikely(uref == NULL)) {
+                for (unsigned int j = 0; j < i; j++)
+                    uref_block_unmap(upipe_udpsrc->batch_urefs[j], 0);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return;
+            }
+            upipe_udpsrc->batch_urefs[i] = uref;
+        }
+
+        uint8_t *buffer;
+        int output_size = -1;
+        if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
+                                                   &buffer)))) {
+            for (unsigned int j = 0; j < i; j++)
+                uref_block_unmap(upipe_udpsrc->batch_urefs[j], 0);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+
+        struct iovec *iovec = &upipe_udpsrc->batch_iovecs[i];
+        iovec->iov_base = buffer;
+        iovec->iov_len = output_size;
+
+        struct msghdr *msghdr = &upipe_udpsrc->batch_msgs[i].msg_hdr;
+        msghdr->msg_name = &upipe_udpsrc->batch_addrs[i];
+        msghdr->msg_namelen = sizeof(struct sockaddr_storage);
+        msghdr->msg_iov = iovec;
+        msghdr->msg_iovlen = 1;
+        msghdr->msg_control = upipe_udpsrc->batch_controls[i].buf;
+        msghdr->msg_controllen = sizeof(union upipe_udpsrc_control);
+        msghdr->msg_flags = 0;
+        upipe_udpsrc->batch_msgs[i].msg_len = 0;
+    }
+
+    int ret = recvmmsg(upipe_udpsrc->fd, upipe_udpsrc->batch_msgs, batch,
+                       MSG_DONTWAIT, NULL);
+    uint64_t real_now = 0;
+    if (unlikely(upipe_udpsrc->uclock != NULL)) {
+        systime = uclock_now(upipe_udpsrc->uclock);
+        real_now = upipe_udpsrc_real_now(upipe);
+    }
+    for (unsigned int i = 0; i < batch; i++)
+        uref_block_unmap(upipe_udpsrc->batch_urefs[i], 0);
+
+    if (unlikely(ret == -1)) {
+        upipe_udpsrc_read_error(upipe);
+        return;
+    }
+
+    /* detach the received buffers from the vector, as outputting them may
+     * change the configuration of the pipe */
+    struct uref *urefs[batch];
+    unsigned int nb_urefs = 0;
+    bool end = false;
+    for (unsigned int i = 0; i < ret; i++) {
+        struct uref *uref = upipe_udpsrc->batch_urefs[i];
+        struct mmsghdr *msg = &upipe_udpsrc->batch_msgs[i];
+        upipe_udpsrc->batch_urefs[i] = NULL;
+
+        upipe_udpsrc_check_peer(upipe, &upipe_udpsrc->batch_addrs[i],
+                                msg->msg_hdr.msg_namelen);
+        if (unlikely(msg->msg_len == 0)) {
+            uref_free(uref);
+            if (likely(upipe_udpsrc->uclock == NULL))
+                end = true;
+            continue;
+        }
+        if (unlikely(upipe_udpsrc->uclock != NULL))
+            uref_clock_set_cr_sys(uref,
+                upipe_udpsrc_arrival(&msg->msg_hdr, systime, real_now));
+        if (unlikely(msg->msg_len != upipe_udpsrc->output_size))
+            uref_block_resize(uref, 0, msg->msg_len);
+        urefs[nb_urefs++] = uref;
+    }
+
+    upipe_use(upipe);
+    for (unsigned int i = 0; i < nb_urefs; i++) {
+        if (unlikely(upipe_udpsrc->upump == NULL)) {
+            /* the source was closed by a downstream pipe */
+            uref_free(urefs[i]);
+            continue;
+        }
+        upipe_udpsrc_output(upipe, urefs[i], &upipe_udpsrc->upump);
+    }
+    if (unlikely(end && upipe_udpsrc->upump != NULL)) {
+        upipe_notice_va(upipe, "end of udp socket %s", upipe_udpsrc->uri);
+        upipe_udpsrc_set_upump(upipe, NULL);
+        upipe_throw_source_end(upipe);
+    }
+    upipe_release(upipe);
+}
+#endif
+
 /** @internal @This reads data from the source and outputs it.
  * It is called either when the idler triggers (permanent storage mode) or
  * when data is available on the udp socket descriptor (live stream mode).
@@ -209,39 +554,30 @@ static void upipe_udpsrc_worker(struct upump *upump)
     assert(output_size == upipe_udpsrc->output_size);
 
     struct sockaddr_storage addr;
-    socklen_t addrlen = sizeof(addr);
-
-    ssize_t ret = recvfrom(upipe_udpsrc->fd, buffer, upipe_udpsrc->output_size,
-                        0, (struct sockaddr*)&addr, &addrlen);
+    struct iovec iovec = {
+        .iov_base = buffer,
+        .iov_len = upipe_udpsrc->output_size,
+    };
+    union upipe_udpsrc_control control;
+    struct msghdr msghdr = {
+        .msg_name = &addr,
+        .msg_namelen = sizeof(addr),
+        .msg_iov = &iovec,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control),
+        .msg_flags = 0,
+    };
+
+    ssize_t ret = recvmsg(upipe_udpsrc->fd, &msghdr, 0);
     uref_block_unmap(uref, 0);
 
     if (unlikely(ret == -1)) {
         uref_free(uref);
-        switch (errno) {
-            case EINTR:
-            case EAGAIN:
-#if EAGAIN != EWOULDBLOCK
-            case EWOULDBLOCK:
-#endif
-                /* not an issue, try again later */
-                return;
-            case EBADF:
-            case EINVAL:
-            case EIO:
-            default:
-                break;
-        }
-        upipe_err_va(upipe, "read error from %s (%m)", upipe_udpsrc->uri);
-        upipe_udpsrc_set_upump(upipe, NULL);
-        upipe_throw_source_end(upipe);
+        upipe_udpsrc_read_error(upipe);
         return;
-    } else if (addrlen != upipe_udpsrc->addrlen ||
-        memcmp(&addr, &upipe_udpsrc->addr, addrlen)) {
-        upipe_throw(upipe, UPROBE_UDPSRC_NEW_PEER, UPIPE_UDPSRC_SIGNATURE,
-                &addr, &addrlen);
-        upipe_udpsrc->addrlen = addrlen;
-        memcpy(&upipe_udpsrc->addr, &addr, addrlen);
     }
+    upipe_udpsrc_check_peer(upipe, &addr, msghdr.msg_namelen);
 
     if (unlikely(ret == 0)) {
         uref_free(uref);
@@ -253,7 +589,8 @@ static void upipe_udpsrc_worker(struct upump *upump)
         return;
     }
     if (unlikely(upipe_udpsrc->uclock != NULL))
-        uref_clock_set_cr_sys(uref, systime);
+        uref_clock_set_cr_sys(uref, upipe_udpsrc_arrival(&msghdr, systime,
+                                          upipe_udpsrc_real_now(upipe)));
     if (unlikely(ret != upipe_udpsrc->output_size))
         uref_block_resize(uref, 0, ret);
     upipe_udpsrc_output(upipe, uref, &upipe_udpsrc->upump);
@@ -299,9 +636,13 @@ static int upipe_udpsrc_check(struct upipe *upipe, struct uref *flow_format)
 
     if (upipe_udpsrc->fd != -1 && upipe_udpsrc->upump == NULL) {
         struct upump *upump;
-        upump = upump_alloc_fd_read(upipe_udpsrc->upump_mgr,
-                                    upipe_udpsrc_worker, upipe, upipe->refcount,
-                                    upipe_udpsrc->fd);
+        upump_cb cb = upipe_udpsrc_worker;
+#ifdef UPIPE_HAVE_RECVMMSG
+        if (upipe_udpsrc->batch > 1)
+            cb = upipe_udpsrc_worker_batch;
+#endif
+        upump = upump_alloc_fd_read(upipe_udpsrc->upump_mgr, cb,
+                                    upipe, upipe->refcount, upipe_udpsrc->fd);
         if (unlikely(upump == NULL)) {
             upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
             return UBASE_ERR_UPUMP;
@@ -362,10 +703,34 @@ static int upipe_udpsrc_set_uri(struct upipe *upipe, const char *uri)
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return UBASE_ERR_ALLOC;
     }
+    upipe_udpsrc_check_timestamps(upipe);
     upipe_notice_va(upipe, "opening udp socket %s", upipe_udpsrc->uri);
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the maximum number of datagrams read per wake-up.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of datagrams, 1 to disable batching
+ * @return an error code
+ */
+static int _upipe_udpsrc_set_batch(struct upipe *upipe,
+                                   unsigned int batch)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (unlikely(!batch || batch > UPIPE_UDPSRC_MAX_BATCH))
+        return UBASE_ERR_INVALID;
+#ifdef UPIPE_HAVE_RECVMMSG
+    upipe_udpsrc_clean_batch(upipe);
+#else
+    if (batch > 1)
+        return UBASE_ERR_UNHANDLED;
+#endif
+    upipe_udpsrc_set_upump(upipe, NULL);
+    upipe_udpsrc->batch = batch;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a udp socket source pipe.
  *
  * @param upipe description structure of the pipe
@@ -393,7 +758,12 @@ static int _upipe_udpsrc_control(struct upipe *upipe,
             return upipe_udpsrc_control_output(upipe, command, args);
 
         case UPIPE_GET_OUTPUT_SIZE:
+            return upipe_udpsrc_control_output_size(upipe, command, args);
         case UPIPE_SET_OUTPUT_SIZE:
+#ifdef UPIPE_HAVE_RECVMMSG
+            /* preallocated buffers no longer have the right size */
+            upipe_udpsrc_clean_batch(upipe);
+#endif
             return upipe_udpsrc_control_output_size(upipe, command, args);
 
         case UPIPE_GET_URI: {
@@ -414,8 +784,32 @@ static int _upipe_udpsrc_control(struct upipe *upipe,
             UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
             upipe_udpsrc_set_upump(upipe, NULL);
             upipe_udpsrc->fd = va_arg(args, int );
+            upipe_udpsrc_check_timestamps(upipe);
             return UBASE_ERR_NONE;
         }
+        case UPIPE_UDPSRC_GET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            unsigned int *batch_p = va_arg(args, unsigned int *);
+            *batch_p = upipe_udpsrc->batch;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSRC_GET_TIMESTAMPS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            int *timestamps_p = va_arg(args, int *);
+            *timestamps_p = upipe_udpsrc->kernel_timestamps;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSRC_SET_TIMESTAMPS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            upipe_udpsrc->timestamps = !!va_arg(args, int);
+            upipe_udpsrc_check_timestamps(upipe);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSRC_SET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            unsigned int batch = va_arg(args, unsigned int);
+            return _upipe_udpsrc_set_batch(upipe, batch);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -453,6 +847,9 @@ static void upipe_udpsrc_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     free(upipe_udpsrc->uri);
+#ifdef UPIPE_HAVE_RECVMMSG
+    upipe_udpsrc_clean_batch(upipe);
+#endif
     upipe_udpsrc_clean_output_size(upipe);
     upipe_udpsrc_clean_uclock(upipe);
     upipe_udpsrc_clean_upump(upipe);
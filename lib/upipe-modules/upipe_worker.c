@@ -66,6 +66,13 @@ struct upipe_work_mgr {
     /** pointer to xfer manager */
     struct upipe_mgr *xfer_mgr;
 
+    /** maximum number of urefs output by queue sources per wake-up */
+    unsigned int batch;
+    /** number of queued urefs waking up the queue sources */
+    unsigned int coalesce_threshold;
+    /** maximum time a uref may stay pending in the queues */
+    uint64_t coalesce_timeout;
+
     /** public upipe_mgr structure */
     struct upipe_mgr mgr;
 };
@@ -156,6 +163,26 @@ static int upipe_work_out_qsrc_probe(struct uprobe *uprobe, struct upipe *inner,
     return uprobe_throw_next(uprobe, inner, event, args);
 }
 
+/** @internal @This applies the wake-up parameters of the manager to a pair
+ * of queue pipes.
+ *
+ * @param upipe description structure of the pipe
+ * @param qsrc queue source pipe
+ * @param qsink queue sink pipe
+ */
+static void upipe_work_setup_queue(struct upipe *upipe,
+                                   struct upipe *qsrc, struct upipe *qsink)
+{
+    struct upipe_work_mgr *work_mgr = upipe_work_mgr_from_upipe_mgr(upipe->mgr);
+    if (work_mgr->batch > 1 &&
+        !ubase_check(upipe_qsrc_set_batch(qsrc, work_mgr->batch)))
+        upipe_warn(upipe, "unable to set queue batch size");
+    if (work_mgr->coalesce_threshold > 1 &&
+        !ubase_check(upipe_qsink_set_coalesce(qsink,
+                work_mgr->coalesce_threshold, work_mgr->coalesce_timeout)))
+        upipe_warn(upipe, "unable to set queue wake-up coalescing");
+}
+
 /** @internal @This allocates a worker pipe.
  *
  * @param mgr common management structure
@@ -257,7 +284,7 @@ static struct upipe *_upipe_work_alloc(struct upipe_mgr *mgr,
         struct upipe *out_qsrc = upipe_qsrc_alloc(work_mgr->qsrc_mgr,
                 uprobe_pfx_alloc(uprobe_use(&upipe_work->out_qsrc_probe),
                                  UPROBE_LOG_VERBOSE, "out_qsrc"),
-                out_queue_length > UINT8_MAX ? UINT8_MAX : out_queue_length);
+                out_queue_length);
         if (unlikely(out_qsrc == NULL))
             goto error;
 
@@ -269,9 +296,8 @@ static struct upipe *_upipe_work_alloc(struct upipe_mgr *mgr,
             upipe_release(out_qsrc);
             goto error;
         }
-        if (out_queue_length > UINT8_MAX)
-            upipe_set_max_length(out_qsink, out_queue_length - UINT8_MAX);
 
+        upipe_work_setup_queue(upipe, out_qsrc, out_qsink);
         upipe_attach_upump_mgr(out_qsrc);
         ulist_add(&upipe_work->upump_mgr_pipes, upipe_to_uchain(out_qsrc));
         upipe_work_store_bin_output(upipe, upipe_use(out_qsrc));
@@ -315,7 +341,7 @@ static struct upipe *_upipe_work_alloc(struct upipe_mgr *mgr,
                 uprobe_pfx_alloc(
                     uprobe_use(&upipe_work->in_qsrc_probe),
                     UPROBE_LOG_VERBOSE, "in_qsrc"),
-                in_queue_length > UINT8_MAX ? UINT8_MAX : in_queue_length);
+                in_queue_length);
         if (unlikely(in_qsrc == NULL))
             goto error;
 
@@ -327,10 +353,8 @@ static struct upipe *_upipe_work_alloc(struct upipe_mgr *mgr,
             upipe_release(in_qsrc);
             goto error;
         }
+        upipe_work_setup_queue(upipe, in_qsrc, in_qsink);
         upipe_work_store_bin_input(upipe, in_qsink);
-        if (in_queue_length > UINT8_MAX)
-            upipe_set_max_length(upipe_work->in_qsink,
-                                      in_queue_length - UINT8_MAX);
 
         struct upipe *in_qsrc_xfer = upipe_xfer_alloc(work_mgr->xfer_mgr,
                 uprobe_pfx_alloc(uprobe_use(&upipe_work->proxy_probe),
@@ -565,6 +589,41 @@ static int upipe_work_mgr_control(struct upipe_mgr *mgr,
         GET_SET_MGR(xfer, XFER)
 #undef GET_SET_MGR
 
+        case UPIPE_WORK_MGR_GET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_WORK_SIGNATURE)
+            unsigned int *batch_p = va_arg(args, unsigned int *);
+            *batch_p = work_mgr->batch;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_WORK_MGR_SET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_WORK_SIGNATURE)
+            unsigned int batch = va_arg(args, unsigned int);
+            if (unlikely(!batch))
+                return UBASE_ERR_INVALID;
+            work_mgr->batch = batch;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_WORK_MGR_GET_COALESCE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_WORK_SIGNATURE)
+            unsigned int *threshold_p = va_arg(args, unsigned int *);
+            uint64_t *timeout_p = va_arg(args, uint64_t *);
+            if (threshold_p != NULL)
+                *threshold_p = work_mgr->coalesce_threshold;
+            if (timeout_p != NULL)
+                *timeout_p = work_mgr->coalesce_timeout;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_WORK_MGR_SET_COALESCE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_WORK_SIGNATURE)
+            unsigned int threshold = va_arg(args, unsigned int);
+            uint64_t timeout = va_arg(args, uint64_t);
+            if (unlikely(!threshold || (threshold > 1 && !timeout)))
+                return UBASE_ERR_INVALID;
+            work_mgr->coalesce_threshold = threshold;
+            work_mgr->coalesce_timeout = timeout;
+            return UBASE_ERR_NONE;
+        }
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -587,6 +646,9 @@ struct upipe_mgr *upipe_work_mgr_alloc(struct upipe_mgr *xfer_mgr)
     work_mgr->qsrc_mgr = upipe_qsrc_mgr_alloc();
     work_mgr->qsink_mgr = upipe_qsink_mgr_alloc();
     work_mgr->xfer_mgr = upipe_mgr_use(xfer_mgr);
+    work_mgr->batch = 1;
+    work_mgr->coalesce_threshold = 1;
+    work_mgr->coalesce_timeout = 0;
 
     urefcount_init(upipe_work_mgr_to_urefcount(work_mgr),
                    upipe_work_mgr_free);
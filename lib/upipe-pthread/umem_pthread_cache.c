@@ -0,0 +1,570 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe umem manager caching buffers in thread-local magazines
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/ulifo.h>
+#include <upipe/umem.h>
+#include <upipe-pthread/umem_pthread_cache.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+/** @This is a magazine of buffers of the same size class. */
+struct umem_pthread_cache_magazine {
+    /** number of buffers in the magazine */
+    unsigned int count;
+    /** buffers, allocated by the underlying manager */
+    struct umem umems[];
+};
+
+/** @This is the thread-local state of a size class. */
+struct umem_pthread_cache_class {
+    /** magazine currently in use */
+    struct umem_pthread_cache_magazine *loaded;
+    /** magazine previously in use */
+    struct umem_pthread_cache_magazine *previous;
+};
+
+/** @This is the thread-local structure of the manager. */
+struct umem_pthread_cache_local {
+    /** pointer to the manager */
+    struct umem_pthread_cache_mgr *cache_mgr;
+    /** statistics not yet accounted for in the manager */
+    struct umem_pthread_cache_stats stats;
+    /** size classes */
+    struct umem_pthread_cache_class classes[];
+};
+
+/** @This defines the private data structures of the umem pthread cache
+ * manager. */
+struct umem_pthread_cache_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** common management structure */
+    struct umem_mgr mgr;
+
+    /** underlying manager */
+    struct umem_mgr *umem_mgr;
+    /** size (in octets) of buffers of the first size class */
+    size_t class0_size;
+    /** base 2 logarithm of class0_size */
+    unsigned int class0_shift;
+    /** number of size classes */
+    unsigned int nb_classes;
+    /** number of buffers per magazine */
+    unsigned int magazine_size;
+
+    /** thread-local storage key */
+    pthread_key_t key;
+    /** lock protecting the statistics */
+    pthread_mutex_t stats_lock;
+    /** statistics accounted for */
+    struct umem_pthread_cache_stats stats;
+
+    /** depots of full magazines, then of empty magazines, per size class */
+    struct ulifo depots[];
+};
+
+UBASE_FROM_TO(umem_pthread_cache_mgr, umem_mgr, umem_mgr, mgr)
+UBASE_FROM_TO(umem_pthread_cache_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This returns the depot of full magazines of a size class.
+ *
+ * @param cache_mgr pointer to the manager
+ * @param c size class
+ * @return pointer to the depot
+ */
+static inline struct ulifo *
+    umem_pthread_cache_full(struct umem_pthread_cache_mgr *cache_mgr,
+                            unsigned int c)
+{
+    return &cache_mgr->depots[c];
+}
+
+/** @internal @This returns the depot of empty magazines of a size class.
+ *
+ * @param cache_mgr pointer to the manager
+ * @param c size class
+ * @return pointer to the depot
+ */
+static inline struct ulifo *
+    umem_pthread_cache_empty(struct umem_pthread_cache_mgr *cache_mgr,
+                             unsigned int c)
+{
+    return &cache_mgr->depots[cache_mgr->nb_classes + c];
+}
+
+/** @internal @This returns the thread-local structure, or allocates it if
+ * needed.
+ *
+ * @param cache_mgr pointer to the manager
+ * @return thread-local structure, or NULL in case of error
+ */
+static struct umem_pthread_cache_local *
+    umem_pthread_cache_tls(struct umem_pthread_cache_mgr *cache_mgr)
+{
+    struct umem_pthread_cache_local *local =
+        pthread_getspecific(cache_mgr->key);
+    if (likely(local != NULL))
+        return local;
+
+    size_t size = sizeof(struct umem_pthread_cache_local) +
+        cache_mgr->nb_classes * sizeof(struct umem_pthread_cache_class);
+    local = malloc(size);
+    if (unlikely(local == NULL))
+        return NULL;
+    memset(local, 0, size);
+    local->cache_mgr = cache_mgr;
+    if (unlikely(pthread_setspecific(cache_mgr->key, local) != 0)) {
+        free(local);
+        return NULL;
+    }
+    return local;
+}
+
+/** @internal @This accounts for the statistics of a thread.
+ *
+ * @param local thread-local structure
+ */
+static void umem_pthread_cache_account(struct umem_pthread_cache_local *local)
+{
+    struct umem_pthread_cache_mgr *cache_mgr = local->cache_mgr;
+    pthread_mutex_lock(&cache_mgr->stats_lock);
+    cache_mgr->stats.alloc_hits += local->stats.alloc_hits;
+    cache_mgr->stats.alloc_depot += local->stats.alloc_depot;
+    cache_mgr->stats.alloc_misses += local->stats.alloc_misses;
+    cache_mgr->stats.free_hits += local->stats.free_hits;
+    cache_mgr->stats.free_depot += local->stats.free_depot;
+    cache_mgr->stats.free_misses += local->stats.free_misses;
+    pthread_mutex_unlock(&cache_mgr->stats_lock);
+    memset(&local->stats, 0, sizeof(local->stats));
+}
+
+/** @internal @This returns an empty magazine, from the depot if possible.
+ *
+ * @param cache_mgr pointer to the manager
+ * @param c size class
+ * @return pointer to an empty magazine, or NULL in case of error
+ */
+static struct umem_pthread_cache_magazine *
+    umem_pthread_cache_magazine_alloc(struct umem_pthread_cache_mgr *cache_mgr,
+                                      unsigned int c)
+{
+    struct umem_pthread_cache_magazine *magazine =
+        ulifo_pop(umem_pthread_cache_empty(cache_mgr, c),
+                  struct umem_pthread_cache_magazine *);
+    if (likely(magazine != NULL))
+        return magazine;
+
+    magazine = malloc(sizeof(struct umem_pthread_cache_magazine) +
+                      cache_mgr->magazine_size * sizeof(struct umem));
+    if (likely(magazine != NULL))
+        magazine->count = 0;
+    return magazine;
+}
+
+/** @internal @This releases a magazine, returning its buffers to the depot
+ * or to the underlying manager.
+ *
+ * @param cache_mgr pointer to the manager
+ * @param c size class
+ * @param magazine magazine to release, or NULL
+ * @return number of buffers released to the underlying manager
+ */
+static unsigned int
+    umem_pthread_cache_magazine_release(struct umem_pthread_cache_mgr *cache_mgr,
+                                        unsigned int c,
+                                        struct umem_pthread_cache_magazine *magazine)
+{
+    if (magazine == NULL)
+        return 0;
+
+    unsigned int released = 0;
+    if (magazine->count) {
+        if (likely(ulifo_push(umem_pthread_cache_full(cache_mgr, c),
+                              magazine)))
+            return 0;
+
+        /* the depot is full */
+        released = magazine->count;
+        while (magazine->count)
+            umem_free(&magazine->umems[--magazine->count]);
+    }
+
+    if (!ulifo_push(umem_pthread_cache_empty(cache_mgr, c), magazine))
+        free(magazine);
+    return released;
+}
+
+/** @internal @This returns the size class in which a buffer of the given
+ * size may be allocated.
+ *
+ * @param cache_mgr pointer to the manager
+ * @param size requested size
+ * @return size class, or nb_classes if the size is too large
+ */
+static inline unsigned int
+    umem_pthread_cache_class_alloc(struct umem_pthread_cache_mgr *cache_mgr,
+                                   size_t size)
+{
+    if (likely(size <= cache_mgr->class0_size))
+        return 0;
+    unsigned int c = ubase_log2_ceil(size) - cache_mgr->class0_shift;
+    return c < cache_mgr->nb_classes ? c : cache_mgr->nb_classes;
+}
+
+/** @internal @This returns the size class in which a buffer of the given
+ * real size may be cached.
+ *
+ * @param cache_mgr pointer to the manager
+ * @param real_size real size of the buffer
+ * @return size class
+ */
+static inline unsigned int
+    umem_pthread_cache_class_free(struct umem_pthread_cache_mgr *cache_mgr,
+                                  size_t real_size)
+{
+    assert(real_size >= cache_mgr->class0_size);
+    unsigned int c = ubase_log2(real_size) - cache_mgr->class0_shift;
+    return c < cache_mgr->nb_classes ? c : cache_mgr->nb_classes - 1;
+}
+
+/** @This allocates a new umem buffer space.
+ *
+ * @param mgr management structure
+ * @param umem caller-allocated structure, filled in with the required pointer
+ * and size (previous content is discarded)
+ * @param size requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_pthread_cache_alloc(struct umem_mgr *mgr, struct umem *umem,
+                                     size_t size)
+{
+    struct umem_pthread_cache_mgr *cache_mgr =
+        umem_pthread_cache_mgr_from_umem_mgr(mgr);
+    unsigned int c = umem_pthread_cache_class_alloc(cache_mgr, size);
+    struct umem_pthread_cache_local *local;
+    if (unlikely(c >= cache_mgr->nb_classes ||
+                 (local = umem_pthread_cache_tls(cache_mgr)) == NULL))
+        /* the buffer will be released directly to the underlying manager */
+        return umem_alloc(cache_mgr->umem_mgr, umem, size);
+
+    struct umem_pthread_cache_class *size_class = &local->classes[c];
+    struct umem_pthread_cache_magazine *magazine = size_class->loaded;
+    if (unlikely(magazine == NULL || !magazine->count)) {
+        if (size_class->previous != NULL && size_class->previous->count) {
+            size_class->loaded = size_class->previous;
+            size_class->previous = magazine;
+            magazine = size_class->loaded;
+            local->stats.alloc_hits++;
+        } else if ((magazine =
+                        ulifo_pop(umem_pthread_cache_full(cache_mgr, c),
+                                  struct umem_pthread_cache_magazine *))
+                   != NULL) {
+            local->stats.free_misses +=
+                umem_pthread_cache_magazine_release(cache_mgr, c,
+                                                    size_class->previous);
+            size_class->previous = size_class->loaded;
+            size_class->loaded = magazine;
+            local->stats.alloc_depot++;
+            umem_pthread_cache_account(local);
+        } else {
+            if (unlikely(!umem_alloc(cache_mgr->umem_mgr, umem,
+                                     cache_mgr->class0_size << c)))
+                return false;
+            local->stats.alloc_misses++;
+            umem->size = size;
+            umem->mgr = mgr;
+            return true;
+        }
+    } else
+        local->stats.alloc_hits++;
+
+    *umem = magazine->umems[--magazine->count];
+    umem->size = size;
+    umem->mgr = mgr;
+    return true;
+}
+
+/** @This frees a umem.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc
+ */
+static void umem_pthread_cache_free(struct umem *umem)
+{
+    struct umem_pthread_cache_mgr *cache_mgr =
+        umem_pthread_cache_mgr_from_umem_mgr(umem->mgr);
+    unsigned int c = umem_pthread_cache_class_free(cache_mgr, umem->real_size);
+    umem->mgr = cache_mgr->umem_mgr;
+
+    struct umem_pthread_cache_local *local =
+        umem_pthread_cache_tls(cache_mgr);
+    if (unlikely(local == NULL)) {
+        umem_free(umem);
+        return;
+    }
+
+    struct umem_pthread_cache_class *size_class = &local->classes[c];
+    struct umem_pthread_cache_magazine *magazine = size_class->loaded;
+    if (unlikely(magazine == NULL ||
+                 magazine->count >= cache_mgr->magazine_size)) {
+        if (size_class->previous != NULL &&
+            size_class->previous->count < cache_mgr->magazine_size) {
+            size_class->loaded = size_class->previous;
+            size_class->previous = magazine;
+            magazine = size_class->loaded;
+            local->stats.free_hits++;
+        } else {
+            struct umem_pthread_cache_magazine *empty =
+                umem_pthread_cache_magazine_alloc(cache_mgr, c);
+            if (unlikely(empty == NULL)) {
+                local->stats.free_misses++;
+                umem_free(umem);
+                return;
+            }
+            if (size_class->previous != NULL) {
+                local->stats.free_misses +=
+                    umem_pthread_cache_magazine_release(cache_mgr, c,
+                                                        size_class->previous);
+                local->stats.free_depot++;
+                umem_pthread_cache_account(local);
+            } else
+                local->stats.free_hits++;
+            size_class->previous = size_class->loaded;
+            size_class->loaded = empty;
+            magazine = empty;
+        }
+    } else
+        local->stats.free_hits++;
+
+    magazine->umems[magazine->count++] = *umem;
+    umem->buffer = NULL;
+    umem->mgr = NULL;
+}
+
+/** @This resizes a umem.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc, and filled in with the new pointer and size
+ * @param new_size new requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_pthread_cache_realloc(struct umem *umem, size_t new_size)
+{
+    if (likely(new_size <= umem->real_size)) {
+        umem->size = new_size;
+        return true;
+    }
+
+    struct umem new_umem;
+    if (!umem_pthread_cache_alloc(umem->mgr, &new_umem, new_size))
+        return false;
+    memcpy(new_umem.buffer, umem->buffer, umem->size);
+    umem_pthread_cache_free(umem);
+    *umem = new_umem;
+    return true;
+}
+
+/** @internal @This returns the magazines of a thread to the depot.
+ *
+ * @param local thread-local structure
+ */
+static void umem_pthread_cache_flush(struct umem_pthread_cache_local *local)
+{
+    struct umem_pthread_cache_mgr *cache_mgr = local->cache_mgr;
+    for (unsigned int c = 0; c < cache_mgr->nb_classes; c++) {
+        struct umem_pthread_cache_class *size_class = &local->classes[c];
+        local->stats.free_misses +=
+            umem_pthread_cache_magazine_release(cache_mgr, c, size_class->loaded);
+        local->stats.free_misses +=
+            umem_pthread_cache_magazine_release(cache_mgr, c,
+                                                size_class->previous);
+        size_class->loaded = size_class->previous = NULL;
+    }
+    umem_pthread_cache_account(local);
+}
+
+/** @internal @This destroys thread-local storage.
+ *
+ * @param _local pointer to thread-local storage
+ */
+static void umem_pthread_cache_destr(void *_local)
+{
+    struct umem_pthread_cache_local *local = _local;
+    umem_pthread_cache_flush(local);
+    free(local);
+}
+
+/** @This instructs an existing umem manager to release all structures
+ * currently kept in pools. It is intended as a debug tool only.
+ *
+ * @param mgr pointer to umem manager
+ */
+static void umem_pthread_cache_mgr_vacuum(struct umem_mgr *mgr)
+{
+    struct umem_pthread_cache_mgr *cache_mgr =
+        umem_pthread_cache_mgr_from_umem_mgr(mgr);
+    umem_pthread_cache_mgr_flush(mgr);
+
+    for (unsigned int c = 0; c < 2 * cache_mgr->nb_classes; c++) {
+        struct umem_pthread_cache_magazine *magazine;
+        while ((magazine = ulifo_pop(&cache_mgr->depots[c],
+                        struct umem_pthread_cache_magazine *)) != NULL) {
+            while (magazine->count)
+                umem_free(&magazine->umems[--magazine->count]);
+            free(magazine);
+        }
+    }
+    umem_mgr_vacuum(cache_mgr->umem_mgr);
+}
+
+/** @This frees a umem manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void umem_pthread_cache_mgr_free(struct urefcount *urefcount)
+{
+    struct umem_pthread_cache_mgr *cache_mgr =
+        umem_pthread_cache_mgr_from_urefcount(urefcount);
+    umem_pthread_cache_mgr_vacuum(umem_pthread_cache_mgr_to_umem_mgr(cache_mgr));
+    struct umem_pthread_cache_local *local =
+        pthread_getspecific(cache_mgr->key);
+    if (local != NULL)
+        /* POSIX doesn't deallocate values on key deletion */
+        umem_pthread_cache_destr(local);
+    pthread_key_delete(cache_mgr->key);
+
+    for (unsigned int c = 0; c < 2 * cache_mgr->nb_classes; c++)
+        ulifo_clean(&cache_mgr->depots[c]);
+    pthread_mutex_destroy(&cache_mgr->stats_lock);
+    umem_mgr_release(cache_mgr->umem_mgr);
+
+    urefcount_clean(urefcount);
+    free(cache_mgr);
+}
+
+/** @This allocates a new instance of the umem pthread cache manager.
+ *
+ * @param umem_mgr underlying umem manager
+ * @param class0_size size (in octets) of the smallest size class; it must be
+ * a power of 2
+ * @param nb_classes number of size classes, in power of 2's increments;
+ * larger buffers are directly managed by the underlying manager
+ * @param magazine_size number of buffers per magazine
+ * @param depot_depth maximum number of full magazines kept in the depot per
+ * size class
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pthread_cache_mgr_alloc(struct umem_mgr *umem_mgr,
+                                              size_t class0_size,
+                                              unsigned int nb_classes,
+                                              unsigned int magazine_size,
+                                              unsigned int depot_depth)
+{
+    assert(umem_mgr != NULL);
+    if (unlikely(!class0_size || (class0_size & (class0_size - 1)) ||
+                 !nb_classes || !magazine_size || !depot_depth ||
+                 depot_depth > UINT16_MAX))
+        return NULL;
+
+    struct umem_pthread_cache_mgr *cache_mgr =
+        malloc(sizeof(struct umem_pthread_cache_mgr) +
+               2 * nb_classes * (sizeof(struct ulifo) +
+                                 ulifo_sizeof(depot_depth)));
+    if (unlikely(cache_mgr == NULL))
+        return NULL;
+
+    if (unlikely(pthread_key_create(&cache_mgr->key,
+                                    umem_pthread_cache_destr) != 0)) {
+        free(cache_mgr);
+        return NULL;
+    }
+    pthread_mutex_init(&cache_mgr->stats_lock, NULL);
+    memset(&cache_mgr->stats, 0, sizeof(cache_mgr->stats));
+
+    cache_mgr->umem_mgr = umem_mgr_use(umem_mgr);
+    cache_mgr->class0_size = class0_size;
+    cache_mgr->class0_shift = ubase_log2(class0_size);
+    cache_mgr->nb_classes = nb_classes;
+    cache_mgr->magazine_size = magazine_size;
+
+    void *extra = (void *)cache_mgr + sizeof(struct umem_pthread_cache_mgr) +
+                  2 * nb_classes * sizeof(struct ulifo);
+    for (unsigned int c = 0; c < 2 * nb_classes; c++) {
+        ulifo_init(&cache_mgr->depots[c], depot_depth, extra);
+        extra += ulifo_sizeof(depot_depth);
+    }
+
+    urefcount_init(umem_pthread_cache_mgr_to_urefcount(cache_mgr),
+                   umem_pthread_cache_mgr_free);
+    cache_mgr->mgr.refcount = umem_pthread_cache_mgr_to_urefcount(cache_mgr);
+    cache_mgr->mgr.umem_alloc = umem_pthread_cache_alloc;
+    cache_mgr->mgr.umem_realloc = umem_pthread_cache_realloc;
+    cache_mgr->mgr.umem_free = umem_pthread_cache_free;
+    cache_mgr->mgr.umem_mgr_vacuum = umem_pthread_cache_mgr_vacuum;
+
+    return umem_pthread_cache_mgr_to_umem_mgr(cache_mgr);
+}
+
+/** @This returns the magazines of the calling thread to the depot, and
+ * accounts for its statistics.
+ *
+ * @param mgr pointer to umem manager
+ */
+void umem_pthread_cache_mgr_flush(struct umem_mgr *mgr)
+{
+    struct umem_pthread_cache_mgr *cache_mgr =
+        umem_pthread_cache_mgr_from_umem_mgr(mgr);
+    struct umem_pthread_cache_local *local =
+        pthread_getspecific(cache_mgr->key);
+    if (local != NULL)
+        umem_pthread_cache_flush(local);
+}
+
+/** @This returns the statistics of the manager. The statistics of a thread
+ * are only accounted for when it exchanges a magazine with the depot, is
+ * flushed or exits.
+ *
+ * @param mgr pointer to umem manager
+ * @param stats filled in with the statistics
+ */
+void umem_pthread_cache_mgr_get_stats(struct umem_mgr *mgr,
+                                      struct umem_pthread_cache_stats *stats)
+{
+    struct umem_pthread_cache_mgr *cache_mgr =
+        umem_pthread_cache_mgr_from_umem_mgr(mgr);
+    assert(stats != NULL);
+    pthread_mutex_lock(&cache_mgr->stats_lock);
+    *stats = cache_mgr->stats;
+    pthread_mutex_unlock(&cache_mgr->stats_lock);
+}
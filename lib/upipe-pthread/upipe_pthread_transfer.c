@@ -28,6 +28,8 @@
  * This is particularly helpful for multithreaded applications.
  */
 
+#define _GNU_SOURCE
+
 #include <upipe/ubase.h>
 #include <upipe/urefcount.h>
 #include <upipe/ueventfd.h>
@@ -52,8 +54,18 @@
 #include <signal.h>
 #include <errno.h>
 #include <math.h>
+#include <sched.h>
 #include <assert.h>
 
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#if defined(__linux__) && defined(SYS_set_mempolicy) && defined(SYS_getcpu)
+/** memory policy restricting allocations to the given nodes */
+#define UPIPE_PTHREAD_MPOL_BIND 2
+#endif
+
 /** @internal @This is the private context for pthread. */
 struct upipe_pthread_ctx {
     /** xfer manager */
@@ -72,8 +84,124 @@ struct upipe_pthread_ctx {
     struct ueventfd event;
     /** mutual exclusion primitives for access to the event loop */
     struct umutex *mutex;
+    /** scheduling of the thread */
+    struct upipe_pthread_sched sched;
 };
 
+/** @internal @This pins the calling thread to a set of CPUs.
+ *
+ * @param sched pointer to scheduling description
+ * @param uprobe pointer to probe used to report errors, or NULL
+ * @return an error code
+ */
+static int upipe_pthread_sched_apply_cpus(
+        const struct upipe_pthread_sched *sched, struct uprobe *uprobe)
+{
+    bool pin = false;
+    for (unsigned int i = 0; i < UPIPE_PTHREAD_SCHED_MAX_CPUS / 64; i++)
+        if (sched->cpus[i])
+            pin = true;
+    if (!pin)
+        return UBASE_ERR_NONE;
+
+#if defined(__linux__) && defined(CPU_SETSIZE)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (unsigned int cpu = 0;
+         cpu < UPIPE_PTHREAD_SCHED_MAX_CPUS && cpu < CPU_SETSIZE; cpu++)
+        if (upipe_pthread_sched_has_cpu(sched, cpu))
+            CPU_SET(cpu, &cpuset);
+
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (unlikely(ret != 0)) {
+        uprobe_warn_va(uprobe, NULL, "unable to set CPU affinity (%s)",
+                       strerror(ret));
+        return UBASE_ERR_EXTERNAL;
+    }
+    return UBASE_ERR_NONE;
+#else
+    uprobe_warn(uprobe, NULL, "CPU affinity is not supported");
+    return UBASE_ERR_EXTERNAL;
+#endif
+}
+
+/** @internal @This binds the memory allocated by the calling thread to a
+ * NUMA node.
+ *
+ * @param sched pointer to scheduling description
+ * @param uprobe pointer to probe used to report errors, or NULL
+ * @return an error code
+ */
+static int upipe_pthread_sched_apply_numa(
+        const struct upipe_pthread_sched *sched, struct uprobe *uprobe)
+{
+    if (sched->numa_node == -1)
+        return UBASE_ERR_NONE;
+
+#ifdef UPIPE_PTHREAD_MPOL_BIND
+    int numa_node = sched->numa_node;
+    if (numa_node == UPIPE_PTHREAD_SCHED_NUMA_LOCAL) {
+        /* the node of the CPU we run on, after the affinity was set */
+        unsigned int cpu, node;
+        if (unlikely(syscall(SYS_getcpu, &cpu, &node, NULL) < 0)) {
+            uprobe_warn_va(uprobe, NULL, "unable to get NUMA node (%m)");
+            return UBASE_ERR_EXTERNAL;
+        }
+        numa_node = node;
+    }
+    if (unlikely(numa_node < 0))
+        return UBASE_ERR_INVALID;
+
+    unsigned long nodemask[numa_node / (sizeof(unsigned long) * 8) + 1];
+    memset(nodemask, 0, sizeof(nodemask));
+    nodemask[numa_node / (sizeof(unsigned long) * 8)] =
+        1UL << (numa_node % (sizeof(unsigned long) * 8));
+    if (unlikely(syscall(SYS_set_mempolicy, UPIPE_PTHREAD_MPOL_BIND,
+                         nodemask, (unsigned long)numa_node + 2) < 0)) {
+        uprobe_warn_va(uprobe, NULL, "unable to bind memory to node %d (%m)",
+                       numa_node);
+        return UBASE_ERR_EXTERNAL;
+    }
+    return UBASE_ERR_NONE;
+#else
+    uprobe_warn(uprobe, NULL, "NUMA binding is not supported");
+    return UBASE_ERR_EXTERNAL;
+#endif
+}
+
+/** @This applies a scheduling description to the calling thread. It is
+ * called by the transfer thread at startup, but may also be used by
+ * applications for their own threads.
+ *
+ * @param sched pointer to scheduling description
+ * @param uprobe pointer to probe used to report errors, or NULL
+ * @return an error code, UBASE_ERR_EXTERNAL if one of the settings couldn't
+ * be applied (the others are applied nevertheless)
+ */
+int upipe_pthread_sched_apply(const struct upipe_pthread_sched *sched,
+                              struct uprobe *uprobe)
+{
+    int err = upipe_pthread_sched_apply_cpus(sched, uprobe);
+
+    if (sched->policy >= 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = sched->priority;
+        int ret = pthread_setschedparam(pthread_self(), sched->policy, &param);
+        if (unlikely(ret != 0)) {
+            uprobe_warn_va(uprobe, NULL,
+                           "unable to set scheduling policy %d priority %d (%s)",
+                           sched->policy, sched->priority, strerror(ret));
+            err = UBASE_ERR_EXTERNAL;
+        }
+    }
+
+    int numa_err = upipe_pthread_sched_apply_numa(sched, uprobe);
+    if (!ubase_check(numa_err))
+        err = numa_err;
+    return err;
+}
+
 /** @internal @This is the main function of the new thread.
  *
  * @param mgr pointer to a upipe pthread manager
@@ -93,6 +221,10 @@ static void *upipe_pthread_start(void *_pthread_ctx)
 
     pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
 
+    /* before the upump manager, so that it is allocated on the right node */
+    upipe_pthread_sched_apply(&pthread_ctx->sched,
+                              pthread_ctx->uprobe_pthread_upump_mgr);
+
     /* spawn the upump manager */
     struct upump_mgr *upump_mgr =
         pthread_ctx->upump_mgr_alloc(pthread_ctx->upump_pool_depth,
@@ -154,7 +286,9 @@ static void upipe_pthread_stop(struct upump *upump)
 }
 
 /** @This returns a management structure for transfer pipes, using a new
- * pthread. You would need one management structure per target thread.
+ * pthread with the given scheduling. Settings which cannot be applied (for
+ * instance a real-time policy without the required privileges) are reported
+ * as warnings on uprobe_pthread_upump_mgr, and the thread runs anyway.
  *
  * @param queue_length maximum length of the internal queue of commands
  * @param msg_pool_depth maximum number of messages in the pool
@@ -167,13 +301,15 @@ static void upipe_pthread_stop(struct upump *upump)
  * @param mutex mutual exclusion pimitives to access the event loop, or NULL
  * @param pthread_id_p reference to created thread ID (may be NULL)
  * @param attr pthread attributes
+ * @param sched scheduling of the new thread, or NULL to inherit
  * @return pointer to xfer manager
  */
-struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_sched(unsigned int queue_length,
         uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
         upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
         uint16_t upump_blocker_pool_depth, struct umutex *mutex,
-        pthread_t *pthread_id_p, const pthread_attr_t *restrict attr)
+        pthread_t *pthread_id_p, const pthread_attr_t *restrict attr,
+        const struct upipe_pthread_sched *sched)
 {
     struct upipe_pthread_ctx *pthread_ctx =
         malloc(sizeof(struct upipe_pthread_ctx));
@@ -207,6 +343,10 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
     pthread_ctx->upump_pool_depth = upump_pool_depth;
     pthread_ctx->upump_blocker_pool_depth = upump_blocker_pool_depth;
     pthread_ctx->mutex = umutex_use(mutex);
+    if (sched != NULL)
+        pthread_ctx->sched = *sched;
+    else
+        upipe_pthread_sched_init(&pthread_ctx->sched);
 
     if (unlikely(pthread_create(&pthread_ctx->pthread_id, attr,
                                 upipe_pthread_start, pthread_ctx) != 0))
@@ -231,3 +371,30 @@ upipe_pthread_xfer_mgr_alloc_err1:
     uprobe_release(uprobe_pthread_upump_mgr);
     return NULL;
 }
+
+/** @This returns a management structure for transfer pipes, using a new
+ * pthread. You would need one management structure per target thread.
+ *
+ * @param queue_length maximum length of the internal queue of commands
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
+ * with the created upump_mgr
+ * @param upump_mgr_alloc alloc function provided by the upump manager
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param mutex mutual exclusion pimitives to access the event loop, or NULL
+ * @param pthread_id_p reference to created thread ID (may be NULL)
+ * @param attr pthread attributes
+ * @return pointer to xfer manager
+ */
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(unsigned int queue_length,
+        uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
+        upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth, struct umutex *mutex,
+        pthread_t *pthread_id_p, const pthread_attr_t *restrict attr)
+{
+    return upipe_pthread_xfer_mgr_alloc_sched(queue_length, msg_pool_depth,
+            uprobe_pthread_upump_mgr, upump_mgr_alloc, upump_pool_depth,
+            upump_blocker_pool_depth, mutex, pthread_id_p, attr, NULL);
+}
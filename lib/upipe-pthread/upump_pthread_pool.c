@@ -0,0 +1,1068 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe pool of POSIX threads running upump managers
+ *
+ * The readiness state of all the domains is protected by the lock of the
+ * pool. At most one idle worker polls the file descriptors and waits for the
+ * next timer, while the other idle workers sleep on a condition variable;
+ * each worker has its own run queue of domains, protected by its own lock,
+ * from which the other workers may steal.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/uatomic.h>
+#include <upipe/uclock.h>
+#include <upipe/ulist.h>
+#include <upipe/uheap.h>
+#include <upipe/umutex.h>
+#include <upipe/ueventfd.h>
+#include <upipe/upump.h>
+#include <upipe/upump_common.h>
+#include <upipe-pthread/upump_pthread_pool.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+
+/** minimum interval between two polls by a busy worker */
+#define UPUMP_PTHREAD_POOL_POLL_INTERVAL (UCLOCK_FREQ / 1000)
+
+/** @internal @This is the state of a pump with respect to the pool. */
+enum upump_pthread_pool_state {
+    /** not waiting */
+    UPUMP_PTHREAD_POOL_NONE,
+    /** file descriptor being polled */
+    UPUMP_PTHREAD_POOL_ARMED,
+    /** waiting to be dispatched */
+    UPUMP_PTHREAD_POOL_READY
+};
+
+/** @internal @This is the structure of a worker thread. */
+struct upump_pthread_pool_worker {
+    /** pointer to the pool */
+    struct upump_pthread_pool *pool;
+    /** thread ID */
+    pthread_t thread;
+    /** lock protecting the run queue */
+    pthread_mutex_t lock;
+    /** run queue of domains */
+    struct uchain queue;
+};
+
+/** @This is the structure of a pool. */
+struct upump_pthread_pool {
+    /** lock protecting the state of the pool and its domains */
+    pthread_mutex_t lock;
+    /** condition on which idle workers wait */
+    pthread_cond_t cond;
+    /** condition signalled when a domain becomes idle */
+    pthread_cond_t idle_cond;
+    /** event interrupting the poll */
+    struct ueventfd event;
+    /** true if a worker is polling */
+    bool polling;
+    /** true if the workers must exit */
+    bool exit;
+    /** number of workers waiting on the condition */
+    unsigned int nb_waiting;
+    /** number of queued domains */
+    uatomic_uint32_t nb_queued;
+    /** date of the last poll */
+    uint64_t last_poll;
+
+    /** heap of active timers */
+    struct uheap timers;
+    /** list of armed file descriptor pumps */
+    struct uchain fds;
+    /** number of armed file descriptor pumps */
+    unsigned int nb_fds;
+    /** true if the poll array must be rebuilt */
+    bool fds_changed;
+    /** poll array, the event is first */
+    struct pollfd *pollfds;
+    /** number of entries in the poll array */
+    unsigned int nb_pollfds;
+    /** allocated entries in the poll array */
+    unsigned int pollfds_size;
+
+    /** statistics */
+    struct upump_pthread_pool_stats stats;
+    /** worker to assign to the next domain */
+    unsigned int next_worker;
+    /** number of workers */
+    unsigned int nb_workers;
+    /** workers */
+    struct upump_pthread_pool_worker workers[];
+};
+
+/** @This is the structure of a domain. */
+struct upump_pthread_pool_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** pointer to the pool */
+    struct upump_pthread_pool *pool;
+    /** mutex held while dispatching, or NULL */
+    struct umutex *mutex;
+
+    /** structure for the run queue */
+    struct uchain uchain;
+    /** true if the domain is in a run queue */
+    bool queued;
+    /** true if the domain is being dispatched */
+    bool running;
+    /** index of the worker which last ran the domain */
+    unsigned int worker;
+    /** pumps waiting to be dispatched */
+    struct uchain ready;
+    /** active idlers */
+    struct uchain idlers;
+    /** pump being dispatched */
+    struct upump_pthread_pool_pump *current;
+    /** number of active blocking pumps */
+    unsigned int nb_blocking;
+
+    /** common structure */
+    struct upump_common_mgr common_mgr;
+
+    /** extra space for upool */
+    uint8_t upool_extra[];
+};
+
+UBASE_FROM_TO(upump_pthread_pool_mgr, upump_mgr, upump_mgr, common_mgr.mgr)
+UBASE_FROM_TO(upump_pthread_pool_mgr, urefcount, urefcount, urefcount)
+UBASE_FROM_TO(upump_pthread_pool_mgr, uchain, uchain, uchain)
+
+/** @This is the structure of a pump of a domain. */
+struct upump_pthread_pool_pump {
+    /** type of event to watch */
+    int event;
+    /** true if the pump is active */
+    bool active;
+    /** blocking status of the active pump */
+    bool blocking;
+    /** state with respect to the pool */
+    enum upump_pthread_pool_state state;
+
+    /** file descriptor */
+    int fd;
+    /** index in the poll array, or UINT_MAX */
+    unsigned int pollfd;
+    /** timer first expiration */
+    uint64_t after;
+    /** timer repeat period */
+    uint64_t repeat;
+    /** node in the heap of timers */
+    struct uheap_node uheap_node;
+    /** structure for the lists of the domain and the pool */
+    struct uchain uchain;
+
+    /** common structure */
+    struct upump_common common;
+};
+
+UBASE_FROM_TO(upump_pthread_pool_pump, upump, upump, common.upump)
+UBASE_FROM_TO(upump_pthread_pool_pump, uchain, uchain, uchain)
+UBASE_FROM_TO(upump_pthread_pool_pump, uheap_node, uheap_node, uheap_node)
+
+/** @internal @This returns the current monotonic date.
+ *
+ * @return date in units of 27 MHz
+ */
+static uint64_t upump_pthread_pool_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UCLOCK_FREQ +
+           (uint64_t)ts.tv_nsec * UCLOCK_FREQ / UINT64_C(1000000000);
+}
+
+/** @internal @This returns the readable file descriptor of the event.
+ *
+ * @param pool pointer to pool
+ * @return file descriptor
+ */
+static int upump_pthread_pool_event_fd(struct upump_pthread_pool *pool)
+{
+#ifdef UPIPE_HAVE_EVENTFD
+    if (pool->event.mode == UEVENTFD_MODE_EVENTFD)
+        return pool->event.event_fd;
+#endif
+    return pool->event.pipe_fds[0];
+}
+
+/** @internal @This wakes up a worker, if one is idle. It must be called
+ * with the pool lock held.
+ *
+ * @param pool pointer to pool
+ */
+static void upump_pthread_pool_wake(struct upump_pthread_pool *pool)
+{
+    if (pool->nb_waiting)
+        pthread_cond_signal(&pool->cond);
+    else if (pool->polling)
+        ueventfd_write(&pool->event);
+}
+
+/** @internal @This queues a domain on the run queue of the worker which
+ * last ran it. It must be called with the pool lock held.
+ *
+ * @param domain pointer to domain
+ */
+static void upump_pthread_pool_schedule(struct upump_pthread_pool_mgr *domain)
+{
+    struct upump_pthread_pool *pool = domain->pool;
+    if (domain->queued || domain->running)
+        return;
+
+    /* the run queue holds a reference to the domain */
+    upump_mgr_use(upump_pthread_pool_mgr_to_upump_mgr(domain));
+    domain->queued = true;
+    struct upump_pthread_pool_worker *worker = &pool->workers[domain->worker];
+    pthread_mutex_lock(&worker->lock);
+    ulist_add(&worker->queue, upump_pthread_pool_mgr_to_uchain(domain));
+    pthread_mutex_unlock(&worker->lock);
+    uatomic_fetch_add(&pool->nb_queued, 1);
+    upump_pthread_pool_wake(pool);
+}
+
+/** @internal @This marks a pump as ready to be dispatched. It must be called
+ * with the pool lock held.
+ *
+ * @param pump pointer to pump
+ */
+static void upump_pthread_pool_ready(struct upump_pthread_pool_pump *pump)
+{
+    struct upump_pthread_pool_mgr *domain =
+        upump_pthread_pool_mgr_from_upump_mgr(pump->common.upump.mgr);
+    if (pump->state == UPUMP_PTHREAD_POOL_READY)
+        return;
+    if (pump->state == UPUMP_PTHREAD_POOL_ARMED) {
+        domain->pool->nb_fds--;
+        domain->pool->fds_changed = true;
+        ulist_delete(upump_pthread_pool_pump_to_uchain(pump));
+    }
+    pump->state = UPUMP_PTHREAD_POOL_READY;
+    ulist_add(&domain->ready, upump_pthread_pool_pump_to_uchain(pump));
+    upump_pthread_pool_schedule(domain);
+}
+
+/** @internal @This arms a file descriptor pump. It must be called with the
+ * pool lock held.
+ *
+ * @param pump pointer to pump
+ */
+static void upump_pthread_pool_arm(struct upump_pthread_pool_pump *pump)
+{
+    struct upump_pthread_pool_mgr *domain =
+        upump_pthread_pool_mgr_from_upump_mgr(pump->common.upump.mgr);
+    struct upump_pthread_pool *pool = domain->pool;
+    if (pump->state != UPUMP_PTHREAD_POOL_NONE)
+        return;
+    pump->state = UPUMP_PTHREAD_POOL_ARMED;
+    pump->pollfd = UINT_MAX;
+    ulist_add(&pool->fds, upump_pthread_pool_pump_to_uchain(pump));
+    pool->nb_fds++;
+    pool->fds_changed = true;
+    if (pool->polling)
+        ueventfd_write(&pool->event);
+}
+
+/** @internal @This dispatches the expired timers. It must be called with
+ * the pool lock held.
+ *
+ * @param pool pointer to pool
+ * @param now current date
+ */
+static void upump_pthread_pool_expire(struct upump_pthread_pool *pool,
+                                      uint64_t now)
+{
+    struct uheap_node *node;
+    while ((node = uheap_peek(&pool->timers)) != NULL && node->key <= now) {
+        struct upump_pthread_pool_pump *pump =
+            upump_pthread_pool_pump_from_uheap_node(node);
+        if (pump->repeat) {
+            uint64_t key = node->key + pump->repeat;
+            if (key <= now)
+                key = now + pump->repeat;
+            uheap_update(&pool->timers, node, key);
+        } else {
+            struct upump_pthread_pool_mgr *domain =
+                upump_pthread_pool_mgr_from_upump_mgr(pump->common.upump.mgr);
+            uheap_delete(&pool->timers, node);
+            pump->active = false;
+            if (pump->blocking)
+                domain->nb_blocking--;
+        }
+        upump_pthread_pool_ready(pump);
+    }
+}
+
+/** @internal @This polls the file descriptors and expires the timers. It must
+ * be called with the pool lock held, and no other worker polling.
+ *
+ * @param pool pointer to pool
+ * @param wait true if the worker may wait for an event
+ */
+static void upump_pthread_pool_poll(struct upump_pthread_pool *pool,
+                                    bool wait)
+{
+    pool->polling = true;
+    uint64_t now = upump_pthread_pool_now();
+    upump_pthread_pool_expire(pool, now);
+    if (uatomic_load(&pool->nb_queued))
+        wait = false;
+
+    if (pool->fds_changed) {
+        if (pool->nb_fds + 1 > pool->pollfds_size) {
+            struct pollfd *pollfds = realloc(pool->pollfds,
+                    (pool->nb_fds + 1) * sizeof(struct pollfd));
+            if (unlikely(pollfds == NULL)) {
+                pool->polling = false;
+                return;
+            }
+            pool->pollfds = pollfds;
+            pool->pollfds_size = pool->nb_fds + 1;
+        }
+        pool->nb_pollfds = 1;
+        struct uchain *uchain;
+        ulist_foreach (&pool->fds, uchain) {
+            struct upump_pthread_pool_pump *pump =
+                upump_pthread_pool_pump_from_uchain(uchain);
+            struct pollfd *pollfd = &pool->pollfds[pool->nb_pollfds];
+            pollfd->fd = pump->fd;
+            pollfd->events = pump->event == UPUMP_TYPE_FD_READ ?
+                             POLLIN : POLLOUT;
+            pump->pollfd = pool->nb_pollfds++;
+        }
+        pool->fds_changed = false;
+    }
+    pool->pollfds[0].fd = upump_pthread_pool_event_fd(pool);
+    pool->pollfds[0].events = POLLIN;
+
+    int timeout = 0;
+    if (wait) {
+        struct uheap_node *node = uheap_peek(&pool->timers);
+        if (node == NULL)
+            timeout = -1;
+        else {
+            uint64_t delay = (node->key - now + UCLOCK_FREQ / 1000 - 1) /
+                             (UCLOCK_FREQ / 1000);
+            timeout = delay > INT_MAX ? INT_MAX : delay;
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    int ret = poll(pool->pollfds, pool->nb_pollfds, timeout);
+    pthread_mutex_lock(&pool->lock);
+
+    if (ret > 0) {
+        if (pool->pollfds[0].revents)
+            ueventfd_read(&pool->event);
+
+        /* pumps disarmed during the poll are no longer in the list */
+        struct uchain *uchain, *uchain_tmp;
+        ulist_delete_foreach (&pool->fds, uchain, uchain_tmp) {
+            struct upump_pthread_pool_pump *pump =
+                upump_pthread_pool_pump_from_uchain(uchain);
+            if (pump->pollfd < pool->nb_pollfds &&
+                pool->pollfds[pump->pollfd].revents)
+                upump_pthread_pool_ready(pump);
+        }
+    }
+    now = upump_pthread_pool_now();
+    upump_pthread_pool_expire(pool, now);
+    pool->last_poll = now;
+    pool->polling = false;
+    /* hand the poll over to a sleeping worker */
+    if (pool->nb_waiting)
+        pthread_cond_signal(&pool->cond);
+}
+
+/** @internal @This dispatches the pumps of a domain.
+ *
+ * @param worker pointer to the running worker
+ * @param domain pointer to domain
+ */
+static void upump_pthread_pool_run(struct upump_pthread_pool_worker *worker,
+                                   struct upump_pthread_pool_mgr *domain)
+{
+    struct upump_pthread_pool *pool = worker->pool;
+    unsigned int index = worker - pool->workers;
+    struct uchain ready, idlers, *uchain;
+    ulist_init(&ready);
+    ulist_init(&idlers);
+
+    pthread_mutex_lock(&pool->lock);
+    domain->queued = false;
+    domain->running = true;
+    pool->stats.runs++;
+    if (domain->worker != index) {
+        pool->stats.steals++;
+        domain->worker = index;
+    }
+    while ((uchain = ulist_pop(&domain->ready)) != NULL)
+        ulist_add(&ready, uchain);
+    while ((uchain = ulist_pop(&domain->idlers)) != NULL)
+        ulist_add(&idlers, uchain);
+    pthread_mutex_unlock(&pool->lock);
+
+    umutex_lock(domain->mutex);
+
+    /* pumps stopped by a callback are removed from the local lists */
+    pthread_mutex_lock(&pool->lock);
+    while ((uchain = ulist_pop(&ready)) != NULL) {
+        struct upump_pthread_pool_pump *pump =
+            upump_pthread_pool_pump_from_uchain(uchain);
+        pump->state = UPUMP_PTHREAD_POOL_NONE;
+        domain->current = pump;
+        pthread_mutex_unlock(&pool->lock);
+
+        upump_common_dispatch(upump_pthread_pool_pump_to_upump(pump));
+
+        pthread_mutex_lock(&pool->lock);
+        /* the pump was neither stopped nor freed */
+        if (domain->current == pump && pump->active &&
+            (pump->event == UPUMP_TYPE_FD_READ ||
+             pump->event == UPUMP_TYPE_FD_WRITE))
+            upump_pthread_pool_arm(pump);
+        domain->current = NULL;
+    }
+    while ((uchain = ulist_pop(&idlers)) != NULL) {
+        ulist_add(&domain->idlers, uchain);
+        pthread_mutex_unlock(&pool->lock);
+
+        upump_common_dispatch(upump_pthread_pool_pump_to_upump(
+                    upump_pthread_pool_pump_from_uchain(uchain)));
+
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    umutex_unlock(domain->mutex);
+
+    pthread_mutex_lock(&pool->lock);
+    domain->running = false;
+    if (!ulist_empty(&domain->ready) || !ulist_empty(&domain->idlers))
+        upump_pthread_pool_schedule(domain);
+    if (!domain->nb_blocking && ulist_empty(&domain->ready))
+        pthread_cond_broadcast(&pool->idle_cond);
+
+    /* keep the timers and file descriptors going while all workers are busy */
+    if (!pool->polling && (pool->nb_fds || uheap_size(&pool->timers)) &&
+        upump_pthread_pool_now() >=
+            pool->last_poll + UPUMP_PTHREAD_POOL_POLL_INTERVAL)
+        upump_pthread_pool_poll(pool, false);
+    pthread_mutex_unlock(&pool->lock);
+
+    upump_mgr_release(upump_pthread_pool_mgr_to_upump_mgr(domain));
+}
+
+/** @internal @This takes a domain from the run queue of a worker, or steals
+ * one from another worker.
+ *
+ * @param worker pointer to the running worker
+ * @return pointer to domain, or NULL
+ */
+static struct upump_pthread_pool_mgr *
+    upump_pthread_pool_pop(struct upump_pthread_pool_worker *worker)
+{
+    struct upump_pthread_pool *pool = worker->pool;
+    unsigned int index = worker - pool->workers;
+    struct uchain *uchain;
+
+    pthread_mutex_lock(&worker->lock);
+    uchain = ulist_pop(&worker->queue);
+    pthread_mutex_unlock(&worker->lock);
+
+    for (unsigned int i = 1; uchain == NULL && i < pool->nb_workers; i++) {
+        struct upump_pthread_pool_worker *victim =
+            &pool->workers[(index + i) % pool->nb_workers];
+        pthread_mutex_lock(&victim->lock);
+        /* steal from the back, the front is served by the victim */
+        if (!ulist_empty(&victim->queue)) {
+            uchain = victim->queue.prev;
+            ulist_delete(uchain);
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+
+    if (uchain == NULL)
+        return NULL;
+    uatomic_fetch_sub(&pool->nb_queued, 1);
+    return upump_pthread_pool_mgr_from_uchain(uchain);
+}
+
+/** @internal @This is the main function of a worker thread.
+ *
+ * @param _worker pointer to the worker
+ * @return NULL
+ */
+static void *upump_pthread_pool_worker(void *_worker)
+{
+    struct upump_pthread_pool_worker *worker = _worker;
+    struct upump_pthread_pool *pool = worker->pool;
+
+    for ( ; ; ) {
+        struct upump_pthread_pool_mgr *domain = upump_pthread_pool_pop(worker);
+        if (domain != NULL) {
+            upump_pthread_pool_run(worker, domain);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        if (pool->exit) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        if (!uatomic_load(&pool->nb_queued)) {
+            if (!pool->polling)
+                upump_pthread_pool_poll(pool, true);
+            else {
+                pool->nb_waiting++;
+                pthread_cond_wait(&pool->cond, &pool->lock);
+                pool->nb_waiting--;
+            }
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+/** @This allocates a new pump.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_pthread_pool_mgr structure
+ * @param event type of event to watch for
+ * @param args optional parameters depending on event type
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static struct upump *upump_pthread_pool_pump_alloc(struct upump_mgr *mgr,
+                                                   int event, va_list args)
+{
+    struct upump_pthread_pool_mgr *domain =
+        upump_pthread_pool_mgr_from_upump_mgr(mgr);
+    struct upump_pthread_pool_pump *pump =
+        upool_alloc(&domain->common_mgr.upump_pool,
+                    struct upump_pthread_pool_pump *);
+    if (unlikely(pump == NULL))
+        return NULL;
+    struct upump *upump = upump_pthread_pool_pump_to_upump(pump);
+
+    pump->fd = -1;
+    pump->after = pump->repeat = 0;
+    switch (event) {
+        case UPUMP_TYPE_IDLER:
+            break;
+        case UPUMP_TYPE_TIMER:
+            pump->after = va_arg(args, uint64_t);
+            pump->repeat = va_arg(args, uint64_t);
+            break;
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+            pump->fd = va_arg(args, int);
+            break;
+        default:
+            upool_free(&domain->common_mgr.upump_pool, pump);
+            return NULL;
+    }
+    pump->event = event;
+    pump->active = false;
+    pump->blocking = false;
+    pump->state = UPUMP_PTHREAD_POOL_NONE;
+    pump->pollfd = UINT_MAX;
+    uheap_node_init(&pump->uheap_node);
+    uchain_init(&pump->uchain);
+
+    upump_common_init(upump);
+
+    return upump;
+}
+
+/** @This starts a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_pthread_pool_real_start(struct upump *upump, bool status)
+{
+    struct upump_pthread_pool_pump *pump =
+        upump_pthread_pool_pump_from_upump(upump);
+    struct upump_pthread_pool_mgr *domain =
+        upump_pthread_pool_mgr_from_upump_mgr(upump->mgr);
+    struct upump_pthread_pool *pool = domain->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pump->active) {
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+
+    switch (pump->event) {
+        case UPUMP_TYPE_IDLER:
+            ulist_add(&domain->idlers, upump_pthread_pool_pump_to_uchain(pump));
+            upump_pthread_pool_schedule(domain);
+            break;
+        case UPUMP_TYPE_TIMER:
+            if (unlikely(!ubase_check(uheap_update(&pool->timers,
+                                &pump->uheap_node,
+                                upump_pthread_pool_now() + pump->after)))) {
+                pthread_mutex_unlock(&pool->lock);
+                return;
+            }
+            if (pool->polling)
+                ueventfd_write(&pool->event);
+            break;
+        default:
+            upump_pthread_pool_arm(pump);
+            break;
+    }
+
+    pump->active = true;
+    pump->blocking = status;
+    if (status)
+        domain->nb_blocking++;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/** @internal @This stops a pump. It must be called with the pool lock
+ * held.
+ *
+ * @param pump pointer to pump
+ */
+static void upump_pthread_pool_stop(struct upump_pthread_pool_pump *pump)
+{
+    struct upump_pthread_pool_mgr *domain =
+        upump_pthread_pool_mgr_from_upump_mgr(pump->common.upump.mgr);
+    struct upump_pthread_pool *pool = domain->pool;
+
+    /* expired one-shot timers are already inactive */
+    if (pump->state == UPUMP_PTHREAD_POOL_READY) {
+        ulist_delete(upump_pthread_pool_pump_to_uchain(pump));
+        pump->state = UPUMP_PTHREAD_POOL_NONE;
+    }
+    if (domain->current == pump)
+        domain->current = NULL;
+    if (!pump->active)
+        return;
+
+    pump->active = false;
+    if (pump->blocking && !--domain->nb_blocking && !domain->running &&
+        ulist_empty(&domain->ready))
+        pthread_cond_broadcast(&pool->idle_cond);
+
+    switch (pump->event) {
+        case UPUMP_TYPE_IDLER:
+            ulist_delete(upump_pthread_pool_pump_to_uchain(pump));
+            break;
+        case UPUMP_TYPE_TIMER:
+            uheap_delete(&pool->timers, &pump->uheap_node);
+            break;
+        default:
+            if (pump->state == UPUMP_PTHREAD_POOL_ARMED) {
+                ulist_delete(upump_pthread_pool_pump_to_uchain(pump));
+                pump->state = UPUMP_PTHREAD_POOL_NONE;
+                pool->nb_fds--;
+                pool->fds_changed = true;
+            }
+            break;
+    }
+}
+
+/** @This stops a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_pthread_pool_real_stop(struct upump *upump, bool status)
+{
+    struct upump_pthread_pool_mgr *domain =
+        upump_pthread_pool_mgr_from_upump_mgr(upump->mgr);
+    struct upump_pthread_pool *pool = domain->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    upump_pthread_pool_stop(upump_pthread_pool_pump_from_upump(upump));
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/** @This restarts a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_pthread_pool_real_restart(struct upump *upump, bool status)
+{
+    struct upump_pthread_pool_pump *pump =
+        upump_pthread_pool_pump_from_upump(upump);
+    struct upump_pthread_pool_mgr *domain =
+        upump_pthread_pool_mgr_from_upump_mgr(upump->mgr);
+    struct upump_pthread_pool *pool = domain->pool;
+    if (pump->event != UPUMP_TYPE_TIMER)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    if (!pump->repeat ||
+        unlikely(!ubase_check(uheap_update(&pool->timers, &pump->uheap_node,
+                        upump_pthread_pool_now() + pump->repeat)))) {
+        upump_pthread_pool_stop(pump);
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+    if (!pump->active) {
+        pump->active = true;
+        pump->blocking = status;
+        if (status)
+            domain->nb_blocking++;
+    }
+    if (pool->polling)
+        ueventfd_write(&pool->event);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/** @This released the memory space previously used by a pump.
+ * Please note that the pump must be stopped before.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_pthread_pool_pump_free(struct upump *upump)
+{
+    struct upump_pthread_pool_mgr *domain =
+        upump_pthread_pool_mgr_from_upump_mgr(upump->mgr);
+    upump_stop(upump);
+    upump_common_clean(upump);
+    struct upump_pthread_pool_pump *pump =
+        upump_pthread_pool_pump_from_upump(upump);
+    upool_free(&domain->common_mgr.upump_pool, pump);
+}
+
+/** @internal @This allocates the data structure.
+ *
+ * @param upool pointer to upool
+ * @return pointer to upump_pthread_pool_pump or NULL in case of allocation
+ * error
+ */
+static void *upump_pthread_pool_pump_alloc_inner(struct upool *upool)
+{
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_pool(upool);
+    struct upump_pthread_pool_pump *pump =
+        malloc(sizeof(struct upump_pthread_pool_pump));
+    if (unlikely(pump == NULL))
+        return NULL;
+    struct upump *upump = upump_pthread_pool_pump_to_upump(pump);
+    upump->mgr = upump_common_mgr_to_upump_mgr(common_mgr);
+    return pump;
+}
+
+/** @internal @This frees a upump_pthread_pool_pump.
+ *
+ * @param upool pointer to upool
+ * @param pump pointer to a upump_pthread_pool_pump structure to free
+ */
+static void upump_pthread_pool_pump_free_inner(struct upool *upool, void *pump)
+{
+    free(pump);
+}
+
+/** @This processes control commands on a pump.
+ *
+ * @param upump description structure of the pump
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_pthread_pool_control(struct upump *upump, int command,
+                                      va_list args)
+{
+    switch (command) {
+        case UPUMP_START:
+            upump_common_start(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_RESTART:
+            upump_common_restart(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_STOP:
+            upump_common_stop(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_FREE:
+            upump_pthread_pool_pump_free(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_GET_STATUS: {
+            int *status_p = va_arg(args, int *);
+            upump_common_get_status(upump, status_p);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_SET_STATUS: {
+            int status = va_arg(args, int);
+            upump_common_set_status(upump, status);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_ALLOC_BLOCKER: {
+            struct upump_blocker **p = va_arg(args, struct upump_blocker **);
+            *p = upump_common_blocker_alloc(upump);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_FREE_BLOCKER: {
+            struct upump_blocker *blocker =
+                va_arg(args, struct upump_blocker *);
+            upump_common_blocker_free(blocker);
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This waits until a domain is idle.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @return an error code
+ */
+static int upump_pthread_pool_mgr_run(struct upump_mgr *mgr)
+{
+    struct upump_pthread_pool_mgr *domain =
+        upump_pthread_pool_mgr_from_upump_mgr(mgr);
+    struct upump_pthread_pool *pool = domain->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    while (domain->nb_blocking || domain->running ||
+           !ulist_empty(&domain->ready))
+        pthread_cond_wait(&pool->idle_cond, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+    return UBASE_ERR_NONE;
+}
+
+/** @This processes control commands on a domain.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_pthread_pool_mgr_control(struct upump_mgr *mgr,
+                                          int command, va_list args)
+{
+    switch (command) {
+        case UPUMP_MGR_RUN:
+            return upump_pthread_pool_mgr_run(mgr);
+        case UPUMP_MGR_VACUUM:
+            upump_common_mgr_vacuum(mgr);
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a domain.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void upump_pthread_pool_mgr_free(struct urefcount *urefcount)
+{
+    struct upump_pthread_pool_mgr *domain =
+        upump_pthread_pool_mgr_from_urefcount(urefcount);
+    upump_common_mgr_clean(upump_pthread_pool_mgr_to_upump_mgr(domain));
+    umutex_release(domain->mutex);
+    urefcount_clean(urefcount);
+    free(domain);
+}
+
+/** @This allocates a domain of a pool, that is a upump manager whose pumps
+ * are dispatched by the workers of the pool.
+ *
+ * @param pool pointer to pool
+ * @param mutex mutual exclusion primitives held by the workers while they
+ * dispatch the pumps of the domain, or NULL
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @return pointer to the wrapped upump_mgr structure, or NULL in case of error
+ */
+struct upump_mgr *upump_pthread_pool_mgr_alloc(struct upump_pthread_pool *pool,
+        struct umutex *mutex, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth)
+{
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    struct upump_pthread_pool_mgr *domain =
+        malloc(sizeof(struct upump_pthread_pool_mgr) +
+               upump_common_mgr_sizeof(upump_pool_depth,
+                                       upump_blocker_pool_depth));
+    if (unlikely(domain == NULL))
+        return NULL;
+
+    struct upump_mgr *mgr = upump_pthread_pool_mgr_to_upump_mgr(domain);
+    mgr->signature = UPUMP_PTHREAD_POOL_SIGNATURE;
+    urefcount_init(upump_pthread_pool_mgr_to_urefcount(domain),
+                   upump_pthread_pool_mgr_free);
+    domain->common_mgr.mgr.refcount =
+        upump_pthread_pool_mgr_to_urefcount(domain);
+    domain->common_mgr.mgr.upump_alloc = upump_pthread_pool_pump_alloc;
+    domain->common_mgr.mgr.upump_control = upump_pthread_pool_control;
+    domain->common_mgr.mgr.upump_mgr_control = upump_pthread_pool_mgr_control;
+    upump_common_mgr_init(mgr, upump_pool_depth, upump_blocker_pool_depth,
+                          domain->upool_extra,
+                          upump_pthread_pool_real_start,
+                          upump_pthread_pool_real_stop,
+                          upump_pthread_pool_real_restart,
+                          upump_pthread_pool_pump_alloc_inner,
+                          upump_pthread_pool_pump_free_inner);
+
+    domain->pool = pool;
+    domain->mutex = umutex_use(mutex);
+    uchain_init(&domain->uchain);
+    domain->queued = false;
+    domain->running = false;
+    ulist_init(&domain->ready);
+    ulist_init(&domain->idlers);
+    domain->current = NULL;
+    domain->nb_blocking = 0;
+
+    /* spread the domains, work stealing does the rest */
+    pthread_mutex_lock(&pool->lock);
+    domain->worker = pool->next_worker++ % pool->nb_workers;
+    pthread_mutex_unlock(&pool->lock);
+    return mgr;
+}
+
+/** @This returns the statistics of a pool.
+ *
+ * @param pool pointer to pool
+ * @param stats filled in with the statistics
+ */
+void upump_pthread_pool_get_stats(struct upump_pthread_pool *pool,
+                                  struct upump_pthread_pool_stats *stats)
+{
+    pthread_mutex_lock(&pool->lock);
+    *stats = pool->stats;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/** @internal @This stops the worker threads and frees a pool.
+ *
+ * @param pool pointer to pool
+ * @param nb_started number of worker threads to join
+ */
+static void upump_pthread_pool_clean(struct upump_pthread_pool *pool,
+                                     unsigned int nb_started)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->exit = true;
+    pthread_cond_broadcast(&pool->cond);
+    ueventfd_write(&pool->event);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (unsigned int i = 0; i < nb_started; i++)
+        pthread_join(pool->workers[i].thread, NULL);
+    for (unsigned int i = 0; i < pool->nb_workers; i++)
+        pthread_mutex_destroy(&pool->workers[i].lock);
+
+    uheap_clean(&pool->timers);
+    free(pool->pollfds);
+    ueventfd_clean(&pool->event);
+    uatomic_clean(&pool->nb_queued);
+    pthread_cond_destroy(&pool->idle_cond);
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+/** @This stops the worker threads and frees a pool. All domains must have
+ * been released, and it must not be called from a worker thread.
+ *
+ * @param pool pointer to pool
+ */
+void upump_pthread_pool_free(struct upump_pthread_pool *pool)
+{
+    if (pool == NULL)
+        return;
+    upump_pthread_pool_clean(pool, pool->nb_workers);
+}
+
+/** @This allocates a pool and starts its worker threads.
+ *
+ * @param nb_workers number of worker threads
+ * @param attr pthread attributes of the workers, or NULL
+ * @return pointer to pool, or NULL in case of error
+ */
+struct upump_pthread_pool *upump_pthread_pool_alloc(unsigned int nb_workers,
+        const pthread_attr_t *restrict attr)
+{
+    if (unlikely(!nb_workers))
+        return NULL;
+
+    struct upump_pthread_pool *pool =
+        malloc(sizeof(struct upump_pthread_pool) +
+               nb_workers * sizeof(struct upump_pthread_pool_worker));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    pool->pollfds = malloc(sizeof(struct pollfd));
+    if (unlikely(pool->pollfds == NULL ||
+                 !ueventfd_init(&pool->event, false))) {
+        free(pool->pollfds);
+        free(pool);
+        return NULL;
+    }
+    pool->pollfds_size = 1;
+    pool->nb_pollfds = 1;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    pthread_cond_init(&pool->idle_cond, NULL);
+    pool->polling = false;
+    pool->exit = false;
+    pool->nb_waiting = 0;
+    uatomic_init(&pool->nb_queued, 0);
+    pool->last_poll = 0;
+    uheap_init(&pool->timers);
+    ulist_init(&pool->fds);
+    pool->nb_fds = 0;
+    pool->fds_changed = false;
+    pool->stats.runs = pool->stats.steals = 0;
+    pool->next_worker = 0;
+    pool->nb_workers = nb_workers;
+
+    for (unsigned int i = 0; i < nb_workers; i++) {
+        struct upump_pthread_pool_worker *worker = &pool->workers[i];
+        worker->pool = pool;
+        pthread_mutex_init(&worker->lock, NULL);
+        ulist_init(&worker->queue);
+    }
+    for (unsigned int i = 0; i < nb_workers; i++) {
+        if (unlikely(pthread_create(&pool->workers[i].thread, attr,
+                                    upump_pthread_pool_worker,
+                                    &pool->workers[i]) != 0)) {
+            upump_pthread_pool_clean(pool, i);
+            return NULL;
+        }
+    }
+    return pool;
+}
@@ -57,6 +57,9 @@
 #include <assert.h>
 
 #include <libavutil/opt.h>
+#include <libavutil/frame.h>
+#include <libavutil/buffer.h>
+#include <libavutil/pixdesc.h>
 #include <libswscale/swscale.h>
 
 /** @hidden */
@@ -65,6 +68,24 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
 /** @hidden */
 static int upipe_sws_check(struct upipe *upipe, struct uref *flow_format);
 
+/** true if libswscale can render output slices of a full-frame context in
+ * parallel */
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 4, 100)
+# define UPIPE_SWS_THREADS
+#endif
+
+/** @This describes the picture sizes a swscale context was set up for. */
+struct upipe_sws_ctx_size {
+    /** input horizontal size */
+    size_t input_hsize;
+    /** input vertical size of the frame or field */
+    size_t input_vsize;
+    /** output horizontal size */
+    size_t output_hsize;
+    /** output vertical size of the frame or field */
+    size_t output_vsize;
+};
+
 /** upipe_sws structure with swscale parameters */
 struct upipe_sws {
     /** refcount management structure */
@@ -101,8 +122,12 @@ struct upipe_sws {
 
     /** swscale flags */
     int flags;
+    /** number of slice threads of the swscale contexts */
+    unsigned int nb_threads;
     /** swscale image conversion context [0] for progressive, [1,2] interlaced */
     struct SwsContext *convert_ctx[3];
+    /** picture sizes of the swscale contexts */
+    struct upipe_sws_ctx_size ctx_size[3];
     /** input pixel format */
     enum AVPixelFormat input_pix_fmt;
     /** requested output pixel format */
@@ -163,6 +188,214 @@ static int upipe_sws_convert_color(struct upipe *upipe, struct uref *flow_def)
     return colorspace;
 }
 
+/** @internal @This returns the vertical size of a frame or field. The top
+ * field gets the extra line of pictures with an odd vertical size.
+ *
+ * @param vsize vertical size of the frame
+ * @param field 0 for progressive, 1 or 2 for interlaced
+ * @return vertical size of the frame or field
+ */
+static inline size_t upipe_sws_field_vsize(size_t vsize, int field)
+{
+    switch (field) {
+        case 1: return (vsize + 1) / 2;
+        case 2: return vsize / 2;
+        default: return vsize;
+    }
+}
+
+/** @internal @This frees the swscale contexts, so that they are set up again
+ * with the current parameters on the next picture.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_sws_clean_ctx(struct upipe *upipe)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    for (int i = 0; i < 3; i++) {
+        if (likely(upipe_sws->convert_ctx[i]))
+            sws_freeContext(upipe_sws->convert_ctx[i]);
+        upipe_sws->convert_ctx[i] = NULL;
+    }
+}
+
+/** @internal @This sets up the swscale context of a frame or field for the
+ * given sizes, and applies the color space parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param field 0 for progressive, 1 or 2 for interlaced
+ * @param input_hsize input horizontal size
+ * @param input_vsize input vertical size of the frame or field
+ * @param output_hsize output horizontal size
+ * @param output_vsize output vertical size of the frame or field
+ * @return false if the context could not be allocated
+ */
+static bool upipe_sws_setup_ctx(struct upipe *upipe, int field,
+                                size_t input_hsize, size_t input_vsize,
+                                size_t output_hsize, size_t output_vsize)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    struct upipe_sws_ctx_size *size = &upipe_sws->ctx_size[field];
+    struct SwsContext *convert_ctx = upipe_sws->convert_ctx[field];
+    if (convert_ctx == NULL ||
+        size->input_hsize != input_hsize || size->input_vsize != input_vsize ||
+        size->output_hsize != output_hsize ||
+        size->output_vsize != output_vsize) {
+        sws_freeContext(convert_ctx);
+        upipe_sws->convert_ctx[field] = convert_ctx = sws_alloc_context();
+        if (unlikely(convert_ctx == NULL)) {
+            upipe_err(upipe, "sws_alloc_context failed");
+            return false;
+        }
+
+        av_opt_set_int(convert_ctx, "srcw", input_hsize, 0);
+        av_opt_set_int(convert_ctx, "srch", input_vsize, 0);
+        av_opt_set_int(convert_ctx, "src_format", upipe_sws->input_pix_fmt, 0);
+        av_opt_set_int(convert_ctx, "dstw", output_hsize, 0);
+        av_opt_set_int(convert_ctx, "dsth", output_vsize, 0);
+        av_opt_set_int(convert_ctx, "dst_format", upipe_sws->output_pix_fmt,
+                       0);
+        av_opt_set_int(convert_ctx, "sws_flags", upipe_sws->flags, 0);
+#ifdef UPIPE_SWS_THREADS
+        av_opt_set_int(convert_ctx, "threads", upipe_sws->nb_threads, 0);
+#endif
+
+        static const int chr_pos[3] = { 128, 64, 192 };
+        if (upipe_sws->input_pix_fmt == AV_PIX_FMT_YUV420P)
+            av_opt_set_int(convert_ctx, "src_v_chr_pos", chr_pos[field], 0);
+        if (upipe_sws->output_pix_fmt == AV_PIX_FMT_YUV420P)
+            av_opt_set_int(convert_ctx, "dst_v_chr_pos", chr_pos[field], 0);
+
+        if (unlikely(sws_init_context(convert_ctx, NULL, NULL) < 0)) {
+            upipe_err(upipe, "sws_init_context failed");
+            sws_freeContext(convert_ctx);
+            upipe_sws->convert_ctx[field] = NULL;
+            return false;
+        }
+        size->input_hsize = input_hsize;
+        size->input_vsize = input_vsize;
+        size->output_hsize = output_hsize;
+        size->output_vsize = output_vsize;
+    }
+
+    if (upipe_sws->colorspace_invalid)
+        return true;
+
+    int in_full, out_full, brightness, contrast, saturation;
+    const int *inv_table, *table;
+
+    if (unlikely(sws_getColorspaceDetails(convert_ctx,
+                    (int **)&inv_table, &in_full, (int **)&table, &out_full,
+                    &brightness, &contrast, &saturation) < 0)) {
+        upipe_warn(upipe, "unable to set color space data");
+        upipe_sws->colorspace_invalid = true;
+        return true;
+    }
+
+    if (upipe_sws->input_colorspace != -1)
+        inv_table = sws_getCoefficients(upipe_sws->input_colorspace);
+    if (upipe_sws->input_color_range != -1)
+        in_full = upipe_sws->input_color_range;
+    if (upipe_sws->output_colorspace != -1)
+        table = sws_getCoefficients(upipe_sws->output_colorspace);
+    if (upipe_sws->output_color_range != -1)
+        out_full = upipe_sws->output_color_range;
+
+    if (unlikely(sws_setColorspaceDetails(convert_ctx,
+                    inv_table, in_full, table, out_full,
+                    brightness, contrast, saturation) < 0)) {
+        upipe_warn(upipe, "unable to set color space data");
+        upipe_sws->colorspace_invalid = true;
+    }
+    return true;
+}
+
+#ifdef UPIPE_SWS_THREADS
+/** @internal @This is called when the last reference to a wrapped plane is
+ * released. The plane belongs to the ubuf, so there is nothing to do.
+ *
+ * @param opaque unused
+ * @param data unused
+ */
+static void upipe_sws_buffer_free(void *opaque, uint8_t *data)
+{
+}
+
+/** @internal @This describes mapped planes in a frame, without copying.
+ *
+ * @param frame frame to fill in
+ * @param pix_fmt pixel format
+ * @param hsize horizontal size
+ * @param vsize vertical size of the frame or field
+ * @param planes mapped planes
+ * @param strides strides of the planes
+ * @return false in case of allocation error
+ */
+static bool upipe_sws_wrap_frame(AVFrame *frame, enum AVPixelFormat pix_fmt,
+                                 size_t hsize, size_t vsize,
+                                 uint8_t *const *planes, const int *strides)
+{
+    frame->format = pix_fmt;
+    frame->width = hsize;
+    frame->height = vsize;
+    for (int i = 0; i < UPIPE_AV_MAX_PLANES && planes[i] != NULL; i++) {
+        frame->data[i] = planes[i];
+        frame->linesize[i] = strides[i];
+    }
+    /* sws_scale_frame() takes references to the frames */
+    frame->buf[0] = av_buffer_create(planes[0], 0, upipe_sws_buffer_free,
+                                     NULL, 0);
+    return frame->buf[0] != NULL;
+}
+#endif
+
+/** @internal @This converts a frame or field. With several slice threads,
+ * the context renders horizontal slices of the output in parallel, each
+ * slice reading the whole input, so the result is the same as with a
+ * single thread.
+ *
+ * @param upipe description structure of the pipe
+ * @param field 0 for progressive, 1 or 2 for interlaced
+ * @param input_planes mapped input planes of the frame or field
+ * @param input_strides strides of the input planes
+ * @param output_planes mapped output planes of the frame or field
+ * @param output_strides strides of the output planes
+ * @return false if the conversion failed
+ */
+static bool upipe_sws_scale(struct upipe *upipe, int field,
+                            const uint8_t *const *input_planes,
+                            const int *input_strides,
+                            uint8_t *const *output_planes,
+                            const int *output_strides)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    struct SwsContext *convert_ctx = upipe_sws->convert_ctx[field];
+    const struct upipe_sws_ctx_size *size = &upipe_sws->ctx_size[field];
+
+#ifdef UPIPE_SWS_THREADS
+    if (upipe_sws->nb_threads > 1) {
+        AVFrame *src = av_frame_alloc();
+        AVFrame *dst = av_frame_alloc();
+        bool ret = src != NULL && dst != NULL &&
+            upipe_sws_wrap_frame(src, upipe_sws->input_pix_fmt,
+                                 size->input_hsize, size->input_vsize,
+                                 (uint8_t *const *)input_planes,
+                                 input_strides) &&
+            upipe_sws_wrap_frame(dst, upipe_sws->output_pix_fmt,
+                                 size->output_hsize, size->output_vsize,
+                                 output_planes, output_strides) &&
+            sws_scale_frame(convert_ctx, dst, src) >= 0;
+        av_frame_free(&src);
+        av_frame_free(&dst);
+        return ret;
+    }
+#endif
+
+    return sws_scale(convert_ctx, input_planes, input_strides,
+                     0, size->input_vsize,
+                     output_planes, output_strides) > 0;
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -195,12 +428,6 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
         return true;
     }
 
-    int progressive = ubase_check(uref_pic_get_progressive(uref)) ? 1 : 0;
-    if (unlikely(!progressive && input_vsize % 2)) {
-        upipe_warn(upipe, "interlaced picture has odd vertical size");
-        progressive = 1;
-    }
-
     uint64_t output_hsize, output_vsize;
     if (!ubase_check(uref_pic_flow_get_hsize(upipe_sws->flow_def_attr, &output_hsize)) ||
         !ubase_check(uref_pic_flow_get_vsize(upipe_sws->flow_def_attr, &output_vsize))) {
@@ -209,48 +436,20 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
         output_vsize = input_vsize;
     }
 
+    int progressive = ubase_check(uref_pic_get_progressive(uref)) ? 1 : 0;
+    if (unlikely(!progressive && (input_vsize < 2 || output_vsize < 2))) {
+        upipe_warn(upipe, "interlaced picture is too small");
+        progressive = 1;
+    }
+
     int i;
-    for (i = 0; i < 3; i++) {
-        upipe_sws->convert_ctx[i] = sws_getCachedContext(upipe_sws->convert_ctx[i],
-                    input_hsize, input_vsize >> !!i, upipe_sws->input_pix_fmt,
-                    output_hsize, output_vsize >> !!i, upipe_sws->output_pix_fmt,
-                    upipe_sws->flags, NULL, NULL, NULL);
-
-        if (unlikely(upipe_sws->convert_ctx[i] == NULL)) {
-            upipe_err(upipe, "sws_getContext failed");
+    for (i = progressive ? 0 : 1; i < (progressive ? 1 : 3); i++) {
+        if (unlikely(!upipe_sws_setup_ctx(upipe, i, input_hsize,
+                        upipe_sws_field_vsize(input_vsize, i), output_hsize,
+                        upipe_sws_field_vsize(output_vsize, i)))) {
             uref_free(uref);
             return true;
         }
-
-        if (upipe_sws->colorspace_invalid)
-            continue;
-
-        int in_full, out_full, brightness, contrast, saturation;
-        const int *inv_table, *table;
-
-        if (unlikely(sws_getColorspaceDetails(upipe_sws->convert_ctx[i],
-                        (int **)&inv_table, &in_full, (int **)&table, &out_full,
-                        &brightness, &contrast, &saturation) < 0)) {
-            upipe_warn(upipe, "unable to set color space data");
-            upipe_sws->colorspace_invalid = true;
-            continue;
-        }
-
-        if (upipe_sws->input_colorspace != -1)
-            inv_table = sws_getCoefficients(upipe_sws->input_colorspace);
-        if (upipe_sws->input_color_range != -1)
-            in_full = upipe_sws->input_color_range;
-        if (upipe_sws->output_colorspace != -1)
-            table = sws_getCoefficients(upipe_sws->output_colorspace);
-        if (upipe_sws->output_color_range != -1)
-            out_full = upipe_sws->output_color_range;
-
-        if (unlikely(sws_setColorspaceDetails(upipe_sws->convert_ctx[i],
-                        inv_table, in_full, table, out_full,
-                        brightness, contrast, saturation) < 0)) {
-            upipe_warn(upipe, "unable to set color space data");
-            upipe_sws->colorspace_invalid = true;
-        }
     }
 
     upipe_verbose_va(upipe, "%s -> %s",
@@ -279,7 +478,7 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
         upipe_verbose_va(upipe, "input_stride[%d] %d",
                          i, input_strides[i]);
     }
-    for ( ; i < UPIPE_AV_MAX_PLANES; i++) {
+    for ( ; i <= UPIPE_AV_MAX_PLANES; i++) {
         input_planes[i] = NULL;
         input_strides[i] = 0;
     }
@@ -320,33 +519,27 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
         upipe_verbose_va(upipe, "output_stride[%d] %d",
                          i, output_strides[i]);
     }
-    for ( ; i < UPIPE_AV_MAX_PLANES; i++) {
+    for ( ; i <= UPIPE_AV_MAX_PLANES; i++) {
         output_planes[i] = NULL;
         output_strides[i] = 0;
     }
 
     /* fire ! */
-    int ret = 0, ret2 = 1;
+    bool ret;
     if (progressive) {
-        ret = sws_scale(upipe_sws->convert_ctx[0],
-                        input_planes, input_strides, 0, input_vsize,
-                        output_planes, output_strides);
-    }
-    else {
-        ret = sws_scale(upipe_sws->convert_ctx[1],
-                        input_planes, input_strides, 0, (input_vsize+1)/2,
-                        output_planes, output_strides);
-
-        for (i = 0; i < UPIPE_AV_MAX_PLANES && input_planes[i]; i++) {
-                input_planes[i] += input_strides[i] >> 1;
-        }
-        for (i = 0; i < UPIPE_AV_MAX_PLANES && output_planes[i]; i++) {
-                output_planes[i] += output_strides[i] >> 1;
-        }
-
-        ret2 = sws_scale(upipe_sws->convert_ctx[2],
-                         input_planes, input_strides, 0, input_vsize/2,
-                         output_planes, output_strides);
+        ret = upipe_sws_scale(upipe, 0, input_planes, input_strides,
+                              output_planes, output_strides);
+    } else {
+        ret = upipe_sws_scale(upipe, 1, input_planes, input_strides,
+                              output_planes, output_strides);
+
+        for (i = 0; i < UPIPE_AV_MAX_PLANES && input_planes[i]; i++)
+            input_planes[i] += input_strides[i] >> 1;
+        for (i = 0; i < UPIPE_AV_MAX_PLANES && output_planes[i]; i++)
+            output_planes[i] += output_strides[i] >> 1;
+
+        ret = upipe_sws_scale(upipe, 2, input_planes, input_strides,
+                              output_planes, output_strides) && ret;
     }
 
     /* unmap pictures */
@@ -360,7 +553,7 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
                              0, 0, -1, -1);
 
     /* clean and attach */
-    if (unlikely(ret <= 0) || unlikely(ret2 <= 0)) {
+    if (unlikely(!ret)) {
         upipe_warn(upipe, "error during sws conversion");
         ubuf_free(ubuf);
         uref_free(uref);
@@ -521,17 +714,7 @@ static int upipe_sws_set_flow_def(struct upipe *upipe, struct uref *flow_def)
         }
     }
 
-    if (upipe_sws->input_pix_fmt == AV_PIX_FMT_YUV420P) {
-        av_opt_set_int(upipe_sws->convert_ctx[0], "src_v_chr_pos", 128, 0);
-        av_opt_set_int(upipe_sws->convert_ctx[1], "src_v_chr_pos", 64, 0);
-        av_opt_set_int(upipe_sws->convert_ctx[2], "src_v_chr_pos", 192, 0);
-    }
-
-    if (upipe_sws->output_pix_fmt == AV_PIX_FMT_YUV420P) {
-        av_opt_set_int(upipe_sws->convert_ctx[0], "dst_v_chr_pos", 128, 0);
-        av_opt_set_int(upipe_sws->convert_ctx[1], "dst_v_chr_pos", 64, 0);
-        av_opt_set_int(upipe_sws->convert_ctx[2], "dst_v_chr_pos", 192, 0);
-    }
+    upipe_sws_clean_ctx(upipe);
     upipe_sws->colorspace_invalid = false;
 
     upipe_input(upipe, flow_def, NULL);
@@ -561,10 +744,52 @@ static int _upipe_sws_set_flags(struct upipe *upipe, int flags)
 {
     struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
     upipe_sws->flags = flags;
+    upipe_sws_clean_ctx(upipe);
     upipe_dbg_va(upipe, "setting flags to %d", flags);
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This gets the number of slice threads.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_threads_p filled in with the number of slice threads
+ * @return an error code
+ */
+static int _upipe_sws_get_threads(struct upipe *upipe,
+                                  unsigned int *nb_threads_p)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    *nb_threads_p = upipe_sws->nb_threads;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the number of slice threads.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_threads number of slice threads
+ * @return an error code
+ */
+static int _upipe_sws_set_threads(struct upipe *upipe,
+                                  unsigned int nb_threads)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    if (!nb_threads)
+        return UBASE_ERR_INVALID;
+#ifndef UPIPE_SWS_THREADS
+    if (nb_threads > 1) {
+        upipe_warn(upipe, "slice threads require libswscale >= 6.4.100");
+        return UBASE_ERR_UNHANDLED;
+    }
+#endif
+    if (nb_threads == upipe_sws->nb_threads)
+        return UBASE_ERR_NONE;
+
+    upipe_sws->nb_threads = nb_threads;
+    upipe_sws_clean_ctx(upipe);
+    upipe_dbg_va(upipe, "using %u slice threads", nb_threads);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -612,6 +837,16 @@ static int upipe_sws_control(struct upipe *upipe, int command, va_list args)
             int flags = va_arg(args, int);
             return _upipe_sws_set_flags(upipe, flags);
         }
+        case UPIPE_SWS_GET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_SIGNATURE)
+            unsigned int *nb_threads_p = va_arg(args, unsigned int *);
+            return _upipe_sws_get_threads(upipe, nb_threads_p);
+        }
+        case UPIPE_SWS_SET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_SIGNATURE)
+            unsigned int nb_threads = va_arg(args, unsigned int);
+            return _upipe_sws_set_threads(upipe, nb_threads);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -651,14 +886,9 @@ static struct upipe *upipe_sws_alloc(struct upipe_mgr *mgr,
     upipe_sws_init_flow_def(upipe);
     upipe_sws_init_input(upipe);
     upipe_sws->colorspace_invalid = false;
-
+    upipe_sws->input_pix_fmt = AV_PIX_FMT_NONE;
+    upipe_sws->nb_threads = 1;
     memset(upipe_sws->convert_ctx, 0, sizeof(upipe_sws->convert_ctx));
-    for (int i = 0; i < 3; i++) {
-        upipe_sws->convert_ctx[i] = sws_alloc_context();
-        if (!upipe_sws->convert_ctx[i])
-            goto fail;
-    }
-
     upipe_sws->flags = SWS_FULL_CHR_H_INP | SWS_ACCURATE_RND | SWS_LANCZOS;
 
     upipe_throw_ready(upipe);
@@ -670,16 +900,6 @@ static struct upipe *upipe_sws_alloc(struct upipe_mgr *mgr,
 
     upipe_sws_store_flow_def_attr(upipe, flow_def);
     return upipe;
-
-fail:
-    for (int i = 0; i < 3; i++) {
-        if (likely(upipe_sws->convert_ctx[i]))
-            sws_freeContext(upipe_sws->convert_ctx[i]);
-        upipe_sws->convert_ctx[i] = NULL;
-    }
-    uref_free(flow_def);
-    upipe_sws_free_flow(upipe);
-    return NULL;
 }
 
 /** @This frees a upipe.
@@ -688,12 +908,7 @@ fail:
  */
 static void upipe_sws_free(struct upipe *upipe)
 {
-    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
-    for (int i = 0; i < 3; i++) {
-        if (likely(upipe_sws->convert_ctx[i]))
-            sws_freeContext(upipe_sws->convert_ctx[i]);
-        upipe_sws->convert_ctx[i] = NULL;
-    }
+    upipe_sws_clean_ctx(upipe);
 
     upipe_throw_dead(upipe);
     upipe_sws_clean_input(upipe);
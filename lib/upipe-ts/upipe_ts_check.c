@@ -43,6 +43,7 @@
 #include <upipe/upipe_helper_void.h>
 #include <upipe/upipe_helper_output.h>
 #include <upipe/upipe_helper_output_size.h>
+#include <upipe-ts/uref_ts_flow.h>
 #include <upipe-ts/upipe_ts_check.h>
 
 #include <stdlib.h>
@@ -77,6 +78,8 @@ struct upipe_ts_check {
 
     /** TS packet size */
     size_t output_size;
+    /** maximum number of TS packets per output uref */
+    unsigned int vector;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -105,9 +108,11 @@ static struct upipe *upipe_ts_check_alloc(struct upipe_mgr *mgr,
     if (unlikely(upipe == NULL))
         return NULL;
 
+    struct upipe_ts_check *upipe_ts_check = upipe_ts_check_from_upipe(upipe);
     upipe_ts_check_init_urefcount(upipe);
     upipe_ts_check_init_output(upipe);
     upipe_ts_check_init_output_size(upipe, TS_SIZE);
+    upipe_ts_check->vector = 1;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -142,6 +147,68 @@ static bool upipe_ts_check_check(struct upipe *upipe, struct uref *uref,
     return true;
 }
 
+/** @internal @This checks the sync words of all TS packets in a buffer and
+ * outputs vectors of consecutive valid packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param size size of the buffer
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_check_input_vector(struct upipe *upipe, struct uref *uref,
+                                        size_t size, struct upump **upump_p)
+{
+    struct upipe_ts_check *upipe_ts_check = upipe_ts_check_from_upipe(upipe);
+    size_t output_size = upipe_ts_check->output_size;
+    size_t nb = size / output_size;
+    if (unlikely(!nb)) {
+        uref_free(uref);
+        return;
+    }
+    if (size % output_size)
+        uref_block_resize(uref, 0, nb * output_size);
+
+    unsigned int count = 0;
+    while (nb) {
+        uint8_t word;
+        if (unlikely(!ubase_check(uref_block_extract(uref,
+                            count * output_size, 1, &word)))) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        if (unlikely(word != TS_SYNC)) {
+            upipe_warn_va(upipe, "invalid TS sync 0x%"PRIx8, word);
+            break;
+        }
+
+        nb--;
+        if (++count < upipe_ts_check->vector && nb)
+            continue;
+
+        struct uref *next = NULL;
+        if (nb) {
+            next = uref_block_split(uref, count * output_size);
+            if (unlikely(next == NULL)) {
+                uref_free(uref);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return;
+            }
+        }
+        upipe_ts_check_output(upipe, uref, upump_p);
+        uref = next;
+        count = 0;
+    }
+
+    if (uref == NULL)
+        return;
+    /* output the valid packets preceding the lost sync, drop the rest */
+    if (count && ubase_check(uref_block_resize(uref, 0, count * output_size)))
+        upipe_ts_check_output(upipe, uref, upump_p);
+    else
+        uref_free(uref);
+}
+
 /** @internal @This tries to find TS packets in the buffered input urefs.
  *
  * @param upipe description structure of the pipe
@@ -159,6 +226,11 @@ static void upipe_ts_check_input(struct upipe *upipe, struct uref *uref,
         return;
     }
 
+    if (upipe_ts_check->vector > 1) {
+        upipe_ts_check_input_vector(upipe, uref, size, upump_p);
+        return;
+    }
+
     while (size > upipe_ts_check->output_size) {
         struct uref *next = uref_block_split(uref, upipe_ts_check->output_size);
         if (unlikely(next == NULL)) {
@@ -199,6 +271,56 @@ static int upipe_ts_check_set_flow_def(struct upipe *upipe,
     UBASE_RETURN(uref_block_flow_set_size(flow_def_dup,
                                           upipe_ts_check->output_size))
     UBASE_RETURN(uref_flow_set_def(flow_def_dup, OUTPUT_FLOW_DEF))
+    if (upipe_ts_check->vector > 1) {
+        UBASE_RETURN(uref_ts_flow_set_vector(flow_def_dup))
+    } else
+        uref_ts_flow_delete_vector(flow_def_dup);
+    upipe_ts_check_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the maximum number of TS packets per output uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector_p filled in with the number of packets
+ * @return an error code
+ */
+static int _upipe_ts_check_get_vector(struct upipe *upipe,
+                                      unsigned int *vector_p)
+{
+    struct upipe_ts_check *upipe_ts_check = upipe_ts_check_from_upipe(upipe);
+    assert(vector_p != NULL);
+    *vector_p = upipe_ts_check->vector;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the maximum number of TS packets per output uref,
+ * and updates the output flow definition accordingly.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector number of packets
+ * @return an error code
+ */
+static int _upipe_ts_check_set_vector(struct upipe *upipe, unsigned int vector)
+{
+    struct upipe_ts_check *upipe_ts_check = upipe_ts_check_from_upipe(upipe);
+    if (!vector)
+        return UBASE_ERR_INVALID;
+    if ((upipe_ts_check->vector > 1) == (vector > 1)) {
+        upipe_ts_check->vector = vector;
+        return UBASE_ERR_NONE;
+    }
+    upipe_ts_check->vector = vector;
+
+    if (upipe_ts_check->flow_def == NULL)
+        return UBASE_ERR_NONE;
+    struct uref *flow_def_dup = uref_dup(upipe_ts_check->flow_def);
+    if (unlikely(flow_def_dup == NULL))
+        return UBASE_ERR_ALLOC;
+    if (vector > 1) {
+        UBASE_RETURN(uref_ts_flow_set_vector(flow_def_dup))
+    } else
+        uref_ts_flow_delete_vector(flow_def_dup);
     upipe_ts_check_store_flow_def(upipe, flow_def_dup);
     return UBASE_ERR_NONE;
 }
@@ -221,6 +343,16 @@ static int upipe_ts_check_control(struct upipe *upipe,
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_ts_check_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_TS_CHECK_GET_VECTOR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_CHECK_SIGNATURE)
+            unsigned int *vector_p = va_arg(args, unsigned int *);
+            return _upipe_ts_check_get_vector(upipe, vector_p);
+        }
+        case UPIPE_TS_CHECK_SET_VECTOR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_CHECK_SIGNATURE)
+            unsigned int vector = va_arg(args, unsigned int);
+            return _upipe_ts_check_set_vector(upipe, vector);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -28,6 +28,7 @@
 #include <upipe/uref.h>
 #include <upipe/uref_flow.h>
 #include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
 #include <upipe/uref_clock.h>
 #include <upipe/ubuf.h>
 #include <upipe/uclock.h>
@@ -36,6 +37,7 @@
 #include <upipe/upipe_helper_urefcount.h>
 #include <upipe/upipe_helper_void.h>
 #include <upipe/upipe_helper_output.h>
+#include <upipe-ts/uref_ts_flow.h>
 #include <upipe-ts/upipe_ts_decaps.h>
 
 #include <stdlib.h>
@@ -46,7 +48,8 @@
 
 #include <bitstream/mpeg/ts.h>
 
-/** we only accept TS packets */
+/** we only accept TS packets, or vectors of TS packets if the flow
+ * definition has the t.vector attribute */
 #define EXPECTED_FLOW_DEF "block.mpegts."
 
 /** @internal @This is the private context of a ts_decaps pipe. */
@@ -71,6 +74,11 @@ struct upipe_ts_decaps {
     /** lost packets based on cc errors */
     uint64_t lost;
 
+    /** true if the input urefs carry vectors of TS packets */
+    bool vector;
+    /** size of a TS packet in input vectors */
+    size_t packet_size;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -103,6 +111,8 @@ static struct upipe *upipe_ts_decaps_alloc(struct upipe_mgr *mgr,
     upipe_ts_decaps->last_cc = -1;
     upipe_ts_decaps->lost = 0;
     upipe_ts_decaps->last_uref = NULL;
+    upipe_ts_decaps->vector = false;
+    upipe_ts_decaps->packet_size = TS_SIZE;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -113,8 +123,9 @@ static struct upipe *upipe_ts_decaps_alloc(struct upipe_mgr *mgr,
  * @param uref uref structure
  * @param upump_p reference to pump that generated the buffer
  */
-static void upipe_ts_decaps_input(struct upipe *upipe, struct uref *uref,
-                                  struct upump **upump_p)
+static void upipe_ts_decaps_input_packet(struct upipe *upipe,
+                                         struct uref *uref,
+                                         struct upump **upump_p)
 {
     struct upipe_ts_decaps *upipe_ts_decaps = upipe_ts_decaps_from_upipe(upipe);
     uint8_t buffer[TS_HEADER_SIZE];
@@ -234,6 +245,44 @@ static void upipe_ts_decaps_input(struct upipe *upipe, struct uref *uref,
     upipe_ts_decaps_output(upipe, uref, upump_p);
 }
 
+/** @internal @This decapsulates a TS packet, or each packet of a vector of
+ * TS packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_decaps_input(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
+{
+    struct upipe_ts_decaps *upipe_ts_decaps = upipe_ts_decaps_from_upipe(upipe);
+    if (!upipe_ts_decaps->vector) {
+        upipe_ts_decaps_input_packet(upipe, uref, upump_p);
+        return;
+    }
+
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    size_t packet_size = upipe_ts_decaps->packet_size;
+    upipe_use(upipe);
+    for (size_t offset = 0; offset + packet_size <= size;
+         offset += packet_size) {
+        struct uref *packet = uref_block_splice(uref, offset, packet_size);
+        if (unlikely(packet == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            break;
+        }
+        upipe_ts_decaps_input_packet(upipe, packet, upump_p);
+    }
+    uref_free(uref);
+    upipe_release(upipe);
+}
+
 /** @internal @This sets the input flow definition.
  *
  * @param upipe description structure of the pipe
@@ -257,6 +306,19 @@ static int upipe_ts_decaps_set_flow_def(struct upipe *upipe,
     if (unlikely(!ubase_check(uref_flow_set_def_va(flow_def_dup, "block.%s",
                                        def + strlen(EXPECTED_FLOW_DEF)))))
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+
+    struct upipe_ts_decaps *upipe_ts_decaps = upipe_ts_decaps_from_upipe(upipe);
+    upipe_ts_decaps->vector = ubase_check(uref_ts_flow_get_vector(flow_def));
+    if (upipe_ts_decaps->vector) {
+        uint64_t packet_size;
+        if (!ubase_check(uref_block_flow_get_size(flow_def, &packet_size)) ||
+            packet_size < TS_SIZE)
+            packet_size = TS_SIZE;
+        upipe_ts_decaps->packet_size = packet_size;
+        /* the output carries one payload per uref */
+        uref_ts_flow_delete_vector(flow_def_dup);
+        uref_block_flow_delete_size(flow_def_dup);
+    }
     upipe_ts_decaps_store_flow_def(upipe, flow_def_dup);
     return UBASE_ERR_NONE;
 }
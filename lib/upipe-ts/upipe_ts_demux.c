@@ -220,6 +220,8 @@ struct upipe_ts_demux {
     bool acquired;
     /** flow definition of the input */
     struct uref *flow_def_input;
+    /** maximum number of TS packets per uref before ts_split */
+    unsigned int vector;
 
     /** pointer to null inner pipe */
     struct upipe *null;
@@ -526,6 +528,24 @@ struct upipe_ts_demux_psi_pid {
 
 UBASE_FROM_TO(upipe_ts_demux_psi_pid, uchain, uchain, uchain)
 
+/** @internal @This marks the flow definition of a ts_split output as
+ * accepting vectors of TS packets when the demux works on vectors. Only
+ * outputs feeding ts_decaps may be marked.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition of the ts_split output
+ * @return an error code
+ */
+static int upipe_ts_demux_split_flow_def(struct upipe *upipe,
+                                         struct uref *flow_def)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    if (upipe_ts_demux->vector > 1)
+        return uref_ts_flow_set_vector(flow_def);
+    uref_ts_flow_delete_vector(flow_def);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This allocates and initializes a new PID-specific
  * substructure.
  *
@@ -573,7 +593,15 @@ static struct upipe_ts_demux_psi_pid *
         return NULL;
     }
 
-    uref_flow_set_def(flow_def, "block.mpegts.mpegtspsi.");
+    if (unlikely(!ubase_check(uref_flow_set_def(flow_def,
+                                          "block.mpegts.mpegtspsi.")) ||
+                 !ubase_check(upipe_ts_demux_split_flow_def(upipe,
+                                                            flow_def)))) {
+        uref_free(flow_def);
+        upipe_release(psi_pid->psi_split);
+        free(psi_pid);
+        return NULL;
+    }
     psi_pid->split_output =
         upipe_flow_alloc_sub(upipe_ts_demux->split,
                              uprobe_pfx_alloc_va(
@@ -653,6 +681,45 @@ static void
     }
 }
 
+/** @internal @This reallocates the ts_split outputs of the PSI PIDs after
+ * the vector mode of the demux has changed.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_demux_psi_pids_update(struct upipe *upipe)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach (&upipe_ts_demux->psi_pids, uchain) {
+        struct upipe_ts_demux_psi_pid *psi_pid =
+            upipe_ts_demux_psi_pid_from_uchain(uchain);
+        struct uref *flow_def;
+        if (unlikely(!ubase_check(upipe_get_flow_def(psi_pid->split_output,
+                                                     &flow_def)) ||
+                     (flow_def = uref_dup(flow_def)) == NULL ||
+                     !ubase_check(upipe_ts_demux_split_flow_def(upipe,
+                                                                flow_def)))) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+
+        struct upipe *split_output =
+            upipe_flow_alloc_sub(upipe_ts_demux->split,
+                                 uprobe_pfx_alloc_va(
+                                     uprobe_use(&upipe_ts_demux->psi_pid_plumber),
+                                     UPROBE_LOG_VERBOSE,
+                                     "split output %"PRIu16, psi_pid->pid),
+                                 flow_def);
+        uref_free(flow_def);
+        if (unlikely(split_output == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_release(psi_pid->split_output);
+        psi_pid->split_output = split_output;
+    }
+}
+
 
 /*
  * upipe_ts_demux_output structure handling (derived from upipe structure)
@@ -1010,15 +1077,25 @@ static struct upipe *upipe_ts_demux_output_alloc(struct upipe_mgr *mgr,
 
     struct upipe_ts_demux_mgr *ts_demux_mgr =
         upipe_ts_demux_mgr_from_upipe_mgr(upipe_ts_demux_to_upipe(demux)->mgr);
+    struct uref *split_flow_def = uref_dup(flow_def);
+    if (unlikely(split_flow_def == NULL ||
+                 !ubase_check(upipe_ts_demux_split_flow_def(
+                         upipe_ts_demux_to_upipe(demux), split_flow_def)))) {
+        uref_free(split_flow_def);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return upipe;
+    }
     /* set up split_output and set rap inner pipes */
-    if (unlikely((upipe_ts_demux_output->split_output =
-                    upipe_flow_alloc_sub(
-                        demux->split,
-                        uprobe_pfx_alloc_va(
-                            uprobe_use(&upipe_ts_demux_output->probe),
-                            UPROBE_LOG_VERBOSE,
-                            "split output %"PRIu64, upipe_ts_demux_output->pid),
-                        flow_def)) == NULL ||
+    upipe_ts_demux_output->split_output =
+        upipe_flow_alloc_sub(demux->split,
+                             uprobe_pfx_alloc_va(
+                                 uprobe_use(&upipe_ts_demux_output->probe),
+                                 UPROBE_LOG_VERBOSE,
+                                 "split output %"PRIu64,
+                                 upipe_ts_demux_output->pid),
+                             split_flow_def);
+    uref_free(split_flow_def);
+    if (unlikely(upipe_ts_demux_output->split_output == NULL ||
                  (upipe_ts_demux_output->setrap =
                     upipe_void_alloc_output(upipe_ts_demux_output->split_output,
                                ts_demux_mgr->setrap_mgr,
@@ -1066,6 +1143,22 @@ static bool upipe_ts_demux_output_pmtd_update(struct upipe *upipe,
             return false;
         }
 
+        /* keep the packet layout of the ts_split output */
+        struct uref *split_flow_def;
+        uint64_t packet_size;
+        if (ubase_check(upipe_get_flow_def(upipe_ts_demux_output->split_output,
+                                           &split_flow_def)) &&
+            ubase_check(uref_ts_flow_get_vector(split_flow_def))) {
+            if (unlikely(!ubase_check(uref_ts_flow_set_vector(flow_def)))) {
+                uref_free(flow_def);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return false;
+            }
+            if (ubase_check(uref_block_flow_get_size(split_flow_def,
+                                                     &packet_size)))
+                uref_block_flow_set_size(flow_def, packet_size);
+        }
+
         upipe_set_flow_def(upipe_ts_demux_output->setrap, flow_def);
         uref_free(flow_def);
         return true;
@@ -3197,6 +3290,7 @@ static struct upipe *upipe_ts_demux_alloc(struct upipe_mgr *mgr,
     upipe_ts_demux->auto_conformance = true;
     upipe_ts_demux->nit_pid = 0;
     upipe_ts_demux->flow_def_input = NULL;
+    upipe_ts_demux->vector = 1;
 
     uprobe_init(&upipe_ts_demux->psi_pid_plumber,
                 upipe_ts_demux_psi_pid_plumber, NULL);
@@ -3362,7 +3456,8 @@ static int upipe_ts_demux_set_flow_def(struct upipe *upipe,
         upipe_ts_demux_mgr_from_upipe_mgr(upipe->mgr);
     struct upipe *input;
     if (ubase_ncmp(def, EXPECTED_FLOW_DEF_SYNC)) {
-        if (!ubase_ncmp(def, EXPECTED_FLOW_DEF_CHECK))
+        bool check = !ubase_ncmp(def, EXPECTED_FLOW_DEF_CHECK);
+        if (check)
             /* allocate ts_check inner pipe */
             input = upipe_void_alloc(ts_demux_mgr->ts_check_mgr,
                      uprobe_pfx_alloc(
@@ -3378,6 +3473,12 @@ static int upipe_ts_demux_set_flow_def(struct upipe *upipe,
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             return UBASE_ERR_ALLOC;
         }
+        if (upipe_ts_demux->vector > 1) {
+            if (check)
+                upipe_ts_check_set_vector(input, upipe_ts_demux->vector);
+            else
+                upipe_ts_sync_set_vector(input, upipe_ts_demux->vector);
+        }
         upipe_ts_demux_store_bin_input(upipe, input);
         upipe_set_output(input, upipe_ts_demux->setrap);
 
@@ -3390,6 +3491,37 @@ static int upipe_ts_demux_set_flow_def(struct upipe *upipe,
     return upipe_set_flow_def(upipe_ts_demux->input, flow_def);
 }
 
+/** @internal @This sets the maximum number of TS packets per uref between
+ * the ts_sync or ts_check inner pipe and ts_split, and forwards it to the
+ * inner pipe if it already exists.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector number of packets (1 to disable)
+ * @return an error code
+ */
+static int _upipe_ts_demux_set_vector(struct upipe *upipe, unsigned int vector)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    struct upipe_ts_demux_mgr *ts_demux_mgr =
+        upipe_ts_demux_mgr_from_upipe_mgr(upipe->mgr);
+    if (!vector)
+        return UBASE_ERR_INVALID;
+    bool changed = (upipe_ts_demux->vector > 1) != (vector > 1);
+    upipe_ts_demux->vector = vector;
+    if (changed)
+        upipe_ts_demux_psi_pids_update(upipe);
+
+    struct upipe *input = upipe_ts_demux->input;
+    if (input == NULL)
+        return UBASE_ERR_NONE;
+    if (input->mgr == ts_demux_mgr->ts_check_mgr)
+        return upipe_ts_check_set_vector(input, vector);
+    if (input->mgr == ts_demux_mgr->ts_sync_mgr)
+        return upipe_ts_sync_set_vector(input, vector);
+    /* already synchronized input goes straight to setrap */
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This iterates over flow definition.
  *
  * @param upipe description structure of the pipe
@@ -3521,6 +3653,11 @@ static int upipe_ts_demux_control(struct upipe *upipe,
 #endif
             return UBASE_ERR_NONE;
         }
+        case UPIPE_TS_DEMUX_SET_VECTOR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_DEMUX_SIGNATURE)
+            unsigned int vector = va_arg(args, unsigned int);
+            return _upipe_ts_demux_set_vector(upipe, vector);
+        }
 
         default:
             break;
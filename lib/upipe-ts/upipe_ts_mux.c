@@ -38,6 +38,7 @@
 
 #include <upipe/ubase.h>
 #include <upipe/ulist.h>
+#include <upipe/uheap.h>
 #include <upipe/uprobe.h>
 #include <upipe/uprobe_prefix.h>
 #include <upipe/uref.h>
@@ -150,6 +151,12 @@
 #define DEFAULT_PCR_INTERVAL (UCLOCK_FREQ / 15)
 /** default interval between SCTE-35 tables */
 #define DEFAULT_SCTE35_INTERVAL (UCLOCK_FREQ)
+/** default interval between redistributions of octetrates in statmux mode */
+#define DEFAULT_STATMUX_INTERVAL (UCLOCK_FREQ)
+/** number of buffer fullness samples per statmux interval */
+#define STATMUX_SAMPLES 8
+/** weight of a full buffer relatively to an empty buffer, minus 1 */
+#define STATMUX_WEIGHT 3
 /** default interval between PATs and PMTs in ISO conformance */
 #define DEFAULT_PSI_INTERVAL_ISO (UCLOCK_FREQ / 4)
 /** max interval between PATs and PMTs, in DVB and ISDB conformance */
@@ -306,6 +313,12 @@ struct upipe_ts_mux {
     uint64_t eit_interval;
     /** interval between TDTs */
     uint64_t tdt_interval;
+    /** interval between redistributions of octetrates in statmux mode */
+    uint64_t statmux_interval;
+    /** date of the next buffer fullness sample in statmux mode */
+    uint64_t statmux_next;
+    /** number of buffer fullness samples in the current statmux interval */
+    unsigned int statmux_samples;
     /** default maximum retention delay */
     uint64_t max_delay;
     /** muxing delay */
@@ -349,6 +362,12 @@ struct upipe_ts_mux {
     struct uchain psi_pids_splice;
     /** list of inputs that are actually PSI */
     struct uchain psi_inputs;
+    /** heap of inputs ordered by cr_sys of their next packet */
+    struct uheap splice_cr;
+    /** heap of inputs ordered by dts_sys of their next packet */
+    struct uheap splice_dts;
+    /** heap of inputs ordered by cr_sys of their next PCR */
+    struct uheap splice_pcr;
     /** max latency of the subpipes */
     uint64_t latency;
     /** date of the current uref (system time, latency taken into account) */
@@ -530,6 +549,10 @@ struct upipe_ts_mux_input {
     bool pcr;
     /** calculated required octetrate including overheads */
     uint64_t required_octetrate;
+    /** octetrate assigned by the statmux, or 0 */
+    uint64_t statmux_octetrate;
+    /** sum of buffer fullness samples (per mille) in the statmux interval */
+    uint64_t statmux_fullness;
 
     /** proxy probe */
     struct uprobe probe;
@@ -553,6 +576,12 @@ struct upipe_ts_mux_input {
     uint64_t pcr_sys;
     /** true if the input is ready to output packet */
     bool ready;
+    /** node in the heap of the mux ordered by cr_sys */
+    struct uheap_node heap_cr;
+    /** node in the heap of the mux ordered by dts_sys */
+    struct uheap_node heap_dts;
+    /** node in the heap of the mux ordered by pcr_sys */
+    struct uheap_node heap_pcr;
 
     /** psi_pid structure for PSI-based elementary streams */
     struct upipe_ts_mux_psi_pid *psi_pid;
@@ -581,6 +610,9 @@ UPIPE_HELPER_BIN_INPUT(upipe_ts_mux_input, input, input_request_list)
 
 UBASE_FROM_TO(upipe_ts_mux_input, urefcount, urefcount_real, urefcount_real)
 UBASE_FROM_TO(upipe_ts_mux_input, uchain, uchain_psi, uchain_psi)
+UBASE_FROM_TO(upipe_ts_mux_input, uheap_node, heap_cr, heap_cr)
+UBASE_FROM_TO(upipe_ts_mux_input, uheap_node, heap_dts, heap_dts)
+UBASE_FROM_TO(upipe_ts_mux_input, uheap_node, heap_pcr, heap_pcr)
 
 UPIPE_HELPER_SUBPIPE(upipe_ts_mux_program, upipe_ts_mux_input, input,
                      input_mgr, inputs, uchain)
@@ -918,6 +950,45 @@ static int upipe_ts_mux_input_probe(struct uprobe *uprobe, struct upipe *inner,
     return upipe_throw_proxy(upipe, inner, event, args);
 }
 
+/** @internal @This sets the key of an input in a splice heap of the mux.
+ *
+ * @param upipe description structure of the input
+ * @param uheap pointer to the splice heap
+ * @param node pointer to the heap node of the input
+ * @param key new key, or UINT64_MAX to remove the input from the heap
+ */
+static void upipe_ts_mux_input_heap_update(struct upipe *upipe,
+                                           struct uheap *uheap,
+                                           struct uheap_node *node,
+                                           uint64_t key)
+{
+    if (key == UINT64_MAX)
+        uheap_delete(uheap, node);
+    else if (unlikely(!ubase_check(uheap_update(uheap, node, key))))
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+}
+
+/** @internal @This updates the position of an input in the splice heaps of
+ * the mux, after its dates have changed.
+ *
+ * @param upipe description structure of the input
+ */
+static void upipe_ts_mux_input_schedule(struct upipe *upipe)
+{
+    struct upipe_ts_mux_input *input = upipe_ts_mux_input_from_upipe(upipe);
+    struct upipe_ts_mux_program *program =
+        upipe_ts_mux_program_from_input_mgr(upipe->mgr);
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_program_mgr(
+                upipe_ts_mux_program_to_upipe(program)->mgr);
+
+    upipe_ts_mux_input_heap_update(upipe, &mux->splice_cr,
+                                   &input->heap_cr, input->cr_sys);
+    upipe_ts_mux_input_heap_update(upipe, &mux->splice_dts,
+                                   &input->heap_dts, input->dts_sys);
+    upipe_ts_mux_input_heap_update(upipe, &mux->splice_pcr,
+                                   &input->heap_pcr, input->pcr_sys);
+}
+
 /** @internal @This catches the events from encaps inner pipes.
  *
  * @param uprobe pointer to the probe in upipe_ts_mux_input
@@ -945,6 +1016,7 @@ static int upipe_ts_mux_input_encaps_probe(struct uprobe *uprobe,
     upipe_ts_mux_input->dts_sys = va_arg(args, uint64_t);
     upipe_ts_mux_input->pcr_sys = va_arg(args, uint64_t);
     upipe_ts_mux_input->ready = !!va_arg(args, int);
+    upipe_ts_mux_input_schedule(upipe);
     return UBASE_ERR_NONE;
 }
 
@@ -985,12 +1057,17 @@ static struct upipe *upipe_ts_mux_input_alloc(struct upipe_mgr *mgr,
     upipe_ts_mux_input->octetrate = 0;
     upipe_ts_mux_input->buffer_duration = 0;
     upipe_ts_mux_input->required_octetrate = 0;
+    upipe_ts_mux_input->statmux_octetrate = 0;
+    upipe_ts_mux_input->statmux_fullness = 0;
     upipe_ts_mux_input->encaps = NULL;
     upipe_ts_mux_input->psig_flow = NULL;
     upipe_ts_mux_input->cr_sys = UINT64_MAX;
     upipe_ts_mux_input->dts_sys = UINT64_MAX;
     upipe_ts_mux_input->pcr_sys = UINT64_MAX;
     upipe_ts_mux_input->ready = false;
+    uheap_node_init(&upipe_ts_mux_input->heap_cr);
+    uheap_node_init(&upipe_ts_mux_input->heap_dts);
+    uheap_node_init(&upipe_ts_mux_input->heap_pcr);
     upipe_ts_mux_input->psi_pid = NULL;
     upipe_ts_mux_input->scte35_interval = program->scte35_interval;
     upipe_ts_mux_input->aac_encaps = program->aac_encaps;
@@ -1298,6 +1375,7 @@ static int upipe_ts_mux_input_set_flow_def(struct upipe *upipe,
         input->dts_sys = UINT64_MAX;
         input->pcr_sys = UINT64_MAX;
         input->ready = false;
+        upipe_ts_mux_input_schedule(upipe_ts_mux_input_to_upipe(input));
         if (!ulist_is_in(upipe_ts_mux_input_to_uchain_psi(input)))
             ulist_add(&upipe_ts_mux->psi_inputs,
                       upipe_ts_mux_input_to_uchain_psi(input));
@@ -1390,6 +1468,8 @@ static int upipe_ts_mux_input_set_flow_def(struct upipe *upipe,
     input->pid = pid;
     input->octetrate = octetrate;
     input->required_octetrate = octetrate + pes_overhead + ts_overhead;
+    input->statmux_octetrate = 0;
+    input->statmux_fullness = 0;
     input->pcr = false; /* reset PCR state to trigger a new PMT */
 
     uint64_t latency = 0;
@@ -1608,6 +1688,10 @@ static void upipe_ts_mux_input_free(struct urefcount *urefcount_real)
     struct upipe_ts_mux_program *program =
         upipe_ts_mux_program_from_input_mgr(upipe->mgr);
 
+    upipe_ts_mux_input->cr_sys = UINT64_MAX;
+    upipe_ts_mux_input->dts_sys = UINT64_MAX;
+    upipe_ts_mux_input->pcr_sys = UINT64_MAX;
+    upipe_ts_mux_input_schedule(upipe);
     upipe_ts_mux_input_clean_sub(upipe);
     if (!upipe_single(upipe_ts_mux_program_to_upipe(program)))
         upipe_ts_mux_program_change(upipe_ts_mux_program_to_upipe(program));
@@ -2507,6 +2591,9 @@ static struct upipe *upipe_ts_mux_alloc(struct upipe_mgr *mgr,
     upipe_ts_mux->tdt_interval = MAX_TDT_INTERVAL;
     upipe_ts_mux->pcr_interval = DEFAULT_PCR_INTERVAL;
     upipe_ts_mux->scte35_interval = DEFAULT_SCTE35_INTERVAL;
+    upipe_ts_mux->statmux_interval = DEFAULT_STATMUX_INTERVAL;
+    upipe_ts_mux->statmux_next = UINT64_MAX;
+    upipe_ts_mux->statmux_samples = 0;
     upipe_ts_mux->aac_encaps = DEFAULT_AAC_ENCAPS;
     upipe_ts_mux->encoding = DEFAULT_ENCODING;
     upipe_ts_mux->max_delay = UINT64_MAX;
@@ -2525,6 +2612,9 @@ static struct upipe *upipe_ts_mux_alloc(struct upipe_mgr *mgr,
     ulist_init(&upipe_ts_mux->psi_pids);
     ulist_init(&upipe_ts_mux->psi_pids_splice);
     ulist_init(&upipe_ts_mux->psi_inputs);
+    uheap_init(&upipe_ts_mux->splice_cr);
+    uheap_init(&upipe_ts_mux->splice_dts);
+    uheap_init(&upipe_ts_mux->splice_pcr);
     upipe_ts_mux->mode = UPIPE_TS_MUX_MODE_CBR;
     upipe_ts_mux->tb_size = T_STD_TS_BUFFER;
     upipe_ts_mux->mtu = TS_SIZE;
@@ -2621,6 +2711,224 @@ static void upipe_ts_mux_prepare_psi(struct upipe *upipe,
     }
 }
 
+/** @internal @This checks if an input takes part in the statistical
+ * multiplexing.
+ *
+ * @param input pointer to the input
+ * @return true if the octetrate of the input is managed by the statmux
+ */
+static inline bool upipe_ts_mux_input_statmux(struct upipe_ts_mux_input *input)
+{
+    return input->input_type == UPIPE_TS_MUX_INPUT_VIDEO && !input->deleted &&
+           input->octetrate && input->buffer_duration;
+}
+
+/** @internal @This assigns a new octetrate to an input in statmux mode, and
+ * tells the application so that it can reconfigure the encoder.
+ *
+ * @param input pointer to the input
+ * @param octetrate new octetrate
+ */
+static void upipe_ts_mux_input_set_statmux_octetrate(
+        struct upipe_ts_mux_input *input, uint64_t octetrate)
+{
+    struct upipe *upipe = upipe_ts_mux_input_to_upipe(input);
+    input->statmux_octetrate = octetrate;
+    upipe_verbose_va(upipe, "statmux target %"PRIu64" bits/s", octetrate * 8);
+    upipe_throw(upipe, UPROBE_TS_MUX_TARGET_OCTETRATE,
+                UPIPE_TS_MUX_SIGNATURE, octetrate);
+}
+
+/** @internal @This samples the buffer fullness of the inputs. An input whose
+ * next packet is due within less than its buffer duration is considered to
+ * fill its buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param cr_sys current muxing date
+ */
+static void upipe_ts_mux_statmux_sample(struct upipe *upipe, uint64_t cr_sys)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach (&mux->programs, uchain) {
+        struct upipe_ts_mux_program *program =
+            upipe_ts_mux_program_from_uchain(uchain);
+        struct uchain *uchain_input;
+        ulist_foreach (&program->inputs, uchain_input) {
+            struct upipe_ts_mux_input *input =
+                upipe_ts_mux_input_from_uchain(uchain_input);
+            if (!upipe_ts_mux_input_statmux(input) ||
+                input->dts_sys == UINT64_MAX)
+                continue;
+
+            uint64_t slack = input->dts_sys > cr_sys ?
+                             input->dts_sys - cr_sys : 0;
+            if (slack < input->buffer_duration)
+                input->statmux_fullness +=
+                    1000 - slack * 1000 / input->buffer_duration;
+        }
+    }
+}
+
+/** @internal @This returns the octetrate available to the elementary
+ * streams of the video inputs in statmux mode. It is the total octetrate of
+ * the mux, minus the clock drift margin, padding, PSI tables, PCR packets,
+ * the other inputs (such as audio), and the PES and TS overhead of the
+ * video inputs.
+ *
+ * @param upipe description structure of the pipe
+ * @return the octetrate budget, or 0 if there is none left
+ */
+static uint64_t upipe_ts_mux_statmux_budget(struct upipe *upipe)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    uint64_t total_octetrate = mux->fixed_octetrate;
+    if (!total_octetrate)
+        total_octetrate = mux->total_octetrate;
+    total_octetrate -=
+        (total_octetrate * PCR_TOLERANCE_PPM * 2 + 999999) / 1000000;
+
+    uint64_t reserved = mux->padding_octetrate;
+    uint64_t declared = 0;
+    struct uchain *uchain;
+    ulist_foreach (&mux->psi_pids, uchain) {
+        struct upipe_ts_mux_psi_pid *psi_pid =
+            upipe_ts_mux_psi_pid_from_uchain(uchain);
+        reserved += psi_pid->octetrate;
+    }
+
+    ulist_foreach (&mux->programs, uchain) {
+        struct upipe_ts_mux_program *program =
+            upipe_ts_mux_program_from_uchain(uchain);
+        reserved += program->required_octetrate;
+        struct uchain *uchain_input;
+        ulist_foreach (&program->inputs, uchain_input) {
+            struct upipe_ts_mux_input *input =
+                upipe_ts_mux_input_from_uchain(uchain_input);
+            if (upipe_ts_mux_input_statmux(input))
+                declared += input->octetrate;
+        }
+    }
+
+    /* the overhead of the video inputs stays reserved */
+    reserved -= declared;
+    if (reserved >= total_octetrate) {
+        upipe_warn_va(upipe, "no octetrate left for statmux "
+                      "(%"PRIu64" bits/s reserved)", reserved * 8);
+        return 0;
+    }
+    return total_octetrate - reserved;
+}
+
+/** @internal @This redistributes the octetrate budget of the video inputs
+ * according to their average buffer fullness.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_mux_statmux_update(struct upipe *upipe)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    uint64_t budget = upipe_ts_mux_statmux_budget(upipe);
+    uint64_t total_weight = 0;
+    struct uchain *uchain;
+    ulist_foreach (&mux->programs, uchain) {
+        struct upipe_ts_mux_program *program =
+            upipe_ts_mux_program_from_uchain(uchain);
+        struct uchain *uchain_input;
+        ulist_foreach (&program->inputs, uchain_input) {
+            struct upipe_ts_mux_input *input =
+                upipe_ts_mux_input_from_uchain(uchain_input);
+            if (!upipe_ts_mux_input_statmux(input))
+                continue;
+            if (!input->statmux_octetrate)
+                input->statmux_octetrate = input->octetrate;
+            /* the fullness is replaced by the weight of the input */
+            input->statmux_fullness = 1000 + STATMUX_WEIGHT *
+                input->statmux_fullness / mux->statmux_samples;
+            total_weight += input->statmux_fullness;
+        }
+    }
+    if (!total_weight)
+        return;
+
+    ulist_foreach (&mux->programs, uchain) {
+        struct upipe_ts_mux_program *program =
+            upipe_ts_mux_program_from_uchain(uchain);
+        struct uchain *uchain_input;
+        ulist_foreach (&program->inputs, uchain_input) {
+            struct upipe_ts_mux_input *input =
+                upipe_ts_mux_input_from_uchain(uchain_input);
+            if (!upipe_ts_mux_input_statmux(input))
+                continue;
+
+            uint64_t weight = input->statmux_fullness;
+            input->statmux_fullness = 0;
+            if (!budget)
+                continue;
+            uint64_t target = budget * weight / total_weight;
+            uint64_t octetrate = (input->statmux_octetrate * 3 + target) / 4;
+            /* ignore changes below 1 % */
+            if (octetrate * 100 < input->statmux_octetrate * 99 ||
+                octetrate * 100 > input->statmux_octetrate * 101)
+                upipe_ts_mux_input_set_statmux_octetrate(input, octetrate);
+        }
+    }
+}
+
+/** @internal @This restores the octetrates declared by the inputs, when
+ * leaving statmux mode.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_mux_statmux_reset(struct upipe *upipe)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    mux->statmux_next = UINT64_MAX;
+    mux->statmux_samples = 0;
+
+    struct uchain *uchain;
+    ulist_foreach (&mux->programs, uchain) {
+        struct upipe_ts_mux_program *program =
+            upipe_ts_mux_program_from_uchain(uchain);
+        struct uchain *uchain_input;
+        ulist_foreach (&program->inputs, uchain_input) {
+            struct upipe_ts_mux_input *input =
+                upipe_ts_mux_input_from_uchain(uchain_input);
+            input->statmux_fullness = 0;
+            if (input->statmux_octetrate &&
+                input->statmux_octetrate != input->octetrate &&
+                !input->deleted)
+                upipe_ts_mux_input_set_statmux_octetrate(input,
+                                                         input->octetrate);
+            input->statmux_octetrate = 0;
+        }
+    }
+}
+
+/** @internal @This runs the statmux control loop, if it is time to.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_mux_statmux(struct upipe *upipe)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    uint64_t cr_sys = mux->cr_sys - mux->latency;
+    uint64_t period = mux->statmux_interval / STATMUX_SAMPLES;
+    if (mux->statmux_next == UINT64_MAX) {
+        mux->statmux_next = cr_sys + period;
+        return;
+    }
+    if (cr_sys < mux->statmux_next)
+        return;
+
+    mux->statmux_next = cr_sys + period;
+    upipe_ts_mux_statmux_sample(upipe, cr_sys);
+    if (++mux->statmux_samples >= STATMUX_SAMPLES) {
+        upipe_ts_mux_statmux_update(upipe);
+        mux->statmux_samples = 0;
+    }
+}
+
 /** @internal @This increments the cr_sys by a tick, and prepares PSI tables.
  *
  * @param upipe description structure of the pipe
@@ -2636,6 +2944,9 @@ static void upipe_ts_mux_increment(struct upipe *upipe)
 
     /* Tell PSI tables to prepare packets. */
     upipe_ts_mux_prepare_psi(upipe, mux->cr_sys - mux->latency, mux->latency);
+
+    if (mux->mode == UPIPE_TS_MUX_MODE_STATMUX)
+        upipe_ts_mux_statmux(upipe);
 }
 
 /** @internal @This shows the next increment of cr_sys.
@@ -2695,51 +3006,51 @@ static void upipe_ts_mux_splice(struct upipe *upipe, struct ubuf **ubuf_p,
         return;
     }
 
-    /* 2. Inputs */
-    uint64_t cr_sys = UINT64_MAX;
-    struct upipe_ts_mux_input *selected_input = NULL;
-    struct uchain *uchain_tmp;
-    ulist_delete_foreach (&mux->programs, uchain, uchain_tmp) {
+    /* 2. Inputs: flush late packets */
+    struct uheap_node *node;
+    while ((node = uheap_peek(&mux->splice_dts)) != NULL) {
+        struct upipe_ts_mux_input *input =
+            upipe_ts_mux_input_from_heap_dts(node);
+        uint64_t dts_sys = input->dts_sys;
+        if (dts_sys >= original_cr_sys)
+            break;
+
         struct upipe_ts_mux_program *program =
-            upipe_ts_mux_program_from_uchain(uchain);
+            upipe_ts_mux_program_from_input_mgr(
+                    upipe_ts_mux_input_to_upipe(input)->mgr);
         upipe_use(upipe_ts_mux_program_to_upipe(program));
-
-        struct uchain *uchain_input, *uchain_tmp2;
-        ulist_delete_foreach (&program->inputs, uchain_input, uchain_tmp2) {
-            struct upipe_ts_mux_input *input =
-                upipe_ts_mux_input_from_uchain(uchain_input);
-            if (input->dts_sys < original_cr_sys) { /* flush */
-                upipe_ts_encaps_splice(input->encaps, original_cr_sys,
-                                       original_cr_sys + mux->interval,
-                                       NULL, NULL);
-
-                if (input->deleted && !input->ready) {
-                    /* This triggers the immediate deletion of the input. */
-                    upipe_release(input->encaps);
-                    continue;
-                }
-            }
-
-            if (input->dts_sys <= original_cr_sys + mux->interval ||
-                input->pcr_sys <= original_cr_sys) {
-                selected_input = input;
-                upipe_release(upipe_ts_mux_program_to_upipe(program));
-                goto upipe_ts_mux_splice_done;
-            }
-            if (input->cr_sys < cr_sys) {
-                selected_input = input;
-                cr_sys = input->cr_sys;
-            }
+        /* No need to update the heaps as the probe does it for us. */
+        upipe_ts_encaps_splice(input->encaps, original_cr_sys,
+                               original_cr_sys + mux->interval, NULL, NULL);
+
+        if (input->deleted && !input->ready) {
+            /* This triggers the immediate deletion of the input. */
+            upipe_release(input->encaps);
+        } else if (uheap_peek(&mux->splice_dts) == node &&
+                   input->dts_sys == dts_sys) {
+            /* Nothing could be flushed, retry on the next packet. */
+            upipe_release(upipe_ts_mux_program_to_upipe(program));
+            break;
         }
-
         upipe_release(upipe_ts_mux_program_to_upipe(program));
     }
 
-    if (selected_input == NULL ||
-        selected_input->cr_sys > original_cr_sys)
+    /* 3. Inputs with a due dts_sys or PCR, then by order of cr_sys */
+    struct upipe_ts_mux_input *selected_input;
+    if ((node = uheap_peek(&mux->splice_dts)) != NULL &&
+        upipe_ts_mux_input_from_heap_dts(node)->dts_sys <=
+            original_cr_sys + mux->interval)
+        selected_input = upipe_ts_mux_input_from_heap_dts(node);
+    else if ((node = uheap_peek(&mux->splice_pcr)) != NULL &&
+             upipe_ts_mux_input_from_heap_pcr(node)->pcr_sys <=
+                original_cr_sys)
+        selected_input = upipe_ts_mux_input_from_heap_pcr(node);
+    else if ((node = uheap_peek(&mux->splice_cr)) != NULL &&
+             upipe_ts_mux_input_from_heap_cr(node)->cr_sys <= original_cr_sys)
+        selected_input = upipe_ts_mux_input_from_heap_cr(node);
+    else
         return;
 
-upipe_ts_mux_splice_done:
     err = upipe_ts_encaps_splice(selected_input->encaps, original_cr_sys,
                                  original_cr_sys + mux->interval,
                                  ubuf_p, dts_sys_p);
@@ -4158,11 +4469,45 @@ static int _upipe_ts_mux_set_mode(struct upipe *upipe,
                                   enum upipe_ts_mux_mode mode)
 {
     struct upipe_ts_mux *upipe_ts_mux = upipe_ts_mux_from_upipe(upipe);
+    if (upipe_ts_mux->mode == UPIPE_TS_MUX_MODE_STATMUX &&
+        mode != UPIPE_TS_MUX_MODE_STATMUX)
+        upipe_ts_mux_statmux_reset(upipe);
     upipe_ts_mux->mode = mode;
     upipe_ts_mux_notice(upipe);
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the current statmux interval.
+ *
+ * @param upipe description structure of the pipe
+ * @param interval_p filled in with the interval
+ * @return an error code
+ */
+static int _upipe_ts_mux_get_statmux_interval(struct upipe *upipe,
+                                              uint64_t *interval_p)
+{
+    struct upipe_ts_mux *upipe_ts_mux = upipe_ts_mux_from_upipe(upipe);
+    assert(interval_p != NULL);
+    *interval_p = upipe_ts_mux->statmux_interval;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the statmux interval.
+ *
+ * @param upipe description structure of the pipe
+ * @param interval new interval
+ * @return an error code
+ */
+static int _upipe_ts_mux_set_statmux_interval(struct upipe *upipe,
+                                              uint64_t interval)
+{
+    struct upipe_ts_mux *upipe_ts_mux = upipe_ts_mux_from_upipe(upipe);
+    if (interval < STATMUX_SAMPLES)
+        return UBASE_ERR_INVALID;
+    upipe_ts_mux->statmux_interval = interval;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This returns the current encapsulation for AAC streams.
  *
  * @param upipe description structure of the pipe
@@ -4430,6 +4775,16 @@ static int _upipe_ts_mux_control(struct upipe *upipe, int command, va_list args)
             enum upipe_ts_mux_mode mode = va_arg(args, enum upipe_ts_mux_mode);
             return _upipe_ts_mux_set_mode(upipe, mode);
         }
+        case UPIPE_TS_MUX_GET_STATMUX_INTERVAL: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            uint64_t *interval_p = va_arg(args, uint64_t *);
+            return _upipe_ts_mux_get_statmux_interval(upipe, interval_p);
+        }
+        case UPIPE_TS_MUX_SET_STATMUX_INTERVAL: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            uint64_t interval = va_arg(args, uint64_t);
+            return _upipe_ts_mux_set_statmux_interval(upipe, interval);
+        }
         case UPIPE_TS_MUX_GET_AAC_ENCAPS: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
             int *encaps_p = va_arg(args, int *);
@@ -4513,6 +4868,9 @@ static void upipe_ts_mux_free(struct urefcount *urefcount_real)
 
     upipe_throw_dead(upipe);
 
+    uheap_clean(&mux->splice_cr);
+    uheap_clean(&mux->splice_dts);
+    uheap_clean(&mux->splice_pcr);
     ubuf_free(mux->padding);
     uref_free(mux->flow_def_input);
     uprobe_clean(&mux->probe);
@@ -4663,6 +5021,8 @@ const char *upipe_ts_mux_command_str(int cmd)
         UBASE_CASE_TO_STR(UPIPE_TS_MUX_SET_ENCODING);
         UBASE_CASE_TO_STR(UPIPE_TS_MUX_FREEZE_PSI);
         UBASE_CASE_TO_STR(UPIPE_TS_MUX_PREPARE);
+        UBASE_CASE_TO_STR(UPIPE_TS_MUX_GET_STATMUX_INTERVAL);
+        UBASE_CASE_TO_STR(UPIPE_TS_MUX_SET_STATMUX_INTERVAL);
         default: break;
     }
     return NULL;
@@ -4677,6 +5037,7 @@ const char *upipe_ts_mux_event_str(int event)
 {
     switch (event) {
         UBASE_CASE_TO_STR(UPROBE_TS_MUX_LAST_CC);
+        UBASE_CASE_TO_STR(UPROBE_TS_MUX_TARGET_OCTETRATE);
         default: break;
     }
     return NULL;
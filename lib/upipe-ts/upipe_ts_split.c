@@ -27,7 +27,9 @@
 #include <upipe/uprobe.h>
 #include <upipe/uref.h>
 #include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
 #include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
@@ -46,7 +48,8 @@
 
 #include <bitstream/mpeg/ts.h>
 
-/** we only accept blocks containing exactly one TS packet */
+/** we only accept blocks containing exactly one TS packet, or a vector of TS
+ * packets if the flow definition has the t.vector attribute */
 #define EXPECTED_FLOW_DEF "block.mpegts."
 /** maximum number of PIDs */
 #define MAX_PIDS 8192
@@ -71,6 +74,14 @@ struct upipe_ts_split {
 
     /** PIDs array */
     struct upipe_ts_split_pid pids[MAX_PIDS];
+    /** true if the input urefs carry vectors of TS packets */
+    bool vector;
+    /** size of a TS packet in input vectors */
+    size_t packet_size;
+    /** PID of each packet of the vector being demuxed */
+    uint16_t *pid_index;
+    /** number of allocated entries in pid_index */
+    size_t pid_index_size;
 
     /** manager to create output subpipes */
     struct upipe_mgr sub_mgr;
@@ -106,6 +117,11 @@ struct upipe_ts_split_sub {
     /** list of output requests */
     struct uchain request_list;
 
+    /** true if the output accepts vectors of TS packets */
+    bool vector;
+    /** vector of TS packets being built from the current input */
+    struct uref *vector_uref;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -151,10 +167,17 @@ static struct upipe *upipe_ts_split_sub_alloc(struct upipe_mgr *mgr,
     uchain_init(&upipe_ts_split_sub->uchain_pid);
     upipe_ts_split_sub_init_output(upipe);
     upipe_ts_split_sub_init_sub(upipe);
-    upipe_ts_split_sub_store_flow_def(upipe, flow_def);
+    upipe_ts_split_sub->vector = ubase_check(uref_ts_flow_get_vector(flow_def));
+    upipe_ts_split_sub->vector_uref = NULL;
 
     struct upipe_ts_split *upipe_ts_split =
         upipe_ts_split_from_sub_mgr(upipe->mgr);
+    if (upipe_ts_split_sub->vector &&
+        unlikely(!ubase_check(uref_block_flow_set_size(flow_def,
+                                    upipe_ts_split->packet_size))))
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+    upipe_ts_split_sub_store_flow_def(upipe, flow_def);
+
     uint64_t pid;
     if (likely(ubase_check(uref_ts_flow_get_pid(flow_def, &pid)) &&
                pid < MAX_PIDS))
@@ -210,6 +233,7 @@ static void upipe_ts_split_sub_free(struct upipe *upipe)
     }
 
     upipe_throw_dead(upipe);
+    uref_free(upipe_ts_split_sub->vector_uref);
     upipe_ts_split_sub_clean_output(upipe);
     upipe_ts_split_sub_clean_sub(upipe);
     upipe_ts_split_sub_clean_urefcount(upipe);
@@ -255,6 +279,10 @@ static struct upipe *upipe_ts_split_alloc(struct upipe_mgr *mgr,
                    upipe_ts_split_free);
     upipe_ts_split_init_sub_mgr(upipe);
     upipe_ts_split_init_sub_subs(upipe);
+    upipe_ts_split->vector = false;
+    upipe_ts_split->packet_size = TS_SIZE;
+    upipe_ts_split->pid_index = NULL;
+    upipe_ts_split->pid_index_size = 0;
 
     int i;
     for (i = 0; i < MAX_PIDS; i++) {
@@ -328,6 +356,176 @@ static void upipe_ts_split_pid_unset(struct upipe *upipe, uint16_t pid,
     upipe_ts_split_pid_check(upipe, pid);
 }
 
+/** @internal @This demuxes a run of consecutive TS packets of the same PID,
+ * taken from a vector of TS packets, to the appropriate output(s). Outputs
+ * accepting vectors get the run appended to their pending vector, the others
+ * get one uref per packet.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure containing the vector
+ * @param pid PID of the run
+ * @param offset offset of the run in the vector
+ * @param nb number of packets in the run
+ * @param upump_p reference to pump that generated the buffer
+ * @return an error code
+ */
+static int upipe_ts_split_input_run(struct upipe *upipe, struct uref *uref,
+                                    uint16_t pid, size_t offset, size_t nb,
+                                    struct upump **upump_p)
+{
+    struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
+    size_t packet_size = upipe_ts_split->packet_size;
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_ts_split->pids[pid].subs, uchain, uchain_tmp) {
+        struct upipe_ts_split_sub *output =
+                upipe_ts_split_sub_from_uchain_pid(uchain);
+        if (output->vector) {
+            if (output->vector_uref == NULL) {
+                output->vector_uref = uref_block_splice(uref, offset,
+                                                        nb * packet_size);
+                if (unlikely(output->vector_uref == NULL))
+                    return UBASE_ERR_ALLOC;
+                continue;
+            }
+            struct ubuf *ubuf = ubuf_block_splice(uref->ubuf, offset,
+                                                  nb * packet_size);
+            if (unlikely(ubuf == NULL))
+                return UBASE_ERR_ALLOC;
+            if (unlikely(!ubase_check(uref_block_append(output->vector_uref,
+                                                        ubuf)))) {
+                ubuf_free(ubuf);
+                return UBASE_ERR_ALLOC;
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < nb; i++) {
+            struct uref *new_uref =
+                uref_block_splice(uref, offset + i * packet_size, packet_size);
+            if (unlikely(new_uref == NULL))
+                return UBASE_ERR_ALLOC;
+            upipe_ts_split_sub_output(upipe_ts_split_sub_to_upipe(output),
+                                      new_uref, upump_p);
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This fills in the PID index with the PID of each packet of a
+ * vector of TS packets. Each segment of the buffer is mapped once, and only
+ * headers straddling two segments are copied.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure containing the vector
+ * @param nb number of packets in the vector
+ * @return an error code
+ */
+static int upipe_ts_split_index_vector(struct upipe *upipe, struct uref *uref,
+                                       size_t nb)
+{
+    struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
+    size_t packet_size = upipe_ts_split->packet_size;
+    if (unlikely(nb > upipe_ts_split->pid_index_size)) {
+        uint16_t *pid_index = realloc(upipe_ts_split->pid_index,
+                                      nb * sizeof(uint16_t));
+        if (unlikely(pid_index == NULL))
+            return UBASE_ERR_ALLOC;
+        upipe_ts_split->pid_index = pid_index;
+        upipe_ts_split->pid_index_size = nb;
+    }
+    uint16_t *pid_index = upipe_ts_split->pid_index;
+
+    size_t i = 0;
+    while (i < nb) {
+        size_t offset = i * packet_size;
+        const uint8_t *buffer;
+        int read_size = -1;
+        UBASE_RETURN(uref_block_read(uref, offset, &read_size, &buffer))
+        size_t end = i;
+        while (end < nb &&
+               (end - i) * packet_size + TS_HEADER_SIZE <= (size_t)read_size) {
+            pid_index[end] = ts_get_pid(buffer + (end - i) * packet_size);
+            end++;
+        }
+        UBASE_RETURN(uref_block_unmap(uref, offset))
+
+        if (unlikely(end == i)) {
+            /* the header is split between two segments */
+            uint8_t header[TS_HEADER_SIZE];
+            const uint8_t *ts_header = uref_block_peek(uref, offset,
+                                                       TS_HEADER_SIZE, header);
+            if (unlikely(ts_header == NULL))
+                return UBASE_ERR_ALLOC;
+            pid_index[i] = ts_get_pid(ts_header);
+            UBASE_RETURN(uref_block_peek_unmap(uref, offset, header,
+                                               ts_header))
+            end = i + 1;
+        }
+        i = end;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This demuxes a vector of TS packets to the appropriate
+ * output(s). The PID index of the vector is built first, then consecutive
+ * packets of the same PID are grouped, and packets of PIDs without outputs
+ * are skipped without any allocation.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_split_input_vector(struct upipe *upipe, struct uref *uref,
+                                        struct upump **upump_p)
+{
+    struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
+    size_t packet_size = upipe_ts_split->packet_size;
+    size_t size;
+    int err;
+    if (unlikely(!ubase_check(err = uref_block_size(uref, &size))) ||
+        unlikely(!ubase_check(err = upipe_ts_split_index_vector(upipe, uref,
+                                            size / packet_size)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, err);
+        return;
+    }
+
+    const uint16_t *pid_index = upipe_ts_split->pid_index;
+    size_t nb = size / packet_size;
+    size_t run_start = 0;
+    while (run_start < nb) {
+        uint16_t pid = pid_index[run_start];
+        size_t run_end = run_start + 1;
+        while (run_end < nb && pid_index[run_end] == pid)
+            run_end++;
+
+        if (!ulist_empty(&upipe_ts_split->pids[pid].subs)) {
+            err = upipe_ts_split_input_run(upipe, uref, pid,
+                                           run_start * packet_size,
+                                           run_end - run_start, upump_p);
+            if (unlikely(!ubase_check(err))) {
+                uref_free(uref);
+                upipe_throw_fatal(upipe, err);
+                return;
+            }
+        }
+        run_start = run_end;
+    }
+    uref_free(uref);
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_ts_split->subs, uchain, uchain_tmp) {
+        struct upipe_ts_split_sub *output =
+                upipe_ts_split_sub_from_uchain(uchain);
+        if (output->vector_uref != NULL) {
+            struct uref *vector_uref = output->vector_uref;
+            output->vector_uref = NULL;
+            upipe_ts_split_sub_output(upipe_ts_split_sub_to_upipe(output),
+                                      vector_uref, upump_p);
+        }
+    }
+}
+
 /** @internal @This demuxes a TS packet to the appropriate output(s).
  *
  * @param upipe description structure of the pipe
@@ -338,6 +536,11 @@ static void upipe_ts_split_input(struct upipe *upipe, struct uref *uref,
                                  struct upump **upump_p)
 {
     struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
+    if (upipe_ts_split->vector) {
+        upipe_ts_split_input_vector(upipe, uref, upump_p);
+        return;
+    }
+
     uint8_t buffer[TS_HEADER_SIZE];
     const uint8_t *ts_header = uref_block_peek(uref, 0, TS_HEADER_SIZE,
                                                buffer);
@@ -385,7 +588,36 @@ static int upipe_ts_split_set_flow_def(struct upipe *upipe,
 {
     if (flow_def == NULL)
         return UBASE_ERR_INVALID;
-    return uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF);
+    UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
+
+    struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
+    uint64_t packet_size;
+    if (!ubase_check(uref_block_flow_get_size(flow_def, &packet_size)) ||
+        packet_size < TS_SIZE)
+        packet_size = TS_SIZE;
+    upipe_ts_split->vector = ubase_check(uref_ts_flow_get_vector(flow_def));
+    if (packet_size == upipe_ts_split->packet_size)
+        return UBASE_ERR_NONE;
+    upipe_ts_split->packet_size = packet_size;
+
+    /* outputs accepting vectors need the size of the packets */
+    struct uchain *uchain;
+    ulist_foreach (&upipe_ts_split->subs, uchain) {
+        struct upipe_ts_split_sub *output =
+                upipe_ts_split_sub_from_uchain(uchain);
+        if (!output->vector || output->flow_def == NULL)
+            continue;
+        struct uref *flow_def_dup = uref_dup(output->flow_def);
+        if (unlikely(flow_def_dup == NULL ||
+                     !ubase_check(uref_block_flow_set_size(flow_def_dup,
+                                                           packet_size)))) {
+            uref_free(flow_def_dup);
+            return UBASE_ERR_ALLOC;
+        }
+        upipe_ts_split_sub_store_flow_def(upipe_ts_split_sub_to_upipe(output),
+                                          flow_def_dup);
+    }
+    return UBASE_ERR_NONE;
 }
 
 /** @internal @This processes control commands.
@@ -430,6 +662,7 @@ static void upipe_ts_split_free(struct urefcount *urefcount_real)
     struct upipe *upipe = upipe_ts_split_to_upipe(upipe_ts_split);
     upipe_throw_dead(upipe);
     upipe_ts_split_clean_sub_subs(upipe);
+    free(upipe_ts_split->pid_index);
     urefcount_clean(urefcount_real);
     upipe_ts_split_clean_urefcount(upipe);
     upipe_ts_split_free_void(upipe);
@@ -45,6 +45,7 @@
 #include <upipe/upipe_helper_uref_stream.h>
 #include <upipe/upipe_helper_output.h>
 #include <upipe/upipe_helper_output_size.h>
+#include <upipe-ts/uref_ts_flow.h>
 #include <upipe-ts/upipe_ts_sync.h>
 
 #include <stdlib.h>
@@ -84,6 +85,8 @@ struct upipe_ts_sync {
     size_t output_size;
     /** number of packets to sync with */
     unsigned int ts_sync;
+    /** maximum number of TS packets per output uref */
+    unsigned int vector;
     /** next uref to be processed */
     struct uref *next_uref;
     /** original size of the next uref */
@@ -129,6 +132,7 @@ static struct upipe *upipe_ts_sync_alloc(struct upipe_mgr *mgr,
     upipe_ts_sync_init_output(upipe);
     upipe_ts_sync_init_output_size(upipe, TS_SIZE);
     upipe_ts_sync->ts_sync = DEFAULT_TS_SYNC;
+    upipe_ts_sync->vector = 1;
     upipe_ts_sync->next_uref = NULL;
     ulist_init(&upipe_ts_sync->urefs);
     upipe_throw_ready(upipe);
@@ -177,6 +181,33 @@ static bool upipe_ts_sync_check(struct upipe *upipe, size_t *offset_p)
     return true;
 }
 
+/** @internal @This counts the synchronized TS packets that may be output
+ * in a single uref, the first packet being already checked. The vector
+ * stops at the end of the current input uref, so that all its packets
+ * carry the dates of the uref they were received in.
+ *
+ * @param upipe description structure of the pipe
+ * @return number of packets
+ */
+static unsigned int upipe_ts_sync_count(struct upipe *upipe)
+{
+    struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
+    size_t offset = upipe_ts_sync->ts_sync * upipe_ts_sync->output_size;
+    unsigned int count = 1;
+    while (count < upipe_ts_sync->vector &&
+           (count + 1) * upipe_ts_sync->output_size <=
+               upipe_ts_sync->next_uref_size) {
+        uint8_t word;
+        if (!ubase_check(uref_block_extract(upipe_ts_sync->next_uref,
+                                            offset, 1, &word)) ||
+            word != TS_SYNC)
+            break;
+        count++;
+        offset += upipe_ts_sync->output_size;
+    }
+    return count;
+}
+
 /** @internal @This flushes all input buffers.
  *
  * @param upipe description structure of the pipe
@@ -235,8 +266,9 @@ static void upipe_ts_sync_input(struct upipe *upipe, struct uref *uref,
 
         /* upipe_ts_sync_check said there is at least one TS packet there. */
         upipe_ts_sync_sync_acquired(upipe);
+        unsigned int count = upipe_ts_sync_count(upipe);
         struct uref *output = upipe_ts_sync_extract_uref_stream(upipe,
-                                                    upipe_ts_sync->output_size);
+                                        count * upipe_ts_sync->output_size);
         if (unlikely(output == NULL)) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             continue;
@@ -266,6 +298,10 @@ static int upipe_ts_sync_set_flow_def(struct upipe *upipe,
     UBASE_RETURN(uref_block_flow_set_size(flow_def_dup,
                                           upipe_ts_sync->output_size))
     UBASE_RETURN(uref_flow_set_def(flow_def_dup, OUTPUT_FLOW_DEF))
+    if (upipe_ts_sync->vector > 1) {
+        UBASE_RETURN(uref_ts_flow_set_vector(flow_def_dup))
+    } else
+        uref_ts_flow_delete_vector(flow_def_dup);
     upipe_ts_sync_store_flow_def(upipe, flow_def_dup);
     return UBASE_ERR_NONE;
 }
@@ -302,6 +338,52 @@ static int _upipe_ts_sync_set_sync(struct upipe *upipe, int sync)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the maximum number of TS packets per output uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector_p filled in with the number of packets
+ * @return an error code
+ */
+static int _upipe_ts_sync_get_vector(struct upipe *upipe,
+                                     unsigned int *vector_p)
+{
+    struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
+    assert(vector_p != NULL);
+    *vector_p = upipe_ts_sync->vector;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the maximum number of TS packets per output uref,
+ * and updates the output flow definition accordingly.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector number of packets
+ * @return an error code
+ */
+static int _upipe_ts_sync_set_vector(struct upipe *upipe, unsigned int vector)
+{
+    struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
+    if (!vector)
+        return UBASE_ERR_INVALID;
+    if ((upipe_ts_sync->vector > 1) == (vector > 1)) {
+        upipe_ts_sync->vector = vector;
+        return UBASE_ERR_NONE;
+    }
+    upipe_ts_sync->vector = vector;
+
+    if (upipe_ts_sync->flow_def == NULL)
+        return UBASE_ERR_NONE;
+    struct uref *flow_def_dup = uref_dup(upipe_ts_sync->flow_def);
+    if (unlikely(flow_def_dup == NULL))
+        return UBASE_ERR_ALLOC;
+    if (vector > 1) {
+        UBASE_RETURN(uref_ts_flow_set_vector(flow_def_dup))
+    } else
+        uref_ts_flow_delete_vector(flow_def_dup);
+    upipe_ts_sync_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a ts sync pipe.
  *
  * @param upipe description structure of the pipe
@@ -333,6 +415,16 @@ static int upipe_ts_sync_control(struct upipe *upipe,
             int sync = va_arg(args, int);
             return _upipe_ts_sync_set_sync(upipe, sync);
         }
+        case UPIPE_TS_SYNC_GET_VECTOR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_SYNC_SIGNATURE)
+            unsigned int *vector_p = va_arg(args, unsigned int *);
+            return _upipe_ts_sync_get_vector(upipe, vector_p);
+        }
+        case UPIPE_TS_SYNC_SET_VECTOR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_SYNC_SIGNATURE)
+            unsigned int vector = va_arg(args, unsigned int);
+            return _upipe_ts_sync_set_vector(upipe, vector);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -67,6 +67,7 @@
 #include <strings.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <limits.h>
 #include <ctype.h>
 
 #include <x264.h>
@@ -335,6 +336,73 @@ static int upipe_x264_set_option(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the octetrate enforced by the rate control of
+ * the encoder: the average bitrate in ABR mode, or the VBV maximum bitrate
+ * in CRF mode with VBV.
+ *
+ * @param params encoder parameters
+ * @return the octetrate, or 0 if the stream is not rate-controlled
+ */
+static uint64_t upipe_x264_rc_octetrate(const x264_param_t *params)
+{
+    switch (params->rc.i_rc_method) {
+        case X264_RC_ABR:
+            return params->rc.i_bitrate > 0 ?
+                   (uint64_t)params->rc.i_bitrate * 125 : 0;
+        case X264_RC_CRF:
+            return params->rc.i_vbv_max_bitrate > 0 &&
+                   params->rc.i_vbv_buffer_size > 0 ?
+                   (uint64_t)params->rc.i_vbv_max_bitrate * 125 : 0;
+        default:
+            return 0;
+    }
+}
+
+/** @internal @This changes the target octetrate of the encoder, and
+ * reconfigures it if it is already running. In ABR mode, the average
+ * bitrate is changed and the VBV maximum bitrate is scaled accordingly.
+ * In CRF mode, the VBV maximum bitrate capping the quality target is
+ * changed; VBV must then be enabled.
+ *
+ * @param upipe description structure of the pipe
+ * @param octetrate new target octetrate
+ * @return an error code
+ */
+static int upipe_x264_set_octetrate(struct upipe *upipe, uint64_t octetrate)
+{
+    struct upipe_x264 *upipe_x264 = upipe_x264_from_upipe(upipe);
+    x264_param_t *params = &upipe_x264->params;
+    if (!octetrate || octetrate > (uint64_t)INT_MAX * 125)
+        return UBASE_ERR_INVALID;
+    int bitrate = (octetrate * 8 + 999) / 1000;
+
+    switch (params->rc.i_rc_method) {
+        case X264_RC_ABR:
+            if (bitrate == params->rc.i_bitrate)
+                return UBASE_ERR_NONE;
+            if (params->rc.i_vbv_max_bitrate > 0 && params->rc.i_bitrate > 0)
+                params->rc.i_vbv_max_bitrate =
+                    (int64_t)params->rc.i_vbv_max_bitrate *
+                    bitrate / params->rc.i_bitrate;
+            params->rc.i_bitrate = bitrate;
+            break;
+        case X264_RC_CRF:
+            if (params->rc.i_vbv_max_bitrate <= 0 ||
+                params->rc.i_vbv_buffer_size <= 0)
+                return UBASE_ERR_INVALID;
+            if (bitrate == params->rc.i_vbv_max_bitrate)
+                return UBASE_ERR_NONE;
+            params->rc.i_vbv_max_bitrate = bitrate;
+            break;
+        default:
+            return UBASE_ERR_INVALID;
+    }
+
+    if (upipe_x264->encoder == NULL)
+        return UBASE_ERR_NONE;
+    return _upipe_x264_reconfigure(upipe);
+}
+
 /** @This switches x264 into speedcontrol mode, with the given latency (size
  * of sc buffer).
  *
@@ -523,10 +591,10 @@ static bool upipe_x264_open(struct upipe *upipe, int width, int height)
     }
     UBASE_FATAL(upipe, uref_flow_set_complete(flow_def_attr))
 
-    /* set octetrate for CBR streams */
-    if (params->rc.i_bitrate > 0) {
-        uref_block_flow_set_octetrate(flow_def_attr,
-                                      (uint64_t)params->rc.i_bitrate * 125);
+    /* set octetrate for CBR and capped CRF streams */
+    uint64_t octetrate = upipe_x264_rc_octetrate(params);
+    if (octetrate > 0) {
+        uref_block_flow_set_octetrate(flow_def_attr, octetrate);
         if (params->rc.i_vbv_buffer_size > 0)
             uref_block_flow_set_buffer_size(flow_def_attr,
                 (uint64_t)params->rc.i_vbv_buffer_size * 125);
@@ -1307,6 +1375,16 @@ static int upipe_x264_control(struct upipe *upipe, int command, va_list args)
             const char *content = va_arg(args, const char *);
             return upipe_x264_set_option(upipe, option, content);
         }
+        case UPIPE_ENC_GET_OCTETRATE: {
+            struct upipe_x264 *upipe_x264 = upipe_x264_from_upipe(upipe);
+            uint64_t *octetrate_p = va_arg(args, uint64_t *);
+            *octetrate_p = upipe_x264_rc_octetrate(&upipe_x264->params);
+            return *octetrate_p ? UBASE_ERR_NONE : UBASE_ERR_INVALID;
+        }
+        case UPIPE_ENC_SET_OCTETRATE: {
+            uint64_t octetrate = va_arg(args, uint64_t);
+            return upipe_x264_set_octetrate(upipe, octetrate);
+        }
         case UPIPE_X264_SET_SC_LATENCY: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_X264_SIGNATURE)
             uint64_t sc_latency = va_arg(args, uint64_t);
@@ -67,6 +67,7 @@
 #include <strings.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <limits.h>
 #include <ctype.h>
 
 /* fix undef warnings in x265.h */
@@ -127,6 +128,8 @@ struct upipe_x265 {
     char *profile;
     /** configured options */
     struct uchain options;
+    /** target octetrate set by @ref upipe_enc_set_octetrate, or 0 */
+    uint64_t octetrate;
     /** latency in the input flow */
     uint64_t input_latency;
     /** buffered frames count */
@@ -433,6 +436,59 @@ static void apply_params(struct upipe *upipe, x265_param *params)
         upipe_x265_set_option(upipe, params, "colormatrix", value);
 }
 
+/** @internal @This returns the octetrate enforced by the rate control of
+ * the encoder: the average bitrate in ABR mode, or the VBV maximum bitrate
+ * in CRF mode with VBV.
+ *
+ * @param params encoder parameters
+ * @return the octetrate, or 0 if the stream is not rate-controlled
+ */
+static uint64_t upipe_x265_rc_octetrate(const x265_param *params)
+{
+    switch (params->rc.rateControlMode) {
+        case X265_RC_ABR:
+            return params->rc.bitrate > 0 ?
+                   (uint64_t)params->rc.bitrate * 125 : 0;
+        case X265_RC_CRF:
+            return params->rc.vbvMaxBitrate > 0 &&
+                   params->rc.vbvBufferSize > 0 ?
+                   (uint64_t)params->rc.vbvMaxBitrate * 125 : 0;
+        default:
+            return 0;
+    }
+}
+
+/** @internal @This applies the target octetrate, if any, to the encoder
+ * parameters. In ABR mode, the average bitrate is changed and the VBV
+ * maximum bitrate is scaled accordingly. In CRF mode with VBV, the VBV
+ * maximum bitrate is changed.
+ *
+ * @param upipe description structure of the pipe
+ * @param params encoder parameters
+ */
+static void apply_octetrate(struct upipe *upipe, x265_param *params)
+{
+    struct upipe_x265 *upipe_x265 = upipe_x265_from_upipe(upipe);
+    if (!upipe_x265->octetrate)
+        return;
+    int bitrate = (upipe_x265->octetrate * 8 + 999) / 1000;
+
+    switch (params->rc.rateControlMode) {
+        case X265_RC_ABR:
+            if (params->rc.vbvMaxBitrate > 0 && params->rc.bitrate > 0)
+                params->rc.vbvMaxBitrate = (int64_t)params->rc.vbvMaxBitrate *
+                                           bitrate / params->rc.bitrate;
+            params->rc.bitrate = bitrate;
+            break;
+        case X265_RC_CRF:
+            if (params->rc.vbvMaxBitrate > 0 && params->rc.vbvBufferSize > 0)
+                params->rc.vbvMaxBitrate = bitrate;
+            break;
+        default:
+            break;
+    }
+}
+
 static int setup_encoder_params(struct upipe *upipe)
 {
     struct upipe_x265 *upipe_x265 = upipe_x265_from_upipe(upipe);
@@ -461,6 +517,7 @@ static int setup_encoder_params(struct upipe *upipe)
         if (unlikely(!ubase_check(ret)))
             return ret;
     }
+    apply_octetrate(upipe, &params);
 
     if (unlikely(api->param_apply_profile(&params, upipe_x265->profile) < 0)) {
         upipe_err_va(upipe, "cannot apply profile %s", upipe_x265->profile);
@@ -566,6 +623,7 @@ static struct upipe *upipe_x265_alloc(struct upipe_mgr *mgr,
     upipe_x265->tune = NULL;
     upipe_x265->profile = NULL;
     ulist_init(&upipe_x265->options);
+    upipe_x265->octetrate = 0;
     upipe_x265->input_latency = 0;
     upipe_x265->latency_frames = 3;
     upipe_x265->initial_latency = 0;
@@ -634,12 +692,35 @@ static void speedcontrol_update(struct upipe *upipe)
             upipe_x265_set_option(upipe, &upipe_x265->params,
                                   option->name, option->value);
         }
+        apply_octetrate(upipe, &upipe_x265->params);
 
         if (ubase_check(_upipe_x265_reconfigure(upipe)))
             upipe_x265->sc_preset = set;
     }
 }
 
+/** @internal @This changes the target octetrate of the encoder, and
+ * reconfigures it if it is already running.
+ *
+ * @param upipe description structure of the pipe
+ * @param octetrate new target octetrate
+ * @return an error code
+ */
+static int _upipe_x265_set_octetrate(struct upipe *upipe, uint64_t octetrate)
+{
+    struct upipe_x265 *upipe_x265 = upipe_x265_from_upipe(upipe);
+    if (!octetrate || octetrate > (uint64_t)INT_MAX * 125)
+        return UBASE_ERR_INVALID;
+    upipe_x265->octetrate = octetrate;
+    if (upipe_x265->encoder == NULL)
+        return UBASE_ERR_NONE;
+    if (!upipe_x265_rc_octetrate(&upipe_x265->params))
+        return UBASE_ERR_INVALID;
+
+    apply_octetrate(upipe, &upipe_x265->params);
+    return _upipe_x265_reconfigure(upipe);
+}
+
 /** @internal @This opens x265 encoder.
  *
  * @param upipe description structure of the pipe
@@ -685,10 +766,10 @@ static bool upipe_x265_open(struct upipe *upipe, int width, int height)
     }
     UBASE_FATAL(upipe, uref_flow_set_complete(flow_def_attr))
 
-    /* set octetrate for CBR streams */
-    if (params->rc.bitrate > 0) {
-        uref_block_flow_set_octetrate(flow_def_attr,
-                                      (uint64_t)params->rc.bitrate * 125);
+    /* set octetrate for CBR and capped CRF streams */
+    uint64_t octetrate = upipe_x265_rc_octetrate(params);
+    if (octetrate > 0) {
+        uref_block_flow_set_octetrate(flow_def_attr, octetrate);
         if (params->rc.vbvBufferSize > 0)
             uref_block_flow_set_buffer_size(flow_def_attr,
                 (uint64_t)params->rc.vbvBufferSize * 125);
@@ -1545,6 +1626,15 @@ static int upipe_x265_control(struct upipe *upipe, int command, va_list args)
             upipe_dbg_va(upipe, "set %s=%s", name, value ?: "true");
             return UBASE_ERR_NONE;
         }
+        case UPIPE_ENC_GET_OCTETRATE: {
+            uint64_t *octetrate_p = va_arg(args, uint64_t *);
+            *octetrate_p = upipe_x265_rc_octetrate(&upipe_x265->params);
+            return *octetrate_p ? UBASE_ERR_NONE : UBASE_ERR_INVALID;
+        }
+        case UPIPE_ENC_SET_OCTETRATE: {
+            uint64_t octetrate = va_arg(args, uint64_t);
+            return _upipe_x265_set_octetrate(upipe, octetrate);
+        }
         case UPIPE_X265_SET_SC_LATENCY: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_X265_SIGNATURE)
             uint64_t sc_latency = va_arg(args, uint64_t);
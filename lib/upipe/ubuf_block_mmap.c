@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe ubuf manager for block formats mapping regions of files
+ */
+
+#include <upipe/config.h>
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/urefcount.h>
+#include <upipe/upool.h>
+#include <upipe/umem.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_common.h>
+#include <upipe/ubuf_block_mmap.h>
+#include <upipe/ubuf_mem_common.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef UPIPE_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#if defined(UPIPE_HAVE_SYS_MMAN_H) && defined(UPIPE_HAVE_MMAP)
+#define UBUF_BLOCK_MMAP
+#endif
+
+/** @This is a super-set of the @ref ubuf (and @ref ubuf_block)
+ * structure with private fields pointing to shared data. */
+struct ubuf_block_mmap {
+    /** pointer to shared structure */
+    struct ubuf_mem_shared *shared;
+
+    /** block structure */
+    struct ubuf_block ubuf_block;
+};
+
+UBASE_FROM_TO(ubuf_block_mmap, ubuf, ubuf, ubuf_block.ubuf)
+
+/** @This is a super-set of the ubuf_mgr structure with additional local
+ * members. */
+struct ubuf_block_mmap_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** size of a page */
+    size_t page_size;
+    /** true if the mapped regions are read ahead */
+    bool readahead;
+
+    /** ubuf pool */
+    struct upool ubuf_pool;
+    /** ubuf shared pool */
+    struct upool shared_pool;
+
+    /** common management structure */
+    struct ubuf_mgr mgr;
+
+    /** extra space for upool */
+    uint8_t upool_extra[];
+};
+
+UBASE_FROM_TO(ubuf_block_mmap_mgr, ubuf_mgr, ubuf_mgr, mgr)
+UBASE_FROM_TO(ubuf_block_mmap_mgr, urefcount, urefcount, urefcount)
+UBASE_FROM_TO(ubuf_block_mmap_mgr, upool, ubuf_pool, ubuf_pool)
+
+UBUF_MEM_MGR_HELPER_POOL(ubuf_block_mmap, ubuf_pool, shared_pool, shared)
+
+#ifdef UBUF_BLOCK_MMAP
+/** @internal @This unmaps the region pointed to by a umem.
+ *
+ * @param umem pointer to umem
+ */
+static void ubuf_block_mmap_umem_free(struct umem *umem)
+{
+    munmap(umem->buffer, umem->real_size);
+}
+
+/** @internal @This is the umem manager of the mapped regions, which are only
+ * ever allocated by @ref ubuf_block_mmap_alloc. */
+static struct umem_mgr ubuf_block_mmap_umem_mgr = {
+    .refcount = NULL,
+    .umem_alloc = NULL,
+    .umem_realloc = NULL,
+    .umem_free = ubuf_block_mmap_umem_free,
+    .umem_mgr_vacuum = NULL
+};
+#endif
+
+/** @This allocates a ubuf, a shared structure and maps a region of a file.
+ *
+ * @param mgr common management structure
+ * @param signature type of allocation
+ * @param args optional arguments
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+static struct ubuf *ubuf_block_mmap_alloc(struct ubuf_mgr *mgr,
+                                          uint32_t signature, va_list args)
+{
+#ifdef UBUF_BLOCK_MMAP
+    if (unlikely(signature != UBUF_BLOCK_MMAP_ALLOC))
+        return NULL;
+
+    int fd = va_arg(args, int);
+    uint64_t offset = va_arg(args, uint64_t);
+    int size = va_arg(args, int);
+    struct stat st;
+    if (unlikely(fd < 0 || size <= 0 || fstat(fd, &st) == -1 ||
+                 offset + size > (uint64_t)st.st_size))
+        return NULL;
+
+    struct ubuf_block_mmap_mgr *block_mmap_mgr =
+        ubuf_block_mmap_mgr_from_ubuf_mgr(mgr);
+    struct ubuf_block_mmap *block_mmap = ubuf_block_mmap_alloc_pool(mgr);
+    if (unlikely(block_mmap == NULL))
+        return NULL;
+
+    block_mmap->shared = ubuf_block_mmap_shared_alloc_pool(mgr);
+    if (unlikely(block_mmap->shared == NULL)) {
+        ubuf_block_mmap_free_pool(mgr, block_mmap);
+        return NULL;
+    }
+
+    /* mmap() requires the offset to be a multiple of the page size */
+    size_t skip = offset % block_mmap_mgr->page_size;
+    size_t map_size = skip + size;
+    uint8_t *buffer = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE, fd, offset - skip);
+    if (unlikely(buffer == MAP_FAILED)) {
+        ubuf_block_mmap_shared_free_pool(block_mmap->shared);
+        ubuf_block_mmap_free_pool(mgr, block_mmap);
+        return NULL;
+    }
+#ifdef UPIPE_HAVE_MADVISE
+    if (block_mmap_mgr->readahead)
+        madvise(buffer, map_size, MADV_WILLNEED);
+#endif
+
+    struct umem *umem = &block_mmap->shared->umem;
+    umem->mgr = &ubuf_block_mmap_umem_mgr;
+    umem->buffer = buffer;
+    umem->size = umem->real_size = map_size;
+
+    struct ubuf *ubuf = ubuf_block_mmap_to_ubuf(block_mmap);
+    ubuf_block_common_init(ubuf, false);
+    ubuf_block_common_set(ubuf, skip, size);
+    ubuf_block_common_set_buffer(ubuf, buffer);
+    return ubuf;
+#else
+    return NULL;
+#endif
+}
+
+/** @This asks for the creation of a new reference to the same mapping.
+ *
+ * @param ubuf pointer to ubuf
+ * @param new_ubuf_p reference written with a pointer to the newly allocated
+ * ubuf
+ * @return an error code
+ */
+static int ubuf_block_mmap_dup(struct ubuf *ubuf, struct ubuf **new_ubuf_p)
+{
+    assert(new_ubuf_p != NULL);
+    struct ubuf_block_mmap *new_block = ubuf_block_mmap_alloc_pool(ubuf->mgr);
+    if (unlikely(new_block == NULL))
+        return UBASE_ERR_ALLOC;
+
+    struct ubuf *new_ubuf = ubuf_block_mmap_to_ubuf(new_block);
+    ubuf_block_common_init(new_ubuf, false);
+    if (unlikely(!ubase_check(ubuf_block_common_dup(ubuf, new_ubuf)))) {
+        ubuf_free(new_ubuf);
+        return UBASE_ERR_INVALID;
+    }
+    *new_ubuf_p = new_ubuf;
+
+    struct ubuf_block_mmap *block_mmap = ubuf_block_mmap_from_ubuf(ubuf);
+    new_block->shared = ubuf_mem_shared_use(block_mmap->shared);
+    return UBASE_ERR_NONE;
+}
+
+/** @This checks whether there is only one reference to the mapping.
+ *
+ * @param ubuf pointer to ubuf
+ * @return an error code
+ */
+static int ubuf_block_mmap_single(struct ubuf *ubuf)
+{
+    struct ubuf_block_mmap *block_mmap = ubuf_block_mmap_from_ubuf(ubuf);
+    return ubuf_mem_shared_single(block_mmap->shared) ?
+           UBASE_ERR_NONE : UBASE_ERR_BUSY;
+}
+
+/** @This asks for the creation of a new reference to part of the mapping.
+ *
+ * @param ubuf pointer to ubuf
+ * @param new_ubuf_p reference written with a pointer to the newly allocated
+ * ubuf
+ * @param offset offset in the buffer
+ * @param size final size of the buffer
+ * @return an error code
+ */
+static int ubuf_block_mmap_splice(struct ubuf *ubuf, struct ubuf **new_ubuf_p,
+                                  int offset, int size)
+{
+    assert(new_ubuf_p != NULL);
+    struct ubuf_block_mmap *new_block = ubuf_block_mmap_alloc_pool(ubuf->mgr);
+    if (unlikely(new_block == NULL))
+        return UBASE_ERR_ALLOC;
+
+    struct ubuf *new_ubuf = ubuf_block_mmap_to_ubuf(new_block);
+    ubuf_block_common_init(new_ubuf, false);
+    if (unlikely(!ubase_check(ubuf_block_common_splice(ubuf, new_ubuf,
+                                                       offset, size)))) {
+        ubuf_free(new_ubuf);
+        return UBASE_ERR_INVALID;
+    }
+    *new_ubuf_p = new_ubuf;
+
+    struct ubuf_block_mmap *block_mmap = ubuf_block_mmap_from_ubuf(ubuf);
+    new_block->shared = ubuf_mem_shared_use(block_mmap->shared);
+    return UBASE_ERR_NONE;
+}
+
+/** @This handles control commands.
+ *
+ * @param ubuf pointer to ubuf
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int ubuf_block_mmap_control(struct ubuf *ubuf, int command,
+                                   va_list args)
+{
+    switch (command) {
+        case UBUF_DUP: {
+            struct ubuf **new_ubuf_p = va_arg(args, struct ubuf **);
+            return ubuf_block_mmap_dup(ubuf, new_ubuf_p);
+        }
+        case UBUF_SINGLE:
+            return ubuf_block_mmap_single(ubuf);
+
+        case UBUF_SPLICE_BLOCK: {
+            struct ubuf **new_ubuf_p = va_arg(args, struct ubuf **);
+            int offset = va_arg(args, int);
+            int size = va_arg(args, int);
+            return ubuf_block_mmap_splice(ubuf, new_ubuf_p, offset, size);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This recycles or frees a ubuf, and unmaps the region if it was the last
+ * reference.
+ *
+ * @param ubuf pointer to a ubuf structure
+ */
+static void ubuf_block_mmap_free(struct ubuf *ubuf)
+{
+    struct ubuf_mgr *mgr = ubuf->mgr;
+    struct ubuf_block_mmap *block_mmap = ubuf_block_mmap_from_ubuf(ubuf);
+
+    ubuf_block_common_clean(ubuf);
+
+    if (unlikely(ubuf_mem_shared_release(block_mmap->shared))) {
+        umem_free(&block_mmap->shared->umem);
+        ubuf_block_mmap_shared_free_pool(block_mmap->shared);
+    }
+    ubuf_block_mmap_free_pool(mgr, block_mmap);
+}
+
+/** @internal @This allocates the data structure.
+ *
+ * @param upool pointer to upool
+ * @return pointer to ubuf_block_mmap or NULL in case of allocation error
+ */
+static void *ubuf_block_mmap_alloc_inner(struct upool *upool)
+{
+    struct ubuf_block_mmap_mgr *block_mmap_mgr =
+        ubuf_block_mmap_mgr_from_ubuf_pool(upool);
+    struct ubuf_block_mmap *block_mmap =
+        malloc(sizeof(struct ubuf_block_mmap));
+    struct ubuf_mgr *mgr = ubuf_block_mmap_mgr_to_ubuf_mgr(block_mmap_mgr);
+    if (unlikely(block_mmap == NULL))
+        return NULL;
+    struct ubuf *ubuf = ubuf_block_mmap_to_ubuf(block_mmap);
+    ubuf->mgr = mgr;
+    return block_mmap;
+}
+
+/** @internal @This frees a ubuf_block_mmap.
+ *
+ * @param upool pointer to upool
+ * @param _block_mmap pointer to a ubuf_block_mmap structure to free
+ */
+static void ubuf_block_mmap_free_inner(struct upool *upool, void *_block_mmap)
+{
+    struct ubuf_block_mmap *block_mmap =
+        (struct ubuf_block_mmap *)_block_mmap;
+    free(block_mmap);
+}
+
+/** @This handles manager control commands.
+ *
+ * @param mgr pointer to ubuf manager
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int ubuf_block_mmap_mgr_control(struct ubuf_mgr *mgr,
+                                       int command, va_list args)
+{
+    switch (command) {
+        case UBUF_MGR_VACUUM: {
+            ubuf_block_mmap_mgr_vacuum_pool(mgr);
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a ubuf manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void ubuf_block_mmap_mgr_free(struct urefcount *urefcount)
+{
+    struct ubuf_block_mmap_mgr *block_mmap_mgr =
+        ubuf_block_mmap_mgr_from_urefcount(urefcount);
+    struct ubuf_mgr *mgr = ubuf_block_mmap_mgr_to_ubuf_mgr(block_mmap_mgr);
+    ubuf_block_mmap_mgr_clean_pool(mgr);
+
+    urefcount_clean(urefcount);
+    free(block_mmap_mgr);
+}
+
+/** @This allocates a new instance of the ubuf manager for block formats
+ * mapping regions of files.
+ *
+ * @param ubuf_pool_depth maximum number of ubuf structures in the pool
+ * @param shared_pool_depth maximum number of shared structures in the pool
+ * @param readahead true if the kernel should be asked to read the mapped
+ * regions ahead (madvise(MADV_WILLNEED))
+ * @return pointer to manager, or NULL in case of error
+ */
+struct ubuf_mgr *ubuf_block_mmap_mgr_alloc(uint16_t ubuf_pool_depth,
+                                           uint16_t shared_pool_depth,
+                                           bool readahead)
+{
+#ifdef UBUF_BLOCK_MMAP
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (unlikely(page_size <= 0))
+        return NULL;
+
+    struct ubuf_block_mmap_mgr *block_mmap_mgr =
+        malloc(sizeof(struct ubuf_block_mmap_mgr) +
+               ubuf_block_mmap_mgr_sizeof_pool(ubuf_pool_depth,
+                                               shared_pool_depth));
+    if (unlikely(block_mmap_mgr == NULL))
+        return NULL;
+
+    block_mmap_mgr->page_size = page_size;
+    block_mmap_mgr->readahead = readahead;
+
+    urefcount_init(ubuf_block_mmap_mgr_to_urefcount(block_mmap_mgr),
+                   ubuf_block_mmap_mgr_free);
+    block_mmap_mgr->mgr.refcount =
+        ubuf_block_mmap_mgr_to_urefcount(block_mmap_mgr);
+    block_mmap_mgr->mgr.signature = UBUF_ALLOC_BLOCK;
+    block_mmap_mgr->mgr.ubuf_alloc = ubuf_block_mmap_alloc;
+    block_mmap_mgr->mgr.ubuf_control = ubuf_block_mmap_control;
+    block_mmap_mgr->mgr.ubuf_free = ubuf_block_mmap_free;
+    block_mmap_mgr->mgr.ubuf_mgr_control = ubuf_block_mmap_mgr_control;
+
+    ubuf_block_mmap_mgr_init_pool(
+            ubuf_block_mmap_mgr_to_ubuf_mgr(block_mmap_mgr),
+            ubuf_pool_depth, shared_pool_depth, block_mmap_mgr->upool_extra,
+            ubuf_block_mmap_alloc_inner, ubuf_block_mmap_free_inner);
+
+    return ubuf_block_mmap_mgr_to_ubuf_mgr(block_mmap_mgr);
+#else
+    return NULL;
+#endif
+}
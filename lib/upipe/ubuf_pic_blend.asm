@@ -0,0 +1,305 @@
+;******************************************************************************
+;* Picture plane alpha blending
+;* Copyright (C) 2026 OpenHeadend S.A.R.L.
+;*
+;* Permission is hereby granted, free of charge, to any person obtaining
+;* a copy of this software and associated documentation files (the
+;* "Software"), to deal in the Software without restriction, including
+;* without limitation the rights to use, copy, modify, merge, publish,
+;* distribute, sublicense, and/or sell copies of the Software, and to
+;* permit persons to whom the Software is furnished to do so, subject
+;* to the following conditions:
+;*
+;* The above copyright notice and this permission notice shall be
+;* included in all copies or substantial portions of the Software.
+;*
+;* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+;* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+;* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+;* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+;* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+;* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+;* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+;******************************************************************************
+
+%include "x86util.asm"
+
+SECTION_RODATA 32
+
+blend_pw_1:   times 16 dw 1
+blend_pw_255: times 16 dw 255
+blend_pd_1:   times 8 dd 1
+
+SECTION .text
+
+; load mmsize/2 octets zero-extended to words
+%macro LOAD_BW 3 ; dst, mem, zero
+%if cpuflag(avx2)
+    pmovzxbw  %1, %2
+%else
+    movq      %1, %2
+    punpcklbw %1, %3
+%endif
+%endmacro
+
+; pack words to octets and store mmsize/2 octets
+%macro STORE_WB 2 ; mem, reg index
+    packuswb  m%2, m%2
+%if cpuflag(avx2)
+    vpermq    m%2, m%2, 0xd8
+    movu      %1, xm%2
+%else
+    movq      %1, m%2
+%endif
+%endmacro
+
+; load the alpha values of mmsize/2 pixels as words
+%macro LOAD_ALPHA 3 ; dst, hsub, zero
+%if %2 == 2
+    movu      %1, [aq+2*pixelsq]
+    pand      %1, [blend_pw_255]
+%else
+    LOAD_BW   %1, [aq+pixelsq], %3
+%endif
+%endmacro
+
+%macro ALPHA_PTR 1 ; hsub
+%if %1 == 2
+    lea       aq, [aq+2*pixelsq]
+%else
+    add       aq, pixelsq
+%endif
+%endmacro
+
+; x / 255 for words up to 255 * 255
+%macro DIV255W 2 ; x, tmp
+    psrlw     %2, %1, 8
+    paddw     %1, %2
+    paddw     %1, [blend_pw_1]
+    psrlw     %1, 8
+%endmacro
+
+; x / 255 for dwords up to 32767 * 255
+%macro DIV255D 2 ; x, tmp
+    paddd     %1, [blend_pd_1]
+    psrld     %2, %1, 8
+    paddd     %2, %1
+    pslld     %1, 8
+    paddd     %1, %2
+    psrld     %1, 16
+%endmacro
+
+; scaled alpha (m2) of the next mmsize/2 pixels, alpha multiplier in m5
+%macro SCALE_ALPHA 1 ; hsub
+    LOAD_ALPHA m2, %1, m6
+    pmullw    m2, m5
+    DIV255W   m2, m3
+%endmacro
+
+%macro blend_const_8 0
+; blend_const_8(uint8_t *dst, const uint8_t *src, uintptr_t pixels, int alpha)
+cglobal blend_const_8, 4, 4, 6, dst, src, pixels, alpha
+    movd      xm4, alphad
+    SPLATW    m4, xm4
+    mova      m5, [blend_pw_255]
+    psubw     m5, m4
+    pxor      m3, m3
+    add       dstq, pixelsq
+    add       srcq, pixelsq
+    neg       pixelsq
+
+.loop:
+    LOAD_BW   m0, [dstq+pixelsq], m3
+    LOAD_BW   m1, [srcq+pixelsq], m3
+    pmullw    m0, m5
+    pmullw    m1, m4
+    paddw     m0, m1
+    DIV255W   m0, m1
+    STORE_WB  [dstq+pixelsq], 0
+
+    add       pixelsq, mmsize/2
+    jl .loop
+
+    RET
+%endmacro
+
+%macro blend_alpha_8 2 ; name suffix, hsub
+; blend_alpha_8(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha)
+cglobal blend_alpha_8%1, 5, 5, 7, dst, src, a, pixels, alpha
+    movd      xm5, alphad
+    SPLATW    m5, xm5
+    pxor      m6, m6
+    add       dstq, pixelsq
+    add       srcq, pixelsq
+    ALPHA_PTR %2
+    neg       pixelsq
+
+.loop:
+    SCALE_ALPHA %2
+    mova      m3, [blend_pw_255]
+    psubw     m3, m2
+    LOAD_BW   m0, [dstq+pixelsq], m6
+    LOAD_BW   m1, [srcq+pixelsq], m6
+    pmullw    m0, m3
+    pmullw    m1, m2
+    paddw     m0, m1
+    DIV255W   m0, m1
+    STORE_WB  [dstq+pixelsq], 0
+
+    add       pixelsq, mmsize/2
+    jl .loop
+
+    RET
+%endmacro
+
+%macro blend_threshold_8 2 ; name suffix, hsub
+; blend_threshold_8(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold)
+cglobal blend_threshold_8%1, 6, 6, 7, dst, src, a, pixels, alpha, threshold
+    movd      xm5, alphad
+    SPLATW    m5, xm5
+    movd      xm4, thresholdd
+    SPLATW    m4, xm4
+    pxor      m6, m6
+    add       dstq, pixelsq
+    add       srcq, pixelsq
+    ALPHA_PTR %2
+    neg       pixelsq
+
+.loop:
+    SCALE_ALPHA %2
+    pcmpgtw   m2, m4
+    packsswb  m2, m2
+%if cpuflag(avx2)
+    vpermq    m2, m2, 0xd8
+    movu      xm0, [dstq+pixelsq]
+    movu      xm1, [srcq+pixelsq]
+%else
+    movq      m0, [dstq+pixelsq]
+    movq      m1, [srcq+pixelsq]
+%endif
+    pand      xm1, xm2
+    pandn     xm2, xm0
+    por       xm1, xm2
+%if cpuflag(avx2)
+    movu      [dstq+pixelsq], xm1
+%else
+    movq      [dstq+pixelsq], m1
+%endif
+
+    add       pixelsq, mmsize/2
+    jl .loop
+
+    RET
+%endmacro
+
+; 16 bits samples must have at most 15 significant bits
+%macro blend_const_16 0
+; blend_const_16(uint16_t *dst, const uint16_t *src, uintptr_t pixels, int alpha)
+cglobal blend_const_16, 4, 4, 6, dst, src, pixels, alpha
+    movd      xm4, alphad
+    SPLATW    m4, xm4
+    mova      m5, [blend_pw_255]
+    psubw     m5, m4
+    punpcklwd m4, m5, m4
+    lea       dstq, [dstq+2*pixelsq]
+    lea       srcq, [srcq+2*pixelsq]
+    neg       pixelsq
+
+.loop:
+    movu      m0, [dstq+2*pixelsq]
+    movu      m1, [srcq+2*pixelsq]
+    punpckhwd m2, m0, m1
+    punpcklwd m0, m1
+    pmaddwd   m0, m4
+    pmaddwd   m2, m4
+    DIV255D   m0, m1
+    DIV255D   m2, m1
+    packssdw  m0, m2
+    movu      [dstq+2*pixelsq], m0
+
+    add       pixelsq, mmsize/2
+    jl .loop
+
+    RET
+%endmacro
+
+%macro blend_alpha_16 2 ; name suffix, hsub
+; blend_alpha_16(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha)
+cglobal blend_alpha_16%1, 5, 5, 7, dst, src, a, pixels, alpha
+    movd      xm5, alphad
+    SPLATW    m5, xm5
+    pxor      m6, m6
+    lea       dstq, [dstq+2*pixelsq]
+    lea       srcq, [srcq+2*pixelsq]
+    ALPHA_PTR %2
+    neg       pixelsq
+
+.loop:
+    SCALE_ALPHA %2
+    mova      m3, [blend_pw_255]
+    psubw     m3, m2
+    punpckhwd m4, m3, m2
+    punpcklwd m3, m2
+    movu      m0, [dstq+2*pixelsq]
+    movu      m1, [srcq+2*pixelsq]
+    punpckhwd m2, m0, m1
+    punpcklwd m0, m1
+    pmaddwd   m0, m3
+    pmaddwd   m2, m4
+    DIV255D   m0, m1
+    DIV255D   m2, m1
+    packssdw  m0, m2
+    movu      [dstq+2*pixelsq], m0
+
+    add       pixelsq, mmsize/2
+    jl .loop
+
+    RET
+%endmacro
+
+%macro blend_threshold_16 2 ; name suffix, hsub
+; blend_threshold_16(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold)
+cglobal blend_threshold_16%1, 6, 6, 7, dst, src, a, pixels, alpha, threshold
+    movd      xm5, alphad
+    SPLATW    m5, xm5
+    movd      xm4, thresholdd
+    SPLATW    m4, xm4
+    pxor      m6, m6
+    lea       dstq, [dstq+2*pixelsq]
+    lea       srcq, [srcq+2*pixelsq]
+    ALPHA_PTR %2
+    neg       pixelsq
+
+.loop:
+    SCALE_ALPHA %2
+    pcmpgtw   m2, m4
+    movu      m0, [dstq+2*pixelsq]
+    movu      m1, [srcq+2*pixelsq]
+    pand      m1, m2
+    pandn     m2, m0
+    por       m1, m2
+    movu      [dstq+2*pixelsq], m1
+
+    add       pixelsq, mmsize/2
+    jl .loop
+
+    RET
+%endmacro
+
+%macro blend_funcs 0
+blend_const_8
+blend_alpha_8 , 1
+blend_alpha_8 _sub2, 2
+blend_threshold_8 , 1
+blend_threshold_8 _sub2, 2
+blend_const_16
+blend_alpha_16 , 1
+blend_alpha_16 _sub2, 2
+blend_threshold_16 , 1
+blend_threshold_16 _sub2, 2
+%endmacro
+
+INIT_XMM sse2
+blend_funcs
+INIT_YMM avx2
+blend_funcs
@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe alpha blending of picture planes
+ */
+
+#include <upipe/config.h>
+#include <upipe/ubase.h>
+#include <upipe/ubuf_pic.h>
+#include <upipe/uatomic.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ubuf_pic_blend.h"
+
+/** @internal @This defines the C blending kernels for a sample type. */
+#define BLEND_TEMPLATE(bits, type)                                          \
+static inline void blend_const_##bits(type *dst, const type *src,           \
+                                      uintptr_t pixels, int alpha)          \
+{                                                                           \
+    for (uintptr_t j = 0; j < pixels; j++)                                  \
+        dst[j] = ((uint32_t)dst[j] * (0xff - alpha) +                       \
+                  (uint32_t)src[j] * alpha) / 0xff;                         \
+}                                                                           \
+                                                                            \
+static inline void blend_alpha_##bits(type *dst, const type *src,           \
+                                      const uint8_t *a, uintptr_t pixels,   \
+                                      int alpha, unsigned int hsub)         \
+{                                                                           \
+    for (uintptr_t j = 0; j < pixels; j++) {                                \
+        const uint32_t aj = a[j * hsub] * alpha / 0xff;                     \
+        dst[j] = ((uint32_t)dst[j] * (0xff - aj) +                          \
+                  (uint32_t)src[j] * aj) / 0xff;                            \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+static inline void blend_threshold_##bits(type *dst, const type *src,       \
+                                          const uint8_t *a,                 \
+                                          uintptr_t pixels, int alpha,      \
+                                          int threshold, unsigned int hsub) \
+{                                                                           \
+    for (uintptr_t j = 0; j < pixels; j++)                                  \
+        if (a[j * hsub] * alpha / 0xff > threshold)                         \
+            dst[j] = src[j];                                                \
+}                                                                           \
+                                                                            \
+void upipe_blend_const_##bits##_c(type *dst, const type *src,               \
+                                  uintptr_t pixels, int alpha)              \
+{                                                                           \
+    blend_const_##bits(dst, src, pixels, alpha);                            \
+}                                                                           \
+                                                                            \
+void upipe_blend_alpha_##bits##_c(type *dst, const type *src,               \
+                                  const uint8_t *a, uintptr_t pixels,       \
+                                  int alpha)                                \
+{                                                                           \
+    blend_alpha_##bits(dst, src, a, pixels, alpha, 1);                      \
+}                                                                           \
+                                                                            \
+void upipe_blend_alpha_##bits##_sub2_c(type *dst, const type *src,          \
+                                       const uint8_t *a, uintptr_t pixels,  \
+                                       int alpha)                           \
+{                                                                           \
+    blend_alpha_##bits(dst, src, a, pixels, alpha, 2);                      \
+}                                                                           \
+                                                                            \
+void upipe_blend_threshold_##bits##_c(type *dst, const type *src,           \
+                                      const uint8_t *a, uintptr_t pixels,   \
+                                      int alpha, int threshold)             \
+{                                                                           \
+    blend_threshold_##bits(dst, src, a, pixels, alpha, threshold, 1);       \
+}                                                                           \
+                                                                            \
+void upipe_blend_threshold_##bits##_sub2_c(type *dst, const type *src,      \
+                                           const uint8_t *a,                \
+                                           uintptr_t pixels, int alpha,     \
+                                           int threshold)                   \
+{                                                                           \
+    blend_threshold_##bits(dst, src, a, pixels, alpha, threshold, 2);       \
+}
+
+BLEND_TEMPLATE(8, uint8_t)
+BLEND_TEMPLATE(16, uint16_t)
+#undef BLEND_TEMPLATE
+
+/** @internal @This holds the blending kernels for a plane. */
+struct blend_funcs {
+    /** number of pixels processed by the SIMD kernels per iteration */
+    unsigned int step;
+    /** constant alpha blending */
+    void (*blend_const)(void *dst, const void *src, uintptr_t pixels,
+                        int alpha);
+    /** smooth blending with an alpha plane */
+    void (*blend_alpha)(void *dst, const void *src, const uint8_t *a,
+                        uintptr_t pixels, int alpha);
+    /** on/off blending with an alpha plane */
+    void (*blend_threshold)(void *dst, const void *src, const uint8_t *a,
+                            uintptr_t pixels, int alpha, int threshold);
+};
+
+/** @internal @This defines the blending kernels of a CPU, indexed by the
+ * sample size (8 or 16 bits) and the horizontal subsampling (1 or 2). */
+#define BLEND_FUNCS(cpu, step)                                              \
+{                                                                           \
+    {                                                                       \
+        { step, (void *)upipe_blend_const_8_##cpu,                          \
+                (void *)upipe_blend_alpha_8_##cpu,                          \
+                (void *)upipe_blend_threshold_8_##cpu },                    \
+        { step, (void *)upipe_blend_const_8_##cpu,                          \
+                (void *)upipe_blend_alpha_8_sub2_##cpu,                     \
+                (void *)upipe_blend_threshold_8_sub2_##cpu },               \
+    }, {                                                                    \
+        { step, (void *)upipe_blend_const_16_##cpu,                         \
+                (void *)upipe_blend_alpha_16_##cpu,                         \
+                (void *)upipe_blend_threshold_16_##cpu },                   \
+        { step, (void *)upipe_blend_const_16_##cpu,                         \
+                (void *)upipe_blend_alpha_16_sub2_##cpu,                    \
+                (void *)upipe_blend_threshold_16_sub2_##cpu },              \
+    }                                                                       \
+}
+
+#if defined(UPIPE_HAVE_X86ASM) && defined(UPIPE_HAVE_UNCHECKED_ASM) && \
+    (defined(__i686__) || defined(__x86_64__))
+/** @internal @This is the number of blending kernel sets */
+#define BLEND_CPUS 3
+#else
+#define BLEND_CPUS 1
+#endif
+
+/** @internal @This holds the blending kernels of the C version, and of the
+ * assembly versions if they are enabled. */
+static const struct blend_funcs blend_funcs[BLEND_CPUS][2][2] = {
+    BLEND_FUNCS(c, 0),
+#if BLEND_CPUS > 1
+    BLEND_FUNCS(sse2, 8),
+    BLEND_FUNCS(avx2, 16),
+#endif
+};
+#undef BLEND_FUNCS
+
+/** @internal @This returns the bit depth of a planar chroma, or 0 if the
+ * plane is not made of samples in native endianness.
+ *
+ * @param chroma chroma type
+ * @return bit depth
+ */
+static unsigned int ubuf_pic_blend_depth(const char *chroma)
+{
+#ifdef UPIPE_WORDS_BIGENDIAN
+    static const char native = 'b';
+#else
+    static const char native = 'l';
+#endif
+    if (!chroma[0])
+        return 0;
+    char *end;
+    unsigned long depth = strtoul(chroma + 1, &end, 10);
+    if (end == chroma + 1)
+        return 0;
+    if (!*end && depth == 8)
+        return 8;
+    if (depth > 8 && depth <= 16 && end[0] == native && !end[1])
+        return depth;
+    return 0;
+}
+
+#if BLEND_CPUS > 1
+/** @internal @This caches the index of the kernels plus one, or 0 if it is
+ * not resolved yet. */
+static uatomic_uint32_t ubuf_pic_blend_cpu_cache;
+#endif
+
+/** @internal @This returns the best set of blending kernels supported
+ * by the CPU. It is only resolved once.
+ *
+ * The SIMD kernels have not passed checkasm yet, so they are only selected
+ * with --enable-unchecked-asm.
+ *
+ * @return index in blend_funcs
+ */
+static unsigned int ubuf_pic_blend_cpu(void)
+{
+#if BLEND_CPUS > 1
+    uint32_t cpu = uatomic_load(&ubuf_pic_blend_cpu_cache);
+    if (unlikely(cpu == 0)) {
+        cpu = 1;
+        if (__builtin_cpu_supports("avx2"))
+            cpu = 3;
+        else if (__builtin_cpu_supports("sse2"))
+            cpu = 2;
+        uatomic_store(&ubuf_pic_blend_cpu_cache, cpu);
+    }
+    return cpu - 1;
+#else
+    return 0;
+#endif
+}
+
+/** @internal @This returns the blending kernels for a plane.
+ *
+ * @param depth bit depth of the plane
+ * @param hsub horizontal subsampling of the plane (1 or 2)
+ * @param assembly whether to use assembly
+ * @return pointer to the kernels
+ */
+static const struct blend_funcs *ubuf_pic_blend_funcs(unsigned int depth,
+                                                      unsigned int hsub,
+                                                      bool assembly)
+{
+    /* the 16 bits kernels use signed multiplications */
+    unsigned int cpu = assembly && depth <= 15 ? ubuf_pic_blend_cpu() : 0;
+    return &blend_funcs[cpu][depth > 8][hsub == 2];
+}
+
+/** @internal @This blends a line with an alpha plane of any horizontal
+ * subsampling, without assembly.
+ *
+ * @param depth bit depth of the plane
+ * @param dst destination line
+ * @param src source line
+ * @param a alpha line
+ * @param pixels number of samples
+ * @param hsub horizontal subsampling of the plane
+ * @param alpha alpha multiplier
+ * @param threshold alpha blending method
+ */
+static void ubuf_pic_blend_line(unsigned int depth, void *dst,
+                                const void *src, const uint8_t *a,
+                                uintptr_t pixels, unsigned int hsub,
+                                uint8_t alpha, uint8_t threshold)
+{
+    if (depth == 8) {
+        if (threshold != 0xff)
+            blend_threshold_8(dst, src, a, pixels, alpha, threshold, hsub);
+        else
+            blend_alpha_8(dst, src, a, pixels, alpha, hsub);
+    } else {
+        if (threshold != 0xff)
+            blend_threshold_16(dst, src, a, pixels, alpha, threshold, hsub);
+        else
+            blend_alpha_16(dst, src, a, pixels, alpha, hsub);
+    }
+}
+
+/** @This blends a picture plane into another.
+ *
+ * @param chroma chroma type of the planes
+ * @param dest pointer to the first line of the destination plane
+ * @param dest_stride stride of the destination plane
+ * @param src pointer to the first line of the source plane
+ * @param src_stride stride of the source plane
+ * @param hsize size of a line, in octets
+ * @param vsize number of lines
+ * @param alpha_plane pointer to alpha plane buffer, if any
+ * @param alpha_stride horizontal stride of the alpha plane buffer
+ * @param hsub horizontal subsampling of the planes
+ * @param vsub vertical subsampling of the planes
+ * @param alpha alpha multiplier
+ * @param threshold alpha blending method (see @ref ubuf_pic_blit_alpha)
+ */
+void ubuf_pic_plane_blend(const char *chroma,
+                          uint8_t *dest, size_t dest_stride,
+                          const uint8_t *src, size_t src_stride,
+                          size_t hsize, size_t vsize,
+                          const uint8_t *alpha_plane, size_t alpha_stride,
+                          uint8_t hsub, uint8_t vsub,
+                          uint8_t alpha, uint8_t threshold)
+{
+    if ((!alpha_plane && alpha == 0xff) || threshold == 0) {
+        for (size_t i = 0; i < vsize; i++) {
+            memcpy(dest, src, hsize);
+            dest += dest_stride;
+            src += src_stride;
+        }
+        return;
+    }
+
+    /* planes which are not made of native samples are blended octet per
+     * octet */
+    unsigned int depth = ubuf_pic_blend_depth(chroma);
+    if (depth == 0 || (depth > 8 && hsize % 2))
+        depth = 8;
+    size_t sample_size = depth == 8 ? 1 : 2;
+    size_t pixels = hsize / sample_size;
+
+    const struct blend_funcs *funcs =
+        ubuf_pic_blend_funcs(depth, hsub, alpha_plane == NULL || hsub <= 2);
+    const struct blend_funcs *c_funcs =
+        ubuf_pic_blend_funcs(depth, hsub, false);
+    size_t simd = funcs->step ? pixels - pixels % funcs->step : 0;
+    size_t offset = simd * sample_size;
+
+    for (size_t i = 0; i < vsize; i++) {
+        const uint8_t *a = alpha_plane ?
+                           alpha_plane + alpha_stride * i * vsub : NULL;
+
+        if (!alpha_plane) {
+            if (simd)
+                funcs->blend_const(dest, src, simd, alpha);
+            c_funcs->blend_const(dest + offset, src + offset,
+                                pixels - simd, alpha);
+        } else if (hsub > 2) {
+            ubuf_pic_blend_line(depth, dest, src, a, pixels, hsub,
+                                alpha, threshold);
+        } else if (threshold != 0xff) {
+            /* on/off blending: if alpha is over the threshold, we use the
+             * subpicture pixel */
+            if (simd)
+                funcs->blend_threshold(dest, src, a, simd, alpha, threshold);
+            c_funcs->blend_threshold(dest + offset, src + offset,
+                                    a + simd * hsub, pixels - simd,
+                                    alpha, threshold);
+        } else {
+            /* smooth blending */
+            if (simd)
+                funcs->blend_alpha(dest, src, a, simd, alpha);
+            c_funcs->blend_alpha(dest + offset, src + offset,
+                                a + simd * hsub, pixels - simd, alpha);
+        }
+        dest += dest_stride;
+        src += src_stride;
+    }
+}
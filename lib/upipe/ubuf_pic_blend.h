@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe alpha blending kernels
+ */
+
+#ifndef _UBUF_PIC_BLEND_H_
+/** @hidden */
+#define _UBUF_PIC_BLEND_H_
+
+#include <inttypes.h>
+
+/* constant alpha blending */
+void upipe_blend_const_8_c(uint8_t *dst, const uint8_t *src, uintptr_t pixels, int alpha);
+void upipe_blend_const_16_c(uint16_t *dst, const uint16_t *src, uintptr_t pixels, int alpha);
+
+/* smooth blending with an alpha plane, read every pixel or every other pixel */
+void upipe_blend_alpha_8_c(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha);
+void upipe_blend_alpha_8_sub2_c(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha);
+void upipe_blend_alpha_16_c(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha);
+void upipe_blend_alpha_16_sub2_c(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha);
+
+/* on/off blending with an alpha plane */
+void upipe_blend_threshold_8_c(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold);
+void upipe_blend_threshold_8_sub2_c(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold);
+void upipe_blend_threshold_16_c(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold);
+void upipe_blend_threshold_16_sub2_c(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold);
+
+/* process mmsize/2 pixels per iteration, 16 bits variants require samples
+ * of at most 15 bits */
+#define BLEND_ASM(cpu) \
+void upipe_blend_const_8_##cpu(uint8_t *dst, const uint8_t *src, uintptr_t pixels, int alpha); \
+void upipe_blend_const_16_##cpu(uint16_t *dst, const uint16_t *src, uintptr_t pixels, int alpha); \
+void upipe_blend_alpha_8_##cpu(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha); \
+void upipe_blend_alpha_8_sub2_##cpu(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha); \
+void upipe_blend_alpha_16_##cpu(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha); \
+void upipe_blend_alpha_16_sub2_##cpu(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha); \
+void upipe_blend_threshold_8_##cpu(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold); \
+void upipe_blend_threshold_8_sub2_##cpu(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold); \
+void upipe_blend_threshold_16_##cpu(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold); \
+void upipe_blend_threshold_16_sub2_##cpu(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold);
+
+BLEND_ASM(sse2)
+BLEND_ASM(avx2)
+
+#undef BLEND_ASM
+
+#endif
@@ -0,0 +1,460 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <upipe/config.h>
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/uatomic.h>
+#include <upipe/ufifo.h>
+#include <upipe/umem.h>
+#include <upipe/umem_hugepage.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+
+#ifdef UPIPE_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(UPIPE_HAVE_SYS_MMAN_H) && defined(UPIPE_HAVE_MMAP)
+#define UMEM_HUGEPAGE_MMAP
+#endif
+
+#if defined(__linux__) && defined(SYS_mbind)
+/** memory policy restricting allocations to the given nodes */
+#define UMEM_HUGEPAGE_MPOL_BIND 2
+/** fail mbind() if the existing pages do not follow the policy */
+#define UMEM_HUGEPAGE_MPOL_MF_STRICT (1 << 0)
+#endif
+
+/** @This defines the private data structures of the umem hugepage manager. */
+struct umem_hugepage_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** common management structure */
+    struct umem_mgr mgr;
+
+    /** pointer to the arena */
+    uint8_t *arena;
+    /** size of the arena (in octets) */
+    size_t arena_size;
+    /** true if the arena is backed by explicit hugepages */
+    bool hugetlb;
+
+    /** size (in octets) of a chunk */
+    size_t chunk_size;
+    /** base 2 logarithm of chunk_size */
+    unsigned int chunk_shift;
+    /** number of chunks in the arena */
+    uint32_t nb_chunks;
+    /** index of the first chunk never allocated */
+    uatomic_uint32_t next_chunk;
+
+    /** number of size classes */
+    unsigned int nb_classes;
+    /** lists of released buffers, per size class */
+    struct ufifo classes[];
+};
+
+UBASE_FROM_TO(umem_hugepage_mgr, umem_mgr, umem_mgr, mgr)
+UBASE_FROM_TO(umem_hugepage_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This returns the number of chunks of a size class. Classes
+ * go 1, 2, 3, 4, 6, 8, 12, 16... chunks.
+ *
+ * @param class size class
+ * @return number of chunks
+ */
+static inline uint64_t umem_hugepage_class_chunks(unsigned int class)
+{
+    if (!class)
+        return 1;
+    if (class & 1)
+        return UINT64_C(1) << ((class + 1) / 2);
+    return UINT64_C(3) << (class / 2 - 1);
+}
+
+/** @internal @This returns the smallest size class holding the given number
+ * of chunks.
+ *
+ * @param chunks number of chunks
+ * @return size class
+ */
+static inline unsigned int umem_hugepage_chunks_class(uint64_t chunks)
+{
+    if (chunks <= 1)
+        return 0;
+    unsigned int k = ubase_log2(chunks);
+    if (chunks == UINT64_C(1) << k)
+        return 2 * k - 1;
+    if (chunks <= UINT64_C(3) << (k - 1))
+        return 2 * k;
+    return 2 * k + 1;
+}
+
+/** @internal @This returns the size class for a umem of the given size.
+ *
+ * @param hugepage_mgr private structure of the umem mgr
+ * @param wanted desired size of the umem
+ * @param real_p reference written with the actual size of the future buffer
+ * @return size class, or nb_classes if the buffer is too large
+ */
+static unsigned int umem_hugepage_find(struct umem_hugepage_mgr *hugepage_mgr,
+                                       size_t wanted, size_t *real_p)
+{
+    uint64_t chunks = ((uint64_t)wanted + hugepage_mgr->chunk_size - 1) >>
+                      hugepage_mgr->chunk_shift;
+    unsigned int class = umem_hugepage_chunks_class(chunks);
+    if (unlikely(class >= hugepage_mgr->nb_classes)) {
+        class = hugepage_mgr->nb_classes;
+        if (likely(real_p != NULL))
+            *real_p = wanted;
+    } else if (likely(real_p != NULL))
+        *real_p = umem_hugepage_class_chunks(class) <<
+                  hugepage_mgr->chunk_shift;
+    return class;
+}
+
+/** @internal @This carves a new buffer out of the unused part of the arena.
+ *
+ * @param hugepage_mgr private structure of the umem mgr
+ * @param class size class
+ * @return pointer to buffer, or NULL if the arena is exhausted
+ */
+static uint8_t *umem_hugepage_carve(struct umem_hugepage_mgr *hugepage_mgr,
+                                    unsigned int class)
+{
+    uint32_t chunks = umem_hugepage_class_chunks(class);
+    uint32_t next = uatomic_load(&hugepage_mgr->next_chunk);
+    do {
+        if (unlikely(hugepage_mgr->nb_chunks - next < chunks))
+            return NULL;
+    } while (unlikely(!uatomic_compare_exchange(&hugepage_mgr->next_chunk,
+                                                &next, next + chunks)));
+    return hugepage_mgr->arena + ((size_t)next << hugepage_mgr->chunk_shift);
+}
+
+/** @This allocates a new umem buffer space.
+ *
+ * @param mgr management structure
+ * @param umem caller-allocated structure, filled in with the required pointer
+ * and size (previous content is discarded)
+ * @param size requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_hugepage_alloc(struct umem_mgr *mgr, struct umem *umem,
+                                size_t size)
+{
+    struct umem_hugepage_mgr *hugepage_mgr =
+        umem_hugepage_mgr_from_umem_mgr(mgr);
+    size_t real_size;
+    unsigned int class = umem_hugepage_find(hugepage_mgr, size, &real_size);
+    uint8_t *buffer = NULL;
+
+    if (likely(class < hugepage_mgr->nb_classes)) {
+        buffer = ufifo_pop(&hugepage_mgr->classes[class], uint8_t *);
+        if (unlikely(buffer == NULL))
+            buffer = umem_hugepage_carve(hugepage_mgr, class);
+    }
+    if (unlikely(buffer == NULL))
+        buffer = malloc(real_size);
+    if (unlikely(buffer == NULL))
+        return false;
+
+    umem->buffer = buffer;
+    umem->size = size;
+    umem->real_size = real_size;
+    umem->mgr = mgr;
+    return true;
+}
+
+/** @This frees a umem.
+ *
+ * @param umem pointer to umem
+ */
+static void umem_hugepage_free(struct umem *umem)
+{
+    struct umem_hugepage_mgr *hugepage_mgr =
+        umem_hugepage_mgr_from_umem_mgr(umem->mgr);
+
+    if (umem->buffer >= hugepage_mgr->arena &&
+        umem->buffer < hugepage_mgr->arena + hugepage_mgr->arena_size) {
+        unsigned int class = umem_hugepage_find(hugepage_mgr,
+                                                umem->real_size, NULL);
+        assert(class < hugepage_mgr->nb_classes);
+        /* the list is sized to hold every buffer of the class */
+        bool ret = ufifo_push(&hugepage_mgr->classes[class], umem->buffer);
+        assert(ret);
+        (void)ret;
+    } else
+        free(umem->buffer);
+    umem->buffer = NULL;
+    umem->mgr = NULL;
+}
+
+/** @This resizes a umem.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc, and filled in with the new pointer and size
+ * @param new_size new requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_hugepage_realloc(struct umem *umem, size_t new_size)
+{
+    if (likely(new_size <= umem->real_size)) {
+        umem->size = new_size;
+        return true;
+    }
+
+    struct umem new_umem;
+    if (!umem_hugepage_alloc(umem->mgr, &new_umem, new_size))
+        return false;
+    memcpy(new_umem.buffer, umem->buffer, umem->size);
+    umem_hugepage_free(umem);
+    *umem = new_umem;
+    return true;
+}
+
+/** @This instructs an existing umem manager to release all structures
+ * currently kept in pools. Released buffers belong to the arena, which is
+ * kept until the manager is freed, so this does nothing.
+ *
+ * @param mgr pointer to umem manager
+ */
+static void umem_hugepage_mgr_vacuum(struct umem_mgr *mgr)
+{
+}
+
+/** @internal @This releases the arena.
+ *
+ * @param arena pointer to the arena
+ * @param arena_size size of the arena
+ */
+static void umem_hugepage_arena_free(uint8_t *arena, size_t arena_size)
+{
+#ifdef UMEM_HUGEPAGE_MMAP
+    munmap(arena, arena_size);
+#else
+    free(arena);
+#endif
+}
+
+/** @internal @This allocates the arena, binds it to a NUMA node and
+ * pre-faults it.
+ *
+ * @param hugepage_mgr private structure of the umem mgr
+ * @param page_size size of the hugepages
+ * @param numa_node NUMA node, or -1
+ * @return false in case of error
+ */
+static bool umem_hugepage_arena_alloc(struct umem_hugepage_mgr *hugepage_mgr,
+                                      size_t page_size, int numa_node)
+{
+    size_t size = hugepage_mgr->arena_size;
+    void *arena = NULL;
+    hugepage_mgr->hugetlb = false;
+
+#ifdef UMEM_HUGEPAGE_MMAP
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+    int hugetlb_flags = flags | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+    hugetlb_flags |= ubase_log2(page_size) << MAP_HUGE_SHIFT;
+#endif
+    arena = mmap(NULL, size, PROT_READ | PROT_WRITE, hugetlb_flags, -1, 0);
+    if (arena != MAP_FAILED)
+        hugepage_mgr->hugetlb = true;
+    else
+#endif
+    {
+        arena = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (unlikely(arena == MAP_FAILED))
+            return false;
+#if defined(UPIPE_HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+        madvise(arena, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    if (numa_node >= 0) {
+#ifdef UMEM_HUGEPAGE_MPOL_BIND
+        unsigned long nodemask[(numa_node + 1) /
+                               (sizeof(unsigned long) * 8) + 1];
+        memset(nodemask, 0, sizeof(nodemask));
+        nodemask[numa_node / (sizeof(unsigned long) * 8)] =
+            1UL << (numa_node % (sizeof(unsigned long) * 8));
+        if (unlikely(syscall(SYS_mbind, arena, size, UMEM_HUGEPAGE_MPOL_BIND,
+                             nodemask, (unsigned long)numa_node + 2,
+                             UMEM_HUGEPAGE_MPOL_MF_STRICT) < 0)) {
+            munmap(arena, size);
+            return false;
+        }
+#else
+        munmap(arena, size);
+        return false;
+#endif
+    }
+#else
+    if (numa_node >= 0)
+        return false;
+    arena = malloc(size);
+    if (unlikely(arena == NULL))
+        return false;
+#endif
+
+    /* pre-fault the pages so that the data path does not take page faults */
+    long sys_page_size = 4096;
+#ifdef _SC_PAGESIZE
+    sys_page_size = sysconf(_SC_PAGESIZE);
+    if (sys_page_size <= 0)
+        sys_page_size = 4096;
+#endif
+    for (size_t i = 0; i < size; i += sys_page_size)
+        ((volatile uint8_t *)arena)[i] = 0;
+
+    hugepage_mgr->arena = arena;
+    return true;
+}
+
+/** @This frees a umem manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void umem_hugepage_mgr_free(struct urefcount *urefcount)
+{
+    struct umem_hugepage_mgr *hugepage_mgr =
+        umem_hugepage_mgr_from_urefcount(urefcount);
+
+    for (unsigned int i = 0; i < hugepage_mgr->nb_classes; i++)
+        ufifo_clean(&hugepage_mgr->classes[i]);
+    uatomic_clean(&hugepage_mgr->next_chunk);
+    umem_hugepage_arena_free(hugepage_mgr->arena, hugepage_mgr->arena_size);
+
+    urefcount_clean(urefcount);
+    free(hugepage_mgr);
+}
+
+/** @This allocates a new instance of the umem hugepage manager.
+ *
+ * @param arena_size size (in octets) of the arena, rounded up to a multiple
+ * of page_size
+ * @param page_size size of the hugepages (@ref UMEM_HUGEPAGE_2M or
+ * @ref UMEM_HUGEPAGE_1G)
+ * @param numa_node NUMA node on which the arena is allocated, or -1 to use
+ * the default policy of the calling thread
+ * @param chunk_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_hugepage_mgr_alloc(size_t arena_size, size_t page_size,
+                                         int numa_node, size_t chunk_size)
+{
+    assert(page_size && !(page_size & (page_size - 1)));
+    assert(chunk_size && !(chunk_size & (chunk_size - 1)));
+    if (unlikely(!arena_size || chunk_size > page_size))
+        return NULL;
+
+    arena_size = (arena_size + page_size - 1) & ~(page_size - 1);
+    uint64_t nb_chunks = arena_size / chunk_size;
+    if (unlikely(nb_chunks > UINT32_MAX))
+        return NULL;
+
+    unsigned int nb_classes = 0;
+    while (umem_hugepage_class_chunks(nb_classes) <= nb_chunks)
+        nb_classes++;
+
+    size_t alloc_size = sizeof(struct umem_hugepage_mgr) +
+                        sizeof(struct ufifo) * nb_classes;
+    uint32_t depths[nb_classes];
+    for (unsigned int i = 0; i < nb_classes; i++) {
+        depths[i] = nb_chunks / umem_hugepage_class_chunks(i);
+        alloc_size += ufifo_sizeof(depths[i]);
+    }
+
+    struct umem_hugepage_mgr *hugepage_mgr = malloc(alloc_size);
+    if (unlikely(hugepage_mgr == NULL))
+        return NULL;
+
+    hugepage_mgr->arena_size = arena_size;
+    if (unlikely(!umem_hugepage_arena_alloc(hugepage_mgr, page_size,
+                                            numa_node))) {
+        free(hugepage_mgr);
+        return NULL;
+    }
+
+    hugepage_mgr->chunk_size = chunk_size;
+    hugepage_mgr->chunk_shift = ubase_log2(chunk_size);
+    hugepage_mgr->nb_chunks = nb_chunks;
+    uatomic_init(&hugepage_mgr->next_chunk, 0);
+    hugepage_mgr->nb_classes = nb_classes;
+
+    void *extra = (void *)hugepage_mgr + sizeof(struct umem_hugepage_mgr) +
+                  sizeof(struct ufifo) * nb_classes;
+    for (unsigned int i = 0; i < nb_classes; i++) {
+        ufifo_init(&hugepage_mgr->classes[i], depths[i], extra);
+        extra += ufifo_sizeof(depths[i]);
+    }
+
+    urefcount_init(umem_hugepage_mgr_to_urefcount(hugepage_mgr),
+                   umem_hugepage_mgr_free);
+    hugepage_mgr->mgr.refcount = umem_hugepage_mgr_to_urefcount(hugepage_mgr);
+    hugepage_mgr->mgr.umem_alloc = umem_hugepage_alloc;
+    hugepage_mgr->mgr.umem_realloc = umem_hugepage_realloc;
+    hugepage_mgr->mgr.umem_free = umem_hugepage_free;
+    hugepage_mgr->mgr.umem_mgr_vacuum = umem_hugepage_mgr_vacuum;
+
+    return umem_hugepage_mgr_to_umem_mgr(hugepage_mgr);
+}
+
+/** @This allocates a new instance of the umem hugepage manager, with
+ * 2 MiB hugepages and 64 KiB chunks.
+ *
+ * @param arena_size size (in octets) of the arena
+ * @param numa_node NUMA node on which the arena is allocated, or -1
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_hugepage_mgr_alloc_simple(size_t arena_size,
+                                                int numa_node)
+{
+    return umem_hugepage_mgr_alloc(arena_size, UMEM_HUGEPAGE_2M, numa_node,
+                                   64 << 10);
+}
+
+/** @This returns whether the arena of the manager is actually backed by
+ * explicit hugepages, as opposed to transparent hugepages or regular pages.
+ *
+ * @param mgr pointer to umem manager
+ * @return true if the arena is backed by explicit hugepages
+ */
+bool umem_hugepage_mgr_is_hugetlb(struct umem_mgr *mgr)
+{
+    return umem_hugepage_mgr_from_umem_mgr(mgr)->hugetlb;
+}
@@ -43,6 +43,8 @@ struct umem_pool_mgr {
 
     /** size (in octets) of buffers of pools[0] */
     size_t pool0_size;
+    /** base 2 logarithm of pool0_size */
+    unsigned int pool0_shift;
     /** number of pools of buffers */
     size_t nb_pools;
     /** buffer pools */
@@ -64,14 +66,15 @@ static unsigned int umem_pool_find(struct umem_mgr *mgr, size_t wanted,
                                    size_t *real_p)
 {
     struct umem_pool_mgr *pool_mgr = umem_pool_mgr_from_umem_mgr(mgr);
-    size_t size = pool_mgr->pool0_size;
-    unsigned int pool;
+    unsigned int pool = 0;
 
-    for (pool = 0; pool < pool_mgr->nb_pools; pool++)
-        if (wanted <= (size << pool))
-            break;
+    if (likely(wanted > pool_mgr->pool0_size))
+        pool = ubase_log2_ceil(wanted) - pool_mgr->pool0_shift;
+    if (unlikely(pool > pool_mgr->nb_pools))
+        pool = pool_mgr->nb_pools;
     if (likely(real_p != NULL))
-        *real_p = pool < pool_mgr->nb_pools ? size << pool : wanted;
+        *real_p = pool < pool_mgr->nb_pools ?
+                  pool_mgr->pool0_size << pool : wanted;
     return pool;
 }
 
@@ -210,7 +213,9 @@ struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...)
     if (unlikely(pool_mgr == NULL))
         return NULL;
 
+    assert(pool0_size && !(pool0_size & (pool0_size - 1)));
     pool_mgr->pool0_size = pool0_size;
+    pool_mgr->pool0_shift = ubase_log2(pool0_size);
     pool_mgr->nb_pools = nb_pools;
 
     void *extra = (void *)pool_mgr + sizeof(struct umem_pool_mgr) +
@@ -0,0 +1,1096 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short implementation of a Upipe event loop using io_uring
+ *
+ * The ring is set up and driven with the raw system calls, so that no
+ * additional library is needed. File descriptors and signals are watched
+ * with one-shot poll requests which are re-armed before the pump is
+ * dispatched, so that the semantics are level-triggered as with the other
+ * event loops. Timers are kept in a heap in user space and the nearest
+ * deadline is passed as the timeout of io_uring_enter(2).
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/uclock.h>
+#include <upipe/ulist.h>
+#include <upipe/uheap.h>
+#include <upipe/umutex.h>
+#include <upipe/upump.h>
+#include <upipe/upump_common.h>
+#include <upump-uring/upump_uring.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+
+#include <linux/io_uring.h>
+
+/** default number of entries of the submission ring */
+#define UPUMP_URING_DEFAULT_ENTRIES 256
+
+/** @This stores a request submitted to the ring. Its address is used as
+ * user data, and it is only recycled once its completion is reaped. */
+struct upump_uring_op {
+    /** structure for the lists of the manager */
+    struct uchain uchain;
+    /** pump waiting for the completion, or NULL if it was stopped */
+    struct upump_uring *upump_uring;
+    /** result of the request */
+    int32_t res;
+    /** true if the completion was reaped */
+    bool completed;
+};
+
+UBASE_FROM_TO(upump_uring_op, uchain, uchain, uchain)
+
+/** @This stores management parameters and local structures.
+ */
+struct upump_uring_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** io_uring file descriptor */
+    int fd;
+    /** mapping of the submission ring */
+    void *sq_ring;
+    /** size of the mapping of the submission ring */
+    size_t sq_ring_size;
+    /** mapping of the completion ring, may be the same as sq_ring */
+    void *cq_ring;
+    /** size of the mapping of the completion ring */
+    size_t cq_ring_size;
+    /** array of submission entries */
+    struct io_uring_sqe *sqes;
+    /** size of the mapping of the submission entries */
+    size_t sqes_size;
+
+    /** head of the submission ring (written by the kernel) */
+    unsigned *sq_head;
+    /** tail of the submission ring */
+    unsigned *sq_tail;
+    /** mask of the submission ring */
+    unsigned sq_mask;
+    /** number of entries of the submission ring */
+    unsigned sq_entries;
+    /** indirection array of the submission ring */
+    unsigned *sq_array;
+    /** local tail of the submission ring */
+    unsigned sq_local_tail;
+    /** head of the completion ring */
+    unsigned *cq_head;
+    /** tail of the completion ring (written by the kernel) */
+    unsigned *cq_tail;
+    /** mask of the completion ring */
+    unsigned cq_mask;
+    /** array of completion entries */
+    struct io_uring_cqe *cqes;
+
+    /** registered buffers */
+    struct iovec *buffers;
+    /** number of registered buffers */
+    unsigned int nb_buffers;
+
+    /** requests in flight */
+    struct uchain ops_inflight;
+    /** completed requests not yet processed */
+    struct uchain ops_completed;
+    /** recycled requests */
+    struct uchain ops_free;
+
+    /** heap of active timers */
+    struct uheap timers;
+    /** list of active idlers */
+    struct uchain idlers;
+    /** number of active blocking pumps */
+    unsigned int nb_blocking;
+
+    /** common structure */
+    struct upump_common_mgr common_mgr;
+
+    /** extra space for upool */
+    uint8_t upool_extra[];
+};
+
+UBASE_FROM_TO(upump_uring_mgr, upump_mgr, upump_mgr, common_mgr.mgr)
+UBASE_FROM_TO(upump_uring_mgr, urefcount, urefcount, urefcount)
+
+/** @This stores local structures.
+ */
+struct upump_uring {
+    /** type of event to watch */
+    int event;
+    /** true if the pump is active */
+    bool active;
+    /** blocking status of the active pump */
+    bool blocking;
+
+    /** file descriptor (signalfd for signals) */
+    int fd;
+    /** signal number */
+    int signal;
+    /** timer first expiration */
+    uint64_t after;
+    /** timer repeat period */
+    uint64_t repeat;
+    /** node in the heap of timers */
+    struct uheap_node uheap_node;
+    /** structure for the list of idlers */
+    struct uchain uchain;
+    /** pending request */
+    struct upump_uring_op *op;
+    /** result of the last I/O operation */
+    ssize_t result;
+
+    /** common structure */
+    struct upump_common common;
+};
+
+UBASE_FROM_TO(upump_uring, upump, upump, common.upump)
+UBASE_FROM_TO(upump_uring, uchain, uchain, uchain)
+UBASE_FROM_TO(upump_uring, uheap_node, uheap_node, uheap_node)
+
+/** @internal @This returns the current monotonic date.
+ *
+ * @return date in units of 27 MHz
+ */
+static uint64_t upump_uring_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UCLOCK_FREQ +
+           (uint64_t)ts.tv_nsec * UCLOCK_FREQ / UINT64_C(1000000000);
+}
+
+/** @internal @This calls io_uring_enter(2).
+ *
+ * @param uring_mgr description structure of the manager
+ * @param min_complete number of completions to wait for
+ * @param timeout maximum time to wait in units of 27 MHz, or UINT64_MAX
+ * @return 0, or a negative errno value
+ */
+static int upump_uring_mgr_enter(struct upump_uring_mgr *uring_mgr,
+                                 unsigned int min_complete, uint64_t timeout)
+{
+    unsigned int to_submit = uring_mgr->sq_local_tail -
+        __atomic_load_n(uring_mgr->sq_head, __ATOMIC_ACQUIRE);
+    if (!to_submit && !min_complete)
+        return 0;
+
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    if (min_complete && timeout != UINT64_MAX) {
+        ts.tv_sec = timeout / UCLOCK_FREQ;
+        ts.tv_nsec = (timeout % UCLOCK_FREQ) * UINT64_C(1000000000) /
+                     UCLOCK_FREQ;
+        arg.ts = (uintptr_t)&ts;
+    }
+
+    unsigned int flags = IORING_ENTER_EXT_ARG;
+    if (min_complete)
+        flags |= IORING_ENTER_GETEVENTS;
+    if (syscall(__NR_io_uring_enter, uring_mgr->fd, to_submit, min_complete,
+                flags, &arg, sizeof(arg)) < 0)
+        return -errno;
+    return 0;
+}
+
+/** @internal @This returns a free submission entry, submitting the pending
+ * entries if the ring is full.
+ *
+ * @param uring_mgr description structure of the manager
+ * @param user_data user data of the request
+ * @return pointer to a cleared submission entry
+ */
+static struct io_uring_sqe *upump_uring_mgr_get_sqe(
+        struct upump_uring_mgr *uring_mgr, uint64_t user_data)
+{
+    while (uring_mgr->sq_local_tail -
+               __atomic_load_n(uring_mgr->sq_head, __ATOMIC_ACQUIRE) >=
+           uring_mgr->sq_entries)
+        upump_uring_mgr_enter(uring_mgr, 0, 0);
+
+    unsigned index = uring_mgr->sq_local_tail & uring_mgr->sq_mask;
+    struct io_uring_sqe *sqe = &uring_mgr->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = user_data;
+    uring_mgr->sq_array[index] = index;
+    uring_mgr->sq_local_tail++;
+    __atomic_store_n(uring_mgr->sq_tail, uring_mgr->sq_local_tail,
+                     __ATOMIC_RELEASE);
+    return sqe;
+}
+
+/** @internal @This allocates a request for a pump.
+ *
+ * @param uring_mgr description structure of the manager
+ * @param upump_uring pump waiting for the completion
+ * @return pointer to the request, or NULL in case of allocation error
+ */
+static struct upump_uring_op *upump_uring_op_alloc(
+        struct upump_uring_mgr *uring_mgr, struct upump_uring *upump_uring)
+{
+    struct uchain *uchain = ulist_pop(&uring_mgr->ops_free);
+    struct upump_uring_op *op;
+    if (uchain != NULL)
+        op = upump_uring_op_from_uchain(uchain);
+    else {
+        op = malloc(sizeof(struct upump_uring_op));
+        if (unlikely(op == NULL))
+            return NULL;
+        uchain_init(&op->uchain);
+    }
+    op->upump_uring = upump_uring;
+    op->res = 0;
+    op->completed = false;
+    ulist_add(&uring_mgr->ops_inflight, upump_uring_op_to_uchain(op));
+    return op;
+}
+
+/** @internal @This reaps the available completions.
+ *
+ * @param uring_mgr description structure of the manager
+ */
+static void upump_uring_mgr_reap(struct upump_uring_mgr *uring_mgr)
+{
+    unsigned head = *uring_mgr->cq_head;
+    unsigned tail = __atomic_load_n(uring_mgr->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        struct io_uring_cqe *cqe = &uring_mgr->cqes[head & uring_mgr->cq_mask];
+        struct upump_uring_op *op =
+            (struct upump_uring_op *)(uintptr_t)cqe->user_data;
+        if (op != NULL) {
+            op->res = cqe->res;
+            op->completed = true;
+            ulist_delete(upump_uring_op_to_uchain(op));
+            ulist_add(&uring_mgr->ops_completed, upump_uring_op_to_uchain(op));
+        }
+        head++;
+    }
+    __atomic_store_n(uring_mgr->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/** @internal @This submits a poll request for a pump.
+ *
+ * @param upump_uring description structure of the pump
+ * @param events poll events to wait for
+ */
+static void upump_uring_poll(struct upump_uring *upump_uring, short events)
+{
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+
+    upump_uring->op = upump_uring_op_alloc(uring_mgr, upump_uring);
+    if (unlikely(upump_uring->op == NULL))
+        return;
+    struct io_uring_sqe *sqe =
+        upump_uring_mgr_get_sqe(uring_mgr, (uintptr_t)upump_uring->op);
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = upump_uring->fd;
+    sqe->poll32_events = events;
+}
+
+/** @internal @This detaches the pending request of a pump, cancelling it
+ * if it is still in flight.
+ *
+ * @param upump_uring description structure of the pump
+ */
+static void upump_uring_cancel(struct upump_uring *upump_uring)
+{
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    struct upump_uring_op *op = upump_uring->op;
+    if (op == NULL)
+        return;
+    upump_uring->op = NULL;
+
+    if (!op->completed) {
+        struct io_uring_sqe *sqe = upump_uring_mgr_get_sqe(uring_mgr, 0);
+        switch (upump_uring->event) {
+            case UPUMP_TYPE_IO_READ:
+            case UPUMP_TYPE_IO_WRITE:
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                break;
+            default:
+                sqe->opcode = IORING_OP_POLL_REMOVE;
+                break;
+        }
+        sqe->fd = -1;
+        sqe->addr = (uintptr_t)op;
+
+        if (upump_uring->event == UPUMP_TYPE_IO_READ ||
+            upump_uring->event == UPUMP_TYPE_IO_WRITE) {
+            /* the buffer must not be accessed after the pump is stopped */
+            while (!op->completed) {
+                int err = upump_uring_mgr_enter(uring_mgr, 1, UINT64_MAX);
+                if (unlikely(err < 0 && err != -EINTR && err != -EAGAIN &&
+                             err != -EBUSY))
+                    break;
+                upump_uring_mgr_reap(uring_mgr);
+            }
+        }
+    }
+    op->upump_uring = NULL;
+}
+
+/** @This allocates a new upump_uring.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_uring_mgr structure
+ * @param event type of event to watch for
+ * @param args optional parameters depending on event type
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static struct upump *upump_uring_alloc(struct upump_mgr *mgr,
+                                       int event, va_list args)
+{
+    struct upump_uring_mgr *uring_mgr = upump_uring_mgr_from_upump_mgr(mgr);
+    struct upump_uring *upump_uring =
+        upool_alloc(&uring_mgr->common_mgr.upump_pool, struct upump_uring *);
+    if (unlikely(upump_uring == NULL))
+        return NULL;
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+
+    upump_uring->fd = -1;
+    upump_uring->signal = 0;
+    upump_uring->after = upump_uring->repeat = 0;
+    switch (event) {
+        case UPUMP_TYPE_IDLER:
+            break;
+        case UPUMP_TYPE_TIMER:
+            upump_uring->after = va_arg(args, uint64_t);
+            upump_uring->repeat = va_arg(args, uint64_t);
+            break;
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+            upump_uring->fd = va_arg(args, int);
+            break;
+        case UPUMP_TYPE_SIGNAL: {
+            upump_uring->signal = va_arg(args, int);
+            sigset_t sigset;
+            sigemptyset(&sigset);
+            sigaddset(&sigset, upump_uring->signal);
+            upump_uring->fd = signalfd(-1, &sigset, SFD_NONBLOCK | SFD_CLOEXEC);
+            if (unlikely(upump_uring->fd == -1)) {
+                upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+                return NULL;
+            }
+            break;
+        }
+        case UPUMP_TYPE_IO_READ:
+        case UPUMP_TYPE_IO_WRITE:
+            upump_uring->fd = va_arg(args, int);
+            break;
+        default:
+            upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+            return NULL;
+    }
+    upump_uring->event = event;
+    upump_uring->active = false;
+    upump_uring->blocking = false;
+    uheap_node_init(&upump_uring->uheap_node);
+    uchain_init(&upump_uring->uchain);
+    upump_uring->op = NULL;
+    upump_uring->result = 0;
+
+    upump_common_init(upump);
+
+    return upump;
+}
+
+/** @internal @This arms the poll request of a pump, if needed.
+ *
+ * @param upump_uring description structure of the pump
+ */
+static void upump_uring_arm(struct upump_uring *upump_uring)
+{
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_SIGNAL:
+            upump_uring_poll(upump_uring, POLLIN);
+            break;
+        case UPUMP_TYPE_FD_WRITE:
+            upump_uring_poll(upump_uring, POLLOUT);
+            break;
+        default:
+            break;
+    }
+}
+
+/** @This starts a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_uring_real_start(struct upump *upump, bool status)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    if (upump_uring->active)
+        return;
+
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_IDLER:
+            ulist_add(&uring_mgr->idlers,
+                      upump_uring_to_uchain(upump_uring));
+            break;
+        case UPUMP_TYPE_TIMER:
+            if (unlikely(!ubase_check(uheap_update(&uring_mgr->timers,
+                                &upump_uring->uheap_node,
+                                upump_uring_now() + upump_uring->after))))
+                return;
+            break;
+        case UPUMP_TYPE_SIGNAL: {
+            sigset_t sigset;
+            sigemptyset(&sigset);
+            sigaddset(&sigset, upump_uring->signal);
+            pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+            upump_uring_arm(upump_uring);
+            break;
+        }
+        default:
+            upump_uring_arm(upump_uring);
+            break;
+    }
+
+    upump_uring->active = true;
+    upump_uring->blocking = status;
+    if (status)
+        uring_mgr->nb_blocking++;
+}
+
+/** @This stops a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_uring_real_stop(struct upump *upump, bool status)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    if (!upump_uring->active)
+        return;
+
+    upump_uring->active = false;
+    if (upump_uring->blocking)
+        uring_mgr->nb_blocking--;
+
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_IDLER:
+            ulist_delete(upump_uring_to_uchain(upump_uring));
+            break;
+        case UPUMP_TYPE_TIMER:
+            uheap_delete(&uring_mgr->timers, &upump_uring->uheap_node);
+            break;
+        case UPUMP_TYPE_SIGNAL: {
+            upump_uring_cancel(upump_uring);
+            sigset_t sigset;
+            sigemptyset(&sigset);
+            sigaddset(&sigset, upump_uring->signal);
+            pthread_sigmask(SIG_UNBLOCK, &sigset, NULL);
+            break;
+        }
+        default:
+            upump_uring_cancel(upump_uring);
+            break;
+    }
+}
+
+/** @This restarts a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_uring_real_restart(struct upump *upump, bool status)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_TIMER:
+            if (!upump_uring->repeat) {
+                upump_uring_real_stop(upump, status);
+                break;
+            }
+            if (unlikely(!ubase_check(uheap_update(&uring_mgr->timers,
+                                &upump_uring->uheap_node,
+                                upump_uring_now() + upump_uring->repeat)))) {
+                upump_uring_real_stop(upump, status);
+                break;
+            }
+            if (!upump_uring->active) {
+                upump_uring->active = true;
+                upump_uring->blocking = status;
+                if (status)
+                    uring_mgr->nb_blocking++;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/** @internal @This submits an I/O operation on a started I/O pump.
+ *
+ * @param upump description structure of the pump
+ * @param buffer buffer to read into or write from
+ * @param size size of the buffer
+ * @param offset offset in the file, or UINT64_MAX
+ * @return an error code
+ */
+static int upump_uring_submit_io(struct upump *upump, void *buffer,
+                                 size_t size, uint64_t offset)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    if (unlikely(upump_uring->event != UPUMP_TYPE_IO_READ &&
+                 upump_uring->event != UPUMP_TYPE_IO_WRITE))
+        return UBASE_ERR_UNHANDLED;
+    if (unlikely(!upump_uring->active || size > UINT32_MAX))
+        return UBASE_ERR_INVALID;
+    if (unlikely(upump_uring->op != NULL))
+        return UBASE_ERR_BUSY;
+
+    upump_uring->op = upump_uring_op_alloc(uring_mgr, upump_uring);
+    if (unlikely(upump_uring->op == NULL))
+        return UBASE_ERR_ALLOC;
+
+    bool read = upump_uring->event == UPUMP_TYPE_IO_READ;
+    struct io_uring_sqe *sqe =
+        upump_uring_mgr_get_sqe(uring_mgr, (uintptr_t)upump_uring->op);
+    sqe->opcode = read ? IORING_OP_READ : IORING_OP_WRITE;
+    sqe->fd = upump_uring->fd;
+    sqe->addr = (uintptr_t)buffer;
+    sqe->len = size;
+    sqe->off = offset;
+
+    for (unsigned int i = 0; i < uring_mgr->nb_buffers; i++) {
+        uint8_t *base = uring_mgr->buffers[i].iov_base;
+        if ((uint8_t *)buffer >= base &&
+            (uint8_t *)buffer + size <= base + uring_mgr->buffers[i].iov_len) {
+            sqe->opcode = read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+            sqe->buf_index = i;
+            break;
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @This released the memory space previously used by a pump.
+ * Please note that the pump must be stopped before.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_uring_free(struct upump *upump)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    upump_stop(upump);
+    upump_common_clean(upump);
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    if (upump_uring->event == UPUMP_TYPE_SIGNAL)
+        close(upump_uring->fd);
+    upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+}
+
+/** @internal @This allocates the data structure.
+ *
+ * @param upool pointer to upool
+ * @return pointer to upump_uring or NULL in case of allocation error
+ */
+static void *upump_uring_alloc_inner(struct upool *upool)
+{
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_pool(upool);
+    struct upump_uring *upump_uring = malloc(sizeof(struct upump_uring));
+    if (unlikely(upump_uring == NULL))
+        return NULL;
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+    upump->mgr = upump_common_mgr_to_upump_mgr(common_mgr);
+    return upump_uring;
+}
+
+/** @internal @This frees a upump_uring.
+ *
+ * @param upool pointer to upool
+ * @param upump_uring pointer to a upump_uring structure to free
+ */
+static void upump_uring_free_inner(struct upool *upool, void *upump_uring)
+{
+    free(upump_uring);
+}
+
+/** @This processes control commands on a upump_uring.
+ *
+ * @param upump description structure of the pump
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_uring_control(struct upump *upump, int command, va_list args)
+{
+    switch (command) {
+        case UPUMP_START:
+            upump_common_start(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_RESTART:
+            upump_common_restart(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_STOP:
+            upump_common_stop(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_FREE:
+            upump_uring_free(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_GET_STATUS: {
+            int *status_p = va_arg(args, int *);
+            upump_common_get_status(upump, status_p);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_SET_STATUS: {
+            int status = va_arg(args, int);
+            upump_common_set_status(upump, status);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_ALLOC_BLOCKER: {
+            struct upump_blocker **p = va_arg(args, struct upump_blocker **);
+            *p = upump_common_blocker_alloc(upump);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_FREE_BLOCKER: {
+            struct upump_blocker *blocker =
+                va_arg(args, struct upump_blocker *);
+            upump_common_blocker_free(blocker);
+            return UBASE_ERR_NONE;
+        }
+
+        case UPUMP_IO_SUBMIT: {
+            void *buffer = va_arg(args, void *);
+            size_t size = va_arg(args, size_t);
+            uint64_t offset = va_arg(args, uint64_t);
+            return upump_uring_submit_io(upump, buffer, size, offset);
+        }
+        case UPUMP_IO_GET_RESULT: {
+            struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+            if (unlikely(upump_uring->event != UPUMP_TYPE_IO_READ &&
+                         upump_uring->event != UPUMP_TYPE_IO_WRITE))
+                return UBASE_ERR_UNHANDLED;
+            ssize_t *result_p = va_arg(args, ssize_t *);
+            *result_p = upump_uring->result;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This processes the completed requests and dispatches the
+ * pumps.
+ *
+ * @param uring_mgr description structure of the manager
+ */
+static void upump_uring_mgr_complete(struct upump_uring_mgr *uring_mgr)
+{
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&uring_mgr->ops_completed)) != NULL) {
+        struct upump_uring_op *op = upump_uring_op_from_uchain(uchain);
+        struct upump_uring *upump_uring = op->upump_uring;
+        int32_t res = op->res;
+        ulist_add(&uring_mgr->ops_free, uchain);
+        if (upump_uring == NULL)
+            continue;
+        upump_uring->op = NULL;
+
+        switch (upump_uring->event) {
+            case UPUMP_TYPE_SIGNAL: {
+                struct signalfd_siginfo siginfo;
+                while (read(upump_uring->fd, &siginfo, sizeof(siginfo)) ==
+                       sizeof(siginfo));
+                upump_uring_arm(upump_uring);
+                break;
+            }
+            case UPUMP_TYPE_IO_READ:
+            case UPUMP_TYPE_IO_WRITE:
+                upump_uring->result = res;
+                break;
+            default:
+                upump_uring_arm(upump_uring);
+                break;
+        }
+        upump_common_dispatch(upump_uring_to_upump(upump_uring));
+    }
+}
+
+/** @internal @This dispatches the expired timers.
+ *
+ * @param uring_mgr description structure of the manager
+ */
+static void upump_uring_mgr_expire(struct upump_uring_mgr *uring_mgr)
+{
+    uint64_t now = upump_uring_now();
+    struct uheap_node *node;
+    while ((node = uheap_peek(&uring_mgr->timers)) != NULL &&
+           node->key <= now) {
+        struct upump_uring *upump_uring = upump_uring_from_uheap_node(node);
+        struct upump *upump = upump_uring_to_upump(upump_uring);
+        if (upump_uring->repeat) {
+            uint64_t key = node->key + upump_uring->repeat;
+            if (key <= now)
+                key = now + upump_uring->repeat;
+            uheap_update(&uring_mgr->timers, node, key);
+        } else
+            upump_uring_real_stop(upump, upump_uring->blocking);
+        upump_common_dispatch(upump);
+    }
+}
+
+/** @internal @This dispatches the active idlers once.
+ *
+ * @param uring_mgr description structure of the manager
+ */
+static void upump_uring_mgr_idle(struct upump_uring_mgr *uring_mgr)
+{
+    struct uchain idlers;
+    ulist_init(&idlers);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&uring_mgr->idlers)) != NULL)
+        ulist_add(&idlers, uchain);
+
+    /* idlers stopped by a callback are removed from the local list */
+    while ((uchain = ulist_pop(&idlers)) != NULL) {
+        ulist_add(&uring_mgr->idlers, uchain);
+        upump_common_dispatch(
+            upump_uring_to_upump(upump_uring_from_uchain(uchain)));
+    }
+}
+
+/** @internal @This runs an event loop.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param mutex mutual exclusion primitives to access the event loop
+ * @return an error code
+ */
+static int upump_uring_mgr_run(struct upump_mgr *mgr, struct umutex *mutex)
+{
+    struct upump_uring_mgr *uring_mgr = upump_uring_mgr_from_upump_mgr(mgr);
+    int err = UBASE_ERR_NONE;
+
+    if (mutex != NULL)
+        umutex_lock(mutex);
+
+    for ( ; ; ) {
+        upump_uring_mgr_complete(uring_mgr);
+        upump_uring_mgr_expire(uring_mgr);
+        upump_uring_mgr_idle(uring_mgr);
+        if (!uring_mgr->nb_blocking)
+            break;
+
+        uint64_t timeout = UINT64_MAX;
+        unsigned int min_complete = 1;
+        struct uheap_node *node = uheap_peek(&uring_mgr->timers);
+        if (!ulist_empty(&uring_mgr->idlers))
+            min_complete = 0;
+        else if (node != NULL) {
+            uint64_t now = upump_uring_now();
+            timeout = node->key > now ? node->key - now : 0;
+        }
+
+        if (mutex != NULL && min_complete)
+            umutex_unlock(mutex);
+        int ret = upump_uring_mgr_enter(uring_mgr, min_complete, timeout);
+        if (mutex != NULL && min_complete)
+            umutex_lock(mutex);
+        if (unlikely(ret < 0 && ret != -EINTR && ret != -ETIME &&
+                     ret != -EBUSY && ret != -EAGAIN)) {
+            err = UBASE_ERR_EXTERNAL;
+            break;
+        }
+        upump_uring_mgr_reap(uring_mgr);
+    }
+
+    if (mutex != NULL)
+        umutex_unlock(mutex);
+
+    return err;
+}
+
+/** @This processes control commands on a upump_uring_mgr.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_uring_mgr_control(struct upump_mgr *mgr,
+                                   int command, va_list args)
+{
+    switch (command) {
+        case UPUMP_MGR_RUN: {
+            struct umutex *mutex = va_arg(args, struct umutex *);
+            return upump_uring_mgr_run(mgr, mutex);
+        }
+        case UPUMP_MGR_VACUUM:
+            upump_common_mgr_vacuum(mgr);
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This releases the ring of a manager.
+ *
+ * @param uring_mgr description structure of the manager
+ */
+static void upump_uring_mgr_unmap(struct upump_uring_mgr *uring_mgr)
+{
+    if (uring_mgr->sqes != NULL)
+        munmap(uring_mgr->sqes, uring_mgr->sqes_size);
+    if (uring_mgr->cq_ring != NULL && uring_mgr->cq_ring != uring_mgr->sq_ring)
+        munmap(uring_mgr->cq_ring, uring_mgr->cq_ring_size);
+    if (uring_mgr->sq_ring != NULL)
+        munmap(uring_mgr->sq_ring, uring_mgr->sq_ring_size);
+    close(uring_mgr->fd);
+}
+
+/** @internal @This frees a list of requests.
+ *
+ * @param list list of requests
+ */
+static void upump_uring_ops_free(struct uchain *list)
+{
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(list)) != NULL)
+        free(upump_uring_op_from_uchain(uchain));
+}
+
+/** @This frees a upump manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void upump_uring_mgr_free(struct urefcount *urefcount)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_urefcount(urefcount);
+    upump_common_mgr_clean(upump_uring_mgr_to_upump_mgr(uring_mgr));
+    /* closing the ring cancels the requests in flight */
+    upump_uring_mgr_unmap(uring_mgr);
+    upump_uring_ops_free(&uring_mgr->ops_inflight);
+    upump_uring_ops_free(&uring_mgr->ops_completed);
+    upump_uring_ops_free(&uring_mgr->ops_free);
+    uheap_clean(&uring_mgr->timers);
+    free(uring_mgr->buffers);
+    free(uring_mgr);
+}
+
+/** @internal @This sets up the ring of a manager.
+ *
+ * @param uring_mgr description structure of the manager
+ * @param entries number of entries of the submission ring
+ * @return an error code
+ */
+static int upump_uring_mgr_setup(struct upump_uring_mgr *uring_mgr,
+                                 unsigned int entries)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    uring_mgr->sq_ring = uring_mgr->cq_ring = NULL;
+    uring_mgr->sqes = NULL;
+    uring_mgr->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (unlikely(uring_mgr->fd < 0))
+        return UBASE_ERR_EXTERNAL;
+    if (unlikely(!(p.features & IORING_FEAT_EXT_ARG) ||
+                 !(p.features & IORING_FEAT_NODROP))) {
+        close(uring_mgr->fd);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    uring_mgr->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    uring_mgr->cq_ring_size =
+        p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (uring_mgr->cq_ring_size > uring_mgr->sq_ring_size)
+            uring_mgr->sq_ring_size = uring_mgr->cq_ring_size;
+        uring_mgr->cq_ring_size = uring_mgr->sq_ring_size;
+    }
+
+    void *sq_ring = mmap(NULL, uring_mgr->sq_ring_size,
+                         PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         uring_mgr->fd, IORING_OFF_SQ_RING);
+    if (unlikely(sq_ring == MAP_FAILED)) {
+        upump_uring_mgr_unmap(uring_mgr);
+        return UBASE_ERR_ALLOC;
+    }
+    uring_mgr->sq_ring = sq_ring;
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        uring_mgr->cq_ring = sq_ring;
+    else {
+        void *cq_ring = mmap(NULL, uring_mgr->cq_ring_size,
+                             PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             uring_mgr->fd, IORING_OFF_CQ_RING);
+        if (unlikely(cq_ring == MAP_FAILED)) {
+            upump_uring_mgr_unmap(uring_mgr);
+            return UBASE_ERR_ALLOC;
+        }
+        uring_mgr->cq_ring = cq_ring;
+    }
+
+    uring_mgr->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, uring_mgr->sqes_size,
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      uring_mgr->fd, IORING_OFF_SQES);
+    if (unlikely(sqes == MAP_FAILED)) {
+        upump_uring_mgr_unmap(uring_mgr);
+        return UBASE_ERR_ALLOC;
+    }
+    uring_mgr->sqes = sqes;
+
+    uint8_t *sq = uring_mgr->sq_ring;
+    uring_mgr->sq_head = (unsigned *)(sq + p.sq_off.head);
+    uring_mgr->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    uring_mgr->sq_mask = *(unsigned *)(sq + p.sq_off.ring_mask);
+    uring_mgr->sq_entries = *(unsigned *)(sq + p.sq_off.ring_entries);
+    uring_mgr->sq_array = (unsigned *)(sq + p.sq_off.array);
+    uring_mgr->sq_local_tail = *uring_mgr->sq_tail;
+
+    uint8_t *cq = uring_mgr->cq_ring;
+    uring_mgr->cq_head = (unsigned *)(cq + p.cq_off.head);
+    uring_mgr->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    uring_mgr->cq_mask = *(unsigned *)(cq + p.cq_off.ring_mask);
+    uring_mgr->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return UBASE_ERR_NONE;
+}
+
+/** @This allocates and initializes a upump_mgr structure bound to a new
+ * io_uring instance.
+ *
+ * @param entries number of entries of the submission ring
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @return pointer to the wrapped upump_mgr structure, or NULL if io_uring is
+ * not available
+ */
+struct upump_mgr *upump_uring_mgr_alloc(unsigned int entries,
+                                        uint16_t upump_pool_depth,
+                                        uint16_t upump_blocker_pool_depth)
+{
+    struct upump_uring_mgr *uring_mgr =
+        malloc(sizeof(struct upump_uring_mgr) +
+               upump_common_mgr_sizeof(upump_pool_depth,
+                                       upump_blocker_pool_depth));
+    if (unlikely(uring_mgr == NULL))
+        return NULL;
+
+    if (unlikely(!ubase_check(upump_uring_mgr_setup(uring_mgr,
+                    entries ? entries : UPUMP_URING_DEFAULT_ENTRIES)))) {
+        free(uring_mgr);
+        return NULL;
+    }
+
+    struct upump_mgr *mgr = upump_uring_mgr_to_upump_mgr(uring_mgr);
+    mgr->signature = UPUMP_URING_SIGNATURE;
+    urefcount_init(upump_uring_mgr_to_urefcount(uring_mgr),
+                   upump_uring_mgr_free);
+    uring_mgr->common_mgr.mgr.refcount =
+        upump_uring_mgr_to_urefcount(uring_mgr);
+    uring_mgr->common_mgr.mgr.upump_alloc = upump_uring_alloc;
+    uring_mgr->common_mgr.mgr.upump_control = upump_uring_control;
+    uring_mgr->common_mgr.mgr.upump_mgr_control = upump_uring_mgr_control;
+    upump_common_mgr_init(mgr, upump_pool_depth, upump_blocker_pool_depth,
+                          uring_mgr->upool_extra,
+                          upump_uring_real_start, upump_uring_real_stop,
+                          upump_uring_real_restart,
+                          upump_uring_alloc_inner, upump_uring_free_inner);
+
+    uring_mgr->buffers = NULL;
+    uring_mgr->nb_buffers = 0;
+    ulist_init(&uring_mgr->ops_inflight);
+    ulist_init(&uring_mgr->ops_completed);
+    ulist_init(&uring_mgr->ops_free);
+    uheap_init(&uring_mgr->timers);
+    ulist_init(&uring_mgr->idlers);
+    uring_mgr->nb_blocking = 0;
+    return mgr;
+}
+
+/** @This registers the regions of memory that may be used by I/O pumps as
+ * fixed buffers, replacing the previously registered ones. It must not be
+ * called while an operation is pending.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param iovecs array of regions, or NULL to unregister the regions
+ * @param nb_iovecs number of regions
+ * @return an error code
+ */
+int upump_uring_mgr_register_buffers(struct upump_mgr *mgr,
+                                     const struct iovec *iovecs,
+                                     unsigned int nb_iovecs)
+{
+    if (unlikely(mgr == NULL || mgr->signature != UPUMP_URING_SIGNATURE))
+        return UBASE_ERR_INVALID;
+    struct upump_uring_mgr *uring_mgr = upump_uring_mgr_from_upump_mgr(mgr);
+
+    if (uring_mgr->nb_buffers) {
+        syscall(__NR_io_uring_register, uring_mgr->fd,
+                IORING_UNREGISTER_BUFFERS, NULL, 0);
+        free(uring_mgr->buffers);
+        uring_mgr->buffers = NULL;
+        uring_mgr->nb_buffers = 0;
+    }
+    if (iovecs == NULL || !nb_iovecs)
+        return UBASE_ERR_NONE;
+
+    struct iovec *buffers = malloc(nb_iovecs * sizeof(struct iovec));
+    if (unlikely(buffers == NULL))
+        return UBASE_ERR_ALLOC;
+    memcpy(buffers, iovecs, nb_iovecs * sizeof(struct iovec));
+
+    if (unlikely(syscall(__NR_io_uring_register, uring_mgr->fd,
+                         IORING_REGISTER_BUFFERS, buffers, nb_iovecs) < 0)) {
+        free(buffers);
+        return UBASE_ERR_EXTERNAL;
+    }
+    uring_mgr->buffers = buffers;
+    uring_mgr->nb_buffers = nb_iovecs;
+    return UBASE_ERR_NONE;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-modules/aes_cbc.h"
+
+/* in blocks of 16 octets */
+#define BUF_SIZE 64
+
+void checkasm_check_aes(void)
+{
+    void (*decrypt)(uint8_t *buf, uintptr_t blocks, const uint8_t round_keys[11][16], uint8_t iv[16]) =
+        upipe_aes_cbc_decrypt_c;
+
+    int cpu_flags = av_get_cpu_flags();
+
+#if defined(HAVE_X86ASM) && defined(AV_CPU_FLAG_AESNI)
+    if (cpu_flags & AV_CPU_FLAG_AESNI)
+        decrypt = upipe_aes_cbc_decrypt_aesni;
+#endif
+
+    if (check_func(decrypt, "aes_cbc_decrypt")) {
+        uint8_t buf0[16 * BUF_SIZE];
+        uint8_t buf1[16 * BUF_SIZE];
+        uint8_t iv0[16], iv1[16];
+        uint8_t key[16];
+        uint8_t round_keys[11][16];
+        declare_func(void, uint8_t *buf, uintptr_t blocks,
+                     const uint8_t round_keys[11][16], uint8_t iv[16]);
+
+        /* cover the pipelined loop and the block per block tail */
+        for (uintptr_t blocks = 1; blocks <= BUF_SIZE; blocks++) {
+            for (int i = 0; i < 16; i++) {
+                key[i] = rnd();
+                iv0[i] = iv1[i] = rnd();
+            }
+            for (int i = 0; i < 16 * BUF_SIZE; i++)
+                buf0[i] = buf1[i] = rnd();
+            upipe_aes_cbc_key_expansion(key, round_keys);
+
+            call_ref(buf0, blocks, round_keys, iv0);
+            call_new(buf1, blocks, round_keys, iv1);
+            if (memcmp(buf0, buf1, sizeof(buf0)) || memcmp(iv0, iv1, 16))
+                fail();
+        }
+        bench_new(buf1, BUF_SIZE, round_keys, iv1);
+    }
+    report("aes_cbc_decrypt");
+}
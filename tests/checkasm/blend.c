@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe/ubuf_pic_blend.h"
+
+#define BUF_SIZE 512
+/* number of pixels processed per iteration by the widest kernels */
+#define STEP 16
+
+#define randomize_buffers(type, mask)               \
+    do {                                            \
+        for (int i = 0; i < BUF_SIZE; i++) {        \
+            type r = rnd() & mask;                  \
+            dst0[i] = dst1[i] = r;                  \
+            src[i] = rnd() & mask;                  \
+        }                                           \
+        for (int i = 0; i < 2 * BUF_SIZE; i++)      \
+            a[i] = rnd();                           \
+    } while (0)
+
+#define check_blend_const(type, mask)                                       \
+    do {                                                                    \
+        type dst0[BUF_SIZE];                                                \
+        type dst1[BUF_SIZE];                                                \
+        type src[BUF_SIZE];                                                 \
+        uint8_t a[2 * BUF_SIZE];                                            \
+        declare_func(void, type *dst, const type *src, uintptr_t pixels,    \
+                     int alpha);                                            \
+                                                                            \
+        for (uintptr_t width = STEP; width <= BUF_SIZE; width += STEP) {    \
+            int alpha = rnd() & 0xff;                                       \
+            randomize_buffers(type, mask);                                  \
+            call_ref(dst0, src, width, alpha);                              \
+            call_new(dst1, src, width, alpha);                              \
+            if (memcmp(dst0, dst1, sizeof(dst0)))                           \
+                fail();                                                     \
+            bench_new(dst1, src, width, alpha);                             \
+        }                                                                   \
+    } while (0)
+
+#define check_blend_alpha(type, mask)                                       \
+    do {                                                                    \
+        type dst0[BUF_SIZE];                                                \
+        type dst1[BUF_SIZE];                                                \
+        type src[BUF_SIZE];                                                 \
+        uint8_t a[2 * BUF_SIZE];                                            \
+        declare_func(void, type *dst, const type *src, const uint8_t *a,    \
+                     uintptr_t pixels, int alpha);                          \
+                                                                            \
+        for (uintptr_t width = STEP; width <= BUF_SIZE; width += STEP) {    \
+            int alpha = rnd() & 1 ? 0xff : rnd() & 0xff;                    \
+            randomize_buffers(type, mask);                                  \
+            call_ref(dst0, src, a, width, alpha);                           \
+            call_new(dst1, src, a, width, alpha);                           \
+            if (memcmp(dst0, dst1, sizeof(dst0)))                           \
+                fail();                                                     \
+            bench_new(dst1, src, a, width, alpha);                          \
+        }                                                                   \
+    } while (0)
+
+#define check_blend_threshold(type, mask)                                   \
+    do {                                                                    \
+        type dst0[BUF_SIZE];                                                \
+        type dst1[BUF_SIZE];                                                \
+        type src[BUF_SIZE];                                                 \
+        uint8_t a[2 * BUF_SIZE];                                            \
+        declare_func(void, type *dst, const type *src, const uint8_t *a,    \
+                     uintptr_t pixels, int alpha, int threshold);           \
+                                                                            \
+        for (uintptr_t width = STEP; width <= BUF_SIZE; width += STEP) {    \
+            int alpha = rnd() & 1 ? 0xff : rnd() & 0xff;                    \
+            int threshold = 1 + rnd() % 0xfe;                               \
+            randomize_buffers(type, mask);                                  \
+            call_ref(dst0, src, a, width, alpha, threshold);                \
+            call_new(dst1, src, a, width, alpha, threshold);                \
+            if (memcmp(dst0, dst1, sizeof(dst0)))                           \
+                fail();                                                     \
+            bench_new(dst1, src, a, width, alpha, threshold);               \
+        }                                                                   \
+    } while (0)
+
+void checkasm_check_blend(void)
+{
+    struct {
+        void (*const_8)(uint8_t *dst, const uint8_t *src, uintptr_t pixels, int alpha);
+        void (*const_16)(uint16_t *dst, const uint16_t *src, uintptr_t pixels, int alpha);
+        void (*alpha_8)(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha);
+        void (*alpha_8_sub2)(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha);
+        void (*alpha_16)(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha);
+        void (*alpha_16_sub2)(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha);
+        void (*threshold_8)(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold);
+        void (*threshold_8_sub2)(uint8_t *dst, const uint8_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold);
+        void (*threshold_16)(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold);
+        void (*threshold_16_sub2)(uint16_t *dst, const uint16_t *src, const uint8_t *a, uintptr_t pixels, int alpha, int threshold);
+    } s = {
+        .const_8           = upipe_blend_const_8_c,
+        .const_16          = upipe_blend_const_16_c,
+        .alpha_8           = upipe_blend_alpha_8_c,
+        .alpha_8_sub2      = upipe_blend_alpha_8_sub2_c,
+        .alpha_16          = upipe_blend_alpha_16_c,
+        .alpha_16_sub2     = upipe_blend_alpha_16_sub2_c,
+        .threshold_8       = upipe_blend_threshold_8_c,
+        .threshold_8_sub2  = upipe_blend_threshold_8_sub2_c,
+        .threshold_16      = upipe_blend_threshold_16_c,
+        .threshold_16_sub2 = upipe_blend_threshold_16_sub2_c,
+    };
+
+    int cpu_flags = av_get_cpu_flags();
+
+#ifdef HAVE_X86ASM
+#define SETUP(cpu)                                                          \
+    do {                                                                    \
+        s.const_8           = upipe_blend_const_8_##cpu;                    \
+        s.const_16          = upipe_blend_const_16_##cpu;                   \
+        s.alpha_8           = upipe_blend_alpha_8_##cpu;                    \
+        s.alpha_8_sub2      = upipe_blend_alpha_8_sub2_##cpu;               \
+        s.alpha_16          = upipe_blend_alpha_16_##cpu;                   \
+        s.alpha_16_sub2     = upipe_blend_alpha_16_sub2_##cpu;              \
+        s.threshold_8       = upipe_blend_threshold_8_##cpu;                \
+        s.threshold_8_sub2  = upipe_blend_threshold_8_sub2_##cpu;           \
+        s.threshold_16      = upipe_blend_threshold_16_##cpu;               \
+        s.threshold_16_sub2 = upipe_blend_threshold_16_sub2_##cpu;          \
+    } while (0)
+
+    if (cpu_flags & AV_CPU_FLAG_SSE2)
+        SETUP(sse2);
+    if (cpu_flags & AV_CPU_FLAG_AVX2)
+        SETUP(avx2);
+#undef SETUP
+#endif
+
+    if (check_func(s.const_8, "blend_const_8"))
+        check_blend_const(uint8_t, 0xff);
+    report("blend_const_8");
+
+    if (check_func(s.const_16, "blend_const_10"))
+        check_blend_const(uint16_t, 0x3ff);
+    if (check_func(s.const_16, "blend_const_15"))
+        check_blend_const(uint16_t, 0x7fff);
+    report("blend_const_16");
+
+    if (check_func(s.alpha_8, "blend_alpha_8"))
+        check_blend_alpha(uint8_t, 0xff);
+    if (check_func(s.alpha_8_sub2, "blend_alpha_8_sub2"))
+        check_blend_alpha(uint8_t, 0xff);
+    report("blend_alpha_8");
+
+    if (check_func(s.alpha_16, "blend_alpha_10"))
+        check_blend_alpha(uint16_t, 0x3ff);
+    if (check_func(s.alpha_16_sub2, "blend_alpha_10_sub2"))
+        check_blend_alpha(uint16_t, 0x3ff);
+    if (check_func(s.alpha_16, "blend_alpha_15"))
+        check_blend_alpha(uint16_t, 0x7fff);
+    report("blend_alpha_16");
+
+    if (check_func(s.threshold_8, "blend_threshold_8"))
+        check_blend_threshold(uint8_t, 0xff);
+    if (check_func(s.threshold_8_sub2, "blend_threshold_8_sub2"))
+        check_blend_threshold(uint8_t, 0xff);
+    report("blend_threshold_8");
+
+    if (check_func(s.threshold_16, "blend_threshold_10"))
+        check_blend_threshold(uint16_t, 0x3ff);
+    if (check_func(s.threshold_16_sub2, "blend_threshold_10_sub2"))
+        check_blend_threshold(uint16_t, 0x3ff);
+    report("blend_threshold_16");
+}
@@ -74,9 +74,16 @@ static const struct {
     const char *name;
     void (*func)(void);
 } tests[] = {
+    { "aes", checkasm_check_aes },
+    { "blend", checkasm_check_blend },
+    { "deinterlace", checkasm_check_deinterlace },
+    { "pcm", checkasm_check_pcm },
 #ifdef HAVE_SDI
     { "sdidec", checkasm_check_sdidec },
     { "sdienc", checkasm_check_sdienc },
+#endif
+#ifdef HAVE_STARTCODE
+    { "startcode", checkasm_check_startcode },
 #endif
     { "v210dec", checkasm_check_v210dec },
     { "v210enc", checkasm_check_v210enc },
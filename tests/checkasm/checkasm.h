@@ -67,8 +67,13 @@
 #define HAVE_RDTSC 0
 #include "timer.h"
 
+void checkasm_check_aes(void);
+void checkasm_check_blend(void);
+void checkasm_check_deinterlace(void);
+void checkasm_check_pcm(void);
 void checkasm_check_sdidec(void);
 void checkasm_check_sdienc(void);
+void checkasm_check_startcode(void);
 void checkasm_check_v210dec(void);
 void checkasm_check_v210enc(void);
 
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-filters/deinterlace.h"
+
+#define BUF_SIZE 512
+/* lines above and below the interpolated line */
+#define LINES 5
+
+static void check_merge(const char *name, upipe_filter_merge_func merge,
+                        unsigned int mask)
+{
+    if (check_func(merge, "%s", name)) {
+        uint16_t s1[BUF_SIZE], s2[BUF_SIZE], dst0[BUF_SIZE], dst1[BUF_SIZE];
+        declare_func(void, void *dst, const void *s1, const void *s2,
+                     uintptr_t bytes);
+
+        /* cover the main loop and the overlapping last block */
+        for (uintptr_t bytes = 32; bytes <= sizeof(s1); bytes += 2) {
+            for (int i = 0; i < BUF_SIZE; i++) {
+                s1[i] = rnd() & mask;
+                s2[i] = rnd() & mask;
+                dst0[i] = dst1[i] = rnd();
+            }
+            call_ref(dst0, s1, s2, bytes);
+            call_new(dst1, s1, s2, bytes);
+            if (memcmp(dst0, dst1, sizeof(dst0)))
+                fail();
+        }
+        bench_new(dst1, s1, s2, sizeof(s1));
+    }
+}
+
+static void check_yadif(const char *name, upipe_filter_yadif_func yadif)
+{
+    if (check_func(yadif, "%s", name)) {
+        uint8_t prev[LINES * BUF_SIZE], cur[LINES * BUF_SIZE],
+                next[LINES * BUF_SIZE];
+        uint8_t dst0[BUF_SIZE], dst1[BUF_SIZE];
+        /* interpolate the middle line, leaving 3 samples on each side */
+        intptr_t offset = (LINES / 2) * BUF_SIZE + 3;
+        declare_func(void, void *dst, const void *prev, const void *cur,
+                     const void *next, intptr_t w, intptr_t prefs,
+                     intptr_t mrefs, intptr_t parity);
+
+        for (intptr_t w = 16; w <= BUF_SIZE - 6; w += 1 + rnd() % 8) {
+            /* low amplitude noise exercises the temporal and spatial
+             * checks more than full range noise */
+            int base = rnd() & 0xff;
+            int range = rnd() & 1 ? 0x100 : 8;
+            for (int i = 0; i < LINES * BUF_SIZE; i++) {
+                prev[i] = (base + rnd() % range) & 0xff;
+                cur[i] = (base + rnd() % range) & 0xff;
+                next[i] = rnd() & 1 ? cur[i] : (base + rnd() % range) & 0xff;
+            }
+            for (intptr_t parity = 0; parity < 2; parity++) {
+                memset(dst0, 0, sizeof(dst0));
+                memset(dst1, 0, sizeof(dst1));
+                call_ref(dst0, prev + offset, cur + offset, next + offset,
+                         w, BUF_SIZE, -BUF_SIZE, parity);
+                call_new(dst1, prev + offset, cur + offset, next + offset,
+                         w, BUF_SIZE, -BUF_SIZE, parity);
+                if (memcmp(dst0, dst1, sizeof(dst0)))
+                    fail();
+            }
+        }
+        bench_new(dst1, prev + offset, cur + offset, next + offset,
+                  BUF_SIZE - 6, BUF_SIZE, -BUF_SIZE, 1);
+    }
+}
+
+void checkasm_check_deinterlace(void)
+{
+    struct upipe_filter_deint_funcs s = {
+        .merge8 = upipe_filter_merge8_c,
+        .merge16 = upipe_filter_merge16_c,
+        .yadif8 = upipe_filter_yadif8_c,
+        .yadif16 = upipe_filter_yadif16_c,
+    };
+
+    int cpu_flags = av_get_cpu_flags();
+
+#ifdef HAVE_X86ASM
+    if (cpu_flags & AV_CPU_FLAG_SSE2) {
+        s.merge8 = upipe_filter_merge8_sse2;
+        s.merge16 = upipe_filter_merge16_sse2;
+    }
+    if (cpu_flags & AV_CPU_FLAG_AVX2) {
+        s.merge8 = upipe_filter_merge8_avx2;
+        s.merge16 = upipe_filter_merge16_avx2;
+#if defined(__x86_64__)
+        s.yadif8 = upipe_filter_yadif8_avx2;
+#endif
+    }
+#endif
+
+    check_merge("merge8", s.merge8, 0xffff);
+    check_merge("merge16", s.merge16, 0xffff);
+    report("merge");
+
+    check_yadif("yadif8", s.yadif8);
+    report("yadif");
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-modules/pcm.h"
+
+#define BUF_SIZE 1024
+#define MAX_STRIDE 16
+
+void checkasm_check_pcm(void)
+{
+    struct upipe_pcm_funcs s = {
+        .bswap16 = upipe_pcm_bswap16_c,
+        .l24_to_s32 = upipe_pcm_l24_to_s32_c,
+        .s32_to_l24 = upipe_pcm_s32_to_l24_c,
+        .extract32 = upipe_pcm_extract32_c,
+    };
+
+    int cpu_flags = av_get_cpu_flags();
+
+#ifdef HAVE_X86ASM
+    if (cpu_flags & AV_CPU_FLAG_SSE2)
+        s.bswap16 = upipe_pcm_bswap16_sse2;
+    if (cpu_flags & AV_CPU_FLAG_SSSE3) {
+        s.l24_to_s32 = upipe_pcm_l24_to_s32_ssse3;
+        s.s32_to_l24 = upipe_pcm_s32_to_l24_ssse3;
+    }
+    if (cpu_flags & AV_CPU_FLAG_AVX2) {
+        s.bswap16 = upipe_pcm_bswap16_avx2;
+        s.l24_to_s32 = upipe_pcm_l24_to_s32_avx2;
+        s.s32_to_l24 = upipe_pcm_s32_to_l24_avx2;
+        s.extract32 = upipe_pcm_extract32_avx2;
+    }
+#endif
+
+    if (check_func(s.bswap16, "bswap16")) {
+        uint8_t buf0[BUF_SIZE], buf1[BUF_SIZE];
+        declare_func(void, uint8_t *buf, uintptr_t bytes);
+
+        for (uintptr_t bytes = 32; bytes <= BUF_SIZE; bytes += 32) {
+            for (int i = 0; i < BUF_SIZE; i++)
+                buf0[i] = buf1[i] = rnd();
+            call_ref(buf0, bytes);
+            call_new(buf1, bytes);
+            if (memcmp(buf0, buf1, sizeof(buf0)))
+                fail();
+        }
+        bench_new(buf1, BUF_SIZE);
+    }
+    report("bswap16");
+
+    if (check_func(s.l24_to_s32, "l24_to_s32")) {
+        /* the kernels may read 4 octets past the end */
+        uint8_t src[3 * BUF_SIZE + 4];
+        int32_t dst0[BUF_SIZE], dst1[BUF_SIZE];
+        declare_func(void, int32_t *dst, const uint8_t *src,
+                     uintptr_t samples);
+
+        for (int i = 0; i < sizeof(src); i++)
+            src[i] = rnd();
+        for (uintptr_t samples = 8; samples <= BUF_SIZE; samples += 8) {
+            memset(dst0, 0, sizeof(dst0));
+            memset(dst1, 0, sizeof(dst1));
+            call_ref(dst0, src, samples);
+            call_new(dst1, src, samples);
+            if (memcmp(dst0, dst1, sizeof(dst0)))
+                fail();
+        }
+        bench_new(dst1, src, BUF_SIZE);
+    }
+    report("l24_to_s32");
+
+    if (check_func(s.s32_to_l24, "s32_to_l24")) {
+        int32_t src[BUF_SIZE];
+        /* the kernels may write 4 octets past the end */
+        uint8_t dst0[3 * BUF_SIZE + 4], dst1[3 * BUF_SIZE + 4];
+        declare_func(void, uint8_t *dst, const int32_t *src,
+                     uintptr_t samples);
+
+        for (int i = 0; i < BUF_SIZE; i++)
+            src[i] = rnd();
+        for (uintptr_t samples = 8; samples <= BUF_SIZE; samples += 8) {
+            memset(dst0, 0, sizeof(dst0));
+            memset(dst1, 0, sizeof(dst1));
+            call_ref(dst0, src, samples);
+            call_new(dst1, src, samples);
+            if (memcmp(dst0, dst1, 3 * samples))
+                fail();
+        }
+        bench_new(dst1, src, BUF_SIZE);
+    }
+    report("s32_to_l24");
+
+    if (check_func(s.extract32, "extract32")) {
+        uint32_t src[MAX_STRIDE * BUF_SIZE];
+        uint32_t dst0[BUF_SIZE], dst1[BUF_SIZE];
+        declare_func(void, uint32_t *dst, const uint32_t *src,
+                     intptr_t stride, uintptr_t samples);
+
+        for (int i = 0; i < MAX_STRIDE * BUF_SIZE; i++)
+            src[i] = rnd();
+        /* cover the main loop and the overlapping last block */
+        for (intptr_t stride = 1; stride <= MAX_STRIDE; stride++) {
+            for (uintptr_t samples = 8; samples <= 64; samples++) {
+                intptr_t channel = rnd() % stride;
+                memset(dst0, 0, sizeof(dst0));
+                memset(dst1, 0, sizeof(dst1));
+                call_ref(dst0, src + channel, stride, samples);
+                call_new(dst1, src + channel, stride, samples);
+                if (memcmp(dst0, dst1, sizeof(dst0)))
+                    fail();
+            }
+        }
+        /* 16 channels */
+        bench_new(dst1, src, MAX_STRIDE, BUF_SIZE);
+    }
+    report("extract32");
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-framers/startcode.h"
+
+#define BUF_SIZE 4096
+
+/* fill the buffer with payload containing decoys (00 00 xx, 00 01) and
+ * at most one start code */
+static void randomize_buffer(uint8_t *buf, uintptr_t size)
+{
+    for (uintptr_t i = 0; i < size; i++)
+        buf[i] = rnd() | 1;
+    for (int i = rnd() % 16; i > 0; i--) {
+        uintptr_t j = rnd() % (size - 2);
+        buf[j] = 0;
+        buf[j + 1] = rnd() & 1;
+        buf[j + 2] = buf[j + 1] ? 0 : rnd() % 4 == 1 ? 3 : 2;
+    }
+    if (rnd() & 1) {
+        uintptr_t j = rnd() % (size - 2);
+        buf[j] = buf[j + 1] = 0;
+        buf[j + 2] = 1;
+    }
+}
+
+void checkasm_check_startcode(void)
+{
+    uintptr_t (*find)(const uint8_t *buf, uintptr_t size) =
+        upipe_framers_mpeg_find_c;
+
+    int cpu_flags = av_get_cpu_flags();
+
+#ifdef HAVE_X86ASM
+    if (cpu_flags & AV_CPU_FLAG_SSE2)
+        find = upipe_framers_mpeg_find_sse2;
+    if (cpu_flags & AV_CPU_FLAG_AVX2)
+        find = upipe_framers_mpeg_find_avx2;
+#if defined(__x86_64__) && defined(AV_CPU_FLAG_AVX512)
+    if (cpu_flags & AV_CPU_FLAG_AVX512)
+        find = upipe_framers_mpeg_find_avx512;
+#endif
+#endif
+
+    if (check_func(find, "mpeg_find")) {
+        uint8_t buf[BUF_SIZE];
+        declare_func(uintptr_t, const uint8_t *buf, uintptr_t size);
+
+        /* cover the main loop and the overlapping last block, at all
+         * alignments */
+        for (uintptr_t size = UPIPE_FRAMERS_MPEG_FIND_MIN; size <= 256;
+             size++) {
+            for (int i = 0; i < 8; i++) {
+                uintptr_t offset = rnd() % 32;
+                randomize_buffer(buf + offset, size);
+                if (call_ref(buf + offset, size) !=
+                    call_new(buf + offset, size))
+                    fail();
+            }
+        }
+
+        /* typical slice payload, without start code */
+        for (uintptr_t i = 0; i < BUF_SIZE; i++)
+            buf[i] = rnd() | 1;
+        bench_new(buf, BUF_SIZE);
+
+        /* start code at the very end of the buffer */
+        buf[BUF_SIZE - 3] = buf[BUF_SIZE - 2] = 0;
+        buf[BUF_SIZE - 1] = 1;
+        if (call_ref(buf, BUF_SIZE - 1) != call_new(buf, BUF_SIZE - 1) ||
+            call_ref(buf, BUF_SIZE) != call_new(buf, BUF_SIZE))
+            fail();
+    }
+    report("mpeg_find");
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for ubuf manager for block formats mapping files
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mmap.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define UBUF_POOL_DEPTH     1
+#define FILE_SIZE           65536
+#define MAP_OFFSET          1234
+#define MAP_SIZE            40000
+
+int main(int argc, char **argv)
+{
+    char path[] = "ubuf_block_mmap_test.XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    unlink(path);
+    uint8_t pattern[FILE_SIZE];
+    for (int i = 0; i < FILE_SIZE; i++)
+        pattern[i] = i % 251;
+    assert(write(fd, pattern, FILE_SIZE) == FILE_SIZE);
+
+    struct ubuf_mgr *mgr = ubuf_block_mmap_mgr_alloc(UBUF_POOL_DEPTH,
+                                                     UBUF_POOL_DEPTH, true);
+    assert(mgr != NULL);
+
+    /* regions must lie within the file */
+    assert(ubuf_block_alloc(mgr, 42) == NULL);
+    assert(ubuf_block_mmap_alloc_from_fd(mgr, fd, FILE_SIZE - 10, 11) == NULL);
+
+    struct ubuf *ubuf1, *ubuf2, *ubuf3;
+    ubuf1 = ubuf_block_mmap_alloc_from_fd(mgr, fd, MAP_OFFSET, MAP_SIZE);
+    assert(ubuf1 != NULL);
+
+    size_t size;
+    ubase_assert(ubuf_block_size(ubuf1, &size));
+    assert(size == MAP_SIZE);
+
+    const uint8_t *r;
+    int wanted = -1;
+    ubase_assert(ubuf_block_read(ubuf1, 0, &wanted, &r));
+    assert(wanted == MAP_SIZE);
+    assert(!memcmp(r, pattern + MAP_OFFSET, MAP_SIZE));
+    ubase_assert(ubuf_block_unmap(ubuf1, 0));
+
+    /* slices share the mapping */
+    ubuf2 = ubuf_block_splice(ubuf1, 1000, 2000);
+    assert(ubuf2 != NULL);
+    assert(!ubase_check(ubuf_block_write(ubuf1, 0, &wanted, (uint8_t **)&r)));
+    ubuf_free(ubuf1);
+
+    ubuf3 = ubuf_dup(ubuf2);
+    assert(ubuf3 != NULL);
+    ubase_assert(ubuf_block_size(ubuf3, &size));
+    assert(size == 2000);
+    ubuf_free(ubuf3);
+
+    /* writing does not alter the file */
+    uint8_t *w;
+    wanted = -1;
+    ubase_assert(ubuf_block_write(ubuf2, 0, &wanted, &w));
+    assert(wanted == 2000);
+    assert(!memcmp(w, pattern + MAP_OFFSET + 1000, 2000));
+    memset(w, 0, wanted);
+    ubase_assert(ubuf_block_unmap(ubuf2, 0));
+    ubuf_free(ubuf2);
+
+    uint8_t buffer[2000];
+    assert(pread(fd, buffer, 2000, MAP_OFFSET + 1000) == 2000);
+    assert(!memcmp(buffer, pattern + MAP_OFFSET + 1000, 2000));
+
+    ubuf_mgr_release(mgr);
+    close(fd);
+    return 0;
+}
@@ -38,6 +38,7 @@
 #include <upipe/ubuf_block_mem.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 
@@ -72,6 +73,85 @@ static void fill_in(struct ubuf *ubuf)
     }
 }
 
+static void check_blend(struct ubuf_mgr *dst_mgr, struct ubuf_mgr *src_mgr,
+                        int width, int height, uint8_t alpha,
+                        uint8_t threshold)
+{
+    struct ubuf *dst = ubuf_pic_alloc(dst_mgr, width, height);
+    struct ubuf *src = ubuf_pic_alloc(src_mgr, width, height);
+    assert(dst != NULL);
+    assert(src != NULL);
+
+    size_t a_stride;
+    uint8_t *a;
+    ubase_assert(ubuf_pic_plane_size(src, "a8", &a_stride, NULL, NULL, NULL));
+    ubase_assert(ubuf_pic_plane_write(src, "a8", 0, 0, -1, -1, &a));
+    for (int i = 0; i < height * a_stride; i++)
+        a[i] = rand();
+
+    uint16_t expected[3][width * height];
+    const char *chroma;
+    int p = 0;
+    ubuf_pic_foreach_plane(dst, chroma) {
+        size_t dst_stride, src_stride;
+        uint8_t hsub, vsub, size;
+        uint8_t *d, *s;
+        ubase_assert(ubuf_pic_plane_size(dst, chroma, &dst_stride,
+                                         &hsub, &vsub, &size));
+        ubase_assert(ubuf_pic_plane_size(src, chroma, &src_stride,
+                                         NULL, NULL, NULL));
+        ubase_assert(ubuf_pic_plane_write(dst, chroma, 0, 0, -1, -1, &d));
+        ubase_assert(ubuf_pic_plane_write(src, chroma, 0, 0, -1, -1, &s));
+        unsigned int mask = size == 2 ? 0x3ff : 0xff;
+
+        for (int y = 0; y < height / vsub; y++) {
+            for (int x = 0; x < width / hsub; x++) {
+                unsigned int dv = rand() & mask, sv = rand() & mask;
+                unsigned int av = a[y * vsub * a_stride + x * hsub] * alpha /
+                                  0xff;
+                if (size == 2) {
+                    ((uint16_t *)(d + y * dst_stride))[x] = dv;
+                    ((uint16_t *)(s + y * src_stride))[x] = sv;
+                } else {
+                    d[y * dst_stride + x] = dv;
+                    s[y * src_stride + x] = sv;
+                }
+                if (threshold == 0xff)
+                    dv = (dv * (0xff - av) + sv * av) / 0xff;
+                else if (av > threshold)
+                    dv = sv;
+                expected[p][y * width + x] = dv;
+            }
+        }
+        ubase_assert(ubuf_pic_plane_unmap(dst, chroma, 0, 0, -1, -1));
+        ubase_assert(ubuf_pic_plane_unmap(src, chroma, 0, 0, -1, -1));
+        p++;
+    }
+    ubase_assert(ubuf_pic_plane_unmap(src, "a8", 0, 0, -1, -1));
+
+    ubase_assert(ubuf_pic_blit(dst, src, 0, 0, 0, 0, width, height,
+                               alpha, threshold));
+
+    p = 0;
+    ubuf_pic_foreach_plane(dst, chroma) {
+        size_t stride;
+        uint8_t hsub, vsub, size;
+        const uint8_t *d;
+        ubase_assert(ubuf_pic_plane_size(dst, chroma, &stride,
+                                         &hsub, &vsub, &size));
+        ubase_assert(ubuf_pic_plane_read(dst, chroma, 0, 0, -1, -1, &d));
+        for (int y = 0; y < height / vsub; y++)
+            for (int x = 0; x < width / hsub; x++)
+                assert((size == 2 ? ((const uint16_t *)(d + y * stride))[x] :
+                        d[y * stride + x]) == expected[p][y * width + x]);
+        ubase_assert(ubuf_pic_plane_unmap(dst, chroma, 0, 0, -1, -1));
+        p++;
+    }
+
+    ubuf_free(dst);
+    ubuf_free(src);
+}
+
 int main(int argc, char **argv)
 {
     struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
@@ -266,6 +346,39 @@ int main(int argc, char **argv)
     ubuf_free(ubuf1);
     ubuf_mgr_release(mgr);
 
+    /* alpha blending */
+    for (int bits = 8; bits <= 10; bits += 2) {
+        uint8_t size = bits == 8 ? 1 : 2;
+        struct ubuf_mgr *src_mgr;
+        mgr = ubuf_pic_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
+                                     umem_mgr, 1, 0, 0, 0, 0, 0, 0);
+        src_mgr = ubuf_pic_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
+                                         umem_mgr, 1, 0, 0, 0, 0, 0, 0);
+        assert(mgr != NULL);
+        assert(src_mgr != NULL);
+        ubase_assert(ubuf_pic_mem_mgr_add_plane(mgr,
+                    bits == 8 ? "y8" : "y10l", 1, 1, size));
+        ubase_assert(ubuf_pic_mem_mgr_add_plane(mgr,
+                    bits == 8 ? "u8" : "u10l", 2, 2, size));
+        ubase_assert(ubuf_pic_mem_mgr_add_plane(mgr,
+                    bits == 8 ? "v8" : "v10l", 2, 2, size));
+        ubase_assert(ubuf_pic_mem_mgr_add_plane(src_mgr,
+                    bits == 8 ? "y8" : "y10l", 1, 1, size));
+        ubase_assert(ubuf_pic_mem_mgr_add_plane(src_mgr,
+                    bits == 8 ? "u8" : "u10l", 2, 2, size));
+        ubase_assert(ubuf_pic_mem_mgr_add_plane(src_mgr,
+                    bits == 8 ? "v8" : "v10l", 2, 2, size));
+        ubase_assert(ubuf_pic_mem_mgr_add_plane(src_mgr, "a8", 1, 1, 1));
+
+        check_blend(mgr, src_mgr, 70, 4, 0xff, 0xff);
+        check_blend(mgr, src_mgr, 70, 4, 0x80, 0xff);
+        check_blend(mgr, src_mgr, 70, 4, 0xff, 0x40);
+        check_blend(mgr, src_mgr, 70, 4, 0xc0, 0x40);
+
+        ubuf_mgr_release(src_mgr);
+        ubuf_mgr_release(mgr);
+    }
+
     /* pic -> block transformation */
     mgr = ubuf_pic_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH, umem_mgr, 1,
                                  0, 0, 0, 0, 0, 0);
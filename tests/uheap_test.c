@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for uheap implementation
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uheap.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#define NB_ITEMS 1024
+
+struct item {
+    unsigned id;
+    struct uheap_node node;
+};
+
+UBASE_FROM_TO(item, uheap_node, node, node)
+
+static struct item items[NB_ITEMS];
+
+/** checks that the heap property holds */
+static void check_heap(struct uheap *heap)
+{
+    for (size_t i = 0; i < heap->size; i++) {
+        assert(heap->nodes[i]->index == i);
+        if (i)
+            assert(heap->nodes[(i - 1) / 2]->key <= heap->nodes[i]->key);
+    }
+}
+
+/** pops everything and checks the order */
+static void check_order(struct uheap *heap)
+{
+    uint64_t last = 0;
+    struct uheap_node *node;
+    while ((node = uheap_pop(heap)) != NULL) {
+        assert(!uheap_node_is_in(node));
+        assert(node->key >= last);
+        last = node->key;
+    }
+    assert(uheap_size(heap) == 0);
+}
+
+int main(int argc, char **argv)
+{
+    struct uheap heap;
+    uheap_init(&heap);
+    assert(uheap_peek(&heap) == NULL);
+    assert(uheap_pop(&heap) == NULL);
+
+    srand(42);
+    for (unsigned i = 0; i < NB_ITEMS; i++) {
+        items[i].id = i;
+        uheap_node_init(&items[i].node);
+        assert(!uheap_node_is_in(&items[i].node));
+        ubase_assert(uheap_update(&heap, &items[i].node, rand() % 4096));
+    }
+    assert(uheap_size(&heap) == NB_ITEMS);
+    check_heap(&heap);
+    check_order(&heap);
+
+    /* re-key and delete random nodes */
+    for (unsigned i = 0; i < NB_ITEMS; i++)
+        ubase_assert(uheap_update(&heap, &items[i].node, i));
+    assert(item_from_node(uheap_peek(&heap))->id == 0);
+    for (unsigned i = 0; i < NB_ITEMS; i++) {
+        unsigned j = rand() % NB_ITEMS;
+        if (j % 3)
+            ubase_assert(uheap_update(&heap, &items[j].node, rand() % 4096));
+        else
+            uheap_delete(&heap, &items[j].node);
+        check_heap(&heap);
+    }
+    unsigned count = 0;
+    for (unsigned i = 0; i < NB_ITEMS; i++)
+        if (uheap_node_is_in(&items[i].node))
+            count++;
+    assert(count == uheap_size(&heap));
+
+    /* smallest key first */
+    ubase_assert(uheap_update(&heap, &items[42].node, 0));
+    assert(uheap_peek(&heap) == &items[42].node);
+    uheap_delete(&heap, &items[42].node);
+    uheap_delete(&heap, &items[42].node);
+    check_heap(&heap);
+    check_order(&heap);
+
+    ubase_assert(uheap_update(&heap, &items[0].node, 12));
+    uheap_clean(&heap);
+    assert(!uheap_node_is_in(&items[0].node));
+    return 0;
+}
@@ -49,6 +49,7 @@
 
 #define ULIFO_MAX_DEPTH 10
 #define UQUEUE_MAX_DEPTH 6
+#define UQUEUE_LARGE_DEPTH 1000
 #define UPUMP_POOL 1
 #define UPUMP_BLOCKER_POOL 1
 #define NB_LOOPS 1000
@@ -151,6 +152,31 @@ static void pop(struct upump *upump)
         upump_stop(upump);
 }
 
+static void check_large(void)
+{
+    static uint8_t buffer[uqueue_sizeof(UQUEUE_LARGE_DEPTH)];
+    static struct elem large_elems[UQUEUE_LARGE_DEPTH];
+    struct uqueue large;
+    assert(ufifo_capacity(UQUEUE_LARGE_DEPTH) == 1024);
+    assert(uqueue_init(&large, UQUEUE_LARGE_DEPTH, buffer));
+
+    for (unsigned int i = 0; i < UQUEUE_LARGE_DEPTH; i++) {
+        large_elems[i].loop = i;
+        assert(uqueue_push(&large, &large_elems[i].uchain));
+    }
+    assert(uqueue_length(&large) == UQUEUE_LARGE_DEPTH);
+    assert(!uqueue_push(&large, &large_elems[0].uchain));
+
+    for (unsigned int i = 0; i < UQUEUE_LARGE_DEPTH; i++) {
+        struct uchain *uchain = uqueue_pop(&large, struct uchain *);
+        assert(uchain != NULL);
+        assert(container_of(uchain, struct elem, uchain)->loop == i);
+    }
+    assert(uqueue_pop(&large, struct uchain *) == NULL);
+    assert(!uqueue_length(&large));
+    uqueue_clean(&large);
+}
+
 int main(int argc, char **argv)
 {
     static const long nsec_timeouts[ULIFO_MAX_DEPTH] = {
@@ -162,6 +188,8 @@ int main(int argc, char **argv)
     if (argc > 1)
         nb_loops = atoi(argv[1]);
 
+    check_large();
+
     struct ev_loop *loop = ev_default_loop(0);
     struct upump_mgr *upump_mgr = upump_ev_mgr_alloc(loop, UPUMP_POOL,
                                                      UPUMP_BLOCKER_POOL);
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for umem hugepage manager
+ */
+
+#undef NDEBUG
+
+#include <upipe/umem.h>
+#include <upipe/umem_hugepage.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define CHUNK_SIZE 4096
+#define NB_CHUNKS (UMEM_HUGEPAGE_2M / CHUNK_SIZE)
+
+static struct umem umems[NB_CHUNKS];
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *mgr = umem_hugepage_mgr_alloc(1, UMEM_HUGEPAGE_2M, -1,
+                                                   CHUNK_SIZE);
+    assert(mgr != NULL);
+    printf("hugetlb: %d\n", umem_hugepage_mgr_is_hugetlb(mgr));
+
+    struct umem umem;
+    assert(umem_alloc(mgr, &umem, 42));
+    uint8_t *p = umem_buffer(&umem);
+    assert(p != NULL);
+    assert(umem.real_size == CHUNK_SIZE);
+    memset(p, 0x42, 42);
+    printf("Passed 1\n");
+
+    /* size classes in 1.5x increments */
+    assert(umem_realloc(&umem, CHUNK_SIZE * 2 + 1));
+    assert(umem.real_size == CHUNK_SIZE * 3);
+    p = umem_buffer(&umem);
+    assert(p[41] == 0x42);
+    assert(umem_realloc(&umem, CHUNK_SIZE * 5));
+    assert(umem.real_size == CHUNK_SIZE * 6);
+    assert(umem_realloc(&umem, CHUNK_SIZE * 7));
+    assert(umem.real_size == CHUNK_SIZE * 8);
+    assert(umem_buffer(&umem)[41] == 0x42);
+    assert(umem_realloc(&umem, 16));
+    umem_free(&umem);
+    printf("Passed 2\n");
+
+    /* released buffers are recycled */
+    assert(umem_alloc(mgr, &umem, CHUNK_SIZE * 3));
+    assert(umem_buffer(&umem) == p);
+    umem_free(&umem);
+    printf("Passed 3\n");
+
+    /* buffers larger than the arena are allocated with malloc() */
+    assert(umem_alloc(mgr, &umem, UMEM_HUGEPAGE_2M + 1));
+    assert(umem.real_size == UMEM_HUGEPAGE_2M + 1);
+    memset(umem_buffer(&umem), 0, UMEM_HUGEPAGE_2M + 1);
+    umem_free(&umem);
+    printf("Passed 4\n");
+
+    /* exhaust the arena: 1 + 3 + 6 + 8 chunks were carved, and the first
+     * one was released */
+    unsigned int nb = NB_CHUNKS - 18 + 1;
+    for (unsigned int i = 0; i < nb; i++) {
+        assert(umem_alloc(mgr, &umems[i], CHUNK_SIZE));
+        umem_buffer(&umems[i])[0] = i;
+    }
+    /* then revert to malloc() */
+    assert(umem_alloc(mgr, &umems[nb], CHUNK_SIZE));
+    umem_buffer(&umems[nb])[0] = nb;
+    for (unsigned int i = 0; i <= nb; i++) {
+        assert(umem_buffer(&umems[i])[0] == (uint8_t)i);
+        umem_free(&umems[i]);
+    }
+    printf("Passed 5\n");
+
+    umem_mgr_vacuum(mgr);
+    umem_mgr_release(mgr);
+
+    /* binding to a NUMA node may not be supported */
+    mgr = umem_hugepage_mgr_alloc_simple(UMEM_HUGEPAGE_2M, 0);
+    if (mgr != NULL) {
+        assert(umem_alloc(mgr, &umem, 65536));
+        memset(umem_buffer(&umem), 0, 65536);
+        umem_free(&umem);
+        umem_mgr_release(mgr);
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for umem pthread cache manager
+ */
+
+#undef NDEBUG
+
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe-pthread/umem_pthread_cache.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define MAGAZINE_SIZE 4
+#define DEPOT_DEPTH 8
+#define NB_UMEMS 16
+
+static struct umem umems[NB_UMEMS];
+
+/** frees the buffers in another thread */
+static void *thread(void *unused)
+{
+    for (unsigned int i = 0; i < NB_UMEMS; i++) {
+        assert(umem_buffer(&umems[i])[0] == i);
+        umem_free(&umems[i]);
+    }
+    /* the magazines are returned to the depot on exit */
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *pool_mgr = umem_pool_mgr_alloc_simple(32);
+    assert(pool_mgr != NULL);
+    struct umem_mgr *mgr = umem_pthread_cache_mgr_alloc(pool_mgr, 32, 8,
+                                                        MAGAZINE_SIZE,
+                                                        DEPOT_DEPTH);
+    assert(mgr != NULL);
+    umem_mgr_release(pool_mgr);
+
+    struct umem_pthread_cache_stats stats;
+    struct umem umem;
+    assert(umem_alloc(mgr, &umem, 42));
+    uint8_t *p = umem_buffer(&umem);
+    assert(p != NULL);
+    assert(umem.real_size == 64);
+    memset(p, 0x42, 42);
+    umem_free(&umem);
+    printf("Passed 1\n");
+
+    /* served from the thread-local magazine */
+    assert(umem_alloc(mgr, &umem, 64));
+    assert(umem_buffer(&umem) == p);
+    assert(umem_realloc(&umem, 1024));
+    assert(umem_buffer(&umem)[41] == 0x42);
+    assert(umem_realloc(&umem, 16));
+    umem_free(&umem);
+    umem_pthread_cache_mgr_flush(mgr);
+    umem_pthread_cache_mgr_get_stats(mgr, &stats);
+    assert(stats.alloc_hits == 1);
+    assert(stats.alloc_misses == 2);
+    assert(stats.free_hits == 3);
+    printf("Passed 2\n");
+
+    /* larger buffers bypass the cache */
+    assert(umem_alloc(mgr, &umem, 32 << 8));
+    assert(umem.mgr == pool_mgr);
+    umem_free(&umem);
+    printf("Passed 3\n");
+
+    /* buffers allocated in a thread and freed in another */
+    for (unsigned int i = 0; i < NB_UMEMS; i++) {
+        assert(umem_alloc(mgr, &umems[i], 200));
+        umem_buffer(&umems[i])[0] = i;
+    }
+    pthread_t id;
+    assert(pthread_create(&id, NULL, thread, NULL) == 0);
+    assert(pthread_join(id, NULL) == 0);
+
+    for (unsigned int i = 0; i < NB_UMEMS; i++)
+        assert(umem_alloc(mgr, &umems[i], 256));
+    umem_pthread_cache_mgr_get_stats(mgr, &stats);
+    assert(stats.alloc_depot == NB_UMEMS / MAGAZINE_SIZE);
+    /* the last two magazines were still loaded when the thread exited */
+    assert(stats.free_depot == NB_UMEMS / MAGAZINE_SIZE - 2);
+    for (unsigned int i = 0; i < NB_UMEMS; i++)
+        umem_free(&umems[i]);
+    printf("Passed 4\n");
+
+    umem_mgr_vacuum(mgr);
+    umem_mgr_release(mgr);
+    return 0;
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for umpsc (using libev)
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/umpsc.h>
+#include <upipe/upump.h>
+#include <upipe/upump_blocker.h>
+#include <upump-ev/upump_ev.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define NB_THREADS 8
+#define LANE_LENGTH 5
+#define UPUMP_POOL 1
+#define UPUMP_BLOCKER_POOL 1
+#define NB_LOOPS 10000
+
+struct elem {
+    struct uchain uchain;
+    unsigned int loop;
+    unsigned int thread;
+};
+
+struct thread {
+    pthread_t id;
+    unsigned int thread;
+    struct umpsc_lane *lane;
+    struct upump_mgr *upump_mgr;
+    struct upump *upump;
+    struct upump_blocker *blocker;
+    unsigned int loop;
+    struct elem elems[NB_LOOPS];
+};
+
+static struct umpsc umpsc;
+static struct thread threads[NB_THREADS];
+static unsigned int loops[NB_THREADS];
+static unsigned int nb_popped = 0;
+
+static void push_ready(struct upump *upump)
+{
+    struct thread *thread = upump_get_opaque(upump, struct thread *);
+    upump_blocker_free(thread->blocker);
+    thread->blocker = NULL;
+    upump_stop(thread->upump);
+}
+
+static void push(struct upump *upump)
+{
+    struct thread *thread = upump_get_opaque(upump, struct thread *);
+    struct elem *elem = &thread->elems[thread->loop];
+    elem->loop = thread->loop;
+    elem->thread = thread->thread;
+    if (unlikely(!umpsc_push(&umpsc, thread->lane, &elem->uchain))) {
+        thread->blocker = upump_blocker_alloc(upump, NULL, NULL, NULL);
+        upump_start(thread->upump);
+    } else if (unlikely(++thread->loop >= NB_LOOPS))
+        upump_stop(upump);
+}
+
+static void *push_thread(void *_thread)
+{
+    struct thread *thread = (struct thread *)_thread;
+    thread->loop = 0;
+    thread->blocker = NULL;
+
+    thread->upump_mgr = upump_ev_mgr_alloc_loop(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(thread->upump_mgr != NULL);
+
+    thread->upump = umpsc_lane_upump_alloc_push(thread->lane,
+                                                thread->upump_mgr,
+                                                push_ready, thread, NULL);
+    assert(thread->upump != NULL);
+
+    struct upump *upump = upump_alloc_idler(thread->upump_mgr, push, thread,
+                                            NULL);
+    assert(upump != NULL);
+    upump_start(upump);
+
+    upump_mgr_run(thread->upump_mgr, NULL);
+
+    upump_free(upump);
+    upump_free(thread->upump);
+    upump_mgr_release(thread->upump_mgr);
+    return NULL;
+}
+
+static void pop(struct upump *upump)
+{
+    struct uchain *uchain;
+    while ((uchain = umpsc_pop(&umpsc, struct uchain *)) != NULL) {
+        struct elem *elem = container_of(uchain, struct elem, uchain);
+        assert(elem->loop == loops[elem->thread]);
+        loops[elem->thread]++;
+        nb_popped++;
+    }
+    if (nb_popped == NB_THREADS * NB_LOOPS)
+        upump_stop(upump);
+}
+
+static void check_lanes(void)
+{
+    static uint8_t buffer[umpsc_sizeof(2, LANE_LENGTH)];
+    static struct elem elems[2][LANE_LENGTH];
+    struct umpsc small;
+    assert(umpsc_init(&small, 2, LANE_LENGTH, buffer));
+
+    struct umpsc_lane *lanes[2];
+    lanes[0] = umpsc_lane_get(&small);
+    lanes[1] = umpsc_lane_get(&small);
+    assert(lanes[0] != NULL && lanes[1] != NULL && lanes[0] != lanes[1]);
+    assert(umpsc_lane_get(&small) == NULL);
+    assert(umpsc_producers(&small) == 2);
+
+    for (unsigned int i = 0; i < LANE_LENGTH; i++) {
+        elems[0][i].loop = i;
+        elems[0][i].thread = 0;
+        assert(umpsc_push(&small, lanes[0], &elems[0][i].uchain));
+    }
+    assert(!umpsc_push(&small, lanes[0], &elems[0][0].uchain));
+    elems[1][0].loop = 0;
+    elems[1][0].thread = 1;
+    assert(umpsc_push(&small, lanes[1], &elems[1][0].uchain));
+    assert(umpsc_length(&small) == LANE_LENGTH + 1);
+
+    /* lanes are popped in a round-robin fashion */
+    struct elem *elem = container_of(umpsc_pop(&small, struct uchain *),
+                                     struct elem, uchain);
+    assert(elem->thread == 0 && elem->loop == 0);
+    elem = container_of(umpsc_pop(&small, struct uchain *),
+                        struct elem, uchain);
+    assert(elem->thread == 1 && elem->loop == 0);
+    for (unsigned int i = 1; i < LANE_LENGTH; i++) {
+        elem = container_of(umpsc_pop(&small, struct uchain *),
+                            struct elem, uchain);
+        assert(elem->thread == 0 && elem->loop == i);
+    }
+    assert(umpsc_pop(&small, struct uchain *) == NULL);
+    assert(!umpsc_length(&small));
+
+    /* a lane given back may be claimed again */
+    umpsc_lane_put(lanes[0]);
+    assert(umpsc_producers(&small) == 1);
+    assert(umpsc_lane_get(&small) == lanes[0]);
+    umpsc_clean(&small);
+}
+
+int main(int argc, char **argv)
+{
+    check_lanes();
+
+    uint8_t *buffer = malloc(umpsc_sizeof(NB_THREADS, LANE_LENGTH));
+    assert(buffer != NULL);
+    assert(umpsc_init(&umpsc, NB_THREADS, LANE_LENGTH, buffer));
+
+    struct ev_loop *loop = ev_default_loop(0);
+    struct upump_mgr *upump_mgr = upump_ev_mgr_alloc(loop, UPUMP_POOL,
+                                                     UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    struct upump *upump = umpsc_upump_alloc_pop(&umpsc, upump_mgr, pop, NULL,
+                                                NULL);
+    assert(upump != NULL);
+    upump_start(upump);
+
+    for (unsigned int i = 0; i < NB_THREADS; i++) {
+        threads[i].thread = i;
+        threads[i].lane = umpsc_lane_get(&umpsc);
+        assert(threads[i].lane != NULL);
+        assert(pthread_create(&threads[i].id, NULL, push_thread,
+                              &threads[i]) == 0);
+    }
+
+    ev_loop(loop, 0);
+
+    for (unsigned int i = 0; i < NB_THREADS; i++) {
+        assert(!pthread_join(threads[i].id, NULL));
+        assert(loops[i] == NB_LOOPS);
+        umpsc_lane_put(threads[i].lane);
+    }
+    assert(umpsc_pop(&umpsc, struct uchain *) == NULL);
+
+    upump_free(upump);
+    upump_mgr_release(upump_mgr);
+    ev_default_destroy();
+
+    umpsc_clean(&umpsc);
+    free(buffer);
+    return 0;
+}
@@ -1,6 +1,187 @@
+#undef NDEBUG
+
+#include <upipe/config.h>
 #include <upipe/ubase.h>
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_uclock.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_std.h>
+#include <upipe/upump.h>
+#include <upipe/upipe.h>
+#include <upump-ev/upump_ev.h>
 
 #include <upipe-dvbcsa/upipe_dvbcsa_common.h>
+#include <upipe-dvbcsa/upipe_dvbcsa_decrypt.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include <bitstream/mpeg/ts.h>
+
+#ifdef UPIPE_HAVE_GCRYPT
+#include <gcrypt.h>
+#endif
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+#define PID 256
+#define NB_THREADS 4
+/** number of packets scrambled with each key */
+#define NB_PACKETS 100
+
+static const char *keys[2] = { "112233445566", "aabbccddeeff" };
+
+static unsigned int nb_input = 0;
+static unsigned int nb_output = 0;
+static bool dead = false;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_DEAD:
+            if (upipe->mgr->signature == UPIPE_DVBCSA_DEC_SIGNATURE)
+                dead = true;
+            break;
+        case UPROBE_READY:
+        case UPROBE_LOG:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe, checking that packets are descrambled in order */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    const uint8_t *ts;
+    int size = -1;
+    ubase_assert(uref_block_read(uref, 0, &size, &ts));
+    assert(size == TS_SIZE);
+    assert(ts_get_pid(ts) == PID);
+    assert(ts_get_scrambling(ts) == 0);
+    assert(ts_get_cc(ts) == (nb_output & 0xf));
+    for (int i = TS_HEADER_SIZE; i < TS_SIZE; i++)
+        assert(ts[i] == (uint8_t)(nb_output + i));
+    uref_block_unmap(uref, 0);
+    uref_free(uref);
+    nb_output++;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** sends a TS packet, scrambled with the given key or clear if NULL */
+static void input(struct upipe *upipe, struct uref_mgr *uref_mgr,
+                  struct ubuf_mgr *ubuf_mgr, dvbcsa_key_t *key)
+{
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, TS_SIZE);
+    assert(uref != NULL);
+    uint8_t *ts;
+    int size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &ts));
+    assert(size == TS_SIZE);
+    ts_init(ts);
+    ts_set_pid(ts, PID);
+    ts_set_payload(ts);
+    ts_set_cc(ts, nb_input & 0xf);
+    for (int i = TS_HEADER_SIZE; i < TS_SIZE; i++)
+        ts[i] = nb_input + i;
+    if (key != NULL) {
+        dvbcsa_encrypt(key, ts + TS_HEADER_SIZE, TS_SIZE - TS_HEADER_SIZE);
+        ts_set_scrambling(ts, TS_SCRAMBLING_EVEN);
+    }
+    uref_block_unmap(uref, 0);
+    nb_input++;
+    upipe_input(upipe, uref, NULL);
+}
+
+/** sends packets scrambled with a key, with a clear packet in the middle */
+static void input_packets(struct upipe *upipe, struct uref_mgr *uref_mgr,
+                          struct ubuf_mgr *ubuf_mgr, const char *key_str)
+{
+    struct ustring_dvbcsa_cw cw =
+        ustring_to_dvbcsa_cw(ustring_from_str(key_str));
+    assert(!ustring_is_null(cw.str));
+    dvbcsa_key_t *key = dvbcsa_key_alloc();
+    assert(key != NULL);
+    dvbcsa_key_set(cw.value, key);
+
+    for (int i = 0; i < NB_PACKETS; i++)
+        input(upipe, uref_mgr, ubuf_mgr, i == NB_PACKETS / 2 ? NULL : key);
+    dvbcsa_key_free(key);
+}
 
 int main(int argc, char *argv[])
 {
@@ -13,5 +194,92 @@ int main(int argc, char *argv[])
 
     cw = ustring_to_dvbcsa_cw(ustring_from_str("11223366445566FF"));
     assert(cw.str.len == 16);
+
+#ifdef UPIPE_HAVE_GCRYPT
+    gcry_check_version(NULL);
+    gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
+#endif
+
+    /* batch mode with descrambling threads */
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+    struct upump_mgr *upump_mgr =
+        upump_ev_mgr_alloc_default(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    struct uclock *uclock = uclock_std_alloc(0);
+    assert(uclock != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+    logger = uprobe_uclock_alloc(logger, uclock);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&test_mgr,
+                                                uprobe_use(logger));
+    assert(upipe_sink != NULL);
+
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(flow_def != NULL);
+    ubase_assert(uref_clock_set_latency(flow_def, UCLOCK_FREQ / 100));
+
+    struct upipe_mgr *upipe_dvbcsa_dec_mgr = upipe_dvbcsa_dec_mgr_alloc();
+    assert(upipe_dvbcsa_dec_mgr != NULL);
+    struct upipe *upipe_dvbcsa_dec = upipe_flow_alloc(upipe_dvbcsa_dec_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "dvbcsa dec"), flow_def);
+    assert(upipe_dvbcsa_dec != NULL);
+    upipe_mgr_release(upipe_dvbcsa_dec_mgr);
+    ubase_assert(upipe_set_output(upipe_dvbcsa_dec, upipe_sink));
+    ubase_assert(upipe_set_flow_def(upipe_dvbcsa_dec, flow_def));
+    uref_free(flow_def);
+    ubase_assert(upipe_attach_upump_mgr(upipe_dvbcsa_dec));
+    ubase_assert(upipe_dvbcsa_add_pid(upipe_dvbcsa_dec, PID));
+    ubase_assert(upipe_dvbcsa_dec_set_threads(upipe_dvbcsa_dec,
+                                              NB_THREADS));
+    ubase_assert(upipe_dvbcsa_set_key(upipe_dvbcsa_dec, keys[0], NULL));
+
+    /* the key change outputs the batches scrambled with the previous key */
+    input_packets(upipe_dvbcsa_dec, uref_mgr, ubuf_mgr, keys[0]);
+    ubase_assert(upipe_dvbcsa_set_key(upipe_dvbcsa_dec, keys[1], NULL));
+    assert(nb_output == nb_input);
+
+    /* the pending batches are output after the pipe is released */
+    input_packets(upipe_dvbcsa_dec, uref_mgr, ubuf_mgr, keys[1]);
+    upipe_release(upipe_dvbcsa_dec);
+    assert(!dead);
+
+    upump_mgr_run(upump_mgr, NULL);
+    assert(dead);
+    assert(nb_output == 2 * NB_PACKETS);
+
+    test_free(upipe_sink);
+
+    upump_mgr_release(upump_mgr);
+    uclock_release(uclock);
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
     return 0;
 }
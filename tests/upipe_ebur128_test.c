@@ -63,6 +63,12 @@
 #define STEP                (2. * M_PI * FREQ / RATE)
 #define UPROBE_LOG_LEVEL    UPROBE_LOG_VERBOSE
 #define ALIGN               0
+#define PERIOD              10
+
+/** number of urefs received by the phony pipe */
+static unsigned int nb_urefs = 0;
+/** number of urefs carrying loudness attributes */
+static unsigned int nb_loudness = 0;
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -80,6 +86,67 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    double momentary, shortterm, lra, global;
+    if (ubase_check(uref_ebur128_get_momentary(uref, &momentary))) {
+        ubase_assert(uref_ebur128_get_shortterm(uref, &shortterm));
+        ubase_assert(uref_ebur128_get_lra(uref, &lra));
+        ubase_assert(uref_ebur128_get_global(uref, &global));
+        assert(nb_urefs % PERIOD == 0);
+        nb_loudness++;
+    } else {
+        assert(nb_urefs % PERIOD != 0);
+    }
+    nb_urefs++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr ebur128_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
 int main(int argc, char **argv)
 {
     printf("Compiled %s %s - %s\n", __DATE__, __TIME__, __FILE__);
@@ -168,6 +235,60 @@ int main(int argc, char **argv)
     /* release pipe */
     upipe_release(r128);
 
+    /* planar input, loudness attributes every PERIOD urefs */
+    struct ubuf_mgr *planar_mgr = ubuf_sound_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                             UBUF_POOL_DEPTH, umem_mgr, 2, ALIGN);
+    assert(planar_mgr);
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(planar_mgr, "l"));
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(planar_mgr, "r"));
+
+    r128 = upipe_void_alloc(upipe_ebur128_mgr,
+        uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "r128 planar"));
+    assert(r128);
+    uint64_t period;
+    ubase_assert(upipe_ebur128_get_period(r128, &period));
+    assert(period == 0);
+    ubase_assert(upipe_ebur128_set_period(r128, PERIOD * DURATION));
+    ubase_assert(upipe_ebur128_get_period(r128, &period));
+    assert(period == PERIOD * DURATION);
+
+    flow = uref_sound_flow_alloc_def(uref_mgr, "s16.", CHANNELS, 2);
+    assert(flow != NULL);
+    ubase_assert(uref_sound_flow_add_plane(flow, "l"));
+    ubase_assert(uref_sound_flow_add_plane(flow, "r"));
+    ubase_assert(uref_sound_flow_set_rate(flow, RATE));
+    ubase_assert(upipe_set_flow_def(r128, flow));
+    uref_free(flow);
+
+    struct upipe *sink = upipe_void_alloc(&ebur128_test_mgr,
+                                          uprobe_use(logger));
+    assert(sink != NULL);
+    ubase_assert(upipe_set_output(r128, sink));
+
+    phase = 0;
+    for (i = 0; i < ITERATIONS; i++) {
+        struct uref *uref = uref_sound_alloc(uref_mgr, planar_mgr, SAMPLES);
+        assert(uref);
+        int16_t *l, *r;
+        ubase_assert(uref_sound_plane_write_int16_t(uref, "l", 0, -1, &l));
+        ubase_assert(uref_sound_plane_write_int16_t(uref, "r", 0, -1, &r));
+        for (j = 0; j < SAMPLES; j++) {
+            l[j] = r[j] = sin(phase) * INT16_MAX;
+            phase += STEP;
+            if (phase >= 2. * M_PI)
+                phase = 0;
+        }
+        ubase_assert(uref_sound_plane_unmap(uref, "l", 0, -1));
+        ubase_assert(uref_sound_plane_unmap(uref, "r", 0, -1));
+        upipe_input(r128, uref, NULL);
+    }
+    assert(nb_urefs == ITERATIONS);
+    assert(nb_loudness == ITERATIONS / PERIOD);
+
+    upipe_release(r128);
+    test_free(sink);
+    ubuf_mgr_release(planar_mgr);
+
     /* release managers */
     upipe_mgr_release(upipe_ebur128_mgr); // no-op
     ubuf_mgr_release(sound_mgr);
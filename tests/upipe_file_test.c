@@ -49,6 +49,9 @@
 #include <upipe/uref_std.h>
 #include <upipe/upump.h>
 #include <upump-ev/upump_ev.h>
+#ifdef UPIPE_HAVE_LINUX_IO_URING_H
+#include <upump-uring/upump_uring.h>
+#endif
 #include <upipe/upipe.h>
 #include <upipe-modules/upipe_file_source.h>
 #include <upipe-modules/upipe_file_sink.h>
@@ -70,9 +73,13 @@
 #define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
 
 static void usage(const char *argv0) {
-    fprintf(stdout, "Usage: %s [-d <delay>] [-a|-o] <source file> <sink file>\n", argv0);
+    fprintf(stdout, "Usage: %s [-d <delay>] [-m <mmap size>] [-D <direct size>] [-u] [-a|-o|-n] <source file> <sink file>\n", argv0);
     fprintf(stdout, "-a : append\n");
     fprintf(stdout, "-o : overwrite\n");
+    fprintf(stdout, "-n : write over an existing file without truncating it\n");
+    fprintf(stdout, "-m : map the source file in regions of the given size\n");
+    fprintf(stdout, "-D : write the sink file with direct I/O\n");
+    fprintf(stdout, "-u : run the io_uring event loop, if available\n");
     exit(EXIT_FAILURE);
 }
 
@@ -97,19 +104,34 @@ int main(int argc, char *argv[])
 {
     const char *src_file, *sink_file;
     int64_t delay = 0;
+    unsigned int mmap_size = 0;
+    unsigned int direct_size = 0;
+    bool uring = false;
     enum upipe_fsink_mode mode = UPIPE_FSINK_CREATE;
     int opt;
-    while ((opt = getopt(argc, argv, "d:ao")) != -1) {
+    while ((opt = getopt(argc, argv, "d:m:D:uaon")) != -1) {
         switch (opt) {
             case 'd':
                 delay = atoi(optarg);
                 break;
+            case 'm':
+                mmap_size = atoi(optarg);
+                break;
+            case 'D':
+                direct_size = atoi(optarg);
+                break;
+            case 'u':
+                uring = true;
+                break;
             case 'a':
                 mode = UPIPE_FSINK_APPEND;
                 break;
             case 'o':
                 mode = UPIPE_FSINK_OVERWRITE;
                 break;
+            case 'n':
+                mode = UPIPE_FSINK_NONE;
+                break;
             default:
                 usage(argv[0]);
         }
@@ -127,8 +149,16 @@ int main(int argc, char *argv[])
     struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
                                                    0);
     assert(uref_mgr != NULL);
-    struct upump_mgr *upump_mgr = upump_ev_mgr_alloc_default(UPUMP_POOL,
-            UPUMP_BLOCKER_POOL);
+    struct upump_mgr *upump_mgr = NULL;
+#ifdef UPIPE_HAVE_LINUX_IO_URING_H
+    if (uring)
+        upump_mgr = upump_uring_mgr_alloc(0, UPUMP_POOL, UPUMP_BLOCKER_POOL);
+#endif
+    if (uring && upump_mgr == NULL)
+        fprintf(stdout, "io_uring is not available, using libev\n");
+    if (upump_mgr == NULL)
+        upump_mgr = upump_ev_mgr_alloc_default(UPUMP_POOL,
+                                               UPUMP_BLOCKER_POOL);
     assert(upump_mgr != NULL);
     struct uclock *uclock = uclock_std_alloc(0);
     assert(uclock != NULL);
@@ -156,6 +186,8 @@ int main(int argc, char *argv[])
                              UPROBE_LOG_LEVEL, "file source"));
     assert(upipe_fsrc != NULL);
     ubase_assert(upipe_set_output_size(upipe_fsrc, READ_SIZE));
+    if (mmap_size)
+        ubase_assert(upipe_fsrc_set_mmap_size(upipe_fsrc, mmap_size));
     ubase_assert(upipe_set_uri(upipe_fsrc, src_file));
     uint64_t size;
     if (ubase_check(upipe_src_get_size(upipe_fsrc, &size)))
@@ -186,6 +218,8 @@ int main(int argc, char *argv[])
     assert(upipe_fsink != NULL);
     if (delay)
         ubase_assert(upipe_attach_uclock(upipe_fsink));
+    if (direct_size)
+        ubase_assert(upipe_fsink_set_direct_size(upipe_fsink, direct_size));
     ubase_assert(upipe_fsink_set_path(upipe_fsink, sink_file, mode));
     upipe_release(upipe_fsink);
 
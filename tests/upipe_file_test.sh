@@ -10,3 +10,18 @@ trap cleanup EXIT
 
 "$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_file_test Makefile "$TMP"/test
 cmp --quiet "$TMP"/test Makefile
+
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_file_test -m 10000 -D 16384 Makefile "$TMP"/test_mmap
+cmp --quiet "$TMP"/test_mmap Makefile
+
+cat Makefile Makefile > "$TMP"/test_none
+cp "$TMP"/test_none "$TMP"/test_none_ref
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_file_test -n -D 16384 Makefile "$TMP"/test_none
+cmp --quiet "$TMP"/test_none "$TMP"/test_none_ref
+
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_file_test -u -D 16384 Makefile "$TMP"/test_uring
+cmp --quiet "$TMP"/test_uring Makefile
+
+cat Makefile Makefile > "$TMP"/test_uring_none
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_file_test -u -n -D 16384 Makefile "$TMP"/test_uring_none
+cmp --quiet "$TMP"/test_uring_none "$TMP"/test_none_ref
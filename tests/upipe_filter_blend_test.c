@@ -64,6 +64,14 @@
 
 static struct ubuf_mgr *ubuf_mgr;
 static struct uref_mgr *uref_mgr;
+static unsigned int nb_pics = 0;
+
+/** value of a sample in yadif mode: the picture is static, so it must
+ * be output unchanged */
+static uint8_t sample_value(int x, int plane)
+{
+    return x * 7 + plane * 50;
+}
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -81,6 +89,89 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** helper phony pipe checking the deinterlaced pictures */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    static const char *chromas[] = { "y8", "u8", "v8" };
+    size_t width, height, stride;
+    uint8_t hsub, vsub;
+    const uint8_t *buf;
+
+    ubase_assert(uref_pic_get_progressive(uref));
+    ubase_nassert(uref_pic_get_tff(uref));
+    ubase_assert(uref_pic_size(uref, &width, &height, NULL));
+    assert(width == WIDTH && height == HEIGHT);
+    for (int plane = 0; plane < 3; plane++) {
+        ubase_assert(uref_pic_plane_size(uref, chromas[plane], &stride,
+                                         &hsub, &vsub, NULL));
+        ubase_assert(uref_pic_plane_read(uref, chromas[plane], 0, 0, -1, -1,
+                                         &buf));
+        for (int y = 0; y < HEIGHT / vsub; y++) {
+            for (int x = 0; x < WIDTH / hsub; x++)
+                assert(buf[x] == sample_value(x, plane));
+            buf += stride;
+        }
+        uref_pic_plane_unmap(uref, chromas[plane], 0, 0, -1, -1);
+    }
+    uref_free(uref);
+    nb_pics++;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = NULL,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** sends a static planar picture to the pipe */
+static void send_yadif_pic(struct upipe *upipe, bool tff)
+{
+    static const char *chromas[] = { "y8", "u8", "v8" };
+    size_t stride;
+    uint8_t hsub, vsub;
+    uint8_t *buf;
+
+    struct uref *pic = uref_pic_alloc(uref_mgr, ubuf_mgr, WIDTH, HEIGHT);
+    assert(pic);
+    for (int plane = 0; plane < 3; plane++) {
+        ubase_assert(uref_pic_plane_size(pic, chromas[plane], &stride,
+                                         &hsub, &vsub, NULL));
+        ubase_assert(uref_pic_plane_write(pic, chromas[plane], 0, 0, -1, -1,
+                                          &buf));
+        for (int y = 0; y < HEIGHT / vsub; y++) {
+            for (int x = 0; x < WIDTH / hsub; x++)
+                buf[x] = sample_value(x, plane);
+            buf += stride;
+        }
+        uref_pic_plane_unmap(pic, chromas[plane], 0, 0, -1, -1);
+    }
+    if (tff)
+        ubase_assert(uref_pic_set_tff(pic));
+    upipe_input(upipe, pic, NULL);
+}
+
 int main(int argc, char **argv)
 {
     printf("Compiled %s %s (%s)\n", __DATE__, __TIME__, __FILE__);
@@ -155,6 +246,60 @@ int main(int argc, char **argv)
 
     // Clean - release
     upipe_release(filter_blend);
+    ubuf_mgr_release(ubuf_mgr);
+
+    /* yadif mode, yuv420p */
+    ubuf_mgr = ubuf_pic_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
+                                      umem_mgr, 1,
+                                      UBUF_PREPEND, UBUF_APPEND,
+                                      UBUF_PREPEND, UBUF_APPEND,
+                                      UBUF_ALIGN, UBUF_ALIGN_HOFFSET);
+    assert(ubuf_mgr);
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(ubuf_mgr, "y8", 1, 1, 1));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(ubuf_mgr, "u8", 2, 2, 1));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(ubuf_mgr, "v8", 2, 2, 1));
+
+    struct upipe test_pipe;
+    upipe_init(&test_pipe, &test_mgr,
+               uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "test"));
+
+    uref = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(uref);
+    ubase_assert(uref_pic_flow_add_plane(uref, 1, 1, 1, "y8"));
+    ubase_assert(uref_pic_flow_add_plane(uref, 2, 2, 1, "u8"));
+    ubase_assert(uref_pic_flow_add_plane(uref, 2, 2, 1, "v8"));
+
+    filter_blend = upipe_void_alloc(blend_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "yadif"));
+    assert(filter_blend);
+    int mode;
+    ubase_assert(upipe_filter_blend_get_mode(filter_blend, &mode));
+    assert(mode == UPIPE_FILTER_BLEND_MODE_BLEND);
+    ubase_nassert(upipe_filter_blend_set_mode(filter_blend, 42));
+    ubase_assert(upipe_filter_blend_set_mode(filter_blend,
+                                             UPIPE_FILTER_BLEND_MODE_YADIF));
+    ubase_assert(upipe_filter_blend_get_mode(filter_blend, &mode));
+    assert(mode == UPIPE_FILTER_BLEND_MODE_YADIF);
+    ubase_assert(upipe_set_flow_def(filter_blend, uref));
+    ubase_assert(upipe_set_output(filter_blend, &test_pipe));
+    uref_free(uref);
+
+    /* the first picture is held until the next one is received */
+    for (counter = 0; counter < 10; counter++) {
+        send_yadif_pic(filter_blend, counter & 1);
+        assert(nb_pics == counter);
+    }
+    ubase_assert(upipe_flush(filter_blend));
+    assert(nb_pics == 10);
+
+    /* the last picture is output on release */
+    send_yadif_pic(filter_blend, true);
+    send_yadif_pic(filter_blend, true);
+    assert(nb_pics == 11);
+    upipe_release(filter_blend);
+    assert(nb_pics == 12);
+
+    upipe_clean(&test_pipe);
 
     upipe_mgr_release(blend_mgr); // noop
     upipe_mgr_release(null_mgr); // noop
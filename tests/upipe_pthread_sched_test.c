@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for the scheduling of pthread transfer threads
+ */
+
+#define _GNU_SOURCE
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe-pthread/upipe_pthread_transfer.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+
+static struct upipe_pthread_sched sched;
+static unsigned int pinned_cpu;
+
+/** applies the scheduling in a new thread */
+static void *thread(void *unused)
+{
+    /* an unprivileged process may not be allowed to set the NUMA policy */
+    int err = upipe_pthread_sched_apply(&sched, NULL);
+    assert(err == UBASE_ERR_NONE || err == UBASE_ERR_EXTERNAL);
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    assert(!pthread_getaffinity_np(pthread_self(), sizeof(cpuset), &cpuset));
+    assert(CPU_COUNT(&cpuset) == 1);
+    assert(CPU_ISSET(pinned_cpu, &cpuset));
+    assert(sched_getcpu() == (int)pinned_cpu);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    upipe_pthread_sched_init(&sched);
+    assert(sched.policy == -1);
+    assert(sched.numa_node == -1);
+    for (unsigned int cpu = 0; cpu < UPIPE_PTHREAD_SCHED_MAX_CPUS; cpu++)
+        assert(!upipe_pthread_sched_has_cpu(&sched, cpu));
+    ubase_assert(upipe_pthread_sched_apply(&sched, NULL));
+
+    ubase_nassert(upipe_pthread_sched_add_cpu(&sched,
+                                              UPIPE_PTHREAD_SCHED_MAX_CPUS));
+    ubase_assert(upipe_pthread_sched_add_cpu(&sched, 65));
+    assert(upipe_pthread_sched_has_cpu(&sched, 65));
+    assert(!upipe_pthread_sched_has_cpu(&sched, 64));
+    assert(!upipe_pthread_sched_has_cpu(&sched, 1));
+    printf("Passed 1\n");
+
+    /* pin a thread to the last CPU we are allowed to run on */
+    cpu_set_t cpuset;
+    assert(!pthread_getaffinity_np(pthread_self(), sizeof(cpuset), &cpuset));
+    for (unsigned int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        if (CPU_ISSET(cpu, &cpuset))
+            pinned_cpu = cpu;
+    upipe_pthread_sched_init(&sched);
+    ubase_assert(upipe_pthread_sched_add_cpu(&sched, pinned_cpu));
+    sched.policy = SCHED_OTHER;
+    sched.numa_node = UPIPE_PTHREAD_SCHED_NUMA_LOCAL;
+
+    pthread_t id;
+    assert(pthread_create(&id, NULL, thread, NULL) == 0);
+    assert(pthread_join(id, NULL) == 0);
+    printf("Passed 2\n");
+    return 0;
+}
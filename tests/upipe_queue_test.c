@@ -43,6 +43,7 @@
 #include <upipe/uref_flow.h>
 #include <upipe/uref_block_flow.h>
 #include <upipe/upump.h>
+#include <upipe/uclock.h>
 #include <upump-ev/upump_ev.h>
 #include <upipe/upipe.h>
 #include <upipe-modules/upipe_queue_source.h>
@@ -67,6 +68,9 @@ static uint8_t counter = 0;
 static struct uref_mgr *uref_mgr;
 static struct urequest request;
 static bool request_was_unregistered = false;
+static unsigned int nb_source_ends = 0;
+static unsigned int fanin_counter = 0;
+static struct upipe *fanin_qsinks[2];
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -81,6 +85,7 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
         case UPROBE_NEW_FLOW_DEF:
             break;
         case UPROBE_SOURCE_END:
+            nb_source_ends++;
             upipe_release(upipe);
             break;
     }
@@ -167,6 +172,47 @@ static struct upipe_mgr queue_test_mgr = {
     .upipe_control = test_control
 };
 
+/** helper phony pipe counting fan-in urefs */
+static void fanin_test_input(struct upipe *upipe, struct uref *uref,
+                             struct upump **upump_p)
+{
+    assert(uref != NULL);
+    uint8_t uref_counter;
+    ubase_assert(uref_test_get_test(uref, &uref_counter));
+    assert(uref_counter == fanin_counter / 2);
+    fanin_counter++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int fanin_test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** releases the last fan-in sink */
+static void fanin_timer(struct upump *upump)
+{
+    assert(fanin_counter == 4);
+    assert(nb_source_ends == 0);
+    upipe_release(fanin_qsinks[1]);
+    upump_stop(upump);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr fanin_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = fanin_test_input,
+    .upipe_control = fanin_test_control
+};
+
 int main(int argc, char *argv[])
 {
     upump_mgr = upump_ev_mgr_alloc_default(UPUMP_POOL, UPUMP_BLOCKER_POOL);
@@ -215,6 +261,27 @@ int main(int argc, char *argv[])
     ubase_assert(upipe_set_flow_def(upipe_qsink, uref));
     uref_free(uref);
 
+    /* drain the whole queue on each wake-up, and only wake up the source
+     * once two urefs are queued */
+    unsigned int batch;
+    ubase_assert(upipe_qsrc_get_batch(upipe_qsrc, &batch));
+    assert(batch == 1);
+    ubase_nassert(upipe_qsrc_set_batch(upipe_qsrc, 0));
+    ubase_assert(upipe_qsrc_set_batch(upipe_qsrc, QUEUE_LENGTH));
+    ubase_assert(upipe_qsrc_get_batch(upipe_qsrc, &batch));
+    assert(batch == QUEUE_LENGTH);
+
+    unsigned int threshold;
+    uint64_t timeout;
+    ubase_assert(upipe_qsink_get_coalesce(upipe_qsink, &threshold, &timeout));
+    assert(threshold == 1);
+    ubase_nassert(upipe_qsink_set_coalesce(upipe_qsink, 0, 0));
+    ubase_nassert(upipe_qsink_set_coalesce(upipe_qsink, 2, 0));
+    ubase_assert(upipe_qsink_set_coalesce(upipe_qsink, 2, UCLOCK_FREQ / 100));
+    ubase_assert(upipe_qsink_get_coalesce(upipe_qsink, &threshold, &timeout));
+    assert(threshold == 2);
+    assert(timeout == UCLOCK_FREQ / 100);
+
     uref = uref_alloc(uref_mgr);
     assert(uref != NULL);
     ubase_assert(uref_test_set_test(uref, 0));
@@ -251,6 +318,62 @@ int main(int argc, char *argv[])
     upipe_release(upipe_qsrc);
     upipe_release(upipe_qsink);
 
+    /* fan-in mode, with one lane per sink */
+    struct upipe *fanin_sink = upipe_void_alloc(&fanin_test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "fan-in sink"));
+    assert(fanin_sink != NULL);
+    upipe_qsrc = upipe_qsrc_fanin_alloc(upipe_qsrc_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "fan-in queue source"), QUEUE_LENGTH, 2);
+    assert(upipe_qsrc != NULL);
+    ubase_assert(upipe_set_output(upipe_qsrc, fanin_sink));
+    ubase_assert(upipe_qsrc_get_max_length(upipe_qsrc, &length));
+    assert(length == QUEUE_LENGTH);
+
+    for (unsigned int i = 0; i < 2; i++) {
+        fanin_qsinks[i] = upipe_qsink_alloc(upipe_qsink_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                 "fan-in queue sink"),
+                upipe_qsrc);
+        assert(fanin_qsinks[i] != NULL);
+        uref = uref_block_flow_alloc_def(uref_mgr, NULL);
+        assert(uref != NULL);
+        ubase_assert(upipe_set_flow_def(fanin_qsinks[i], uref));
+        uref_free(uref);
+        ubase_nassert(upipe_qsink_set_coalesce(fanin_qsinks[i], 2,
+                                               UCLOCK_FREQ / 100));
+    }
+    /* no lane left */
+    assert(upipe_qsink_alloc(upipe_qsink_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                 "fan-in queue sink"),
+                upipe_qsrc) == NULL);
+
+    for (uint8_t j = 0; j < 2; j++) {
+        for (unsigned int i = 0; i < 2; i++) {
+            uref = uref_alloc(uref_mgr);
+            assert(uref != NULL);
+            ubase_assert(uref_test_set_test(uref, j));
+            upipe_input(fanin_qsinks[i], uref, NULL);
+        }
+    }
+    ubase_assert(upipe_qsrc_get_length(upipe_qsrc, &length));
+    assert(length == 6);
+
+    /* source end is only thrown when the last sink is released */
+    nb_source_ends = 0;
+    upipe_release(upipe_qsrc);
+    upipe_release(fanin_qsinks[0]);
+    struct upump *upump = upump_alloc_timer(upump_mgr, fanin_timer, NULL,
+                                            NULL, UCLOCK_FREQ / 10, 0);
+    assert(upump != NULL);
+    upump_start(upump);
+    upump_mgr_run(upump_mgr, NULL);
+    upump_free(upump);
+    assert(nb_source_ends == 1);
+    test_free(fanin_sink);
+
     upipe_mgr_release(upipe_qsink_mgr); // nop
     upipe_mgr_release(upipe_qsrc_mgr); // nop
 
@@ -54,6 +54,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <time.h>
 
 #include <libswscale/swscale.h>
 #include <libavutil/pixdesc.h> // debug
@@ -69,6 +70,15 @@
 
 #define SRCSIZE             32
 #define DSTSIZE             16
+#define SLICE_HSIZE         128
+#define SLICE_VSIZE         256
+#define RESCALE_HSIZE       96
+#define RESCALE_VSIZE       160
+#define BENCH_SRC_HSIZE     1920
+#define BENCH_SRC_VSIZE     1080
+#define BENCH_DST_HSIZE     1280
+#define BENCH_DST_VSIZE     720
+#define BENCH_FRAMES        8
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -427,6 +437,126 @@ int main(int argc, char **argv)
     /* release urefs */
     uref_free(uref1);
     uref_free(uref2);
+    upipe_release(sws);
+
+    /* slice threading gives the same result as a single thread, with or
+     * without rescaling, in both frame and field modes, including odd
+     * vertical sizes */
+    pic_flow = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(pic_flow != NULL);
+    ubase_assert(uref_pic_flow_add_plane(pic_flow, 1, 1, 1, "y8"));
+    ubase_assert(uref_pic_flow_add_plane(pic_flow, 2, 2, 1, "u8"));
+    ubase_assert(uref_pic_flow_add_plane(pic_flow, 2, 2, 1, "v8"));
+    ubase_assert(uref_pic_flow_set_align(pic_flow, UBUF_ALIGN));
+
+    static const struct {
+        size_t input_hsize, input_vsize, output_hsize, output_vsize;
+    } slice_tests[] = {
+        { SLICE_HSIZE, SLICE_VSIZE, SLICE_HSIZE, SLICE_VSIZE },
+        { SLICE_HSIZE, SLICE_VSIZE, RESCALE_HSIZE, RESCALE_VSIZE },
+        { SLICE_HSIZE, SLICE_VSIZE - 1, RESCALE_HSIZE, RESCALE_VSIZE - 1 },
+    };
+    unsigned int nb_threads;
+    for (size_t t = 0; t < UBASE_ARRAY_SIZE(slice_tests); t++) {
+        output_flow = uref_dup(pic_flow);
+        assert(output_flow != NULL);
+        ubase_assert(uref_pic_flow_set_hsize(output_flow,
+                                             slice_tests[t].output_hsize));
+        ubase_assert(uref_pic_flow_set_vsize(output_flow,
+                                             slice_tests[t].output_vsize));
+        sws = upipe_flow_alloc(upipe_sws_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "sws"),
+                output_flow);
+        assert(sws != NULL);
+        uref_free(output_flow);
+        ubase_assert(upipe_set_flow_def(sws, pic_flow));
+        ubase_assert(upipe_set_output(sws, sws_test));
+        ubase_assert(upipe_sws_get_threads(sws, &nb_threads));
+        assert(nb_threads == 1);
+
+        for (int progressive = 0; progressive < 2; progressive++) {
+            uref1 = uref_pic_alloc(uref_mgr, ubuf_mgr,
+                                   slice_tests[t].input_hsize,
+                                   slice_tests[t].input_vsize);
+            assert(uref1 != NULL);
+            if (progressive)
+                ubase_assert(uref_pic_set_progressive(uref1));
+            fill_in(uref1, "y8", 1, 1, 1);
+            fill_in(uref1, "u8", 2, 2, 1);
+            fill_in(uref1, "v8", 2, 2, 1);
+
+            ubase_assert(upipe_sws_set_threads(sws, 1));
+            upipe_input(sws, uref_dup(uref1), NULL);
+            uref2 = sws_test_from_upipe(sws_test)->pic;
+            assert(uref2 != NULL);
+            sws_test_from_upipe(sws_test)->pic = NULL;
+
+            size_t hsize, vsize;
+            ubase_assert(uref_pic_size(uref2, &hsize, &vsize, NULL));
+            assert(hsize == slice_tests[t].output_hsize);
+            assert(vsize == slice_tests[t].output_vsize);
+
+            /* slice threads need a recent libswscale */
+            if (ubase_check(upipe_sws_set_threads(sws, 4))) {
+                ubase_assert(upipe_sws_get_threads(sws, &nb_threads));
+                assert(nb_threads == 4);
+                upipe_input(sws, uref_dup(uref1), NULL);
+                struct uref *urefs[2] =
+                    { uref2, sws_test_from_upipe(sws_test)->pic };
+                assert(urefs[1] != NULL);
+                assert(compare_chroma(urefs, "y8", 1, 1, 1, logger));
+                assert(compare_chroma(urefs, "u8", 2, 2, 1, logger));
+                assert(compare_chroma(urefs, "v8", 2, 2, 1, logger));
+            }
+            uref_free(uref2);
+            uref_free(uref1);
+        }
+        upipe_release(sws);
+    }
+
+    /* benchmark the rescaling of a full HD picture */
+    output_flow = uref_dup(pic_flow);
+    assert(output_flow != NULL);
+    ubase_assert(uref_pic_flow_set_hsize(output_flow, BENCH_DST_HSIZE));
+    ubase_assert(uref_pic_flow_set_vsize(output_flow, BENCH_DST_VSIZE));
+    sws = upipe_flow_alloc(upipe_sws_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_NOTICE, "sws"),
+            output_flow);
+    assert(sws != NULL);
+    uref_free(output_flow);
+    ubase_assert(upipe_set_flow_def(sws, pic_flow));
+    ubase_assert(upipe_set_output(sws, sws_test));
+    uref_free(pic_flow);
+
+    uref1 = uref_pic_alloc(uref_mgr, ubuf_mgr,
+                           BENCH_SRC_HSIZE, BENCH_SRC_VSIZE);
+    assert(uref1 != NULL);
+    ubase_assert(uref_pic_set_progressive(uref1));
+    fill_in(uref1, "y8", 1, 1, 1);
+    fill_in(uref1, "u8", 2, 2, 1);
+    fill_in(uref1, "v8", 2, 2, 1);
+
+    for (nb_threads = 1; nb_threads <= 8; nb_threads *= 2) {
+        if (!ubase_check(upipe_sws_set_threads(sws, nb_threads)))
+            break;
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < BENCH_FRAMES; i++)
+            upipe_input(sws, uref_dup(uref1), NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        size_t hsize, vsize;
+        ubase_assert(uref_pic_size(sws_test_from_upipe(sws_test)->pic,
+                                   &hsize, &vsize, NULL));
+        assert(hsize == BENCH_DST_HSIZE && vsize == BENCH_DST_VSIZE);
+        double duration = (end.tv_sec - start.tv_sec) * 1000. +
+                          (end.tv_nsec - start.tv_nsec) / 1000000.;
+        printf("%ux%u -> %ux%u, %u threads: %.2f ms per picture\n",
+               BENCH_SRC_HSIZE, BENCH_SRC_VSIZE,
+               BENCH_DST_HSIZE, BENCH_DST_VSIZE,
+               nb_threads, duration / BENCH_FRAMES);
+    }
+    uref_free(uref1);
 
     /* release pipes */
     upipe_release(sws);
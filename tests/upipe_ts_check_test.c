@@ -62,6 +62,7 @@
 #define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
 
 static unsigned int nb_packets = 0;
+static unsigned int nb_urefs = 0;
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -96,16 +97,19 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(uref != NULL);
     size_t size;
     ubase_assert(uref_block_size(uref, &size));
-    assert(size == TS_SIZE);
+    assert(size && !(size % TS_SIZE));
 
-    const uint8_t *buffer;
-    int rsize = 1;
-    ubase_assert(uref_block_read(uref, 0, &rsize, &buffer));
-    assert(rsize == 1);
-    assert(ts_validate(buffer));
-    uref_block_unmap(uref, 0);
+    for (size_t offset = 0; offset < size; offset += TS_SIZE) {
+        const uint8_t *buffer;
+        int rsize = 1;
+        ubase_assert(uref_block_read(uref, offset, &rsize, &buffer));
+        assert(rsize == 1);
+        assert(ts_validate(buffer));
+        uref_block_unmap(uref, offset);
+        nb_packets--;
+    }
     uref_free(uref);
-    nb_packets--;
+    nb_urefs++;
 }
 
 /** helper phony pipe */
@@ -215,6 +219,27 @@ int main(int argc, char *argv[])
     upipe_input(upipe_ts_check, uref, NULL);
     assert(!nb_packets);
 
+    /* vector mode */
+    unsigned int vector;
+    ubase_assert(upipe_ts_check_set_vector(upipe_ts_check, 4));
+    ubase_assert(upipe_ts_check_get_vector(upipe_ts_check, &vector));
+    assert(vector == 4);
+
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 7 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 7 * TS_SIZE);
+    for (i = 0; i < 7; i++)
+        ts_pad(buffer + i * TS_SIZE);
+    buffer[5 * TS_SIZE] = 0xff;
+    uref_block_unmap(uref, 0);
+    nb_packets = 5;
+    nb_urefs = 0;
+    upipe_input(upipe_ts_check, uref, NULL);
+    assert(!nb_packets);
+    assert(nb_urefs == 2);
+
     upipe_release(upipe_ts_check);
     upipe_mgr_release(upipe_ts_check_mgr); // nop
 
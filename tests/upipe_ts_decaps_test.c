@@ -46,6 +46,7 @@
 #include <upipe/uref_clock.h>
 #include <upipe/uref_std.h>
 #include <upipe/upipe.h>
+#include <upipe-ts/uref_ts_flow.h>
 #include <upipe-ts/upipe_ts_decaps.h>
 
 #include <stdbool.h>
@@ -240,6 +241,32 @@ int main(int argc, char *argv[])
     assert(!nb_packets);
     assert(!pcr);
 
+    /* vector of TS packets */
+    uref = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(uref != NULL);
+    ubase_assert(uref_ts_flow_set_vector(uref));
+    ubase_assert(upipe_set_flow_def(upipe_ts_decaps, uref));
+    uref_free(uref);
+
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 3 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 3 * TS_SIZE);
+    for (int i = 0; i < 3; i++) {
+        ts_init(buffer + i * TS_SIZE);
+        ts_set_unitstart(buffer + i * TS_SIZE);
+        ts_set_cc(buffer + i * TS_SIZE, 4 + i);
+        ts_set_payload(buffer + i * TS_SIZE);
+    }
+    start = UBASE_ERR_NONE;
+    discontinuity = UBASE_ERR_INVALID;
+    payload_size = 184;
+    uref_block_unmap(uref, 0);
+    nb_packets += 3;
+    upipe_input(upipe_ts_decaps, uref, NULL);
+    assert(!nb_packets);
+
     upipe_release(upipe_ts_decaps);
     upipe_mgr_release(upipe_ts_decaps_mgr); // nop
 
@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for the statmux mode of the TS mux module
+ */
+
+#undef NDEBUG
+
+#include <upipe/uclock.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe-ts/upipe_ts_mux.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include <assert.h>
+
+#include <bitstream/mpeg/ts.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+/** number of video inputs, one per program */
+#define NB_INPUTS 2
+/** frame rate of the inputs */
+#define FPS 25
+/** number of frames fed to each input */
+#define NB_FRAMES (4 * FPS)
+/** octetrate declared by each input */
+#define OCTETRATE 125000
+/** buffer size declared by each input (500 ms) */
+#define BUFFER_SIZE (OCTETRATE / 2)
+#define MUX_OCTETRATE (TS_SIZE * 1600)
+
+/** size of the frames of each input: the first one exceeds its declared
+ * octetrate and the second one uses less than half of it */
+static const size_t frame_sizes[NB_INPUTS] = {
+    3 * OCTETRATE / FPS / 2, OCTETRATE / FPS / 3
+};
+
+static struct uprobe uprobe_inputs[NB_INPUTS];
+/** last target octetrate thrown for each input, or 0 */
+static uint64_t targets[NB_INPUTS];
+/** number of target octetrates thrown for each input */
+static unsigned int nb_targets[NB_INPUTS];
+static unsigned int nb_packets = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_LOG:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        case UPROBE_TS_MUX_LAST_CC:
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** probe catching the target octetrates of the inputs */
+static int catch_input(struct uprobe *uprobe, struct upipe *upipe,
+                       int event, va_list args)
+{
+    if (event != UPROBE_TS_MUX_TARGET_OCTETRATE)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+    int i = uprobe - uprobe_inputs;
+    assert(i >= 0 && i < NB_INPUTS);
+    targets[i] = va_arg(args, uint64_t);
+    nb_targets[i]++;
+    upipe_notice_va(upipe, "target octetrate %"PRIu64, targets[i]);
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    assert(size % TS_SIZE == 0);
+    nb_packets += size / TS_SIZE;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&test_mgr,
+                                                uprobe_use(logger));
+    assert(upipe_sink != NULL);
+
+    struct upipe_mgr *upipe_ts_mux_mgr = upipe_ts_mux_mgr_alloc();
+    assert(upipe_ts_mux_mgr != NULL);
+    struct upipe *upipe_ts_mux = upipe_void_alloc(upipe_ts_mux_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "ts mux"));
+    assert(upipe_ts_mux != NULL);
+    upipe_mgr_release(upipe_ts_mux_mgr);
+
+    struct uref *flow_def = uref_alloc_control(uref_mgr);
+    assert(flow_def != NULL);
+    ubase_assert(uref_flow_set_def(flow_def, "void."));
+    ubase_assert(upipe_set_flow_def(upipe_ts_mux, flow_def));
+    ubase_assert(upipe_set_output(upipe_ts_mux, upipe_sink));
+    ubase_assert(upipe_ts_mux_set_mode(upipe_ts_mux,
+                                       UPIPE_TS_MUX_MODE_STATMUX));
+    ubase_assert(upipe_ts_mux_set_octetrate(upipe_ts_mux, MUX_OCTETRATE));
+    ubase_assert(upipe_ts_mux_set_statmux_interval(upipe_ts_mux,
+                                                   UCLOCK_FREQ));
+    uint64_t interval;
+    ubase_assert(upipe_ts_mux_get_statmux_interval(upipe_ts_mux, &interval));
+    assert(interval == UCLOCK_FREQ);
+
+    struct upipe *programs[NB_INPUTS], *inputs[NB_INPUTS];
+    for (int i = 0; i < NB_INPUTS; i++) {
+        programs[i] = upipe_void_alloc_sub(upipe_ts_mux,
+                uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                    "program %d", i));
+        assert(programs[i] != NULL);
+        ubase_assert(upipe_set_flow_def(programs[i], flow_def));
+
+        uprobe_init(&uprobe_inputs[i], catch_input, uprobe_use(logger));
+        inputs[i] = upipe_void_alloc_sub(programs[i],
+                uprobe_pfx_alloc_va(uprobe_use(&uprobe_inputs[i]),
+                                    UPROBE_LOG_LEVEL, "input %d", i));
+        assert(inputs[i] != NULL);
+    }
+    uref_free(flow_def);
+
+    flow_def = uref_block_flow_alloc_def(uref_mgr, "mpeg2video.pic.");
+    assert(flow_def != NULL);
+    ubase_assert(uref_block_flow_set_octetrate(flow_def, OCTETRATE));
+    ubase_assert(uref_block_flow_set_buffer_size(flow_def, BUFFER_SIZE));
+    struct urational fps = { .num = FPS, .den = 1 };
+    ubase_assert(uref_pic_flow_set_fps(flow_def, fps));
+    for (int i = 0; i < NB_INPUTS; i++)
+        ubase_assert(upipe_set_flow_def(inputs[i], flow_def));
+    uref_free(flow_def);
+
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+
+    for (int frame = 0; frame < NB_FRAMES; frame++) {
+        uint64_t dts = UCLOCK_FREQ + frame * UCLOCK_FREQ / FPS;
+        for (int i = 0; i < NB_INPUTS; i++) {
+            struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr,
+                                                 frame_sizes[i]);
+            assert(uref != NULL);
+            uint8_t *buffer;
+            int size = -1;
+            ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+            memset(buffer, 0, size);
+            uref_block_unmap(uref, 0);
+            uref_clock_set_dts_sys(uref, dts);
+            uref_clock_set_dts_prog(uref, dts);
+            uref_clock_set_dts_pts_delay(uref, 0);
+            uref_clock_set_duration(uref, UCLOCK_FREQ / FPS);
+            if (!frame)
+                uref_flow_set_random(uref);
+            upipe_input(inputs[i], uref, NULL);
+        }
+    }
+    assert(nb_packets);
+
+    /* the input that exceeds its octetrate runs late and gets a larger
+     * share of the budget, taken from the other input */
+    for (int i = 0; i < NB_INPUTS; i++)
+        assert(nb_targets[i]);
+    assert(targets[0] > OCTETRATE);
+    assert(targets[1] < OCTETRATE);
+    assert(targets[0] + targets[1] < MUX_OCTETRATE);
+
+    /* leaving statmux mode restores the declared octetrates */
+    ubase_assert(upipe_ts_mux_set_mode(upipe_ts_mux,
+                                       UPIPE_TS_MUX_MODE_CAPPED));
+    for (int i = 0; i < NB_INPUTS; i++)
+        assert(targets[i] == OCTETRATE);
+
+    for (int i = 0; i < NB_INPUTS; i++) {
+        upipe_release(inputs[i]);
+        upipe_release(programs[i]);
+    }
+    upipe_release(upipe_ts_mux);
+    test_free(upipe_sink);
+
+    for (int i = 0; i < NB_INPUTS; i++)
+        uprobe_clean(&uprobe_inputs[i]);
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
@@ -51,6 +51,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <inttypes.h>
 #include <assert.h>
@@ -95,6 +96,8 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
 struct test {
     uint16_t pid;
     bool got_packet;
+    unsigned int nb_urefs;
+    unsigned int nb_packets;
     struct upipe upipe;
 };
 
@@ -109,6 +112,7 @@ static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
     assert(test != NULL);
     upipe_init(&test->upipe, mgr, uprobe);
     test->got_packet = false;
+    test->nb_urefs = test->nb_packets = 0;
     test->pid = pid;
     return &test->upipe;
 }
@@ -120,13 +124,20 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     struct test *test = container_of(upipe, struct test, upipe);
     assert(uref != NULL);
     test->got_packet = true;
-    const uint8_t *buffer;
-    int size = -1;
-    ubase_assert(uref_block_read(uref, 0, &size, &buffer));
-    assert(size == TS_SIZE); //because of the way we allocated it
-    assert(ts_validate(buffer));
-    assert(ts_get_pid(buffer) == test->pid);
-    uref_block_unmap(uref, 0);
+    test->nb_urefs++;
+    size_t uref_size;
+    ubase_assert(uref_block_size(uref, &uref_size));
+    assert(uref_size && !(uref_size % TS_SIZE));
+    for (size_t offset = 0; offset < uref_size; offset += TS_SIZE) {
+        uint8_t header[TS_HEADER_SIZE];
+        const uint8_t *buffer = uref_block_peek(uref, offset, TS_HEADER_SIZE,
+                                                header);
+        assert(buffer != NULL);
+        assert(ts_validate(buffer));
+        assert(ts_get_pid(buffer) == test->pid);
+        ubase_assert(uref_block_peek_unmap(uref, offset, header, buffer));
+        test->nb_packets++;
+    }
     uref_free(uref);
 }
 
@@ -236,12 +247,77 @@ int main(int argc, char *argv[])
     uref_block_unmap(uref, 0);
     upipe_input(upipe_ts_split, uref, NULL);
 
+    /* vector of TS packets */
+    uref = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(uref != NULL);
+    ubase_assert(uref_ts_flow_set_vector(uref));
+    ubase_assert(upipe_set_flow_def(upipe_ts_split, uref));
+
+    ubase_assert(uref_ts_flow_set_pid(uref, 68));
+    struct upipe *upipe_sink68v = upipe_flow_alloc(&test_mgr,
+            uprobe_use(uprobe_stdio), uref);
+    assert(upipe_sink68v != NULL);
+
+    struct upipe *upipe_ts_split_output68v =
+        upipe_flow_alloc_sub(upipe_ts_split,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts split output 68 vector"), uref);
+    assert(upipe_ts_split_output68v != NULL);
+    ubase_assert(upipe_set_output(upipe_ts_split_output68v, upipe_sink68v));
+    uref_free(uref);
+
+    static const uint16_t vector_pids[] = { 68, 70, 69, 68, 68 };
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr,
+                            TS_SIZE * UBASE_ARRAY_SIZE(vector_pids));
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == TS_SIZE * UBASE_ARRAY_SIZE(vector_pids));
+    for (unsigned int i = 0; i < UBASE_ARRAY_SIZE(vector_pids); i++) {
+        ts_pad(buffer + i * TS_SIZE);
+        ts_set_pid(buffer + i * TS_SIZE, vector_pids[i]);
+    }
+    uref_block_unmap(uref, 0);
+    upipe_input(upipe_ts_split, uref, NULL);
+
+    /* vector of TS packets with a header split between two segments */
+    static const uint16_t segmented_pids[] = { 69, 68, 68 };
+    uint8_t packets[TS_SIZE * UBASE_ARRAY_SIZE(segmented_pids)];
+    for (unsigned int i = 0; i < UBASE_ARRAY_SIZE(segmented_pids); i++) {
+        ts_pad(packets + i * TS_SIZE);
+        ts_set_pid(packets + i * TS_SIZE, segmented_pids[i]);
+    }
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, TS_SIZE + 2);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == TS_SIZE + 2);
+    memcpy(buffer, packets, size);
+    uref_block_unmap(uref, 0);
+    struct ubuf *ubuf = ubuf_block_alloc(ubuf_mgr, sizeof(packets) - TS_SIZE - 2);
+    assert(ubuf != NULL);
+    size = -1;
+    ubase_assert(ubuf_block_write(ubuf, 0, &size, &buffer));
+    memcpy(buffer, packets + TS_SIZE + 2, size);
+    ubuf_block_unmap(ubuf, 0);
+    ubase_assert(uref_block_append(uref, ubuf));
+    upipe_input(upipe_ts_split, uref, NULL);
+
     upipe_release(upipe_ts_split_output68);
+    upipe_release(upipe_ts_split_output68v);
     upipe_release(upipe_ts_split_output69);
     upipe_release(upipe_ts_split);
     upipe_mgr_release(upipe_ts_split_mgr); // nop
 
+    struct test *test = container_of(upipe_sink68, struct test, upipe);
+    assert(test->nb_urefs == 6 && test->nb_packets == 6);
+    test = container_of(upipe_sink68v, struct test, upipe);
+    assert(test->nb_urefs == 2 && test->nb_packets == 5);
+    test = container_of(upipe_sink69, struct test, upipe);
+    assert(test->nb_urefs == 3 && test->nb_packets == 3);
+
     test_free(upipe_sink68);
+    test_free(upipe_sink68v);
     test_free(upipe_sink69);
 
     uref_mgr_release(uref_mgr);
@@ -43,12 +43,14 @@
 #include <upipe/uref_flow.h>
 #include <upipe/uref_block_flow.h>
 #include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
 #include <upipe/uref_std.h>
 #include <upipe/upipe.h>
 #include <upipe-ts/upipe_ts_sync.h>
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <inttypes.h>
@@ -64,6 +66,14 @@
 static unsigned int nb_packets = 0;
 static int expect_loss = -1;
 
+/* dates of the input urefs in which the packets of the vector test start */
+static const uint64_t vector_dates[] = {
+    1, 1, 1, 2, 2, 2, 2, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4
+};
+static bool vector_mode = false;
+static unsigned int vector_packet = 0;
+static unsigned int nb_vectors = 0;
+
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
                  int event, va_list args)
@@ -101,16 +111,55 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(uref != NULL);
     size_t size;
     ubase_assert(uref_block_size(uref, &size));
-    assert(size == TS_SIZE);
+    if (!vector_mode)
+        assert(size == TS_SIZE);
+    else {
+        assert(size && !(size % TS_SIZE) && size <= 8 * TS_SIZE);
+        uint64_t cr_sys;
+        ubase_assert(uref_clock_get_cr_sys(uref, &cr_sys));
+        for (size_t offset = 0; offset < size; offset += TS_SIZE) {
+            assert(vector_packet < UBASE_ARRAY_SIZE(vector_dates));
+            assert(cr_sys == vector_dates[vector_packet]);
+            vector_packet++;
+        }
+        if (size > TS_SIZE)
+            nb_vectors++;
+    }
 
-    const uint8_t *buffer;
-    int rsize = 1;
-    ubase_assert(uref_block_read(uref, 0, &rsize, &buffer));
-    assert(rsize == 1);
-    assert(ts_validate(buffer));
-    uref_block_unmap(uref, 0);
+    for (size_t offset = 0; offset < size; offset += TS_SIZE) {
+        const uint8_t *buffer;
+        int rsize = 1;
+        ubase_assert(uref_block_read(uref, offset, &rsize, &buffer));
+        assert(rsize == 1);
+        assert(ts_validate(buffer));
+        uref_block_unmap(uref, offset);
+        nb_packets--;
+    }
     uref_free(uref);
-    nb_packets--;
+}
+
+/** helper function to input a stream chunk in the vector test */
+static void input_chunk(struct upipe *upipe, struct uref_mgr *uref_mgr,
+                        struct ubuf_mgr *ubuf_mgr, size_t head, size_t packets,
+                        size_t tail, uint64_t date)
+{
+    size_t total = head + packets * TS_SIZE + tail;
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, total);
+    assert(uref != NULL);
+    uint8_t *buffer;
+    int size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == total);
+    memset(buffer, 0xff, head);
+    for (size_t i = 0; i < packets; i++)
+        ts_pad(buffer + head + i * TS_SIZE);
+    if (tail) {
+        memset(buffer + total - tail, 0xff, tail);
+        buffer[total - tail] = 0x47;
+    }
+    uref_block_unmap(uref, 0);
+    uref_clock_set_cr_sys(uref, date);
+    upipe_input(upipe, uref, NULL);
 }
 
 /** helper phony pipe */
@@ -233,6 +282,31 @@ int main(int argc, char *argv[])
     nb_packets++;
     upipe_release(upipe_ts_sync);
     assert(!nb_packets);
+
+    /* vectors must not span several input urefs */
+    uref = uref_block_flow_alloc_def(uref_mgr, NULL);
+    assert(uref != NULL);
+    upipe_ts_sync = upipe_void_alloc(upipe_ts_sync_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts sync vector"));
+    assert(upipe_ts_sync != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_ts_sync, uref));
+    ubase_assert(upipe_set_output(upipe_ts_sync, upipe_sink));
+    ubase_assert(upipe_ts_sync_set_vector(upipe_ts_sync, 8));
+    uref_free(uref);
+    vector_mode = true;
+    expect_loss = -1;
+
+    nb_packets += UBASE_ARRAY_SIZE(vector_dates);
+    input_chunk(upipe_ts_sync, uref_mgr, ubuf_mgr, 0, 3, 0, 1);
+    input_chunk(upipe_ts_sync, uref_mgr, ubuf_mgr, 0, 3, TS_SIZE / 2, 2);
+    input_chunk(upipe_ts_sync, uref_mgr, ubuf_mgr, TS_SIZE / 2, 2, 0, 3);
+    input_chunk(upipe_ts_sync, uref_mgr, ubuf_mgr, 0, 10, 0, 4);
+    upipe_release(upipe_ts_sync);
+    assert(!nb_packets);
+    assert(vector_packet == UBASE_ARRAY_SIZE(vector_dates));
+    assert(nb_vectors);
+
     upipe_mgr_release(upipe_ts_sync_mgr); // nop
 
     test_free(upipe_sink);
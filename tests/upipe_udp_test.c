@@ -58,6 +58,7 @@
 #include <upipe-modules/upipe_udp_source.h>
 #include <upipe-modules/upipe_udp_sink.h>
 #include <upipe/upipe_helper_upipe.h>
+#include <upipe/uref_clock.h>
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -68,8 +69,11 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <string.h>
+#include <time.h>
 
 #define UDICT_POOL_DEPTH 0
 #define UREF_POOL_DEPTH 0
@@ -80,6 +84,17 @@
 #define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
 #define BUF_SIZE 256
 #define FORMAT "This is packet number %d"
+#define GSO_SIZE 1316
+#define GSO_SEGMENTS 7
+#define GSO_TAIL_SIZE 188
+#define GSO_TAIL_SEGMENTS 2
+#define TXTIME_PACKETS 16
+#define TXTIME_BAD_CLOCK 42
+#define READ_DELAY (UCLOCK_FREQ / 10)
+#define BATCH_DEPTH 8
+#define BATCH_FIRST 300
+#define BATCH_PACKETS 20
+#define BATCH_INTRUDER 999
 
 /* FIXME: uncomment or remove */
 /*static void usage(const char *argv0) {
@@ -102,6 +117,7 @@ struct addrinfo hints, *servinfo, *p;
 struct upipe *upipe_udpsrc;
 struct upipe *upipe_udpsink;
 static int counter = 0;
+static int new_peers = 0;
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -115,7 +131,9 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
         case UPROBE_DEAD:
         case UPROBE_NEW_FLOW_DEF:
         case UPROBE_SOURCE_END:
+            break;
         case UPROBE_UDPSRC_NEW_PEER:
+            new_peers++;
             break;
     }
     return UBASE_ERR_NONE;
@@ -124,6 +142,11 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
 /** helper phony pipe */
 struct udpsrc_test {
     int counter;
+    uint64_t cr_sys;
+    /** number of distinct cr_sys, that is of reads without timestamps */
+    int reads;
+    /** number of datagrams sharing the last cr_sys */
+    int read_size;
     struct uref *flow;
     struct upipe upipe;
 };
@@ -139,6 +162,9 @@ static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
     assert(udpsrc_test != NULL);
     udpsrc_test->flow = NULL;
     udpsrc_test->counter = 0;
+    udpsrc_test->cr_sys = UINT64_MAX;
+    udpsrc_test->reads = 0;
+    udpsrc_test->read_size = 0;
     upipe_init(&udpsrc_test->upipe, mgr, uprobe);
     upipe_throw_ready(&udpsrc_test->upipe);
     return &udpsrc_test->upipe;
@@ -160,7 +186,17 @@ static void test_input(struct upipe *upipe, struct uref *uref,
         udpsrc_test->counter++;
         uref_block_peek_unmap(uref, 0, buf, rbuf);
     }
-    if (udpsrc_test->counter == 110 || udpsrc_test->counter == 210) {
+    uint64_t cr_sys;
+    ubase_assert(uref_clock_get_cr_sys(uref, &cr_sys));
+    if (cr_sys != udpsrc_test->cr_sys) {
+        udpsrc_test->reads++;
+        udpsrc_test->read_size = 0;
+    }
+    udpsrc_test->read_size++;
+    udpsrc_test->cr_sys = cr_sys;
+    if (udpsrc_test->counter == 110 || udpsrc_test->counter == 210 ||
+        udpsrc_test->counter == 211 || udpsrc_test->counter == 212 ||
+        udpsrc_test->counter == BATCH_FIRST + BATCH_PACKETS) {
         upipe_set_uri(upipe_udpsrc, NULL);
     }
 
@@ -249,6 +285,381 @@ static void genpackets2(struct upump *upump)
     }
 }
 
+#if defined(UPIPE_HAVE_SENDMMSG) && defined(UDP_SEGMENT) && defined(UDP_GRO)
+/** receives a datagram on a GRO-enabled socket */
+static ssize_t recv_gro(int fd, uint8_t *buf, size_t size, int *segment_p)
+{
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct iovec iovec = { .iov_base = buf, .iov_len = size };
+    struct msghdr msghdr = {
+        .msg_iov = &iovec,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf),
+    };
+    ssize_t ret = recvmsg(fd, &msghdr, MSG_DONTWAIT);
+    *segment_p = ret;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msghdr); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(&msghdr, cmsg))
+        if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO)
+            memcpy(segment_p, CMSG_DATA(cmsg), sizeof(int));
+    return ret;
+}
+
+/** checks that same-size datagrams are sent as a single segmented one */
+static void test_gso(struct upump_mgr *upump_mgr, struct uprobe *logger)
+{
+    /* the receiving socket keeps the segments together */
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+    struct sockaddr_in addr;
+    socklen_t addrlen = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(fd, (struct sockaddr *)&addr, addrlen) == 0);
+    assert(getsockname(fd, (struct sockaddr *)&addr, &addrlen) == 0);
+    int one = 1;
+    assert(setsockopt(fd, IPPROTO_UDP, UDP_GRO, &one, sizeof(one)) == 0);
+
+    struct upipe *upipe_gso = upipe_void_alloc(upipe_udpsink_mgr_alloc(),
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "udp sink gso"));
+    assert(upipe_gso != NULL);
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "bar");
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_gso, flow_def));
+    uref_free(flow_def);
+    char uri[64];
+    snprintf(uri, sizeof(uri), "127.0.0.1:%u", ntohs(addr.sin_port));
+    ubase_assert(upipe_set_uri(upipe_gso, uri));
+    ubase_assert(upipe_udpsink_set_batch(upipe_gso, 16, 0));
+    ubase_assert(upipe_udpsink_set_gso(upipe_gso, 1));
+    int gso;
+    ubase_assert(upipe_udpsink_get_gso(upipe_gso, &gso));
+    assert(gso);
+
+    /* 7 TS datagrams followed by 2 single-packet datagrams */
+    for (int i = 0; i < GSO_SEGMENTS + GSO_TAIL_SEGMENTS; i++) {
+        int size = i < GSO_SEGMENTS ? GSO_SIZE : GSO_TAIL_SIZE;
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, size);
+        assert(uref != NULL);
+        uint8_t *buf;
+        ubase_assert(uref_block_write(uref, 0, &size, &buf));
+        memset(buf, i, size);
+        uref_block_unmap(uref, 0);
+        upipe_input(upipe_gso, uref, NULL);
+    }
+    upump_mgr_run(upump_mgr, NULL);
+
+    uint8_t buf[GSO_SIZE * GSO_SEGMENTS];
+    int segment;
+    ssize_t ret = recv_gro(fd, buf, sizeof(buf), &segment);
+    assert(ret == GSO_SIZE * GSO_SEGMENTS);
+    assert(segment == GSO_SIZE);
+    for (int i = 0; i < GSO_SEGMENTS; i++)
+        assert(buf[i * GSO_SIZE] == i && buf[(i + 1) * GSO_SIZE - 1] == i);
+
+    ret = recv_gro(fd, buf, sizeof(buf), &segment);
+    assert(ret == GSO_TAIL_SIZE * GSO_TAIL_SEGMENTS);
+    assert(segment == GSO_TAIL_SIZE);
+    assert(buf[0] == GSO_SEGMENTS);
+    assert(buf[GSO_TAIL_SIZE] == GSO_SEGMENTS + 1);
+
+    assert(recv_gro(fd, buf, sizeof(buf), &segment) == -1);
+    upipe_release(upipe_gso);
+    close(fd);
+}
+#endif
+
+/** opens the udp source on a random port, only accepting datagrams from the
+ * given peer if it is not empty, and returns the port */
+static int open_udpsrc_peer(const char *peer)
+{
+    char udp_uri[512];
+    for (int i = 0; i < 10; i++) {
+        int port = ((rand() % 40000) + 1024);
+        snprintf(udp_uri, sizeof(udp_uri), "%s@127.0.0.1:%d", peer, port);
+        printf("Trying uri: %s ...\n", udp_uri);
+        if (ubase_check(upipe_set_uri(upipe_udpsrc, udp_uri)))
+            return port;
+    }
+    assert(0);
+    return -1;
+}
+
+/** opens the udp source on a random port and returns the port */
+static int open_udpsrc(void)
+{
+    return open_udpsrc_peer("");
+}
+
+/** sends a packet to the udp source and lets it wait before it is read */
+static uint64_t send_late(struct upump_mgr *upump_mgr, struct uclock *uclock,
+                          int port, int number)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    uint8_t buf[BUF_SIZE];
+    memset(buf, 0, sizeof(buf));
+    snprintf((char *)buf, BUF_SIZE, FORMAT, number);
+
+    uint64_t sent = uclock_now(uclock);
+    assert(sendto(fd, buf, BUF_SIZE, 0, (struct sockaddr *)&addr,
+                  sizeof(addr)) == BUF_SIZE);
+    usleep(READ_DELAY * 1000000 / UCLOCK_FREQ);
+    upump_mgr_run(upump_mgr, NULL);
+    close(fd);
+    return sent;
+}
+
+/** checks that cr_sys is the kernel arrival date, and not the read date */
+static void test_timestamps(struct upump_mgr *upump_mgr, struct uclock *uclock,
+                            struct upipe *upipe_test)
+{
+    struct udpsrc_test *udpsrc_test = udpsrc_test_from_upipe(upipe_test);
+    int timestamps, fd, on;
+    socklen_t len = sizeof(on);
+    ubase_assert(upipe_udpsrc_get_timestamps(upipe_udpsrc, &timestamps));
+    if (!timestamps)
+        /* not supported */
+        return;
+
+    int port = open_udpsrc();
+    ubase_assert(upipe_udpsrc_get_fd(upipe_udpsrc, &fd));
+    assert(getsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, &len) == 0);
+    assert(on);
+    uint64_t sent = send_late(upump_mgr, uclock, port, 210);
+    assert(udpsrc_test->counter == 211);
+    assert(udpsrc_test->cr_sys + UCLOCK_FREQ / 1000 >= sent);
+    assert(udpsrc_test->cr_sys < sent + READ_DELAY / 2);
+
+    /* disabling timestamps clears the socket option */
+    port = open_udpsrc();
+    ubase_assert(upipe_udpsrc_set_timestamps(upipe_udpsrc, 0));
+    ubase_assert(upipe_udpsrc_get_timestamps(upipe_udpsrc, &timestamps));
+    assert(!timestamps);
+    ubase_assert(upipe_udpsrc_get_fd(upipe_udpsrc, &fd));
+    assert(getsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, &len) == 0);
+    assert(!on);
+    sent = send_late(upump_mgr, uclock, port, 211);
+    assert(udpsrc_test->counter == 212);
+    assert(udpsrc_test->cr_sys >= sent + READ_DELAY);
+}
+
+#ifdef UPIPE_HAVE_RECVMMSG
+/** opens a socket bound to an ephemeral loopback port and returns it */
+static int open_peer(struct sockaddr_in *addr)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+    socklen_t addrlen = sizeof(*addr);
+    memset(addr, 0, addrlen);
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(fd, (struct sockaddr *)addr, addrlen) == 0);
+    assert(getsockname(fd, (struct sockaddr *)addr, &addrlen) == 0);
+    return fd;
+}
+
+/** sends a numbered packet to the udp source */
+static void send_number(int fd, int port, int number)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    uint8_t buf[BUF_SIZE];
+    memset(buf, 0, sizeof(buf));
+    snprintf((char *)buf, BUF_SIZE, FORMAT, number);
+    assert(sendto(fd, buf, BUF_SIZE, 0, (struct sockaddr *)&addr,
+                  sizeof(addr)) == BUF_SIZE);
+}
+
+/** checks that queued datagrams are read in order by full and partial
+ * batches, and that datagrams from other peers are filtered */
+static void test_batch(struct upump_mgr *upump_mgr, struct upipe *upipe_test)
+{
+    struct udpsrc_test *udpsrc_test = udpsrc_test_from_upipe(upipe_test);
+    struct sockaddr_in peer_addr, intruder_addr;
+    int peer = open_peer(&peer_addr);
+    int intruder = open_peer(&intruder_addr);
+
+    /* without kernel timestamps, all datagrams of a batch share cr_sys */
+    ubase_assert(upipe_udpsrc_set_timestamps(upipe_udpsrc, 0));
+    ubase_assert(upipe_udpsrc_set_batch(upipe_udpsrc, BATCH_DEPTH));
+    char connect[64];
+    snprintf(connect, sizeof(connect), "127.0.0.1:%u",
+             ntohs(peer_addr.sin_port));
+    int port = open_udpsrc_peer(connect);
+
+    /* everything is queued before the first wake-up */
+    for (int i = 0; i < BATCH_PACKETS; i++) {
+        if (i % 3 == 0)
+            send_number(intruder, port, BATCH_INTRUDER);
+        send_number(peer, port, BATCH_FIRST + i);
+    }
+    udpsrc_test->counter = BATCH_FIRST;
+    udpsrc_test->cr_sys = UINT64_MAX;
+    udpsrc_test->reads = 0;
+    new_peers = 0;
+    upump_mgr_run(upump_mgr, NULL);
+
+    assert(udpsrc_test->counter == BATCH_FIRST + BATCH_PACKETS);
+    assert(udpsrc_test->reads == (BATCH_PACKETS + BATCH_DEPTH - 1) /
+                                 BATCH_DEPTH);
+    assert(udpsrc_test->read_size == BATCH_PACKETS % BATCH_DEPTH);
+    assert(new_peers == 1);
+
+    ubase_assert(upipe_udpsrc_set_batch(upipe_udpsrc, 1));
+    close(peer);
+    close(intruder);
+}
+#endif
+
+/** sends dated packets through a sink and checks they are all received */
+static void send_txtime(struct upump_mgr *upump_mgr, struct uclock *uclock,
+                        struct upipe *upipe, int fd)
+{
+    uint64_t now = uclock_now(uclock);
+    for (int i = 0; i < TXTIME_PACKETS; i++) {
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, BUF_SIZE);
+        assert(uref != NULL);
+        int size = BUF_SIZE;
+        uint8_t *buf;
+        ubase_assert(uref_block_write(uref, 0, &size, &buf));
+        memset(buf, i, size);
+        uref_block_unmap(uref, 0);
+        uref_clock_set_cr_sys(uref, now + UCLOCK_FREQ / 100 +
+                                    i * UCLOCK_FREQ / 1000);
+        upipe_input(upipe, uref, NULL);
+    }
+    upump_mgr_run(upump_mgr, NULL);
+
+    /* a malformed SCM_TXTIME message would be rejected by the kernel */
+    uint8_t buf[BUF_SIZE];
+    for (int i = 0; i < TXTIME_PACKETS; i++) {
+        assert(recv(fd, buf, sizeof(buf), MSG_DONTWAIT) == BUF_SIZE);
+        assert(buf[0] == i);
+    }
+    assert(recv(fd, buf, sizeof(buf), MSG_DONTWAIT) == -1);
+}
+
+/** sends a packet beyond the horizon and checks it is handed to the kernel
+ * as soon as it enters the horizon, instead of at its date */
+static void send_txtime_early(struct upump_mgr *upump_mgr,
+                              struct uclock *uclock, struct upipe *upipe,
+                              int fd)
+{
+    uint64_t systime = uclock_now(uclock) + UCLOCK_FREQ / 5;
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, BUF_SIZE);
+    assert(uref != NULL);
+    int size = BUF_SIZE;
+    uint8_t *buf;
+    ubase_assert(uref_block_write(uref, 0, &size, &buf));
+    memset(buf, TXTIME_PACKETS, size);
+    uref_block_unmap(uref, 0);
+    uref_clock_set_cr_sys(uref, systime);
+    upipe_input(upipe, uref, NULL);
+    upump_mgr_run(upump_mgr, NULL);
+    assert(uclock_now(uclock) < systime);
+
+    uint8_t recv_buf[BUF_SIZE];
+    assert(recv(fd, recv_buf, sizeof(recv_buf), MSG_DONTWAIT) == BUF_SIZE);
+    assert(recv_buf[0] == TXTIME_PACKETS);
+    assert(recv(fd, recv_buf, sizeof(recv_buf), MSG_DONTWAIT) == -1);
+}
+
+/** checks kernel-paced transmission */
+static void test_txtime(struct upump_mgr *upump_mgr, struct uclock *uclock,
+                        struct uprobe *logger)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+    struct sockaddr_in addr;
+    socklen_t addrlen = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(fd, (struct sockaddr *)&addr, addrlen) == 0);
+    assert(getsockname(fd, (struct sockaddr *)&addr, &addrlen) == 0);
+
+    struct upipe *upipe_txtime = upipe_void_alloc(upipe_udpsink_mgr_alloc(),
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "udp sink txtime"));
+    assert(upipe_txtime != NULL);
+    ubase_assert(upipe_attach_uclock(upipe_txtime));
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "bar");
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_txtime, flow_def));
+    uref_free(flow_def);
+    char uri[64];
+    snprintf(uri, sizeof(uri), "127.0.0.1:%u", ntohs(addr.sin_port));
+    ubase_assert(upipe_set_uri(upipe_txtime, uri));
+
+    /* CLOCK_MONOTONIC does not require privileges */
+    int clockid;
+    uint64_t horizon;
+    ubase_assert(upipe_udpsink_set_txtime(upipe_txtime, CLOCK_MONOTONIC,
+                                          UCLOCK_FREQ));
+    ubase_assert(upipe_udpsink_get_txtime(upipe_txtime, &clockid, &horizon));
+    assert(horizon == UCLOCK_FREQ);
+    if (clockid == -1) {
+        /* SO_TXTIME is not available */
+        upipe_release(upipe_txtime);
+        close(fd);
+        return;
+    }
+    assert(clockid == CLOCK_MONOTONIC);
+
+    /* one message per packet, then by batches */
+    send_txtime(upump_mgr, uclock, upipe_txtime, fd);
+    ubase_assert(upipe_udpsink_set_batch(upipe_txtime, 8, 0));
+    send_txtime(upump_mgr, uclock, upipe_txtime, fd);
+    ubase_assert(upipe_udpsink_get_txtime(upipe_txtime, &clockid, NULL));
+    assert(clockid == CLOCK_MONOTONIC);
+
+    /* packets beyond the horizon wait in timers before being paced */
+    ubase_assert(upipe_udpsink_set_txtime(upipe_txtime, CLOCK_MONOTONIC,
+                                          UCLOCK_FREQ / 200));
+    send_txtime(upump_mgr, uclock, upipe_txtime, fd);
+    ubase_assert(upipe_udpsink_set_batch(upipe_txtime, 1, 0));
+    send_txtime(upump_mgr, uclock, upipe_txtime, fd);
+    ubase_assert(upipe_udpsink_get_txtime(upipe_txtime, &clockid, NULL));
+    assert(clockid == CLOCK_MONOTONIC);
+    ubase_nassert(upipe_udpsink_set_txtime(upipe_txtime, CLOCK_MONOTONIC,
+                                           UINT64_C(1000) * UCLOCK_FREQ));
+
+    /* timers wake up at the horizon, not at the date of the packet */
+    ubase_assert(upipe_udpsink_set_txtime(upipe_txtime, CLOCK_MONOTONIC,
+                                          UCLOCK_FREQ / 10));
+    send_txtime_early(upump_mgr, uclock, upipe_txtime, fd);
+    ubase_assert(upipe_udpsink_set_batch(upipe_txtime, 8, 0));
+    send_txtime_early(upump_mgr, uclock, upipe_txtime, fd);
+    ubase_assert(upipe_udpsink_set_batch(upipe_txtime, 1, 0));
+
+    /* a clock refused by the kernel falls back to timers */
+    ubase_assert(upipe_udpsink_set_txtime(upipe_txtime, TXTIME_BAD_CLOCK,
+                                          UCLOCK_FREQ));
+    ubase_assert(upipe_udpsink_get_txtime(upipe_txtime, &clockid, NULL));
+    assert(clockid == -1);
+    send_txtime(upump_mgr, uclock, upipe_txtime, fd);
+    ubase_assert(upipe_udpsink_set_batch(upipe_txtime, 8, 0));
+    send_txtime(upump_mgr, uclock, upipe_txtime, fd);
+
+    upipe_release(upipe_txtime);
+    close(fd);
+}
+
 int main(int argc, char *argv[])
 {
     char udp_uri[512], port_str[8];
@@ -301,6 +712,7 @@ int main(int argc, char *argv[])
     ubase_assert(upipe_set_output(upipe_udpsrc, udpsrc_test));
     ubase_assert(upipe_set_output_size(upipe_udpsrc, READ_SIZE));
     ubase_assert(upipe_attach_uclock(upipe_udpsrc));
+    ubase_assert(upipe_udpsrc_set_timestamps(upipe_udpsrc, 1));
     srand(42);
 
     upipe_set_uri(upipe_udpsrc, "@127.0.0.1:42125");
@@ -351,6 +763,17 @@ int main(int argc, char *argv[])
     assert(upipe_udpsink != NULL);
     ubase_assert(upipe_set_flow_def(upipe_udpsink, flow_def));
     uref_free(flow_def);
+#ifdef UPIPE_HAVE_SENDMMSG
+    ubase_assert(upipe_udpsink_set_batch(upipe_udpsink, 8, 0));
+#endif
+
+#ifdef UPIPE_HAVE_RECVMMSG
+    /* read the second run in batches */
+    ubase_assert(upipe_udpsrc_set_batch(upipe_udpsrc, 16));
+    unsigned int batch;
+    ubase_assert(upipe_udpsrc_get_batch(upipe_udpsrc, &batch));
+    assert(batch == 16);
+#endif
 
     /* reset source uri */
     for (i=0; i < 10; i++) {
@@ -372,6 +795,15 @@ int main(int argc, char *argv[])
     /* fire again */
     upump_mgr_run(upump_mgr, NULL);
 
+    test_timestamps(upump_mgr, uclock, udpsrc_test);
+#ifdef UPIPE_HAVE_RECVMMSG
+    test_batch(upump_mgr, udpsrc_test);
+#endif
+#if defined(UPIPE_HAVE_SENDMMSG) && defined(UDP_SEGMENT) && defined(UDP_GRO)
+    test_gso(upump_mgr, logger);
+#endif
+    test_txtime(upump_mgr, uclock, logger);
+
     /* release */
     upump_free(write_pump);
     upipe_release(upipe_udpsrc);
@@ -43,6 +43,7 @@
 #include <upipe/uref.h>
 #include <upipe/uref_std.h>
 #include <upipe/upump.h>
+#include <upipe/uclock.h>
 #include <upump-ev/upump_ev.h>
 #include <upipe/upipe.h>
 #include <upipe-modules/upipe_worker_linear.h>
@@ -244,6 +245,9 @@ int main(int argc, char **argv)
 
     struct upipe_mgr *upipe_wlin_mgr = upipe_wlin_mgr_alloc(upipe_xfer_mgr);
     assert(upipe_wlin_mgr != NULL);
+    ubase_assert(upipe_work_mgr_set_batch(upipe_wlin_mgr, 8));
+    ubase_assert(upipe_work_mgr_set_coalesce(upipe_wlin_mgr, 3,
+                                             UCLOCK_FREQ / 1000));
     upipe_mgr_release(upipe_xfer_mgr);
 
     /* Test with upump_mgr frozen, this is supposed to work. */
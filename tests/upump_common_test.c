@@ -24,14 +24,13 @@
  */
 
 /** @file
- * @short unit tests for upump manager with ev event loop
+ * @short common unit tests for upump managers
  */
 
 #undef NDEBUG
 
 #include <upipe/upump.h>
 #include <upipe/upump_blocker.h>
-#include <upump-ev/upump_ev.h>
 
 #include <stdio.h>
 #include <string.h>
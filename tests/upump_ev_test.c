@@ -31,6 +31,9 @@
 
 #include <upump-ev/upump_ev.h>
 
+#include <unistd.h>
+#include <assert.h>
+
 #include "upump_common_test.h"
 
 #define UPUMP_POOL 1
@@ -38,6 +41,11 @@
 
 int main(int argc, char **argv)
 {
-    run(upump_ev_mgr_alloc_default(UPUMP_POOL, UPUMP_BLOCKER_POOL));
+    struct upump_mgr *mgr = upump_ev_mgr_alloc_default(UPUMP_POOL,
+                                                       UPUMP_BLOCKER_POOL);
+    assert(mgr != NULL);
+    /* I/O operations are not submitted to libev */
+    assert(upump_alloc_io_write(mgr, NULL, NULL, NULL, STDOUT_FILENO) == NULL);
+    run(mgr);
     return 0;
 }
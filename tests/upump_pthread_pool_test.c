@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for the pool of POSIX threads running upump managers
+ */
+
+#undef NDEBUG
+
+#include <upipe/uatomic.h>
+#include <upipe/uclock.h>
+#include <upipe/umutex.h>
+#include <upipe/upump.h>
+#include <upipe-pthread/umutex_pthread.h>
+#include <upipe-pthread/upump_pthread_pool.h>
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define UPUMP_POOL 2
+#define UPUMP_BLOCKER_POOL 1
+#define NB_WORKERS 4
+#define NB_DOMAINS 16
+#define NB_ITERATIONS 1000
+#define TIMEOUT (UCLOCK_FREQ / 100)
+#define NB_TICKS 3
+
+struct domain {
+    struct umutex *mutex;
+    struct upump_mgr *mgr;
+    struct upump *idler;
+    unsigned int count;
+    uatomic_uint32_t busy;
+};
+
+static struct domain domains[NB_DOMAINS];
+static int pipefd[2];
+static unsigned int nb_ticks = 0;
+static bool timer_done = false;
+static bool read_done = false;
+
+static void idler_cb(struct upump *upump)
+{
+    struct domain *domain = upump_get_opaque(upump, struct domain *);
+    /* a domain is never dispatched by two workers at once */
+    assert(uatomic_fetch_add(&domain->busy, 1) == 0);
+    for (volatile unsigned int i = 0; i < 1000; i++);
+    if (++domain->count == NB_ITERATIONS)
+        upump_stop(upump);
+    uatomic_fetch_sub(&domain->busy, 1);
+}
+
+static void timer_cb(struct upump *upump)
+{
+    assert(write(pipefd[1], "", 1) == 1);
+    timer_done = true;
+}
+
+static void read_cb(struct upump *upump)
+{
+    char c;
+    assert(timer_done);
+    assert(read(pipefd[0], &c, 1) == 1);
+    read_done = true;
+    upump_stop(upump);
+}
+
+static void tick_cb(struct upump *upump)
+{
+    if (++nb_ticks == NB_TICKS)
+        upump_stop(upump);
+}
+
+int main(int argc, char **argv)
+{
+    struct upump_pthread_pool *pool = upump_pthread_pool_alloc(NB_WORKERS,
+                                                               NULL);
+    assert(pool != NULL);
+
+    /* independent idlers balanced across the workers */
+    for (unsigned int i = 0; i < NB_DOMAINS; i++) {
+        struct domain *domain = &domains[i];
+        domain->count = 0;
+        uatomic_init(&domain->busy, 0);
+        domain->mutex = umutex_pthread_alloc(NULL);
+        assert(domain->mutex != NULL);
+        domain->mgr = upump_pthread_pool_mgr_alloc(pool, domain->mutex,
+                                                   UPUMP_POOL,
+                                                   UPUMP_BLOCKER_POOL);
+        assert(domain->mgr != NULL);
+        umutex_lock(domain->mutex);
+        domain->idler = upump_alloc_idler(domain->mgr, idler_cb, domain, NULL);
+        assert(domain->idler != NULL);
+        upump_start(domain->idler);
+        umutex_unlock(domain->mutex);
+    }
+
+    for (unsigned int i = 0; i < NB_DOMAINS; i++) {
+        struct domain *domain = &domains[i];
+        upump_mgr_run(domain->mgr, NULL);
+        umutex_lock(domain->mutex);
+        assert(domain->count == NB_ITERATIONS);
+        upump_free(domain->idler);
+        umutex_unlock(domain->mutex);
+        upump_mgr_release(domain->mgr);
+        umutex_release(domain->mutex);
+        uatomic_clean(&domain->busy);
+    }
+
+    struct upump_pthread_pool_stats stats;
+    upump_pthread_pool_get_stats(pool, &stats);
+    assert(stats.runs >= NB_DOMAINS * NB_ITERATIONS);
+    printf("Passed idlers (%"PRIu64" runs, %"PRIu64" steals)\n",
+           stats.runs, stats.steals);
+
+    /* timers and file descriptors */
+    assert(pipe(pipefd) != -1);
+    struct upump_mgr *mgr = upump_pthread_pool_mgr_alloc(pool, NULL,
+                                                         UPUMP_POOL,
+                                                         UPUMP_BLOCKER_POOL);
+    assert(mgr != NULL);
+    struct upump *timer = upump_alloc_timer(mgr, timer_cb, NULL, NULL,
+                                            TIMEOUT, 0);
+    assert(timer != NULL);
+    struct upump *read_watcher = upump_alloc_fd_read(mgr, read_cb, NULL, NULL,
+                                                     pipefd[0]);
+    assert(read_watcher != NULL);
+    assert(upump_alloc_signal(mgr, read_cb, NULL, NULL, 1) == NULL);
+    upump_start(read_watcher);
+    upump_start(timer);
+    upump_mgr_run(mgr, NULL);
+    assert(read_done);
+    upump_free(timer);
+    upump_free(read_watcher);
+
+    timer = upump_alloc_timer(mgr, tick_cb, NULL, NULL, TIMEOUT, TIMEOUT);
+    assert(timer != NULL);
+    upump_start(timer);
+    upump_mgr_run(mgr, NULL);
+    assert(nb_ticks == NB_TICKS);
+    upump_free(timer);
+    printf("Passed timers\n");
+
+    upump_mgr_release(mgr);
+    upump_pthread_pool_free(pool);
+    close(pipefd[0]);
+    close(pipefd[1]);
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 OpenHeadend S.A.R.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for upump manager with io_uring event loop
+ */
+
+#undef NDEBUG
+
+#include <upipe/upump.h>
+#include <upump-uring/upump_uring.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "upump_common_test.h"
+
+#define UPUMP_POOL 1
+#define UPUMP_BLOCKER_POOL 1
+#define MESSAGE "io_uring"
+
+static uint8_t buffer[4096];
+static bool read_done = false;
+static bool write_done = false;
+
+static void read_cb(struct upump *upump)
+{
+    ssize_t result;
+    assert(ubase_check(upump_io_get_result(upump, &result)));
+    assert(result == sizeof(MESSAGE));
+    assert(!memcmp(buffer, MESSAGE, sizeof(MESSAGE)));
+    printf("read passed\n");
+    read_done = true;
+    upump_stop(upump);
+}
+
+static void write_cb(struct upump *upump)
+{
+    ssize_t result;
+    assert(ubase_check(upump_io_get_result(upump, &result)));
+    assert(result == sizeof(MESSAGE));
+    printf("write passed\n");
+    write_done = true;
+    upump_stop(upump);
+}
+
+static void io(struct upump_mgr *mgr)
+{
+    int pipefd[2];
+    assert(pipe(pipefd) != -1);
+
+    struct iovec iovec = { .iov_base = buffer, .iov_len = sizeof(buffer) };
+    assert(ubase_check(upump_uring_mgr_register_buffers(mgr, &iovec, 1)));
+    uint8_t *out = buffer + sizeof(buffer) / 2;
+    memcpy(out, MESSAGE, sizeof(MESSAGE));
+
+    struct upump *read_pump = upump_alloc_io_read(mgr, read_cb, NULL, NULL,
+                                                  pipefd[0]);
+    assert(read_pump != NULL);
+    struct upump *write_pump = upump_alloc_io_write(mgr, write_cb, NULL,
+                                                    NULL, pipefd[1]);
+    assert(write_pump != NULL);
+
+    /* pumps must be started to submit */
+    assert(upump_io_submit(read_pump, buffer, sizeof(MESSAGE),
+                           UINT64_MAX) == UBASE_ERR_INVALID);
+    upump_start(read_pump);
+    upump_start(write_pump);
+    assert(ubase_check(upump_io_submit(read_pump, buffer, sizeof(MESSAGE),
+                                       UINT64_MAX)));
+    assert(upump_io_submit(read_pump, buffer, sizeof(MESSAGE),
+                           UINT64_MAX) == UBASE_ERR_BUSY);
+    assert(ubase_check(upump_io_submit(write_pump, out, sizeof(MESSAGE),
+                                       UINT64_MAX)));
+    upump_mgr_run(mgr, NULL);
+    assert(read_done);
+    assert(write_done);
+
+    /* stopping the pump cancels the pending read */
+    read_done = false;
+    upump_start(read_pump);
+    assert(ubase_check(upump_io_submit(read_pump, buffer, sizeof(MESSAGE),
+                                       UINT64_MAX)));
+    upump_stop(read_pump);
+    upump_mgr_run(mgr, NULL);
+    assert(!read_done);
+
+    upump_free(read_pump);
+    upump_free(write_pump);
+    assert(ubase_check(upump_uring_mgr_register_buffers(mgr, NULL, 0)));
+    close(pipefd[0]);
+    close(pipefd[1]);
+}
+
+int main(int argc, char **argv)
+{
+    struct upump_mgr *mgr = upump_uring_mgr_alloc(0, UPUMP_POOL,
+                                                  UPUMP_BLOCKER_POOL);
+    if (mgr == NULL) {
+        printf("io_uring not available\n");
+        return 77;
+    }
+    io(mgr);
+    run(mgr);
+    return 0;
+}